@@ -40,6 +40,9 @@
 #  include <GL/freeglut_ext.h>
 #endif  // __APPLE__
 
+// Optional per-frame GL call counting (compile with -DGL_TRACE)
+#include "GLTrace.h"
+
 // Define a helpful macro for handling offsets into buffer objects
 #define BUFFER_OFFSET( offset )   ((GLvoid*) (offset))
 
@@ -54,6 +57,9 @@ namespace Angel {
 GLuint InitShader( const char* vertexShaderFile,
 		   const char* fragmentShaderFile );
 
+//  Same for a compute shader (needs an OpenGL 4.3 context)
+GLuint InitComputeShader( const char* computeShaderFile );
+
 //  Defined constant for when numbers are too small to be used in the
 //    denominator of a division operation.  This is only used if the
 //    DEBUG macro is defined.
@@ -0,0 +1,142 @@
+#include "Arena.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+static std::atomic<unsigned long>  heap_allocations( 0 );
+static thread_local unsigned long  thread_heap_allocations = 0;
+
+//----------------------------------------------------------------------------
+//
+//  The global operator new, counting.  new[] and the nothrow forms go
+//    through it.
+//
+
+void*
+operator new( size_t bytes )
+{
+    heap_allocations.fetch_add( 1, std::memory_order_relaxed );
+    thread_heap_allocations++;
+    void* p = malloc( bytes ? bytes : 1 );
+    if ( p == NULL )
+	throw std::bad_alloc();
+    return p;
+}
+
+void
+operator delete( void* p ) noexcept
+{
+    free( p );
+}
+
+unsigned long
+HeapAllocationCount()
+{
+    return heap_allocations.load( std::memory_order_relaxed );
+}
+
+unsigned long
+ThreadHeapAllocationCount()
+{
+    return thread_heap_allocations;
+}
+
+//----------------------------------------------------------------------------
+
+static char*
+block_data( void* block, size_t header )
+{
+    return (char*) block + header;
+}
+
+static char*
+align_up( char* p, size_t align )
+{
+    return (char*) (((size_t) p + align - 1) & ~(align - 1));
+}
+
+Arena::Arena( size_t block_size ) :
+    head( NULL ), top( NULL ), end( NULL ), block_size( block_size ),
+    block_count( 0 )
+{
+}
+
+Arena::~Arena()
+{
+    while ( head ) {
+	Block* next = head->next;
+	free( head );
+	head = next;
+    }
+}
+
+Arena::Block*
+Arena::new_block( size_t bytes )
+{
+    Block* b = (Block*) malloc( sizeof(Block) + bytes );
+    if ( b == NULL )
+	throw std::bad_alloc();
+    heap_allocations.fetch_add( 1, std::memory_order_relaxed );
+    thread_heap_allocations++;
+    block_count++;
+
+    b->next = head;
+    b->size = bytes;
+    b->used_before = used();
+
+    head = b;
+    top = block_data( b, sizeof(Block) );
+    end = top + bytes;
+    return b;
+}
+
+void*
+Arena::allocate( size_t bytes, size_t align )
+{
+    char* p = align_up( top, align );
+    if ( head == NULL || p + bytes > end ) {
+	size_t need = bytes + align;
+	new_block( need > block_size ? need : block_size );
+	p = align_up( top, align );
+    }
+    top = p + bytes;
+    return p;
+}
+
+void
+Arena::reset()
+{
+    if ( head == NULL )
+	return;
+
+    if ( head->next == NULL ) {
+	top = block_data( head, sizeof(Block) );
+	return;
+    }
+
+    // Room for all of this round in one block next time
+    size_t total = capacity();
+    while ( head ) {
+	Block* next = head->next;
+	free( head );
+	head = next;
+    }
+    if ( total > block_size )
+	block_size = total;
+    new_block( total );
+}
+
+size_t
+Arena::used() const
+{
+    return head ? head->used_before + (top - block_data( head, sizeof(Block) )) : 0;
+}
+
+size_t
+Arena::capacity() const
+{
+    size_t total = 0;
+    for ( const Block* b = head; b; b = b->next )
+	total += b->size;
+    return total;
+}
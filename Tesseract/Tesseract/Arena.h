@@ -0,0 +1,128 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Arena.h ---
+//
+//   Linear ("bump") allocation for data that all dies at once: the meshes
+//     while they are being built, and scratch space that only lives for
+//     one frame.  Allocating moves a pointer along a block; nothing is
+//     freed on its own, and reset() drops everything together.
+//
+//   reset() keeps the memory.  If the last round needed more than one
+//     block, they are merged into one that holds all of it, so the same
+//     work afterwards runs without touching the heap.
+//
+//   Only for types that need no destructor.  An arena is not thread-safe.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+class Arena {
+   public:
+    explicit Arena( size_t block_size = 64*1024 );
+    ~Arena();
+
+    //  "bytes" of uninitialized memory aligned to "align" (a power of 2)
+    void* allocate( size_t bytes, size_t align = 16 );
+
+    //  "count" uninitialized T's
+    template <class T>
+    T* allocate( size_t count ) {
+	static_assert( std::is_trivially_destructible<T>::value,
+		       "arena memory is never destroyed" );
+	return (T*) allocate( count * sizeof(T), alignof(T) < 16 ? 16 : alignof(T) );
+    }
+
+    //  Forget everything allocated so far
+    void reset();
+
+    size_t used() const;		// bytes handed out since reset()
+    size_t capacity() const;		// bytes in all blocks
+    unsigned long blocks_allocated() const { return block_count; }
+
+   private:
+    struct Block {
+	Block*  next;
+	size_t  size;
+	size_t  used_before;	// bytes in the blocks after this one
+    };
+
+    Block* new_block( size_t bytes );
+
+    Block*         head;		// the block being filled; older ones follow
+    char*          top;		// next free byte in head
+    char*          end;
+    size_t         block_size;
+    unsigned long  block_count;
+
+    Arena( const Arena& );
+    Arena& operator = ( const Arena& );
+};
+
+//----------------------------------------------------------------------------
+//
+//  A growable array in an arena, for building meshes of unknown size.
+//    Growing copies into a block twice the size and leaves the old one to
+//    the arena; reserve() up front avoids that.  reset() the array
+//    whenever its arena is reset.
+//
+
+template <class T>
+class ArenaArray {
+   public:
+    explicit ArenaArray( Arena& arena ) :
+	arena( &arena ), items( NULL ), count( 0 ), room( 0 ) {}
+
+    void reserve( size_t n ) {
+	if ( n <= room )
+	    return;
+	T* bigger = arena->allocate<T>( n );
+	if ( count )
+	    memcpy( bigger, items, count * sizeof(T) );
+	items = bigger;
+	room = n;
+    }
+
+    void push_back( const T& item ) {
+	if ( count == room )
+	    reserve( room ? 2*room : 64 );
+	items[count++] = item;
+    }
+
+    void clear() { count = 0; }
+
+    //  Let go of the storage too, before its arena is reset
+    void reset() { items = NULL; count = room = 0; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T& operator [] ( size_t i ) { return items[i]; }
+    const T& operator [] ( size_t i ) const { return items[i]; }
+
+    T* data() { return items; }
+    const T* data() const { return items; }
+
+   private:
+    Arena*  arena;
+    T*      items;
+    size_t  count;
+    size_t  room;
+};
+
+//----------------------------------------------------------------------------
+
+//  Heap allocations since startup: calls to the global operator new, and
+//    arena blocks.  HeapAllocationCount() counts every thread's;
+//    ThreadHeapAllocationCount() only the calling thread's, which is what
+//    -bench reports per frame for the display thread, leaving out the
+//    simulation thread and the job workers.
+unsigned long HeapAllocationCount();
+unsigned long ThreadHeapAllocationCount();
+
+#endif // __ARENA_H__
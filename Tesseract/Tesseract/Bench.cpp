@@ -0,0 +1,1807 @@
+#include "Bench.h"
+#include "FrameStats.h"
+#include "Scene.h"
+#include "JobSystem.h"
+#include "Camera.h"
+#include "Polytope.h"
+#include "Wythoff.h"
+#include "Projector.h"
+#include "Arena.h"
+#include "MeshFile.h"
+#include "VolumeStream.h"
+#include "PointCloud.h"
+#include "VertexFormat.h"
+#include "FixedMesh.h"
+#include "Cull.h"
+#include "Surface.h"
+#include "Quality.h"
+#include "Impostor.h"
+#include "RayCast.h"
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+//----------------------------------------------------------------------------
+//
+//  -bench-scene [objects]:  Scene::update throughput, SIMD against scalar.
+//    The two must leave the same scene behind, from the same start.
+//
+
+static double
+time_updates( Scene& scene, int passes, bool simd )
+{
+    double start = FrameStatsNow();
+    for ( int i = 0; i < passes; ++i ) {
+	if ( simd )
+	    scene.update( 1.0/60.0 );
+	else
+	    scene.update_scalar( 0, scene.size(), 1.0/60.0 );
+    }
+    return (FrameStatsNow() - start) / passes;
+}
+
+//  Whether two scenes hold the same objects, the angles to within
+//    "tolerance" degrees either way round the circle; prints the first
+//    difference
+static bool
+same_scene( const Scene& a, const Scene& b, GLfloat tolerance )
+{
+    if ( a.size() != b.size() ) {
+	printf( "scenes of %d and %d objects\n", a.size(), b.size() );
+	return false;
+    }
+    for ( int i = 0; i < a.size(); ++i ) {
+	bool same = a.scale[i] == b.scale[i];
+	for ( int k = 0; k < 4; ++k )
+	    same = same && a.center[k][i] == b.center[k][i]
+		&& a.color[k][i] == b.color[k][i];
+	for ( int p = 0; p < NumPlanes; ++p ) {
+	    GLfloat d = fabs( a.angle[p][i] - b.angle[p][i] );
+	    same = same && a.angular_velocity[p][i] == b.angular_velocity[p][i]
+		&& std::min( d, 360.0f - d ) <= tolerance;
+	}
+	if ( !same ) {
+	    printf( "object %d differs: angles", i );
+	    for ( int p = 0; p < NumPlanes; ++p )
+		printf( " %g/%g", a.angle[p][i], b.angle[p][i] );
+	    printf( "\n" );
+	    return false;
+	}
+    }
+    return true;
+}
+
+static int
+bench_scene( int objects )
+{
+    static const GLfloat velocity[NumPlanes] = { 6, 12, 18, 30, 42, 66 };
+
+    Scene scene;
+    PopulateScene( scene, objects, velocity );
+
+    // Enough passes for roughly 100 million object updates
+    int passes = 100000000 / objects;
+    if ( passes < 10 ) passes = 10;
+
+    // From the same start, a thousand steps each way.  The scalar loop
+    // wraps in double precision, so allow some rounding.
+    Scene simd = scene, scalar = scene;
+    time_updates( simd, 1000, true );
+    time_updates( scalar, 1000, false );
+    bool same = same_scene( simd, scalar, 1e-3 );
+
+    time_updates( scene, passes / 10, true );	// warm caches
+    double simd_ms = time_updates( scene, passes, true );
+    double scalar_ms = time_updates( scene, passes, false );
+
+    printf( "objects:               %d\n", objects );
+    printf( "passes:                %d\n", passes );
+    printf( "simd update:           %.4f ms  (%.0f objects/ms)\n",
+	    simd_ms, objects / simd_ms );
+    printf( "scalar update:         %.4f ms  (%.0f objects/ms)\n",
+	    scalar_ms, objects / scalar_ms );
+    printf( "simd matches scalar:   %s\n", same ? "yes" : "NO" );
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-jobs [items]:  parallel_for scaling from one thread to one per core
+//
+
+//  About the per-object work of a frame: the sines and cosines of six angles
+static void
+rotation_work( const Scene& scene, std::vector<GLfloat>& out, int first, int last )
+{
+    for ( int i = first; i < last; ++i ) {
+	for ( int p = 0; p < NumPlanes; ++p ) {
+	    GLfloat a = scene.angle[p][i] * DegreesToRadians;
+	    out[12*i + p] = sin( a );
+	    out[12*i + 6 + p] = cos( a );
+	}
+    }
+}
+
+static int
+bench_jobs( int items )
+{
+    static const GLfloat velocity[NumPlanes] = { 6, 12, 18, 30, 42, 66 };
+
+    Scene scene;
+    PopulateScene( scene, items, velocity );
+    scene.update( 1.234 );
+
+    std::vector<GLfloat> out( 12*items );
+
+    int cores = (int) std::thread::hardware_concurrency();
+    if ( cores < 1 )
+	cores = 1;
+
+    int passes = 20000000 / items;
+    if ( passes < 5 ) passes = 5;
+
+    printf( "items: %d  passes: %d  cores: %d\n", items, passes, cores );
+    printf( "threads     ms/pass    speedup  efficiency\n" );
+
+    double single_ms = 0.0;
+    for ( int t = 1; t <= cores; ++t ) {
+	JobSystem jobs( t );
+
+	jobs.parallel_for( 0, items, 0, [&]( int first, int last ) {
+	    rotation_work( scene, out, first, last );
+	} );
+
+	double start = FrameStatsNow();
+	for ( int pass = 0; pass < passes; ++pass ) {
+	    jobs.parallel_for( 0, items, 0, [&]( int first, int last ) {
+		rotation_work( scene, out, first, last );
+	    } );
+	}
+	double ms = (FrameStatsNow() - start) / passes;
+
+	if ( t == 1 )
+	    single_ms = ms;
+	printf( "%7d %10.4f %10.2f %10.0f%%\n", t, ms, single_ms / ms,
+		100.0 * single_ms / (ms * t) );
+    }
+
+    // Task dependencies: a diamond a -> (b, c) -> d, repeated
+    JobSystem jobs( cores );
+    std::atomic<int> order( 0 );
+    int wrong = 0;
+    double start = FrameStatsNow();
+    for ( int pass = 0; pass < 1000; ++pass ) {
+	int a_at = -1, b_at = -1, c_at = -1, d_at = -1;
+	Job* a = jobs.create( [&] { a_at = order++; } );
+	Job* b = jobs.create( [&] { b_at = order++; } );
+	Job* c = jobs.create( [&] { c_at = order++; } );
+	Job* d = jobs.create( [&] { d_at = order++; } );
+	jobs.depends( b, a );
+	jobs.depends( c, a );
+	jobs.depends( d, b );
+	jobs.depends( d, c );
+	jobs.run( d );
+	jobs.run( c );
+	jobs.run( b );
+	jobs.run( a );
+	jobs.wait( d );
+	if ( !(a_at < b_at && a_at < c_at && b_at < d_at && c_at < d_at) )
+	    wrong++;
+    }
+    printf( "dependency graphs:  %.4f ms each, %d out of order\n",
+	    (FrameStatsNow() - start) / 1000, wrong );
+
+    return wrong == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-camera [events]:  cost of camera input, applied one event at a
+//    time against applied in per-tick batches
+//
+
+//  A stream like a fast mouse drag with key repeat: mostly motion events,
+//    with a movement key every fourth event
+static void
+feed_event( CameraController& camera, int i )
+{
+    if ( i % 4 == 3 )
+	camera.key( i % 8 == 3 ? 'w' : 'd' );
+    else
+	camera.pointer( 256 + i % 7, 256 - i % 5, 512 );
+}
+
+static double
+time_camera( int events, int batch, int& views )
+{
+    CameraController camera;
+    views = 0;
+
+    double start = FrameStatsNow();
+    for ( int i = 0; i < events; ++i ) {
+	feed_event( camera, i );
+	if ( (i+1) % batch == 0 && camera.update() )
+	    views++;
+    }
+    return (FrameStatsNow() - start) / events;
+}
+
+static int
+bench_camera( int events )
+{
+    // 1000 Hz mouse plus key repeat at a 120 Hz simulation: about 16
+    // events per tick
+    const int batch = 16;
+
+    int single_views, batched_views;
+    time_camera( events / 10, 1, single_views );	// warm caches
+    double single_ms = time_camera( events, 1, single_views );
+    double batched_ms = time_camera( events, batch, batched_views );
+
+    printf( "events:                %d\n", events );
+    printf( "per event:             %.1f ns/event  (%d view matrices)\n",
+	    single_ms * 1.0e6, single_views );
+    printf( "batches of %d:         %.1f ns/event  (%d view matrices)\n",
+	    batch, batched_ms * 1.0e6, batched_views );
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-polytopes [max dimension]:  generation time and memory of the
+//    N-cube, N-simplex and N-orthoplex
+//
+
+static int
+bench_polytopes( int max_dimension )
+{
+    if ( max_dimension > MaxPolytopeDimension )
+	max_dimension = MaxPolytopeDimension;
+
+    printf( "%-10s %3s %7s %7s %7s %7s %10s %12s\n", "family", "n",
+	    "verts", "edges", "faces", "cells", "bytes", "ms" );
+
+    for ( int f = 0; f < POLYTOPE_NUM_FAMILIES; ++f ) {
+	for ( int n = 2; n <= max_dimension; ++n ) {
+	    PolytopeFamily family = PolytopeFamily( f );
+	    Polytope p;
+
+	    // Repeat small ones until the timing means something
+	    int runs = 0;
+	    double start = FrameStatsNow(), elapsed;
+	    do {
+		MakePolytope( p, family, n );
+		runs++;
+		elapsed = FrameStatsNow() - start;
+	    } while ( elapsed < 20.0 );
+
+	    printf( "%-10s %3d %7d %7d %7d %7d %10lu %12.4f\n",
+		    PolytopeFamilyName( family ), n, p.vertex_count(),
+		    p.edge_count(), p.face_count(), p.cell_count(),
+		    (unsigned long) p.bytes(), elapsed / runs );
+	}
+    }
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-wythoff:  Wythoff construction of the uniform 4-polytopes, against
+//    reading the same mesh back from the disk cache
+//
+
+static int
+bench_wythoff()
+{
+    static const char* names[] = {
+	"5-cell", "tesseract", "16-cell", "24-cell", "120-cell", "600-cell",
+	"truncated-120-cell", "rectified-600-cell", "omnitruncated-120-cell"
+    };
+    const char* file = "wythoff-bench.mesh";
+
+    printf( "%-24s %6s %6s %6s %9s %10s %10s\n", "polytope", "verts",
+	    "edges", "faces", "bytes", "make ms", "load ms" );
+
+    for ( size_t i = 0; i < sizeof(names)/sizeof(names[0]); ++i ) {
+	WythoffSymbol symbol;
+	WythoffSymbolFromName( names[i], symbol );
+
+	WythoffMesh mesh;
+	double start = FrameStatsNow();
+	if ( !MakeWythoff( mesh, symbol ) )
+	    return EXIT_FAILURE;
+	double make_ms = FrameStatsNow() - start;
+
+	SaveWythoff( mesh, file );
+	WythoffMesh loaded;
+	start = FrameStatsNow();
+	bool ok = LoadWythoff( loaded, file );
+	double load_ms = FrameStatsNow() - start;
+	remove( file );
+
+	if ( !ok || loaded.face_indices != mesh.face_indices )
+	    return EXIT_FAILURE;
+
+	printf( "%-24s %6d %6d %6d %9lu %10.3f %10.3f\n", names[i],
+		mesh.vertex_count(), mesh.edge_count(), mesh.face_count(),
+		(unsigned long) mesh.bytes(), make_ms, load_ms );
+    }
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-vecmath [points]:  mat4 and vec4 throughput -- transforming a
+//    point cloud, composing matrices and building LookAt views
+//
+
+static int
+bench_vecmath( int count )
+{
+    std::vector<vec4> in( count ), out( count );
+    for ( int i = 0; i < count; ++i )
+	in[i] = vec4( i % 7, i % 11, i % 13, 1.0 );
+
+    mat4 m = RotateX( 30.0 ) * RotateY( 45.0 ) * Translate( 1.0, 2.0, 3.0 );
+    const int passes = 100;
+
+    double start = FrameStatsNow();
+    for ( int p = 0; p < passes; ++p )
+	for ( int i = 0; i < count; ++i )
+	    out[i] = m * in[i];
+    double transform_ms = (FrameStatsNow() - start) / passes;
+
+    GLfloat sum = 0.0;
+    for ( int i = 0; i < count; ++i )
+	sum += dot( out[i], out[i] );
+
+    const int products = 10000000;
+    mat4 a = m, b = RotateZ( 1.0 );
+    start = FrameStatsNow();
+    for ( int i = 0; i < products; ++i )
+	a = b * a;
+    double product_ms = FrameStatsNow() - start;
+    sum += a[0][0];
+
+    // Eye positions already in memory, as the camera's are, and every
+    // view kept whole so none of the matrix can be optimized away
+    const int views = 1000000;
+    const vec4 at( 0.0, 0.0, 0.0, 1.0 ), up( 0.0, 1.0, 0.0, 0.0 );
+    std::vector<vec4> eye( 1024 );
+    std::vector<mat4> view( 64 );
+    for ( int i = 0; i < 1024; ++i )
+	eye[i] = vec4( 0.01*i, 1.0, 5.0, 1.0 );
+    start = FrameStatsNow();
+    for ( int i = 0; i < views; ++i )
+	view[i % 64] = LookAt( eye[i % 1024], at, up );
+    double view_ms = FrameStatsNow() - start;
+    sum += view[0][0][0];
+
+    printf( "points:                %d\n", count );
+    printf( "mat4 * vec4:           %.2f ns/point\n",
+	    transform_ms * 1.0e6 / count );
+    printf( "mat4 * mat4:           %.2f ns/product\n",
+	    product_ms * 1.0e6 / products );
+    printf( "LookAt:                %.2f ns/view\n", view_ms * 1.0e6 / views );
+    printf( "checksum:              %g\n", sum );
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-project [points]:  N-dimensional rotation and projection to 3D
+//    for dimensions 4 to 12 -- the N-cube, then a cloud of that many
+//    points -- SIMD against scalar
+//
+
+//  Time one projector: compose, then project every vertex both ways.
+//    Returns false if the two ways disagree.
+static bool
+time_projector( const char* name, int n, const std::vector<GLfloat>& positions )
+{
+    int count = positions.size() / n;
+    Projector projector;
+    projector.set_vertices( n, &positions[0], count );
+
+    std::vector<GLfloat> angles( RotationPlaneCount( n ) );
+    for ( size_t p = 0; p < angles.size(); ++p )
+	angles[p] = 7.0 * (p + 1);
+
+    const int composes = 10000;
+    double start = FrameStatsNow();
+    for ( int i = 0; i < composes; ++i ) {
+	angles[0] = i % 360;
+	projector.set_rotation( &angles[0], 0.6 );
+    }
+    double compose_ms = (FrameStatsNow() - start) / composes;
+
+    std::vector<vec4> simd( count ), scalar( count );
+    int passes = 1 + 4000000 / count;
+    start = FrameStatsNow();
+    for ( int p = 0; p < passes; ++p )
+	projector.project( 0, count, &simd[0] );
+    double simd_ms = (FrameStatsNow() - start) / passes;
+
+    start = FrameStatsNow();
+    for ( int p = 0; p < passes; ++p )
+	projector.project_scalar( 0, count, &scalar[0] );
+    double scalar_ms = (FrameStatsNow() - start) / passes;
+
+    printf( "%-6s %3d %8d %12.3f %10.2f %10.2f %8.2fx\n", name, n, count,
+	    compose_ms * 1.0e3, simd_ms * 1.0e6 / count,
+	    scalar_ms * 1.0e6 / count, scalar_ms / simd_ms );
+
+    return memcmp( &simd[0], &scalar[0], count * sizeof(vec4) ) == 0;
+}
+
+static int
+bench_project( int points )
+{
+    printf( "%-6s %3s %8s %12s %10s %10s %9s\n", "shape", "dim", "verts",
+	    "compose us", "simd ns", "scalar ns", "speedup" );
+
+    for ( int n = 4; n <= MaxProjectorDimension; ++n ) {
+	Polytope cube;
+	MakePolytope( cube, POLYTOPE_HYPERCUBE, n );
+	if ( !time_projector( "cube", n, cube.positions ) )
+	    return EXIT_FAILURE;
+    }
+
+    srand( 1 );
+    for ( int n = 4; n <= MaxProjectorDimension; ++n ) {
+	std::vector<GLfloat> cloud( points * n );
+	for ( size_t i = 0; i < cloud.size(); ++i )
+	    cloud[i] = 0.5 * (rand() / (GLfloat) RAND_MAX - 0.5);
+	if ( !time_projector( "cloud", n, cloud ) )
+	    return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-arena [frames]:  per-frame scratch (a culling list, a draw queue
+//    and projected vertices, of a size that changes every frame) from the
+//    heap against a frame arena, and the heap allocations each makes once
+//    warmed up.  Then a 10-cube's meshes built in std::vectors against
+//    ArenaArrays.
+//
+
+struct BenchDraw {
+    int      object;
+    GLfloat  depth;
+};
+
+//  One frame's scratch work; returns something to keep it from being
+//    optimized away
+template <class Alloc>
+static GLfloat
+bench_frame( int frame, Alloc alloc )
+{
+    int objects = 1000 + (frame * 7919) % 1000;
+    int* visible = alloc.template get<int>( objects );
+    BenchDraw* queue = alloc.template get<BenchDraw>( objects );
+    vec4* slice = alloc.template get<vec4>( 4*objects );
+
+    int n = 0;
+    for ( int i = 0; i < objects; ++i )
+	if ( (i ^ frame) & 1 )
+	    visible[n++] = i;
+    for ( int i = 0; i < n; ++i ) {
+	queue[i].object = visible[i];
+	queue[i].depth = 0.5 * visible[i];
+	slice[4*i] = vec4( queue[i].depth, 0.0, 0.0, 1.0 );
+    }
+    GLfloat sum = slice[0].x + queue[n-1].depth;
+    alloc.done( visible, queue, slice );
+    return sum;
+}
+
+struct HeapScratch {
+    template <class T> T* get( int n ) { return new T[n]; }
+    void done( int* a, BenchDraw* b, vec4* c ) { delete [] a; delete [] b; delete [] c; }
+};
+
+struct ArenaScratch {
+    Arena* arena;
+    template <class T> T* get( int n ) { return arena->allocate<T>( n ); }
+    void done( int*, BenchDraw*, vec4* ) {}
+};
+
+static int
+bench_arena( int frames )
+{
+    const int warmup = 10;
+    GLfloat sum = 0.0;
+
+    // Heap
+    for ( int f = 0; f < warmup; ++f )
+	sum += bench_frame( f, HeapScratch() );
+    unsigned long allocs = HeapAllocationCount();
+    double start = FrameStatsNow();
+    for ( int f = 0; f < frames; ++f )
+	sum += bench_frame( f, HeapScratch() );
+    double heap_ms = FrameStatsNow() - start;
+    unsigned long heap_allocs = HeapAllocationCount() - allocs;
+
+    // Frame arena, reset at the top of every frame as display() does
+    Arena frame( 4*1024 );
+    ArenaScratch scratch = { &frame };
+    for ( int f = 0; f < warmup; ++f ) {
+	frame.reset();
+	sum += bench_frame( f, scratch );
+    }
+    allocs = HeapAllocationCount();
+    start = FrameStatsNow();
+    for ( int f = 0; f < frames; ++f ) {
+	frame.reset();
+	sum += bench_frame( f, scratch );
+    }
+    double arena_ms = FrameStatsNow() - start;
+    unsigned long arena_allocs = HeapAllocationCount() - allocs;
+
+    printf( "frames:                %d\n", frames );
+    printf( "heap scratch:          %.3f us/frame, %.2f allocs/frame\n",
+	    heap_ms * 1.0e3 / frames, (double) heap_allocs / frames );
+    printf( "arena scratch:         %.3f us/frame, %.2f allocs/frame"
+	    " (%lu KB, %lu blocks ever)\n", arena_ms * 1.0e3 / frames,
+	    (double) arena_allocs / frames, (unsigned long) frame.capacity() / 1024,
+	    frame.blocks_allocated() );
+
+    // Mesh building: the 10-cube's faces as triangles, no reserve()
+    Polytope cube;
+    MakePolytope( cube, POLYTOPE_HYPERCUBE, 10 );
+    int corners = cube.face_count() * 6;
+
+    allocs = HeapAllocationCount();
+    start = FrameStatsNow();
+    {
+	std::vector<vec4> points;
+	for ( int i = 0; i < corners; ++i )
+	    points.push_back( vec4( i, 0.0, 0.0, 1.0 ) );
+	sum += points[corners - 1].x;
+    }
+    double vector_ms = FrameStatsNow() - start;
+    unsigned long vector_allocs = HeapAllocationCount() - allocs;
+
+    Arena mesh;
+    for ( int pass = 0; pass < 2; ++pass ) {
+	mesh.reset();
+	allocs = HeapAllocationCount();
+	start = FrameStatsNow();
+	ArenaArray<vec4> points( mesh );
+	for ( int i = 0; i < corners; ++i )
+	    points.push_back( vec4( i, 0.0, 0.0, 1.0 ) );
+	sum += points[corners - 1].x;
+    }
+    double arena_mesh_ms = FrameStatsNow() - start;
+    unsigned long arena_mesh_allocs = HeapAllocationCount() - allocs;
+
+    printf( "10-cube mesh:          %d triangle corners\n", corners );
+    printf( "  std::vector:         %.3f ms, %lu allocs\n", vector_ms, vector_allocs );
+    printf( "  ArenaArray rebuilt:  %.3f ms, %lu allocs\n", arena_mesh_ms,
+	    arena_mesh_allocs );
+    printf( "checksum:              %g\n", sum );
+
+    // Steady state must not touch the heap
+    return arena_allocs == 0 && arena_mesh_allocs == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-meshio:  loading meshes from a text format (one vertex, edge or
+//    triangle per line), from the mesh file format read into arrays, and
+//    from the same file memory-mapped.  Each load ends with a pass over
+//    all of the data, as an upload would make.
+//
+
+struct BenchMesh {
+    int                         dimension;
+    std::vector<GLfloat>        positions;
+    std::vector<PolytopeIndex>  edges;
+    std::vector<PolytopeIndex>  triangles;
+};
+
+static bool
+write_text_mesh( const char* filename, const MeshFile& m )
+{
+    FILE* fp = fopen( filename, "w" );
+    if ( fp == NULL )
+	return false;
+
+    const MeshFileSection* p = m.find( MESH_POSITIONS );
+    const MeshFileSection* e = m.find( MESH_EDGES );
+    const MeshFileSection* t = m.find( MESH_TRIANGLES );
+    const GLfloat* x = (const GLfloat*) m.data( p );
+    const PolytopeIndex* ei = (const PolytopeIndex*) m.data( e );
+    const PolytopeIndex* ti = (const PolytopeIndex*) m.data( t );
+
+    fprintf( fp, "%d %lu %lu %lu\n", m.dimension(), (unsigned long) p->count,
+	     (unsigned long) e->count, (unsigned long) t->count );
+    for ( uint64_t v = 0; v < p->count; ++v ) {
+	for ( int k = 0; k < m.dimension(); ++k )
+	    fprintf( fp, k ? " %.9g" : "%.9g", x[v*m.dimension() + k] );
+	fputc( '\n', fp );
+    }
+    for ( uint64_t i = 0; i < e->count; ++i )
+	fprintf( fp, "%d %d\n", ei[2*i], ei[2*i+1] );
+    for ( uint64_t i = 0; i < t->count; ++i )
+	fprintf( fp, "%d %d %d\n", ti[3*i], ti[3*i+1], ti[3*i+2] );
+    return fclose( fp ) == 0;
+}
+
+static bool
+read_text_mesh( const char* filename, BenchMesh& mesh )
+{
+    FILE* fp = fopen( filename, "rb" );
+    if ( fp == NULL )
+	return false;
+    fseek( fp, 0L, SEEK_END );
+    long size = ftell( fp );
+    fseek( fp, 0L, SEEK_SET );
+    std::vector<char> text( size + 1 );
+    bool ok = fread( &text[0], 1, size, fp ) == (size_t) size;
+    fclose( fp );
+    text[size] = '\0';
+
+    char* at = &text[0];
+    mesh.dimension = strtol( at, &at, 10 );
+    long vertices = strtol( at, &at, 10 );
+    long edges = strtol( at, &at, 10 );
+    long triangles = strtol( at, &at, 10 );
+
+    mesh.positions.resize( vertices * mesh.dimension );
+    for ( size_t i = 0; i < mesh.positions.size(); ++i )
+	mesh.positions[i] = strtof( at, &at );
+    mesh.edges.resize( 2*edges );
+    for ( size_t i = 0; i < mesh.edges.size(); ++i )
+	mesh.edges[i] = (PolytopeIndex) strtol( at, &at, 10 );
+    mesh.triangles.resize( 3*triangles );
+    for ( size_t i = 0; i < mesh.triangles.size(); ++i )
+	mesh.triangles[i] = (PolytopeIndex) strtol( at, &at, 10 );
+    return ok;
+}
+
+//  The mesh file read into arrays with fread(), as the Wythoff cache does
+static bool
+read_binary_mesh( const char* filename, BenchMesh& mesh )
+{
+    FILE* fp = fopen( filename, "rb" );
+    if ( fp == NULL )
+	return false;
+
+    MeshFileHeader h;
+    std::vector<MeshFileSection> table;
+    bool ok = fread( &h, sizeof(h), 1, fp ) == 1;
+    if ( ok ) {
+	table.resize( h.sections );
+	ok = fread( &table[0], sizeof(MeshFileSection), h.sections, fp ) == h.sections;
+    }
+    mesh.dimension = h.dimension;
+    for ( size_t i = 0; ok && i < table.size(); ++i ) {
+	void* to;
+	if ( table[i].kind == MESH_POSITIONS ) {
+	    mesh.positions.resize( table[i].count * table[i].group );
+	    to = &mesh.positions[0];
+	} else if ( table[i].kind == MESH_EDGES ) {
+	    mesh.edges.resize( table[i].count * 2 );
+	    to = &mesh.edges[0];
+	} else if ( table[i].kind == MESH_TRIANGLES ) {
+	    mesh.triangles.resize( table[i].count * 3 );
+	    to = &mesh.triangles[0];
+	} else
+	    continue;
+	ok = fseek( fp, (long) table[i].offset, SEEK_SET ) == 0
+	    && fread( to, 1, table[i].bytes(), fp ) == table[i].bytes();
+    }
+    fclose( fp );
+    return ok;
+}
+
+//  A pass over the data; also checks that every way read the same
+static double
+mesh_checksum( const GLfloat* x, size_t xs, const PolytopeIndex* e, size_t es,
+	       const PolytopeIndex* t, size_t ts )
+{
+    double sum = 0.0;
+    for ( size_t i = 0; i < xs; ++i ) sum += x[i] * (i % 7 + 1);
+    for ( size_t i = 0; i < es; ++i ) sum += e[i];
+    for ( size_t i = 0; i < ts; ++i ) sum += 3.0 * t[i];
+    return sum;
+}
+
+static double
+mesh_checksum( const BenchMesh& m )
+{
+    return mesh_checksum( m.positions.data(), m.positions.size(), m.edges.data(),
+			  m.edges.size(), m.triangles.data(), m.triangles.size() );
+}
+
+static int
+bench_meshio()
+{
+    static const char* names[] = {
+	"tesseract", "120-cell", "600-cell", "omnitruncated-120-cell", "10-cube"
+    };
+    const char* binary = "meshio-bench.m4d";
+    const char* text = "meshio-bench.txt";
+    const int passes = 20;
+
+    printf( "%-24s %8s %9s %9s %9s %9s %9s\n", "mesh", "verts", "text KB",
+	    "file KB", "text ms", "fread ms", "mmap ms" );
+
+    for ( size_t n = 0; n < sizeof(names)/sizeof(names[0]); ++n ) {
+	bool ok;
+	if ( strcmp( names[n], "10-cube" ) == 0 ) {
+	    Polytope cube;
+	    MakePolytope( cube, POLYTOPE_HYPERCUBE, 10 );
+	    ok = SavePolytopeMeshFile( cube, binary );
+	} else {
+	    WythoffSymbol symbol;
+	    WythoffMesh mesh;
+	    ok = WythoffSymbolFromName( names[n], symbol )
+		&& MakeWythoff( mesh, symbol ) && SaveWythoffMeshFile( mesh, binary );
+	}
+
+	MeshFile file;
+	ok = ok && file.open( binary ) && write_text_mesh( text, file );
+	int vertices = file.vertex_count();
+	file.close();
+	if ( !ok )
+	    return EXIT_FAILURE;
+
+	double sums[3] = { 0.0, 0.0, 0.0 };
+	double start = FrameStatsNow();
+	for ( int p = 0; p < passes; ++p ) {
+	    BenchMesh m;
+	    read_text_mesh( text, m );
+	    sums[0] = mesh_checksum( m );
+	}
+	double text_ms = (FrameStatsNow() - start) / passes;
+
+	start = FrameStatsNow();
+	for ( int p = 0; p < passes; ++p ) {
+	    BenchMesh m;
+	    read_binary_mesh( binary, m );
+	    sums[1] = mesh_checksum( m );
+	}
+	double fread_ms = (FrameStatsNow() - start) / passes;
+
+	size_t file_bytes = 0;
+	start = FrameStatsNow();
+	for ( int p = 0; p < passes; ++p ) {
+	    MeshFile m;
+	    m.open( binary );
+	    const MeshFileSection* x = m.find( MESH_POSITIONS );
+	    const MeshFileSection* e = m.find( MESH_EDGES );
+	    const MeshFileSection* t = m.find( MESH_TRIANGLES );
+	    sums[2] = mesh_checksum( (const GLfloat*) m.data( x ), x->count * x->group,
+				     (const PolytopeIndex*) m.data( e ), e->count * 2,
+				     (const PolytopeIndex*) m.data( t ), t->count * 3 );
+	    file_bytes = m.file_size();
+	}
+	double mmap_ms = (FrameStatsNow() - start) / passes;
+
+	FILE* fp = fopen( text, "rb" );
+	fseek( fp, 0L, SEEK_END );
+	long text_bytes = ftell( fp );
+	fclose( fp );
+	remove( text );
+	remove( binary );
+
+	// Text keeps 9 significant digits, so floats come back exactly
+	if ( sums[0] != sums[2] || sums[1] != sums[2] )
+	    return EXIT_FAILURE;
+
+	printf( "%-24s %8d %9.1f %9.1f %9.3f %9.3f %9.3f\n", names[n],
+		vertices, text_bytes / 1024.0, file_bytes / 1024.0, text_ms, fread_ms, mmap_ms );
+    }
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-volume [size]:  playing a time-varying size^3 volume at 60
+//    frames a second, read on the frame (a blocking fread every frame)
+//    against streamed by VolumeStream, with a copy of each frame standing
+//    in for the texture upload.  The file has just been written, so it
+//    is mostly in the page cache; a cold disk only widens the gap.
+//
+
+static int
+bench_volume( int size )
+{
+    const char* name = "volume-bench.raw";
+    const int frames = 96, shown = 240;
+    const double frame_ms = 1000.0 / 60.0;
+
+    if ( size < 1 || !WriteTestVolume( name, size, frames ) )
+	return EXIT_FAILURE;
+    size_t bytes = (size_t) size * size * size;
+    std::vector<unsigned char> upload( bytes );
+
+    printf( "%d frames of %d^3 (%.1f MB), %d shown at 60 fps\n", frames, size,
+	    frames * bytes / 1048576.0, shown );
+    printf( "%-10s %12s %8s %10s %8s\n", "", "frame ms", "misses", "read MB/s", "fps" );
+
+    // On the frame: the render thread waits for each read
+    FILE* fp = fopen( name, "rb" );
+    double wait_ms = 0.0;
+    double start = FrameStatsNow();
+    for ( int i = 0; i < shown; ++i ) {
+	double t = FrameStatsNow();
+	fseek( fp, (long) ((i % frames) * bytes), SEEK_SET );
+	if ( fread( &upload[0], 1, bytes, fp ) != bytes ) {
+	    fclose( fp );
+	    remove( name );
+	    return EXIT_FAILURE;
+	}
+	wait_ms += FrameStatsNow() - t;
+	double next = start + (i + 1) * frame_ms;
+	double now = FrameStatsNow();
+	if ( now < next )
+	    std::this_thread::sleep_for( std::chrono::duration<double, std::milli>( next - now ) );
+    }
+    double elapsed = FrameStatsNow() - start;
+    fclose( fp );
+    printf( "%-10s %12.3f %8d %10.1f %8.1f\n", "fread", wait_ms / shown, 0,
+	    shown * bytes / wait_ms / 1000.0, shown * 1000.0 / elapsed );
+
+    // Streamed: the render thread only copies what has been read
+    VolumeStream stream;
+    if ( !stream.open( name, size, size, size ) ) {
+	remove( name );
+	return EXIT_FAILURE;
+    }
+    double copy_ms = 0.0;
+    start = FrameStatsNow();
+    for ( int i = 0; i < shown; ++i ) {
+	int f = i % frames;
+	stream.seek( f );
+	double t = FrameStatsNow();
+	const unsigned char* voxels = stream.acquire( f );
+	if ( voxels ) {
+	    memcpy( &upload[0], voxels, bytes );
+	    stream.release( f );
+	}
+	copy_ms += FrameStatsNow() - t;
+	double next = start + (i + 1) * frame_ms;
+	double now = FrameStatsNow();
+	if ( now < next )
+	    std::this_thread::sleep_for( std::chrono::duration<double, std::milli>( next - now ) );
+    }
+    elapsed = FrameStatsNow() - start;
+    VolumeStreamStats vs = stream.stats();
+    stream.close();
+    remove( name );
+
+    printf( "%-10s %12.3f %8lu %10.1f %8.1f\n", "stream", copy_ms / shown, vs.misses,
+	    vs.read_ms > 0.0 ? vs.bytes_read / vs.read_ms / 1000.0 : 0.0,
+	    shown * 1000.0 / elapsed );
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-points [points]:  the point cloud against the naive layout (a
+//    vec4 position and a vec4 color per point): build time, bytes per
+//    point, quantization error, and points per second through the vertex
+//    work -- fetch, unpack, rotate and project -- done on the CPU.  Then
+//    how much of the cloud chunk culling drops from a view close in.
+//
+
+//  Both loops end in the same sum over the projected points and colors
+static double
+transform_naive( const Projector& pr, const vec4* positions, const vec4* colors,
+		 int count )
+{
+    const GLfloat* m = pr.matrix();
+    const GLfloat* t = pr.offset();
+    double sum = 0.0;
+    for ( int i = 0; i < count; ++i ) {
+	const vec4& p = positions[i];
+	GLfloat x[4];
+	for ( int r = 0; r < 4; ++r )
+	    x[r] = m[4*r]*p.x + m[4*r+1]*p.y + m[4*r+2]*p.z + m[4*r+3]*p.w + t[r];
+	GLfloat w = x[3] + 1.0f;
+	sum += (x[0] + x[1] + x[2]) * w + colors[i].x + colors[i].y + colors[i].z;
+    }
+    return sum;
+}
+
+static double
+transform_quantized( const Projector& pr, const PointCloud& cloud )
+{
+    const GLfloat* m = pr.matrix();
+    const GLfloat* t = pr.offset();
+    const GLushort* q = cloud.quantized_positions();
+    const GLubyte* rgba = (const GLubyte*) cloud.packed_colors();
+    double sum = 0.0;
+    for ( int c = 0; c < cloud.chunk_count(); ++c ) {
+	const PointChunk& chunk = cloud.chunk( c );
+	GLfloat step[4];
+	for ( int k = 0; k < 4; ++k )
+	    step[k] = chunk.extent[k] / 65535.0f;
+	for ( int i = chunk.first; i < chunk.first + chunk.count; ++i ) {
+	    GLfloat p[4];
+	    for ( int k = 0; k < 4; ++k )
+		p[k] = chunk.lo[k] + q[4*i + k] * step[k];
+	    GLfloat x[4];
+	    for ( int r = 0; r < 4; ++r )
+		x[r] = m[4*r]*p[0] + m[4*r+1]*p[1] + m[4*r+2]*p[2] + m[4*r+3]*p[3] + t[r];
+	    GLfloat w = x[3] + 1.0f;
+	    sum += (x[0] + x[1] + x[2]) * w
+		+ (rgba[4*i] + rgba[4*i+1] + rgba[4*i+2]) / 255.0f;
+	}
+    }
+    return sum;
+}
+
+static int
+bench_points( int count )
+{
+    if ( count < 1 )
+	return EXIT_FAILURE;
+
+    std::vector<GLfloat> positions;
+    std::vector<GLubyte> colors;
+    MakeTestPointCloud( positions, colors, count );
+
+    double start = FrameStatsNow();
+    PointCloud cloud;
+    cloud.build( &positions[0], &colors[0], count );
+    double build_ms = FrameStatsNow() - start;
+
+    std::vector<vec4> naive( count ), naive_colors( count );
+    for ( int i = 0; i < count; ++i ) {
+	naive[i] = vec4( positions[4*i], positions[4*i+1], positions[4*i+2],
+			 positions[4*i+3] );
+	naive_colors[i] = vec4( colors[4*i] / 255.0, colors[4*i+1] / 255.0,
+				colors[4*i+2] / 255.0, 1.0 );
+    }
+
+    GLfloat angles[6] = { 10.0, 20.0, 30.0, 40.0, 50.0, 60.0 };
+    Projector pr;
+    pr.set_vertices( 4, NULL, 0 );
+    pr.set_rotation( angles, 1.0 );
+
+    const int passes = 1 + 20000000 / count;
+    double sums[2] = { 0.0, 0.0 };
+    start = FrameStatsNow();
+    for ( int p = 0; p < passes; ++p )
+	sums[0] += transform_naive( pr, &naive[0], &naive_colors[0], count );
+    double naive_ms = (FrameStatsNow() - start) / passes;
+
+    start = FrameStatsNow();
+    for ( int p = 0; p < passes; ++p )
+	sums[1] += transform_quantized( pr, cloud );
+    double quantized_ms = (FrameStatsNow() - start) / passes;
+
+    printf( "%d points in %d chunks, built in %.1f ms, max error %.2g\n", count,
+	    cloud.chunk_count(), build_ms, cloud.max_error() );
+    printf( "%-10s %12s %10s %12s\n", "", "bytes/point", "MB", "M points/s" );
+    printf( "%-10s %12d %10.1f %12.1f\n", "vec4", PointCloudNaiveBytesPerPoint,
+	    (double) count * PointCloudNaiveBytesPerPoint / 1048576.0,
+	    count / naive_ms / 1000.0 );
+    printf( "%-10s %12d %10.1f %12.1f\n", "quantized", PointCloudBytesPerPoint,
+	    (double) count * PointCloudBytesPerPoint / 1048576.0,
+	    count / quantized_ms / 1000.0 );
+
+    // Zooming in on the edge of the cloud from outside it
+    std::vector<int> visible( cloud.chunk_count() );
+    mat4 view = LookAt( vec4( 2.5, 0.5, 0.0, 1.0 ), vec4( 0.6, 0.0, 0.0, 1.0 ),
+			vec4( 0.0, 1.0, 0.0, 0.0 ) );
+    for ( GLfloat fovy = 60.0; fovy > 4.0; fovy *= 0.5 ) {
+	mat4 clip = Perspective( fovy, 1.0, 0.1, 10.0 ) * view;
+	start = FrameStatsNow();
+	int n = cloud.cull( pr.matrix(), pr.offset(), clip, &visible[0] );
+	double cull_ms = FrameStatsNow() - start;
+	int points = 0;
+	for ( int i = 0; i < n; ++i )
+	    points += cloud.chunk( visible[i] ).count;
+	printf( "fovy %4.1f:  %d of %d chunks, %.1f%% of the points, in %.3f ms\n",
+		fovy, n, cloud.chunk_count(), 100.0 * points / count, cull_ms );
+    }
+
+    // The sums differ only by the quantization error
+    return fabs( sums[0] - sums[1] ) <= 1.0e-3 * fabs( sums[0] ) + 1.0
+	? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-vertex [objects]:  size of the solid mesh in each vertex layout,
+//    the vertex data fetched per frame to draw it once per object, the
+//    time to pack it, and the largest position error of half floats.
+//    The meshes are built the way the program builds them: the fanned
+//    2-faces, with a shade per face.
+//
+
+struct BenchSoup {
+    const char*        name;
+    std::vector<vec4>  points;
+    std::vector<vec4>  shades;
+};
+
+static void
+wythoff_soup( const WythoffMesh& mesh, BenchSoup& soup )
+{
+    for ( int f = 0; f < mesh.face_count(); ++f ) {
+	const PolytopeIndex* corner = &mesh.face_indices[mesh.face_start[f]];
+	int corners = mesh.face_start[f+1] - mesh.face_start[f];
+	vec4 shade = FaceColors[corners % 24];
+	shade.w = FaceShadeAlpha;
+	for ( int i = 1; i + 1 < corners; ++i ) {
+	    int c[3] = { corner[0], corner[i], corner[i+1] };
+	    for ( int k = 0; k < 3; ++k ) {
+		const GLfloat* p = &mesh.positions[4 * c[k]];
+		soup.points.push_back( 0.6 * vec4( p[0], p[1], p[2], p[3] ) );
+		soup.shades.push_back( shade );
+	    }
+	}
+    }
+}
+
+static int
+bench_vertex( int objects )
+{
+    static const char* names[] = { "120-cell", "omnitruncated-120-cell" };
+    std::vector<BenchSoup> soups( 1 + sizeof(names)/sizeof(names[0]) );
+    soups[0].name = "tesseract";
+    soups[0].points.assign( TesseractMesh.points,
+			    TesseractMesh.points + TesseractMesh.TriangleVertexCount );
+    soups[0].shades.assign( TesseractMesh.shades,
+			    TesseractMesh.shades + TesseractMesh.TriangleVertexCount );
+    for ( size_t n = 0; n < sizeof(names)/sizeof(names[0]); ++n ) {
+	WythoffSymbol symbol;
+	WythoffMesh mesh;
+	if ( !WythoffSymbolFromName( names[n], symbol ) || !MakeWythoff( mesh, symbol ) )
+	    return EXIT_FAILURE;
+	soups[n+1].name = names[n];
+	wythoff_soup( mesh, soups[n+1] );
+    }
+
+    static const SolidVertexFormat formats[] = { SOLID_VEC4, SOLID_PACKED, SOLID_HALF };
+    static const char* format_names[] = { "vec4", "packed", "half" };
+
+    printf( "%d objects a frame\n", objects );
+    printf( "%-24s %-7s %8s %6s %10s %12s %10s %11s\n", "mesh", "format", "verts",
+	    "bytes", "buffer KB", "fetch MB/f", "pack ms", "max error" );
+    for ( size_t n = 0; n < soups.size(); ++n ) {
+	const BenchSoup& soup = soups[n];
+	int count = (int) soup.points.size();
+	for ( int f = 0; f < 3; ++f ) {
+	    int size = SolidVertexSize( formats[f] );
+	    double pack_ms = 0.0, error = 0.0;
+	    if ( formats[f] != SOLID_VEC4 ) {
+		std::vector<unsigned char> packed( (size_t) count * size );
+		vec4 palette[MaxPaletteColors];
+		double start = FrameStatsNow();
+		if ( PackSolidMesh( formats[f], &soup.points[0], &soup.shades[0], count,
+				    &packed[0], palette ) < 0 )
+		    return EXIT_FAILURE;
+		pack_ms = FrameStatsNow() - start;
+
+		if ( formats[f] == SOLID_HALF )
+		    for ( int i = 0; i < count; ++i ) {
+			const HalfVertex& v = ((const HalfVertex*) &packed[0])[i];
+			for ( int k = 0; k < 4; ++k )
+			    error = std::max( error, (double) fabs( HalfToFloat( v.position[k] )
+								    - soup.points[i][k] ) );
+		    }
+	    }
+	    printf( "%-24s %-7s %8d %6d %10.1f %12.2f %10.3f %11.2g\n",
+		    f == 0 ? soup.name : "", format_names[f], count, size,
+		    (double) count * size / 1024.0,
+		    (double) objects * count * size / 1048576.0, pack_ms, error );
+	}
+    }
+
+    // Every half float goes back and forth exactly
+    for ( GLuint h = 0; h < 0x10000; ++h ) {
+	GLushort x = (GLushort) h;
+	bool nan = (x & 0x7c00) == 0x7c00 && (x & 0x3ff) != 0;
+	if ( !nan && FloatToHalf( HalfToFloat( x ) ) != x )
+	    return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-pull [objects]:  what a frame of "objects" tesseracts costs in
+//    vertex data and draw calls drawn one object at a time, instanced
+//    from the buffers (-instanced), and instanced with the vertices
+//    pulled from gl_VertexID (-pull).  The GPU time is measured by
+//    running -bench with each; this checks the pulled vertices -- found
+//    the way vshader_instanced.glsl finds them -- against the buffers,
+//    and times packing the instance data.
+//
+
+static vec4
+pulled_vertex( int id, bool lines )
+{
+    static const int quad_corner[6] = { 0, 1, 3, 3, 1, 2 };
+    if ( lines )
+	return TesseractMesh.vertices[TesseractMesh.edges[id / 2][id % 2]];
+    return TesseractMesh.vertices[TesseractQuads.faces[id / 6][quad_corner[id % 6]]];
+}
+
+static int
+bench_pull( int objects )
+{
+    for ( int id = 0; id < TesseractMesh.LineVertexCount; ++id ) {
+	vec4 v = pulled_vertex( id, true );
+	if ( memcmp( &v, &TesseractMesh.lines[id], sizeof(vec4) ) != 0 )
+	    return EXIT_FAILURE;
+    }
+    for ( int id = 0; id < TesseractMesh.TriangleVertexCount; ++id ) {
+	vec4 v = pulled_vertex( id, false );
+	if ( memcmp( &v, &TesseractMesh.points[id], sizeof(vec4) ) != 0 )
+	    return EXIT_FAILURE;
+    }
+
+    // Solid: a position and a shade per vertex; wireframe: a position
+    double mesh_bytes = TesseractMesh.TriangleVertexCount * 2.0 * sizeof(vec4)
+	+ TesseractMesh.LineVertexCount * sizeof(vec4);
+    double instance_bytes = 24 * sizeof(GLfloat);
+
+    Scene scene;
+    GLfloat velocity[NumPlanes] = { 6.0, 12.0, 18.0, 30.0, 42.0, 66.0 };
+    PopulateScene( scene, objects, velocity );
+    int n = scene.size();
+    std::vector<GLfloat> data( 24 * n );
+    const int passes = 1 + 10000000 / (n * 24);
+    double start = FrameStatsNow();
+    for ( int p = 0; p < passes; ++p )
+	for ( int i = 0; i < n; ++i ) {
+	    GLfloat* d = &data[24 * i];
+	    for ( int k = 0; k < 4; ++k ) {
+		d[k] = scene.center[k][i];
+		d[4+k] = scene.color[k][i];
+	    }
+	    d[8] = scene.scale[i];
+	    for ( int k = 0; k < 6; ++k ) {
+		d[12+k] = sin( scene.angle[k][i] * DegreesToRadians );
+		d[18+k] = cos( scene.angle[k][i] * DegreesToRadians );
+	    }
+	}
+    double pack_ms = (FrameStatsNow() - start) / passes;
+
+    printf( "%d objects, %d vertices each (pulled vertices match the buffers)\n", n,
+	    TesseractMesh.TriangleVertexCount + TesseractMesh.LineVertexCount );
+    printf( "%-12s %12s %14s %16s\n", "", "draw calls", "vertex MB/f", "instance KB/f" );
+    printf( "%-12s %12d %14.2f %16.1f\n", "per object", 2 * n,
+	    n * mesh_bytes / 1048576.0, 0.0 );
+    printf( "%-12s %12d %14.2f %16.1f\n", "instanced", 2,
+	    n * mesh_bytes / 1048576.0, n * instance_bytes / 1024.0 );
+    printf( "%-12s %12d %14.2f %16.1f\n", "pulled", 2, 0.0, n * instance_bytes / 1024.0 );
+    printf( "instance data packed in %.3f ms/frame\n", pack_ms );
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-cull [objects]:  SceneCuller over a scene of "objects"
+//    tesseracts, one in eight pushed behind the projection (w + 1 < 0),
+//    from views outside and inside it.  The hierarchy, the flat SSE loop
+//    and the scalar loop must find the same objects.  Then 1% of the
+//    objects move each frame and the tree is refitted.
+//
+
+static int
+bench_cull( int objects )
+{
+    Scene scene;
+    GLfloat velocity[NumPlanes] = { 6.0, 12.0, 18.0, 30.0, 42.0, 66.0 };
+    PopulateScene( scene, objects, velocity );
+    int n = scene.size();
+
+    std::vector<GLfloat> centers( 4 * n );
+    for ( int i = 0; i < n; ++i ) {
+	for ( int k = 0; k < 4; ++k )
+	    centers[4*i + k] = scene.center[k][i];
+	if ( i % 8 == 7 )
+	    centers[4*i + 3] = -1.5;
+    }
+
+    // The tesseract's vertices are (+-0.5)^4
+    const GLfloat mesh_radius = 1.0;
+    SceneCuller culler;
+    double start = FrameStatsNow();
+    culler.update( &centers[0], &scene.scale[0], n, mesh_radius );
+    double build_ms = FrameStatsNow() - start;
+
+    struct View {
+	const char*  name;
+	vec4         eye, at;
+	GLfloat      fovy, z_near;
+    };
+    static const View views[] = {
+	{ "outside",  vec4( 0.0, 0.5, 2.0, 1.0 ), vec4( 0.0, 0.0, 0.0, 1.0 ), 45.0, 0.5 },
+	{ "corner",   vec4( 1.5, 1.5, 1.5, 1.0 ), vec4( 0.0, 0.0, 0.0, 1.0 ), 20.0, 0.5 },
+	{ "inside",   vec4( 0.0, 0.0, 0.0, 1.0 ), vec4( 1.0, 0.0, 0.0, 1.0 ), 45.0, 0.05 },
+	{ "narrow",   vec4( -0.7, -0.7, 0.0, 1.0 ), vec4( 1.0, 0.3, 0.2, 1.0 ), 7.5, 0.05 },
+	{ "away",     vec4( 0.0, 0.0, 2.0, 1.0 ), vec4( 0.0, 0.0, 4.0, 1.0 ), 45.0, 0.5 }
+    };
+
+    std::vector<int> bvh( n ), flat( n ), scalar( n );
+    const int passes = 1 + 20000000 / n;
+    printf( "%d objects, %d nodes, built in %.3f ms\n", n, culler.node_count(), build_ms );
+    printf( "%-10s %9s %9s %10s %10s %10s\n", "view", "visible", "nodes",
+	    "bvh ms", "sse ms", "scalar ms" );
+    for ( size_t v = 0; v < sizeof(views) / sizeof(views[0]); ++v ) {
+	const View& view = views[v];
+	mat4 clip = Perspective( view.fovy, 1.0, view.z_near, 3.0 )
+	    * LookAt( view.eye, view.at, vec4( 0.0, 1.0, 0.0, 0.0 ) );
+
+	int b = 0, f = 0, s = 0;
+	start = FrameStatsNow();
+	for ( int p = 0; p < passes; ++p )
+	    b = culler.cull( clip, &bvh[0] );
+	double bvh_ms = (FrameStatsNow() - start) / passes;
+	start = FrameStatsNow();
+	for ( int p = 0; p < passes; ++p )
+	    f = culler.cull_flat( clip, &flat[0] );
+	double flat_ms = (FrameStatsNow() - start) / passes;
+	start = FrameStatsNow();
+	for ( int p = 0; p < passes; ++p )
+	    s = culler.cull_scalar( clip, &scalar[0] );
+	double scalar_ms = (FrameStatsNow() - start) / passes;
+
+	std::sort( bvh.begin(), bvh.begin() + b );
+	if ( b != s || f != s || !std::equal( bvh.begin(), bvh.begin() + b, scalar.begin() )
+	     || !std::equal( flat.begin(), flat.begin() + f, scalar.begin() ) ) {
+	    printf( "%s: the culled lists differ (%d, %d, %d)\n", view.name, b, f, s );
+	    return EXIT_FAILURE;
+	}
+	printf( "%-10s %9d %9d %10.4f %10.4f %10.4f\n", view.name, b,
+		culler.stats().nodes_visited, bvh_ms, flat_ms, scalar_ms );
+    }
+
+    // A hundredth of the objects drift each frame
+    const int frames = 200;
+    const int step = 100;
+    double refit_ms = 0.0;
+    for ( int frame = 0; frame < frames; ++frame ) {
+	for ( int i = frame % step; i < n; i += step )
+	    centers[4*i] += 0.001f;
+	start = FrameStatsNow();
+	culler.update( &centers[0], &scene.scale[0], n, mesh_radius );
+	refit_ms += FrameStatsNow() - start;
+    }
+    printf( "refit, %d objects moved: %.4f ms/frame (rebuild %.3f ms)\n",
+	    culler.stats().refitted, refit_ms / frames, build_ms );
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-lod [objects]:  the curved surfaces' level of detail chains,
+//    built on one thread and on all of them, and checked: a level drawn
+//    fully morphed must be the next level.  Then the triangles a frame
+//    and the time to pick levels for growing scenes of glomes, with and
+//    without a budget of 200,000 triangles.
+//
+
+//  Level "level" morphed all the way is the next level: the corners of
+//    each coarser cell stay where the coarser level has them, and every
+//    other vertex goes to the middle of the coarser edge it splits
+static bool
+check_morphs( const SurfaceMesh& mesh, int level )
+{
+    const SurfaceLevel& fine = mesh.level( level );
+    const SurfaceLevel& coarse = mesh.level( level + 1 );
+    int row = fine.segments + 1, coarse_row = coarse.segments + 1;
+    for ( int k = 0; k < fine.vertex_count; ++k ) {
+	int sheet = k / (row * row), i = k % row, j = k / row % row;
+	int di = i & 1, dj = j & 1;
+	const vec4* corners = &mesh.positions[coarse.first_vertex
+					      + sheet * coarse_row * coarse_row];
+	vec4 target = 0.5 * (corners[(j - dj)/2 * coarse_row + (i - di)/2]
+			     + corners[(j + dj)/2 * coarse_row + (i + di)/2]);
+	if ( length( mesh.morphs[fine.first_vertex + k] - target ) > 1.0e-6 )
+	    return false;
+    }
+    return true;
+}
+
+static int
+bench_lod( int max_objects )
+{
+    JobSystem jobs;
+    printf( "%-12s %8s %10s %10s %10s  (%d threads)\n", "surface", "levels",
+	    "triangles", "serial ms", "jobs ms", jobs.threads() );
+    for ( int f = 0; f < SURFACE_NUM_FAMILIES; ++f ) {
+	SurfaceMesh serial, parallel;
+	double start = FrameStatsNow();
+	serial.build( SurfaceFamily( f ), 64, 5 );
+	double serial_ms = FrameStatsNow() - start;
+	start = FrameStatsNow();
+	parallel.build( SurfaceFamily( f ), 64, 5, &jobs );
+	double jobs_ms = FrameStatsNow() - start;
+
+	if ( serial.positions.size() != parallel.positions.size()
+	     || memcmp( serial.positions.data(), parallel.positions.data(),
+			serial.positions.size() * sizeof(vec4) ) != 0
+	     || serial.triangles != parallel.triangles ) {
+	    printf( "%s: the parallel build differs\n", SurfaceFamilyName( SurfaceFamily( f ) ) );
+	    return EXIT_FAILURE;
+	}
+	for ( int l = 0; l + 1 < serial.level_count(); ++l )
+	    if ( !check_morphs( serial, l ) ) {
+		printf( "%s: level %d doesn't morph onto level %d\n",
+			SurfaceFamilyName( SurfaceFamily( f ) ), l, l + 1 );
+		return EXIT_FAILURE;
+	    }
+	printf( "%-12s %8d %10d %10.3f %10.3f\n", SurfaceFamilyName( SurfaceFamily( f ) ),
+		serial.level_count(), serial.level( 0 ).triangle_count / 3, serial_ms, jobs_ms );
+    }
+
+    SurfaceMesh glome;
+    glome.build( SURFACE_GLOME, 64, 5, &jobs );
+    mat4 mv = LookAt( vec4( 0.0, 0.5, 2.0, 1.0 ), vec4( 0.0, 0.0, 0.0, 1.0 ),
+		      vec4( 0.0, 1.0, 0.0, 0.0 ) );
+    GLfloat pixels = 512 / (2.0 * tan( 45.0 * DegreesToRadians / 2.0 ));
+    GLfloat velocity[NumPlanes] = { 6.0, 12.0, 18.0, 30.0, 42.0, 66.0 };
+
+    printf( "\n%-8s %12s %12s %12s %12s %10s\n", "objects", "full detail",
+	    "triangles", "mean level", "budgeted", "pick ms" );
+    for ( int objects = 1; objects <= max_objects; objects *= 10 ) {
+	Scene scene;
+	PopulateScene( scene, objects, velocity );
+	int n = scene.size();
+	std::vector<GLfloat> centers( 4 * n );
+	std::vector<int> all( n );
+	for ( int i = 0; i < n; ++i ) {
+	    for ( int k = 0; k < 4; ++k )
+		centers[4*i + k] = scene.center[k][i];
+	    all[i] = i;
+	}
+
+	std::vector<ObjectLod> lods( n );
+	int budgeted = ChooseSurfaceLods( glome, &centers[0], &scene.scale[0], &all[0], n,
+					  mv, pixels, 8.0, 200000, &lods[0] );
+	const int passes = 1 + 1000000 / n;
+	int triangles = 0;
+	double start = FrameStatsNow();
+	for ( int p = 0; p < passes; ++p )
+	    triangles = ChooseSurfaceLods( glome, &centers[0], &scene.scale[0], &all[0],
+					   n, mv, pixels, 8.0, 0, &lods[0] );
+	double pick_ms = (FrameStatsNow() - start) / passes;
+
+	double level_sum = 0.0;
+	for ( int i = 0; i < n; ++i )
+	    level_sum += lods[i].level + lods[i].morph;
+	printf( "%-8d %12.0f %12d %12.2f %12d %10.4f\n", n,
+		double( n ) * (glome.level( 0 ).triangle_count / 3), triangles,
+		level_sum / n, budgeted, pick_ms );
+    }
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-adapt [frames]:  the quality controller against a made-up
+//    renderer whose load steps up and back down, once limited by fill on
+//    the GPU and once by draw calls on the CPU.  Each phase should settle
+//    with no decisions in its second half, under the budget.
+//
+
+//  Times of a frame of "objects" tesseracts at the knobs' settings: "fill"
+//    ms of GPU fill at full resolution, "per_object" ms of CPU a pass per
+//    object drawn, all times "noise"
+static void
+model_frame( const QualityKnobs& knobs, int objects, double fill, double per_object,
+	     double noise, double& cpu_ms, double& gpu_ms )
+{
+    int drawn = knobs.object_cap ? std::min( knobs.object_cap, objects ) : objects;
+    double passes = knobs.wireframe ? 2.0 : 1.0;
+    double r = knobs.resolution_scale;
+    gpu_ms = (1.0 + fill*r*r + 0.002*drawn*passes*exp2( -knobs.lod_bias )) * noise;
+    cpu_ms = (1.0 + per_object*drawn*passes) * noise;
+}
+
+static int
+bench_adapt( int frames )
+{
+    struct Scenario {
+	const char*  name;
+	double       fill[3];		// GPU ms at full resolution, per phase
+	double       per_object[3];	// CPU ms per object and pass
+    };
+    static const Scenario scenarios[] = {
+	{ "gpu", { 6.0, 20.0, 6.0 }, { 0.001, 0.001, 0.001 } },
+	{ "cpu", { 4.0, 4.0, 4.0 }, { 0.001, 0.004, 0.001 } }
+    };
+    const int objects = 2000;
+    const double budget = 1000.0 / 60.0;
+    int phase_frames = std::max( frames / 3, 10 * QualityController::Window );
+    int status = EXIT_SUCCESS;
+
+    for ( size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); ++s ) {
+	const Scenario& scenario = scenarios[s];
+	QualityController quality;
+	quality.set_budget( budget );
+	quality.set_object_count( objects );
+	quality.set_log( stdout );
+	printf( "%s bound, %d frames a phase, budget %.2f ms:\n", scenario.name,
+		phase_frames, budget );
+
+	unsigned int seed = 1;
+	for ( int phase = 0; phase < 3; ++phase ) {
+	    int before = quality.decisions(), settled = 0, over = 0;
+	    double cost_sum = 0.0;
+	    for ( int f = 0; f < phase_frames; ++f ) {
+		// +-5% from frame to frame
+		seed = seed * 1103515245u + 12345u;
+		double noise = 0.95 + 0.1 * ((seed >> 16) & 0x7fff) / 32767.0;
+		double cpu_ms, gpu_ms;
+		model_frame( quality.knobs(), objects, scenario.fill[phase],
+			     scenario.per_object[phase], noise, cpu_ms, gpu_ms );
+		quality.update( std::max( cpu_ms, gpu_ms ), cpu_ms, gpu_ms );
+
+		if ( f == phase_frames / 2 )
+		    settled = quality.decisions();
+		if ( f >= phase_frames / 2 ) {
+		    double cost = std::max( cpu_ms, gpu_ms );
+		    cost_sum += cost;
+		    over += cost > budget;
+		}
+	    }
+
+	    char knobs[128];
+	    quality.describe( knobs, sizeof(knobs) );
+	    int late = quality.decisions() - settled;
+	    double tail = phase_frames - phase_frames / 2;
+	    printf( "  phase %d: %d decisions (%d in the second half), then %.2f ms,"
+		    " %.1f%% over budget\n           %s\n", phase,
+		    quality.decisions() - before, late, cost_sum / tail,
+		    100.0 * over / tail, knobs );
+	    if ( late > 0 || cost_sum / tail > budget )
+		status = EXIT_FAILURE;
+	}
+    }
+    if ( status != EXIT_SUCCESS )
+	printf( "a phase didn't settle under the budget\n" );
+    return status;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-impostor [objects]:  the impostor cache over a few seconds,
+//    seen from further and further away as the eye drifts from side to
+//    side, with the objects still and then spinning.  After a second to
+//    fill the atlas, counts the vertices a frame takes with billboards
+//    standing in for the small objects against drawing them all as
+//    meshes.  No two billboards may share a tile.
+//
+
+static int
+bench_impostor( int objects )
+{
+    Scene scenes[2];
+    GLfloat still[NumPlanes] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    GLfloat velocity[NumPlanes] = { 6.0, 12.0, 18.0, 30.0, 42.0, 66.0 };
+    PopulateScene( scenes[0], objects, still );
+    PopulateScene( scenes[1], objects, velocity );
+    int n = scenes[0].size();
+
+    // The tesseract's vertices are (+-0.5)^4, and it is drawn as lines
+    // and triangles; a billboard is a strip of 4
+    const GLfloat mesh_radius = 1.0;
+    const int mesh_vertices = TesseractMesh.LineVertexCount
+	+ TesseractMesh.TriangleVertexCount;
+    const int warmup = 60, frames = 240, tiles = 64 * 64;
+    const GLfloat dt = 1.0 / 60.0;
+
+    std::vector<GLfloat> centers( 4 * n ), sines( 6 * n ), cosines( 6 * n );
+    std::vector<int> visible( n ), owner( tiles );
+    SceneCuller culler;
+
+    printf( "%d objects, %d frames after %d, %d tiles, billboards up to 24 pixels"
+	    " across, 2 degrees, 32 tiles/frame\n", n, frames, warmup, tiles );
+    printf( "%-9s %-9s %8s %10s %8s %8s %8s %8s %9s %10s %10s\n", "objects",
+	    "distance", "visible", "billboards", "meshes", "drawn", "stale", "evicted",
+	    "plan ms", "vertices", "without" );
+    for ( int spin = 0; spin < 2; ++spin )
+    for ( GLfloat distance = 1.0; distance <= 8.0; distance *= 2.0 ) {
+	Scene moving = scenes[spin];
+	ImpostorCache cache;
+	ImpostorPlan plan;
+	cache.reset( tiles, n );
+
+	double billboards = 0.0, meshes = 0.0, drawn = 0.0, stale = 0.0, evicted = 0.0;
+	double shown = 0.0, plan_ms = 0.0, vertices = 0.0, without = 0.0;
+	for ( int f = 0; f < warmup + frames; ++f ) {
+	    moving.update( dt );
+	    for ( int i = 0; i < n; ++i ) {
+		for ( int k = 0; k < 4; ++k )
+		    centers[4*i + k] = moving.center[k][i];
+		for ( int p = 0; p < NumPlanes; ++p ) {
+		    sines[6*i + p] = sin( moving.angle[p][i] * DegreesToRadians );
+		    cosines[6*i + p] = cos( moving.angle[p][i] * DegreesToRadians );
+		}
+	    }
+
+	    // A tenth of the distance to either side every four seconds
+	    GLfloat side = 0.1 * distance * sin( 2.0 * M_PI * f * dt / 4.0 );
+	    mat4 mv = LookAt( vec4( side, 0.0, distance, 1.0 ), vec4( 0.0, 0.0, 0.0, 1.0 ),
+			      vec4( 0.0, 1.0, 0.0, 0.0 ) );
+	    mat4 p = Perspective( 45.0, 1.0, 0.5, distance + 2.0 );
+	    culler.update( &centers[0], &moving.scale[0], n, mesh_radius );
+	    int v = culler.cull( p * mv, &visible[0] );
+
+	    ImpostorView view = { &centers[0], &moving.scale[0], &sines[0], &cosines[0],
+				  mesh_radius, mv,
+				  GLfloat( 512 / (2.0 * tan( 45.0 * DegreesToRadians / 2.0 )) ),
+				  12.0, GLfloat( 2.0 * DegreesToRadians ), 32 };
+	    double start = FrameStatsNow();
+	    cache.plan( view, &visible[0], v, plan );
+	    double ms = FrameStatsNow() - start;
+
+	    std::fill( owner.begin(), owner.end(), -1 );
+	    for ( size_t b = 0; b < plan.billboards.size(); ++b ) {
+		int t = cache.tile( plan.billboards[b] );
+		if ( t < 0 || owner[t] >= 0 ) {
+		    printf( "distance %g, frame %d: billboard %d has tile %d, taken by %d\n",
+			    distance, f, plan.billboards[b], t, t < 0 ? -1 : owner[t] );
+		    return EXIT_FAILURE;
+		}
+		owner[t] = plan.billboards[b];
+	    }
+	    if ( f < warmup )
+		continue;
+
+	    const ImpostorStats& s = cache.stats();
+	    shown += v;
+	    plan_ms += ms;
+	    billboards += s.billboards;
+	    meshes += s.geometry;
+	    drawn += s.captures;
+	    stale += s.stale;
+	    evicted += s.evictions;
+	    vertices += double( s.geometry + s.captures ) * mesh_vertices
+		+ 4.0 * s.billboards;
+	    without += double( v ) * mesh_vertices;
+	}
+	printf( "%-9s %-9g %8.1f %10.1f %8.1f %8.1f %8.1f %8.1f %9.4f %10.0f %10.0f\n",
+		spin ? "spinning" : "still", distance, shown / frames, billboards / frames,
+		meshes / frames, drawn / frames, stale / frames, evicted / frames,
+		plan_ms / frames, vertices / frames, without / frames );
+    }
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+//
+//  -bench-raycast [objects]:  rays cast into the spinning tesseracts a frame
+//    at a time -- a 512x512 view of the scene in 2x2 blocks, and as many
+//    rays from all around it toward random points in it -- one at a time,
+//    in packets of four, and in packets spread over every core.  Every
+//    packet's hit must be the one a ray alone finds, and on the first frame
+//    a sample of them the nearest of all the triangles.
+//
+
+//  Whether two casts found the same thing; the triangles may differ where
+//    two meet, at the same distance
+static bool
+same_hit( const RayHit& a, const RayHit& b )
+{
+    if ( a.object < 0 || b.object < 0 )
+	return a.object == b.object;
+    return (a.object == b.object && a.triangle == b.triangle)
+	|| fabs( a.t - b.t ) <= 1e-5 * a.t;
+}
+
+static int
+bench_raycast( int objects )
+{
+    Scene scene;
+    GLfloat velocity[NumPlanes] = { 6.0, 12.0, 18.0, 30.0, 42.0, 66.0 };
+    PopulateScene( scene, objects, velocity );
+    int n = scene.size();
+    const int size = 512, rays = size * size, frames = 10;
+    const GLfloat dt = 1.0 / 60.0;
+
+    RayCaster serial, caster;
+    serial.set_mesh( TesseractMesh.vertices, TesseractMesh.VertexCount,
+		     &TesseractMesh.triangles[0][0], 2 * TesseractMesh.FaceCount );
+    caster.set_mesh( TesseractMesh.vertices, TesseractMesh.VertexCount,
+		     &TesseractMesh.triangles[0][0], 2 * TesseractMesh.FaceCount );
+    JobSystem jobs;
+
+    // The view from (0, 0, 2.5) with a 45 degree field, and the rays from
+    // a sphere of radius 2
+    std::vector<vec3> origins[2], directions[2];
+    GLfloat half = tan( 45.0 * DegreesToRadians / 2.0 );
+    for ( int y = 0; y < size; y += 2 )
+	for ( int x = 0; x < size; x += 2 )
+	    for ( int k = 0; k < 4; ++k ) {
+		GLfloat px = x + k % 2 + 0.5, py = y + k / 2 + 0.5;
+		origins[0].push_back( vec3( 0.0, 0.0, 2.5 ) );
+		directions[0].push_back( vec3( (2.0*px/size - 1.0) * half,
+					       (2.0*py/size - 1.0) * half, -1.0 ) );
+	    }
+    srand( 1 );
+    for ( int i = 0; i < rays; ++i ) {
+	vec3 from, to;
+	do {
+	    for ( int k = 0; k < 3; ++k )
+		from[k] = 2.0 * rand() / (GLfloat) RAND_MAX - 1.0;
+	} while ( dot( from, from ) < 0.01 || dot( from, from ) > 1.0 );
+	for ( int k = 0; k < 3; ++k )
+	    to[k] = 1.6 * rand() / (GLfloat) RAND_MAX - 0.8;
+	from = 2.0 * normalize( from );
+	origins[1].push_back( from );
+	directions[1].push_back( to - from );
+    }
+
+    std::vector<GLfloat> centers( 4 * n ), sines( 6 * n ), cosines( 6 * n );
+    std::vector<RayHit> alone( rays ), packets( rays ), spread( rays );
+    double serial_ms = 0.0, jobs_ms = 0.0, growth = 0.0;
+    double seconds[2][3] = { { 0.0 } }, hits[2] = { 0.0, 0.0 };
+    int rebuilt = 0, mismatches = 0, checked = 0;
+    for ( int f = 0; f < frames; ++f ) {
+	scene.update( dt );
+	for ( int i = 0; i < n; ++i ) {
+	    for ( int k = 0; k < 4; ++k )
+		centers[4*i + k] = scene.center[k][i];
+	    for ( int p = 0; p < NumPlanes; ++p ) {
+		sines[6*i + p] = sin( scene.angle[p][i] * DegreesToRadians );
+		cosines[6*i + p] = cos( scene.angle[p][i] * DegreesToRadians );
+	    }
+	}
+
+	double start = FrameStatsNow();
+	serial.update( &centers[0], &scene.scale[0], &sines[0], &cosines[0], n );
+	double middle = FrameStatsNow();
+	caster.update( &centers[0], &scene.scale[0], &sines[0], &cosines[0], n, &jobs );
+	double end = FrameStatsNow();
+	if ( f > 0 ) {
+	    serial_ms += middle - start;
+	    jobs_ms += end - middle;
+	    rebuilt += caster.stats().rebuilt;
+	}
+	growth = std::max( growth, double( caster.stats().growth ) );
+
+	for ( int s = 0; s < 2; ++s ) {
+	    const vec3* o = &origins[s][0];
+	    const vec3* d = &directions[s][0];
+	    double t0 = FrameStatsNow();
+	    caster.cast_scalar( o, d, rays, &alone[0] );
+	    double t1 = FrameStatsNow();
+	    caster.cast( o, d, rays, &packets[0] );
+	    double t2 = FrameStatsNow();
+	    jobs.parallel_for( 0, rays / 4, 256, [&]( int first, int last ) {
+		caster.cast( o + 4*first, d + 4*first, 4*(last - first), &spread[4*first] );
+	    } );
+	    double t3 = FrameStatsNow();
+	    seconds[s][0] += (t1 - t0) / 1000.0;
+	    seconds[s][1] += (t2 - t1) / 1000.0;
+	    seconds[s][2] += (t3 - t2) / 1000.0;
+
+	    for ( int r = 0; r < rays; ++r ) {
+		hits[s] += alone[r].object >= 0;
+		if ( !same_hit( alone[r], packets[r] ) || !same_hit( packets[r], spread[r] ) ) {
+		    if ( mismatches++ < 5 )
+			printf( "ray %d: alone %d/%d at %g, packet %d/%d at %g, spread %d/%d\n",
+				r, alone[r].object, alone[r].triangle, alone[r].t,
+				packets[r].object, packets[r].triangle, packets[r].t,
+				spread[r].object, spread[r].triangle );
+		}
+		if ( f == 0 && r % 997 == 0 ) {
+		    RayHit all = caster.cast_brute( o[r], d[r] );
+		    checked++;
+		    if ( !same_hit( all, alone[r] ) && mismatches++ < 5 )
+			printf( "ray %d: alone %d/%d at %g, nearest %d/%d at %g\n",
+				r, alone[r].object, alone[r].triangle, alone[r].t,
+				all.object, all.triangle, all.t );
+		}
+	    }
+	}
+    }
+
+    const RayCastStats& st = caster.stats();
+    printf( "%d objects, %d triangles, %d nodes, %d frames of %d rays a set\n",
+	    n, st.triangles, st.nodes, frames, rays );
+    printf( "update: %.3f ms serial, %.3f ms on %d threads; rebuilt %d of %d frames,"
+	    " boxes grew to %.2f\n", serial_ms / (frames - 1), jobs_ms / (frames - 1),
+	    jobs.threads(), rebuilt, frames - 1, growth );
+    printf( "%-10s %6s %14s %14s %14s\n", "rays", "hit %", "alone Mrays/s",
+	    "packets", "packets+jobs" );
+    const char* names[2] = { "view", "scattered" };
+    for ( int s = 0; s < 2; ++s )
+	printf( "%-10s %6.1f %14.2f %14.2f %14.2f\n", names[s],
+		100.0 * hits[s] / (double( frames ) * rays),
+		frames * rays / seconds[s][0] / 1e6, frames * rays / seconds[s][1] / 1e6,
+		frames * rays / seconds[s][2] / 1e6 );
+    printf( "%d rays checked against every triangle, %d mismatches\n", checked, mismatches );
+    return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+RunBenchmark( int argc, char** argv, int& status )
+{
+    for ( int i = 1; i < argc; ++i ) {
+	const char* arg = i+1 < argc ? argv[i+1] : NULL;
+
+	if ( strcmp( argv[i], "-bench-scene" ) == 0 ) {
+	    status = bench_scene( arg ? atoi( arg ) : 10000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-jobs" ) == 0 ) {
+	    status = bench_jobs( arg ? atoi( arg ) : 100000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-camera" ) == 0 ) {
+	    status = bench_camera( arg ? atoi( arg ) : 1000000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-polytopes" ) == 0 ) {
+	    status = bench_polytopes( arg ? atoi( arg ) : 10 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-wythoff" ) == 0 ) {
+	    status = bench_wythoff();
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-vecmath" ) == 0 ) {
+	    status = bench_vecmath( arg ? atoi( arg ) : 100000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-project" ) == 0 ) {
+	    status = bench_project( arg ? atoi( arg ) : 100000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-arena" ) == 0 ) {
+	    status = bench_arena( arg ? atoi( arg ) : 10000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-meshio" ) == 0 ) {
+	    status = bench_meshio();
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-points" ) == 0 ) {
+	    status = bench_points( arg ? atoi( arg ) : 4000000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-vertex" ) == 0 ) {
+	    status = bench_vertex( arg ? atoi( arg ) : 100 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-pull" ) == 0 ) {
+	    status = bench_pull( arg ? atoi( arg ) : 10000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-lod" ) == 0 ) {
+	    status = bench_lod( arg ? atoi( arg ) : 10000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-impostor" ) == 0 ) {
+	    status = bench_impostor( arg ? atoi( arg ) : 2000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-raycast" ) == 0 ) {
+	    status = bench_raycast( arg ? atoi( arg ) : 1000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-adapt" ) == 0 ) {
+	    status = bench_adapt( arg ? atoi( arg ) : 3000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-cull" ) == 0 ) {
+	    status = bench_cull( arg ? atoi( arg ) : 100000 );
+	    return true;
+	}
+	if ( strcmp( argv[i], "-bench-volume" ) == 0 ) {
+	    status = bench_volume( arg ? atoi( arg ) : 128 );
+	    return true;
+	}
+    }
+    return false;
+}
@@ -0,0 +1,17 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Bench.h ---
+//
+//   CPU-side benchmarks, run from the command line without opening a
+//     window:  tesseract -bench-<name> [args]
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+//  Run the benchmark named by argv[i] ("-bench-scene", ...) if there is one.
+//    Returns true and sets "status" when a benchmark ran.
+bool RunBenchmark( int argc, char** argv, int& status );
+
+#endif // __BENCH_H__
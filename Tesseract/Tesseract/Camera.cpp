@@ -0,0 +1,182 @@
+#include "Camera.h"
+
+//----------------------------------------------------------------------------
+
+// Spherical coordinates represented as (r, phi, theta, w)
+static vec4
+sph_to_cart( const vec4& v )
+{
+    GLfloat sin_phi = sin( v.y*DegreesToRadians );
+
+    return vec4( v.x*sin_phi*cos(v.z*DegreesToRadians),
+		 v.x*cos(v.y*DegreesToRadians),
+		 v.x*sin_phi*sin(v.z*DegreesToRadians),
+		 v.w );
+}
+
+// Keep an angle in [0, 360]
+static void
+wrap_degrees( GLfloat& angle )
+{
+    if ( angle > 360.0 )
+	angle -= 360.0;
+    if ( angle < 0.0 )
+	angle += 360.0;
+}
+
+//----------------------------------------------------------------------------
+
+CameraController::CameraController()
+    : start_eye( 0.0, 0.0, 1.0, 1.0 ), x_prev( 256 ), y_prev( 256 )
+{
+    reset();
+}
+
+void
+CameraController::set_start( const vec4& eye )
+{
+    start_eye = eye;
+    reset();
+}
+
+void
+CameraController::reset()
+{
+    sph_at = vec4( 1.0, 90.0, -90.0, 1.0 );
+    sph_up = vec4( 1.0, 0.0, -90.0, 0.0 );
+    eye_offset = start_eye;
+    step = 0.1;
+
+    // Anything queued before the reset no longer applies
+    move_forward = 0.0;
+    move_right = 0.0;
+    pointer_moved = false;
+
+    basis_dirty = true;
+    view_dirty = true;
+}
+
+//----------------------------------------------------------------------------
+
+void
+CameraController::key( unsigned char key )
+{
+    switch ( key ) {
+
+    // Move the camera.  Only the distance is recorded here; the direction
+    // comes from the basis when the batch is applied.
+    case 'w':
+	move_forward += step;
+	break;
+    case 's':
+	move_forward -= step;
+	break;
+    case 'a':
+	move_right -= step;
+	break;
+    case 'd':
+	move_right += step;
+	break;
+
+    // Change camera movement speed
+    case ']':
+	step += 0.05;
+	break;
+    case '[':
+	step -= 0.05;
+	if ( step < 0 )
+	    step = 0;
+	break;
+
+    case ' ':  // reset values to their defaults
+	reset();
+	break;
+    }
+}
+
+void
+CameraController::pointer( int x, int y, int height )
+{
+    // Only the latest position of a burst of motion events matters
+    pointer_moved = true;
+    pointer_x = x;
+    pointer_y = y;
+    pointer_height = height;
+}
+
+void
+CameraController::release( int width, int height )
+{
+    pointer_moved = false;
+    x_prev = width / 2;
+    y_prev = height / 2;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+CameraController::update()
+{
+    // Turn once per update by the pointer's distance from where the drag
+    // is measured from, however many motion events arrived
+    if ( pointer_moved && pointer_height > 0 ) {
+	GLfloat dx = 5.0*((GLfloat)(pointer_x-x_prev))/(GLfloat)pointer_height;
+	GLfloat dy = 5.0*((GLfloat)(pointer_y-y_prev))/(GLfloat)pointer_height;
+
+	if ( dx != 0.0 || dy != 0.0 ) {
+	    // Look horizontally
+	    sph_at.z += dx;
+	    sph_up.z += dx;
+	    wrap_degrees( sph_at.z );
+	    wrap_degrees( sph_up.z );
+
+	    // Look vertically
+	    sph_at.y -= dy;
+	    sph_up.y -= dy;
+	    wrap_degrees( sph_at.y );
+	    wrap_degrees( sph_up.y );
+
+	    basis_dirty = true;
+	}
+	pointer_moved = false;
+    }
+
+    if ( basis_dirty )
+	update_basis();
+
+    if ( move_forward != 0.0 || move_right != 0.0 ) {
+	eye_offset += move_forward*forward + move_right*right;
+	move_forward = 0.0;
+	move_right = 0.0;
+	view_dirty = true;
+    }
+
+    if ( !view_dirty )
+	return false;
+
+    // The eye sits at the camera-space origin, moved by eye_offset
+    vec4 at = eye_offset + cart_at;
+    at.w = 1.0;
+    model_view = LookAt( eye_offset, at, cart_up );
+    view_dirty = false;
+    return true;
+}
+
+void
+CameraController::update_basis()
+{
+    cart_at = sph_to_cart( sph_at );
+    cart_at.w = 0.0;
+    cart_up = sph_to_cart( sph_up );
+
+    forward = -1.0*cart_up;
+    forward.w = 0.0;
+    forward = normalize( forward );
+
+    right = cross( cart_at, cart_up );
+    right.w = 0.0;
+    right = normalize( right );
+
+    basis_dirty = false;
+    view_dirty = true;
+}
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Camera.h ---
+//
+//   First-person camera driven by batches of raw input.  Key presses and
+//     pointer motion only record what was asked for; update() applies a
+//     whole batch at once, and recomputes the camera basis and the LookAt
+//     matrix only when the view actually changed.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CAMERA_H__
+#define __CAMERA_H__
+
+#include "Angel.h"
+
+class CameraController {
+   public:
+    CameraController();
+
+    //  Back to the starting position, direction and speed
+    void reset();
+
+    //  Start from "eye", looking down -z, instead of from (0, 0, 1); moves
+    //    the camera there now
+    void set_start( const vec4& eye );
+
+    //
+    //  --- Input, recorded until the next update() ---
+    //
+
+    void key( unsigned char key );
+
+    //  Pointer at (x, y) in a window "height" pixels tall while dragging
+    void pointer( int x, int y, int height );
+
+    //  Dragging ended; turns are measured from the window center again
+    void release( int width, int height );
+
+    //  Apply the input recorded since the last call.  Returns true if the
+    //    view matrix changed.
+    bool update();
+
+    const mat4& view() const { return model_view; }
+
+   private:
+    void update_basis();
+
+    // Parameters for LookAt -- spherical coordinates (r, phi, theta, w)
+    // phi = angle down from from +y
+    // theta = angle from +x towards +z
+    vec4     sph_at;
+    vec4     sph_up;
+    vec4     eye_offset;	// Cartesian position of the eye
+    vec4     start_eye;		// where reset() puts it
+    GLfloat  step;		// distance moved per key press
+
+    // Previous mouse coordinates -- default to somewhere mid-screen
+    int      x_prev;
+    int      y_prev;
+
+    // Pending input
+    GLfloat  move_forward;	// summed key moves, in world units
+    GLfloat  move_right;
+    bool     pointer_moved;
+    int      pointer_x;
+    int      pointer_y;
+    int      pointer_height;
+
+    // Derived from the above, refreshed by update()
+    vec4     cart_at;		// unit view direction
+    vec4     cart_up;
+    vec4     forward;		// directions of the movement keys
+    vec4     right;
+    mat4     model_view;
+    bool     basis_dirty;
+    bool     view_dirty;
+};
+
+#endif // __CAMERA_H__
@@ -0,0 +1,387 @@
+#include "Cull.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
+//  Objects per leaf.  Leaves are tested four objects at a time, which is
+//    cheap enough that larger leaves beat a deeper tree.
+static const int LeafSize = 32;
+
+enum { OUTSIDE, PARTIAL, INSIDE };
+
+void
+FrustumPlanes( const mat4& clip, GLfloat planes[6][4] )
+{
+    for ( int p = 0; p < 6; ++p ) {
+	GLfloat sign = p & 1 ? -1.0f : 1.0f;
+	GLfloat length = 0.0f;
+	for ( int k = 0; k < 4; ++k ) {
+	    planes[p][k] = clip[3][k] + sign * clip[p/2][k];
+	    if ( k < 3 )
+		length += planes[p][k] * planes[p][k];
+	}
+	length = length > 0.0f ? 1.0f / sqrtf( length ) : 0.0f;
+	for ( int k = 0; k < 4; ++k )
+	    planes[p][k] *= length;
+    }
+}
+
+//  A point d from c projects to within |d| (|(c.xyz, c.w + 1)| + |d|) of
+//    c's projection
+void
+ProjectedSphere( const GLfloat c[4], GLfloat r, GLfloat out[4] )
+{
+    GLfloat w = c[3] + 1.0f;
+    out[0] = c[0]*w;
+    out[1] = c[1]*w;
+    out[2] = c[2]*w;
+    out[3] = r * (sqrtf( c[0]*c[0] + c[1]*c[1] + c[2]*c[2] + w*w ) + r);
+}
+
+//  Where the sphere (c, r) lands against the frustum
+static int
+classify( const GLfloat c[4], GLfloat r, const GLfloat planes[6][4] )
+{
+    GLfloat w = c[3] + 1.0f;
+    if ( w + r <= 0.0f )
+	return OUTSIDE;
+
+    GLfloat p[4];
+    ProjectedSphere( c, r, p );
+    GLfloat r3 = p[3];
+
+    int result = w - r > 0.0f ? INSIDE : PARTIAL;
+    for ( int k = 0; k < 6; ++k ) {
+	const GLfloat* q = planes[k];
+	GLfloat d = q[0]*p[0] + q[1]*p[1] + q[2]*p[2] + q[3];
+	if ( d < -r3 )
+	    return OUTSIDE;
+	if ( d < r3 )
+	    result = PARTIAL;
+    }
+    return result;
+}
+
+#ifdef __SSE__
+//  Four spheres at a time: a mask of the ones that may show
+static int
+visible4( const GLfloat* x, const GLfloat* y, const GLfloat* z, const GLfloat* w,
+	  const GLfloat* r, const GLfloat planes[6][4] )
+{
+    __m128 cx = _mm_loadu_ps( x ), cy = _mm_loadu_ps( y ), cz = _mm_loadu_ps( z );
+    __m128 cw = _mm_add_ps( _mm_loadu_ps( w ), _mm_set1_ps( 1.0f ) );
+    __m128 cr = _mm_loadu_ps( r );
+
+    __m128 length = _mm_sqrt_ps( _mm_add_ps(
+	_mm_add_ps( _mm_mul_ps( cx, cx ), _mm_mul_ps( cy, cy ) ),
+	_mm_add_ps( _mm_mul_ps( cz, cz ), _mm_mul_ps( cw, cw ) ) ) );
+    __m128 r3 = _mm_mul_ps( cr, _mm_add_ps( length, cr ) );
+    __m128 minus_r3 = _mm_sub_ps( _mm_setzero_ps(), r3 );
+    __m128 px = _mm_mul_ps( cx, cw ), py = _mm_mul_ps( cy, cw ),
+	pz = _mm_mul_ps( cz, cw );
+
+    __m128 in = _mm_cmpgt_ps( _mm_add_ps( cw, cr ), _mm_setzero_ps() );
+    for ( int k = 0; k < 6; ++k ) {
+	const GLfloat* q = planes[k];
+	__m128 d = _mm_add_ps(
+	    _mm_add_ps( _mm_mul_ps( _mm_set1_ps( q[0] ), px ),
+			_mm_mul_ps( _mm_set1_ps( q[1] ), py ) ),
+	    _mm_add_ps( _mm_mul_ps( _mm_set1_ps( q[2] ), pz ), _mm_set1_ps( q[3] ) ) );
+	in = _mm_and_ps( in, _mm_cmpge_ps( d, minus_r3 ) );
+    }
+    return _mm_movemask_ps( in );
+}
+#endif
+
+//----------------------------------------------------------------------------
+
+SceneCuller::SceneCuller() :
+    count( 0 )
+{
+    memset( &last, 0, sizeof(last) );
+}
+
+void
+SceneCuller::update( const GLfloat* centers, const GLfloat* scales, int n,
+		     GLfloat mesh_radius )
+{
+    if ( n != count || nodes.empty() ) {
+	count = n;
+	for ( int k = 0; k < 5; ++k )
+	    sphere[k].assign( count + 3, 0.0f );
+	for ( int i = 0; i < count; ++i ) {
+	    for ( int k = 0; k < 4; ++k )
+		sphere[k][i] = centers[4*i + k];
+	    sphere[4][i] = mesh_radius * scales[i];
+	}
+	build();
+	last.refitted = count;
+	return;
+    }
+
+    // Mark the leaves of the objects that changed, and the nodes above
+    last.refitted = 0;
+    for ( int i = 0; i < count; ++i ) {
+	GLfloat r = mesh_radius * scales[i];
+	if ( sphere[0][i] == centers[4*i] && sphere[1][i] == centers[4*i + 1]
+	     && sphere[2][i] == centers[4*i + 2] && sphere[3][i] == centers[4*i + 3]
+	     && sphere[4][i] == r )
+	    continue;
+
+	int slot = slot_of[i];
+	for ( int k = 0; k < 4; ++k )
+	    sphere[k][i] = sorted[k][slot] = centers[4*i + k];
+	sphere[4][i] = sorted[4][slot] = r;
+	last.refitted++;
+
+	for ( int node = leaf_of[i]; node >= 0 && !dirty[node]; node = nodes[node].parent )
+	    dirty[node] = 1;
+    }
+    if ( last.refitted == 0 )
+	return;
+
+    // Children come after their parents, so backwards is bottom up
+    for ( int node = (int) nodes.size() - 1; node >= 0; --node )
+	if ( dirty[node] ) {
+	    fit( nodes[node] );
+	    dirty[node] = 0;
+	}
+}
+
+//----------------------------------------------------------------------------
+
+void
+SceneCuller::build()
+{
+    order.resize( count );
+    for ( int i = 0; i < count; ++i )
+	order[i] = i;
+    nodes.clear();
+    if ( count > 0 )
+	split( 0, count, -1 );
+
+    slot_of.resize( count );
+    leaf_of.resize( count );
+    for ( int k = 0; k < 5; ++k )
+	sorted[k].assign( count + 3, 0.0f );
+    for ( int s = 0; s < count; ++s ) {
+	slot_of[order[s]] = s;
+	for ( int k = 0; k < 5; ++k )
+	    sorted[k][s] = sphere[k][order[s]];
+    }
+    for ( int node = 0; node < (int) nodes.size(); ++node )
+	if ( nodes[node].left < 0 )
+	    for ( int s = nodes[node].first; s < nodes[node].first + nodes[node].count; ++s )
+		leaf_of[order[s]] = node;
+
+    dirty.assign( nodes.size(), 0 );
+    for ( int node = (int) nodes.size() - 1; node >= 0; --node )
+	fit( nodes[node] );
+}
+
+//  Make the node for objects order[first .. first + n), splitting them at
+//    the median of the longest side of their centers' box
+int
+SceneCuller::split( int first, int n, int parent )
+{
+    int index = (int) nodes.size();
+    Node node;
+    node.first = first;
+    node.count = n;
+    node.left = node.right = -1;
+    node.parent = parent;
+    nodes.push_back( node );
+    if ( n <= LeafSize )
+	return index;
+
+    GLfloat lo[4], hi[4];
+    for ( int k = 0; k < 4; ++k )
+	lo[k] = hi[k] = sphere[k][order[first]];
+    for ( int i = first + 1; i < first + n; ++i )
+	for ( int k = 0; k < 4; ++k ) {
+	    lo[k] = std::min( lo[k], sphere[k][order[i]] );
+	    hi[k] = std::max( hi[k], sphere[k][order[i]] );
+	}
+    int axis = 0;
+    for ( int k = 1; k < 4; ++k )
+	if ( hi[k] - lo[k] > hi[axis] - lo[axis] )
+	    axis = k;
+
+    const std::vector<GLfloat>& key = sphere[axis];
+    int half = n / 2;
+    std::nth_element( order.begin() + first, order.begin() + first + half,
+		      order.begin() + first + n,
+		      [&key]( int a, int b ) { return key[a] < key[b]; } );
+
+    int left = split( first, half, index );
+    int right = split( first + half, n - half, index );
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+}
+
+//  A sphere around a leaf's spheres, or around its two children's
+void
+SceneCuller::fit( Node& node )
+{
+    if ( node.left < 0 ) {
+	GLfloat lo[4], hi[4];
+	for ( int k = 0; k < 4; ++k ) {
+	    lo[k] = 1.0e30f;
+	    hi[k] = -1.0e30f;
+	}
+	for ( int s = node.first; s < node.first + node.count; ++s )
+	    for ( int k = 0; k < 4; ++k ) {
+		lo[k] = std::min( lo[k], sorted[k][s] - sorted[4][s] );
+		hi[k] = std::max( hi[k], sorted[k][s] + sorted[4][s] );
+	    }
+	for ( int k = 0; k < 4; ++k )
+	    node.center[k] = 0.5f * (lo[k] + hi[k]);
+
+	GLfloat r = 0.0f;
+	for ( int s = node.first; s < node.first + node.count; ++s ) {
+	    GLfloat d2 = 0.0f;
+	    for ( int k = 0; k < 4; ++k ) {
+		GLfloat d = sorted[k][s] - node.center[k];
+		d2 += d*d;
+	    }
+	    r = std::max( r, sqrtf( d2 ) + sorted[4][s] );
+	}
+	node.radius = r;
+	return;
+    }
+
+    const Node& a = nodes[node.left];
+    const Node& b = nodes[node.right];
+    GLfloat d2 = 0.0f;
+    for ( int k = 0; k < 4; ++k )
+	d2 += (b.center[k] - a.center[k]) * (b.center[k] - a.center[k]);
+    GLfloat d = sqrtf( d2 );
+
+    if ( d + b.radius <= a.radius || d + a.radius <= b.radius ) {
+	const Node& big = a.radius >= b.radius ? a : b;
+	memcpy( node.center, big.center, sizeof(node.center) );
+	node.radius = big.radius;
+	return;
+    }
+    GLfloat r = 0.5f * (d + a.radius + b.radius);
+    GLfloat t = (r - a.radius) / d;
+    for ( int k = 0; k < 4; ++k )
+	node.center[k] = a.center[k] + t * (b.center[k] - a.center[k]);
+    node.radius = r * 1.0001f;		// against rounding
+}
+
+//----------------------------------------------------------------------------
+
+void
+SceneCuller::emit( const Node& node, int* visible, int& n ) const
+{
+    for ( int s = node.first; s < node.first + node.count; ++s )
+	visible[n++] = order[s];
+}
+
+int
+SceneCuller::test_leaf( const Node& node, const GLfloat planes[6][4], int* visible,
+			int n ) const
+{
+    int end = node.first + node.count;
+#ifdef __SSE__
+    for ( int s = node.first; s < end; s += 4 ) {
+	int mask = visible4( &sorted[0][s], &sorted[1][s], &sorted[2][s],
+			     &sorted[3][s], &sorted[4][s], planes );
+	if ( end - s < 4 )
+	    mask &= (1 << (end - s)) - 1;
+	for ( ; mask; mask &= mask - 1 ) {
+	    int lane = mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3;
+	    visible[n++] = order[s + lane];
+	}
+    }
+#else
+    for ( int s = node.first; s < end; ++s ) {
+	GLfloat c[4] = { sorted[0][s], sorted[1][s], sorted[2][s], sorted[3][s] };
+	if ( classify( c, sorted[4][s], planes ) != OUTSIDE )
+	    visible[n++] = order[s];
+    }
+#endif
+    return n;
+}
+
+int
+SceneCuller::cull( const mat4& clip, int* visible )
+{
+    GLfloat planes[6][4];
+    FrustumPlanes( clip, planes );
+
+    last.objects = count;
+    last.visible = last.nodes_visited = last.spheres_tested = 0;
+    if ( nodes.empty() )
+	return 0;
+
+    int n = 0;
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while ( top > 0 ) {
+	const Node& node = nodes[stack[--top]];
+	last.nodes_visited++;
+	switch ( classify( node.center, node.radius, planes ) ) {
+	case OUTSIDE:
+	    break;
+	case INSIDE:
+	    emit( node, visible, n );
+	    break;
+	default:
+	    if ( node.left < 0 ) {
+		last.spheres_tested += node.count;
+		n = test_leaf( node, planes, visible, n );
+	    } else {
+		stack[top++] = node.right;
+		stack[top++] = node.left;
+	    }
+	}
+    }
+    last.visible = n;
+    return n;
+}
+
+int
+SceneCuller::cull_flat( const mat4& clip, int* visible ) const
+{
+    GLfloat planes[6][4];
+    FrustumPlanes( clip, planes );
+
+    int n = 0;
+#ifdef __SSE__
+    for ( int i = 0; i < count; i += 4 ) {
+	int mask = visible4( &sphere[0][i], &sphere[1][i], &sphere[2][i],
+			     &sphere[3][i], &sphere[4][i], planes );
+	if ( count - i < 4 )
+	    mask &= (1 << (count - i)) - 1;
+	for ( int lane = 0; lane < 4; ++lane )
+	    if ( mask & (1 << lane) )
+		visible[n++] = i + lane;
+    }
+#else
+    n = cull_scalar( clip, visible );
+#endif
+    return n;
+}
+
+int
+SceneCuller::cull_scalar( const mat4& clip, int* visible ) const
+{
+    GLfloat planes[6][4];
+    FrustumPlanes( clip, planes );
+
+    int n = 0;
+    for ( int i = 0; i < count; ++i ) {
+	GLfloat c[4] = { sphere[0][i], sphere[1][i], sphere[2][i], sphere[3][i] };
+	if ( classify( c, sphere[4][i], planes ) != OUTSIDE )
+	    visible[n++] = i;
+    }
+    return n;
+}
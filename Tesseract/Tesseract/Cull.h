@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Cull.h ---
+//
+//   View culling of the scene's objects.  Whatever its rotation, an object
+//     stays inside the 4D sphere about its center of radius scale times
+//     the mesh's radius.  The vertex shaders project a 4D point to 3D by
+//     scaling xyz by w + 1, which takes such a sphere to somewhere inside a
+//     3D sphere; that one is tested against the view frustum.  An object
+//     with w + 1 <= 0 all over has collapsed behind the projection and is
+//     culled too.
+//
+//   The spheres sit in a bounding volume hierarchy, so a subtree wholly
+//     outside the view is dropped, and one wholly inside taken, with one
+//     test.  The leaves test their objects four at a time with SSE.  When
+//     objects move or change size only their leaves and the nodes above
+//     them are refitted; the tree is rebuilt when the count changes.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CULL_H__
+#define __CULL_H__
+
+#include "Angel.h"
+#include <vector>
+
+struct CullStats {
+    int     objects;
+    int     visible;
+    int     nodes_visited;
+    int     spheres_tested;	// objects tested one by one in the leaves
+    int     refitted;		// objects whose sphere changed in update()
+};
+
+class SceneCuller {
+   public:
+    SceneCuller();
+
+    //  Take the objects' spheres -- "centers" 4 floats each, and radius
+    //    mesh_radius * scales[i] -- refitting or rebuilding as needed
+    void update( const GLfloat* centers, const GLfloat* scales, int count,
+		 GLfloat mesh_radius );
+
+    //  Fill "visible" (room for every object) with the indices of the
+    //    objects that may show through "clip" (projection times model
+    //    view), and return how many
+    int cull( const mat4& clip, int* visible );
+
+    //  Every object in turn, four at a time without the hierarchy, and one
+    //    at a time -- the references for cull()
+    int cull_flat( const mat4& clip, int* visible ) const;
+    int cull_scalar( const mat4& clip, int* visible ) const;
+
+    const CullStats& stats() const { return last; }
+    int object_count() const { return count; }
+    int node_count() const { return (int) nodes.size(); }
+
+   private:
+    struct Node {
+	GLfloat  center[4];
+	GLfloat  radius;
+	int      first;		// objects [first, first + count) in tree order
+	int      count;
+	int      left;		// children, or -1 for a leaf
+	int      right;
+	int      parent;
+    };
+
+    void build();
+    int split( int first, int count, int parent );
+    void fit( Node& node );
+    void emit( const Node& node, int* visible, int& n ) const;
+    int test_leaf( const Node& node, const GLfloat planes[6][4], int* visible,
+		   int n ) const;
+
+    int                   count;
+
+    //  The spheres by object index, to spot the ones that moved
+    std::vector<GLfloat>  sphere[5];		// x, y, z, w, radius
+
+    //  The same in tree order, padded by 3 for the last leaf's loads
+    std::vector<GLfloat>  sorted[5];
+    std::vector<int>      order;		// tree order -> object
+    std::vector<int>      slot_of;		// object -> tree order
+    std::vector<int>      leaf_of;		// object -> leaf node
+
+    std::vector<Node>     nodes;		// parents before children
+    std::vector<char>     dirty;
+    CullStats             last;
+};
+
+//  The six frustum planes of "clip", from its rows, normalized so that
+//    distances come out in world units: a point p is inside when
+//    dot( plane.xyz, p ) + plane.w >= 0 for all of them
+void FrustumPlanes( const mat4& clip, GLfloat planes[6][4] );
+
+//  A 3D sphere -- center, then radius -- holding the projection of the 4D
+//    sphere about c of radius r
+void ProjectedSphere( const GLfloat c[4], GLfloat r, GLfloat out[4] );
+
+#endif // __CULL_H__
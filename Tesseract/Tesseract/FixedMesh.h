@@ -0,0 +1,197 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- FixedMesh.h ---
+//
+//   The tesseract and the cube, built entirely at compile time.  Their
+//     vertices and square faces are written out below; BuildFixedMesh()
+//     turns them into everything the renderer uploads -- the solid mesh
+//     (two triangles per face, with the face's color), triangle indices,
+//     each edge once, and the wireframe lines over those edges -- as
+//     constexpr arrays that go straight into vertex buffers.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __FIXEDMESH_H__
+#define __FIXEDMESH_H__
+
+#include "Angel.h"
+
+//  One color per face, in face order (the generated polytopes reuse them)
+constexpr vec4 FaceColors[24] = {
+    vec4(1.0, 0.0, 0.0, 1.0), vec4(0.0, 1.0, 0.0, 1.0), vec4(0.0, 0.0, 1.0, 1.0), vec4(1.0, 1.0, 0.0, 1.0),
+    vec4(1.0, 0.0, 1.0, 1.0), vec4(0.0, 1.0, 1.0, 1.0), vec4(0.1, 0.2, 0.3, 1.0), vec4(0.2, 0.1, 0.3, 1.0),
+    vec4(0.1, 0.3, 0.2, 1.0), vec4(0.2, 0.3, 0.1, 0.0), vec4(0.3, 0.2, 0.1, 1.0), vec4(0.3, 0.1, 0.2, 1.0),
+    vec4(0.7, 0.2, 1.0, 1.0), vec4(0.7, 1.0, 0.2, 1.0), vec4(0.2, 0.7, 1.0, 1.0), vec4(0.2, 1.0, 0.7, 1.0),
+    vec4(1.0, 0.2, 0.7, 1.0), vec4(1.0, 0.7, 0.2, 1.0), vec4(0.5, 0.3, 0.0, 1.0), vec4(0.5, 0.0, 0.3, 1.0),
+    vec4(0.0, 0.3, 0.5, 1.0), vec4(0.0, 0.5, 0.3, 1.0), vec4(0.3, 0.0, 0.5, 1.0), vec4(0.3, 0.5, 0.0, 1.0)
+};
+
+//  The solid shader takes the face color in place of a normal, with this
+//    in w
+constexpr GLfloat FaceShadeAlpha = 0.3;
+
+//----------------------------------------------------------------------------
+//
+//  Vertices (on the unit cube, scaled by BuildFixedMesh) and faces, each
+//    face a loop of four vertex indices a, b, c, d
+//
+
+template <int V, int F>
+struct QuadMesh {
+    vec4      vertices[V];
+    GLushort  faces[F][4];
+};
+
+/*****************************************************
+The cube, from 6 square faces
+
+  h_______g
+ /|      /|
+d-------c |
+| e-----|-f
+|/      |/
+a-------b
+
+******************************************************/
+constexpr QuadMesh<8, 6> CubeQuads = {
+    {   vec4(-1.0,-1.0,-1.0, 0.0), vec4( 1.0,-1.0,-1.0, 0.0),	// a b
+	vec4( 1.0, 1.0,-1.0, 0.0), vec4(-1.0, 1.0,-1.0, 0.0),	// c d
+	vec4(-1.0,-1.0, 1.0, 0.0), vec4( 1.0,-1.0, 1.0, 0.0),	// e f
+	vec4( 1.0, 1.0, 1.0, 0.0), vec4(-1.0, 1.0, 1.0, 0.0) },	// g h
+    {   { 0, 1, 2, 3 }, { 3, 2, 6, 7 }, { 6, 2, 1, 5 },
+	{ 1, 5, 4, 0 }, { 4, 0, 3, 7 }, { 4, 5, 6, 7 } }
+};
+
+//  The tesseract: the cube a..h at w = +1, a second one i..p at w = -1,
+//    and the 24 squares between them
+constexpr QuadMesh<16, 24> TesseractQuads = {
+    {   vec4(-1.0,-1.0,-1.0, 1.0), vec4( 1.0,-1.0,-1.0, 1.0),	// a b
+	vec4( 1.0, 1.0,-1.0, 1.0), vec4(-1.0, 1.0,-1.0, 1.0),	// c d
+	vec4(-1.0, 1.0, 1.0, 1.0), vec4( 1.0, 1.0, 1.0, 1.0),	// e f
+	vec4( 1.0,-1.0, 1.0, 1.0), vec4(-1.0,-1.0, 1.0, 1.0),	// g h
+	vec4(-1.0,-1.0, 1.0,-1.0), vec4( 1.0,-1.0, 1.0,-1.0),	// i j
+	vec4( 1.0, 1.0, 1.0,-1.0), vec4(-1.0, 1.0, 1.0,-1.0),	// k l
+	vec4(-1.0, 1.0,-1.0,-1.0), vec4( 1.0, 1.0,-1.0,-1.0),	// m n
+	vec4( 1.0,-1.0,-1.0,-1.0), vec4(-1.0,-1.0,-1.0,-1.0) },	// o p
+    {   {  0,  1,  2,  3 }, {  3,  2,  5,  4 }, {  0,  3,  4,  7 },
+	{  7,  4,  5,  6 }, {  6,  5,  2,  1 }, {  1,  0,  7,  6 },
+
+	{  0, 15, 14,  1 }, {  1, 14,  9,  6 }, {  6,  9,  8,  7 },
+	{  7,  8, 15,  0 },
+
+	{  2, 13, 12,  3 }, {  3, 12, 11,  4 }, {  4, 11, 10,  5 },
+	{  5, 10, 13,  2 },
+
+	{  3, 12, 15,  0 }, {  4, 11,  8,  7 }, {  5, 10,  9,  6 },
+	{  2, 13, 14,  1 },
+
+	{ 14, 15, 12, 13 }, { 13, 12, 11, 10 }, { 10, 11,  8,  9 },
+	{  9,  8, 15, 14 }, { 12, 15,  8, 11 }, { 14,  9, 10, 13 } }
+};
+
+//----------------------------------------------------------------------------
+//
+//  What the renderer draws
+//
+
+template <int V, int F, int E>
+struct FixedMesh {
+    enum { VertexCount = V, FaceCount = F, EdgeCount = E,
+	   TriangleVertexCount = 6 * F, LineVertexCount = 2 * E };
+
+    vec4      vertices[V];
+    GLushort  triangles[2 * F][3];	// (a, b, d) and (d, b, c) per face
+    GLushort  edges[E][2];
+
+    //  Solid mesh: the triangles' corners, and the face color of each
+    vec4      points[6 * F];
+    vec4      shades[6 * F];
+
+    //  Wireframe mesh: both ends of each edge
+    vec4      lines[2 * E];
+};
+
+//  Whether edge (a, b) is already among the first "count" face edges
+template <int V, int F>
+constexpr bool
+FixedMeshSeenEdge( const QuadMesh<V, F>& q, int count, int a, int b )
+{
+    for ( int i = 0; i < count; ++i ) {
+	int u = q.faces[i / 4][i % 4], v = q.faces[i / 4][(i + 1) % 4];
+	if ( (u == a && v == b) || (u == b && v == a) )
+	    return true;
+    }
+    return false;
+}
+
+//  Number of different edges around the faces of "q"
+template <int V, int F>
+constexpr int
+FixedMeshEdgeCount( const QuadMesh<V, F>& q )
+{
+    int edges = 0;
+    for ( int i = 0; i < 4 * F; ++i )
+	if ( !FixedMeshSeenEdge( q, i, q.faces[i / 4][i % 4],
+				 q.faces[i / 4][(i + 1) % 4] ) )
+	    ++edges;
+    return edges;
+}
+
+//  The mesh of "q" with its vertices scaled by "size".  E must be
+//    FixedMeshEdgeCount(q).
+template <int E, int V, int F>
+constexpr FixedMesh<V, F, E>
+BuildFixedMesh( const QuadMesh<V, F>& q, GLfloat size )
+{
+    FixedMesh<V, F, E> m{};
+
+    for ( int v = 0; v < V; ++v )
+	m.vertices[v] = size * q.vertices[v];
+
+    for ( int f = 0; f < F; ++f ) {
+	const GLushort* c = q.faces[f];
+	const GLushort corner[6] = { c[0], c[1], c[3], c[3], c[1], c[2] };
+
+	vec4 shade = FaceColors[f % 24];
+	shade.w = FaceShadeAlpha;
+
+	for ( int i = 0; i < 6; ++i ) {
+	    m.triangles[2*f + i/3][i % 3] = corner[i];
+	    m.points[6*f + i] = m.vertices[corner[i]];
+	    m.shades[6*f + i] = shade;
+	}
+    }
+
+    int e = 0;
+    for ( int i = 0; i < 4 * F; ++i ) {
+	int a = q.faces[i / 4][i % 4], b = q.faces[i / 4][(i + 1) % 4];
+	if ( FixedMeshSeenEdge( q, i, a, b ) )
+	    continue;
+	m.edges[e][0] = a;
+	m.edges[e][1] = b;
+	m.lines[2*e] = m.vertices[a];
+	m.lines[2*e + 1] = m.vertices[b];
+	++e;
+    }
+    return m;
+}
+
+//----------------------------------------------------------------------------
+
+constexpr int CubeEdgeCount = FixedMeshEdgeCount( CubeQuads );
+constexpr int TesseractEdgeCount = FixedMeshEdgeCount( TesseractQuads );
+
+static_assert( CubeEdgeCount == 12, "the cube has 12 edges" );
+static_assert( TesseractEdgeCount == 32, "the tesseract has 32 edges" );
+
+//  Half the edge length of each, as drawn
+constexpr GLfloat CubeSize = 0.5;
+constexpr GLfloat TesseractSize = 0.3;
+
+constexpr FixedMesh<8, 6, CubeEdgeCount> CubeMesh =
+    BuildFixedMesh<CubeEdgeCount>( CubeQuads, CubeSize );
+
+constexpr FixedMesh<16, 24, TesseractEdgeCount> TesseractMesh =
+    BuildFixedMesh<TesseractEdgeCount>( TesseractQuads, TesseractSize );
+
+#endif // __FIXEDMESH_H__
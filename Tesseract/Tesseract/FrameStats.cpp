@@ -0,0 +1,220 @@
+#include "FrameStats.h"
+#include "Arena.h"
+#include <chrono>
+#include <string.h>
+
+static FrameStats  totals;
+
+//  Window used by the title-bar overlay
+static FrameStats  overlay;
+static double      overlay_start = -1.0;
+
+static double      last_frame_end = -1.0;
+static double      frame_begin = 0.0;
+static unsigned long  frame_begin_allocs = 0;
+static double      last_ms = 0.0, last_cpu_ms = 0.0, last_gpu_ms = -1.0;
+
+//  GL_TIME_ELAPSED queries, one for each frame that may still be in flight
+static const int   GpuTimerFrames = 4;
+static bool        gpu_timer = false;
+static GLuint      gpu_queries[GpuTimerFrames];
+static bool        gpu_issued[GpuTimerFrames];
+static int         gpu_slot = 0;
+
+//----------------------------------------------------------------------------
+
+double
+FrameStatsNow()
+{
+    typedef std::chrono::steady_clock  clock;
+    static const clock::time_point  start = clock::now();
+
+    return std::chrono::duration<double, std::milli>( clock::now() - start ).count();
+}
+
+//----------------------------------------------------------------------------
+
+static void
+clear( FrameStats& stats )
+{
+    memset( &stats, 0, sizeof(stats) );
+    stats.min_ms = 1.0e30;
+}
+
+static void
+add_frame( FrameStats& stats, double ms, double cpu_ms, unsigned long allocs,
+	   const GLTraceStats& gl )
+{
+    stats.frames++;
+    stats.total_ms += ms;
+    stats.total_sq_ms += ms*ms;
+    stats.cpu_ms += cpu_ms;
+    stats.heap_allocs += allocs;
+    if ( ms < stats.min_ms ) stats.min_ms = ms;
+    if ( ms > stats.max_ms ) stats.max_ms = ms;
+    GLTraceAccumulate( stats.gl, gl );
+}
+
+//  Pick up the result of the query last issued in "slot", if it is in.
+//    One that is still out is given up on when the slot is reused.
+static void
+collect_gpu_time( int slot )
+{
+    if ( !gpu_issued[slot] )
+	return;
+
+    GLuint available = 0;
+    glGetQueryObjectuiv( gpu_queries[slot], GL_QUERY_RESULT_AVAILABLE, &available );
+    if ( !available )
+	return;
+
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v( gpu_queries[slot], GL_QUERY_RESULT, &ns );
+    gpu_issued[slot] = false;
+
+    last_gpu_ms = ns * 1.0e-6;
+    totals.gpu_ms += last_gpu_ms;
+    totals.gpu_frames++;
+    overlay.gpu_ms += last_gpu_ms;
+    overlay.gpu_frames++;
+}
+
+bool
+FrameStatsEnableGpuTimer()
+{
+    if ( !GLEW_VERSION_3_3 && !GLEW_ARB_timer_query )
+	return false;
+
+    if ( !gpu_timer ) {
+	glGenQueries( GpuTimerFrames, gpu_queries );
+	memset( gpu_issued, 0, sizeof(gpu_issued) );
+	gpu_timer = true;
+    }
+    return true;
+}
+
+void
+FrameStatsBeginFrame()
+{
+    frame_begin = FrameStatsNow();
+    frame_begin_allocs = ThreadHeapAllocationCount();
+
+    if ( gpu_timer ) {
+	collect_gpu_time( gpu_slot );
+	glBeginQuery( GL_TIME_ELAPSED, gpu_queries[gpu_slot] );
+	gpu_issued[gpu_slot] = true;
+    }
+}
+
+void
+FrameStatsEndFrame()
+{
+    if ( gpu_timer ) {
+	glEndQuery( GL_TIME_ELAPSED );
+	gpu_slot = (gpu_slot + 1) % GpuTimerFrames;
+    }
+
+    GLTraceEndFrame();
+
+    double now = FrameStatsNow();
+    if ( last_frame_end >= 0.0 ) {
+	double ms = now - last_frame_end;
+	double cpu_ms = now - frame_begin;
+	unsigned long allocs = ThreadHeapAllocationCount() - frame_begin_allocs;
+	add_frame( totals, ms, cpu_ms, allocs, GLTraceLastFrame() );
+	add_frame( overlay, ms, cpu_ms, allocs, GLTraceLastFrame() );
+	last_ms = ms;
+	last_cpu_ms = cpu_ms;
+    }
+    last_frame_end = now;
+}
+
+void
+FrameStatsLastFrame( double& frame_ms, double& cpu_ms, double& gpu_ms )
+{
+    frame_ms = last_ms;
+    cpu_ms = last_cpu_ms;
+    gpu_ms = last_gpu_ms;
+}
+
+void
+FrameStatsReset()
+{
+    clear( totals );
+    last_frame_end = FrameStatsNow();
+}
+
+const FrameStats&
+FrameStatsTotals()
+{
+    return totals;
+}
+
+double
+FrameStatsDeviation( const FrameStats& stats )
+{
+    if ( stats.frames < 2 )
+	return 0.0;
+
+    double mean = stats.total_ms / stats.frames;
+    double variance = stats.total_sq_ms / stats.frames - mean*mean;
+    return variance > 0.0 ? sqrt( variance ) : 0.0;
+}
+
+//----------------------------------------------------------------------------
+
+void
+FrameStatsUpdateOverlay( const char* title )
+{
+    double now = FrameStatsNow();
+    if ( overlay_start < 0.0 ) {
+	clear( overlay );
+	overlay_start = now;
+    }
+    if ( now - overlay_start < 500.0 || overlay.frames == 0 )
+	return;
+
+    double ms = overlay.total_ms / overlay.frames;
+
+    // Per-frame GL counters averaged over the window
+    GLTraceStats gl = overlay.gl;
+    gl.total_calls /= overlay.frames;
+    gl.draw_calls /= overlay.frames;
+    gl.primitives /= overlay.frames;
+    gl.bytes_uploaded /= overlay.frames;
+    for ( int i = 0; i < TRACE_NUM_CATEGORIES; ++i )
+	gl.category_calls[i] /= overlay.frames;
+
+    char trace[128];
+    GLTraceSummary( trace, sizeof(trace), gl );
+
+    char gpu[32] = "";
+    if ( overlay.gpu_frames )
+	snprintf( gpu, sizeof(gpu), "  gpu %.2f ms", overlay.gpu_ms / overlay.gpu_frames );
+
+    char buf[256];
+    snprintf( buf, sizeof(buf), "%s  -  %.2f +/- %.2f ms (%.0f fps)  cpu %.2f ms%s  %s",
+	      title, ms, FrameStatsDeviation( overlay ), 1000.0 / ms,
+	      overlay.cpu_ms / overlay.frames, gpu, trace );
+    glutSetWindowTitle( buf );
+
+    clear( overlay );
+    overlay_start = now;
+}
+
+void
+FrameStatsReport( FILE* out )
+{
+    unsigned int frames = totals.frames ? totals.frames : 1;
+
+    fprintf( out, "frames:              %u\n", totals.frames );
+    fprintf( out, "frame time (ms):     avg %.3f  min %.3f  max %.3f  stddev %.3f\n",
+	     totals.total_ms / frames, totals.frames ? totals.min_ms : 0.0,
+	     totals.max_ms, FrameStatsDeviation( totals ) );
+    fprintf( out, "display cpu (ms):    avg %.3f\n", totals.cpu_ms / frames );
+    if ( totals.gpu_frames )
+	fprintf( out, "gpu time (ms):       avg %.3f  (%u frames timed)\n",
+		 totals.gpu_ms / totals.gpu_frames, totals.gpu_frames );
+    fprintf( out, "heap allocs/frame:   %.2f\n", (double) totals.heap_allocs / frames );
+    GLTracePrint( out, totals.gl, frames );
+}
@@ -0,0 +1,59 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- FrameStats.h ---
+//
+//   Frame timing and GL call statistics.  The numbers are shown in the
+//     window title (the "overlay") and summarized by the -bench mode.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __FRAMESTATS_H__
+#define __FRAMESTATS_H__
+
+#include "Angel.h"
+
+struct FrameStats {
+    unsigned int  frames;
+    double        total_ms;	// sum of frame-to-frame times
+    double        total_sq_ms;	// sum of their squares, for the variance
+    double        min_ms;
+    double        max_ms;
+    double        cpu_ms;	// sum of the time spent inside display()
+    double        gpu_ms;	// sum of the GPU times measured so far
+    unsigned int  gpu_frames;	// frames whose GPU time came back
+    unsigned long heap_allocs;	// heap allocations display() made itself
+    GLTraceStats  gl;		// GL counters summed over all frames
+};
+
+//  Milliseconds since the first call, at the best resolution available
+double FrameStatsNow();
+
+//  Bracket the work of a frame: call at the top of display() and just
+//    before glutSwapBuffers()
+void FrameStatsBeginFrame();
+void FrameStatsEndFrame();
+
+//  Time each frame's GL commands on the GPU too, with timer queries read
+//    a few frames late so as not to stall.  Needs a current context with
+//    GL 3.3 or ARB_timer_query; returns false, and does nothing, without.
+bool FrameStatsEnableGpuTimer();
+
+//  The last frame's frame-to-frame and display() times, and the most
+//    recent GPU time to come back (-1 if none has yet)
+void FrameStatsLastFrame( double& frame_ms, double& cpu_ms, double& gpu_ms );
+
+//  Standard deviation of the frame-to-frame time
+double FrameStatsDeviation( const FrameStats& stats );
+
+//  Forget everything measured so far, e.g. after a benchmark warm-up
+void FrameStatsReset();
+
+const FrameStats& FrameStatsTotals();
+
+//  Refresh the window title with the averages of the last half second
+void FrameStatsUpdateOverlay( const char* title );
+
+//  Print the averages since the last reset
+void FrameStatsReport( FILE* out );
+
+#endif // __FRAMESTATS_H__
@@ -0,0 +1,846 @@
+//  The wrappers below call the real entry points, so keep the redirection
+//    macros of GLTrace.h out of this file
+#define GL_TRACE_IMPLEMENTATION
+#include "Angel.h"
+#include <string.h>
+
+static GLTraceStats  current;
+static GLTraceStats  last;
+
+static const char* entry_names[TRACE_NUM_ENTRIES] = {
+#define TRACE_NAME( name, category )  #name,
+    GL_TRACE_ENTRY_POINTS( TRACE_NAME )
+#undef TRACE_NAME
+};
+
+static const int entry_categories[TRACE_NUM_ENTRIES] = {
+#define TRACE_CATEGORY( name, category )  category,
+    GL_TRACE_ENTRY_POINTS( TRACE_CATEGORY )
+#undef TRACE_CATEGORY
+};
+
+static const char* category_names[TRACE_NUM_CATEGORIES] = {
+    "draw", "upload", "uniform", "state", "query", "resource", "frame"
+};
+
+//----------------------------------------------------------------------------
+
+const GLTraceStats&
+GLTraceCurrentFrame()
+{
+    return current;
+}
+
+const GLTraceStats&
+GLTraceLastFrame()
+{
+    return last;
+}
+
+void
+GLTraceEndFrame()
+{
+    last = current;
+    memset( &current, 0, sizeof(current) );
+}
+
+void
+GLTraceAccumulate( GLTraceStats& total, const GLTraceStats& frame )
+{
+    for ( int i = 0; i < TRACE_NUM_ENTRIES; ++i )
+	total.calls[i] += frame.calls[i];
+    for ( int i = 0; i < TRACE_NUM_CATEGORIES; ++i )
+	total.category_calls[i] += frame.category_calls[i];
+
+    total.total_calls += frame.total_calls;
+    total.draw_calls += frame.draw_calls;
+    total.primitives += frame.primitives;
+    total.bytes_uploaded += frame.bytes_uploaded;
+}
+
+const char*
+GLTraceEntryName( int entry )
+{
+    return entry_names[entry];
+}
+
+void
+GLTracePrint( FILE* out, const GLTraceStats& stats, unsigned int frames )
+{
+    if ( !GLTraceEnabled ) {
+	fprintf( out, "gl trace: disabled (build with -DGL_TRACE)\n" );
+	return;
+    }
+    if ( frames == 0 )
+	frames = 1;
+
+    double f = frames;
+    fprintf( out, "gl calls/frame:      %.1f\n", stats.total_calls / f );
+    fprintf( out, "draw calls/frame:    %.1f\n", stats.draw_calls / f );
+    fprintf( out, "primitives/frame:    %.1f\n", stats.primitives / f );
+    fprintf( out, "bytes uploaded/frame: %.1f\n", stats.bytes_uploaded / f );
+
+    for ( int i = 0; i < TRACE_NUM_CATEGORIES; ++i ) {
+	if ( stats.category_calls[i] )
+	    fprintf( out, "  %-10s %10.1f\n", category_names[i],
+		     stats.category_calls[i] / f );
+    }
+    for ( int i = 0; i < TRACE_NUM_ENTRIES; ++i ) {
+	if ( stats.calls[i] )
+	    fprintf( out, "    %-28s %10.1f\n", entry_names[i],
+		     stats.calls[i] / f );
+    }
+}
+
+void
+GLTraceSummary( char* buf, int size, const GLTraceStats& stats )
+{
+    if ( !GLTraceEnabled ) {
+	buf[0] = '\0';
+	return;
+    }
+
+    snprintf( buf, size, "%u calls  %u draws  %lu prims  %lu B up  %u state",
+	      stats.total_calls, stats.draw_calls, stats.primitives,
+	      stats.bytes_uploaded, stats.category_calls[TRACE_STATE] );
+}
+
+//----------------------------------------------------------------------------
+
+#ifdef GL_TRACE
+
+//  Texture data from a bound pixel unpack buffer was counted when the
+//    buffer was filled, so the binding is kept track of
+static GLuint  unpack_buffer = 0;
+
+static inline void
+count( GLTraceEntry entry )
+{
+    current.calls[entry]++;
+    current.category_calls[entry_categories[entry]]++;
+    current.total_calls++;
+}
+
+//  Number of primitives assembled from "count" vertices in the given mode
+static unsigned long
+primitive_count( GLenum mode, GLsizei count )
+{
+    if ( count <= 0 )
+	return 0;
+
+    switch ( mode ) {
+    case GL_POINTS:		return count;
+    case GL_LINES:		return count / 2;
+    case GL_LINE_STRIP:		return count - 1;
+    case GL_LINE_LOOP:		return count;
+    case GL_TRIANGLES:		return count / 3;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:	return count > 2 ? count - 2 : 0;
+    default:			return 0;
+    }
+}
+
+void
+traced_glActiveTexture( GLenum texture )
+{
+    count( TRACE_glActiveTexture );
+    glActiveTexture( texture );
+}
+
+void
+traced_glAttachShader( GLuint program, GLuint shader )
+{
+    count( TRACE_glAttachShader );
+    glAttachShader( program, shader );
+}
+
+void
+traced_glBeginConditionalRender( GLuint id, GLenum mode )
+{
+    count( TRACE_glBeginConditionalRender );
+    glBeginConditionalRender( id, mode );
+}
+
+void
+traced_glBeginQuery( GLenum target, GLuint id )
+{
+    count( TRACE_glBeginQuery );
+    glBeginQuery( target, id );
+}
+
+void
+traced_glBindBuffer( GLenum target, GLuint buffer )
+{
+    count( TRACE_glBindBuffer );
+    if ( target == GL_PIXEL_UNPACK_BUFFER )
+	unpack_buffer = buffer;
+    glBindBuffer( target, buffer );
+}
+
+void
+traced_glBindBufferBase( GLenum target, GLuint index, GLuint buffer )
+{
+    count( TRACE_glBindBufferBase );
+    glBindBufferBase( target, index, buffer );
+}
+
+void
+traced_glBindFramebuffer( GLenum target, GLuint framebuffer )
+{
+    count( TRACE_glBindFramebuffer );
+    glBindFramebuffer( target, framebuffer );
+}
+
+void
+traced_glBindRenderbuffer( GLenum target, GLuint renderbuffer )
+{
+    count( TRACE_glBindRenderbuffer );
+    glBindRenderbuffer( target, renderbuffer );
+}
+
+void
+traced_glBindTexture( GLenum target, GLuint texture )
+{
+    count( TRACE_glBindTexture );
+    glBindTexture( target, texture );
+}
+
+void
+traced_glBindVertexArray( GLuint array )
+{
+    count( TRACE_glBindVertexArray );
+    glBindVertexArray( array );
+}
+
+void
+traced_glBlendFunc( GLenum sfactor, GLenum dfactor )
+{
+    count( TRACE_glBlendFunc );
+    glBlendFunc( sfactor, dfactor );
+}
+
+void
+traced_glBlitFramebuffer( GLint x0, GLint y0, GLint x1, GLint y1, GLint dx0,
+			  GLint dy0, GLint dx1, GLint dy1, GLbitfield mask,
+			  GLenum filter )
+{
+    count( TRACE_glBlitFramebuffer );
+    current.draw_calls++;
+    glBlitFramebuffer( x0, y0, x1, y1, dx0, dy0, dx1, dy1, mask, filter );
+}
+
+void
+traced_glBufferData( GLenum target, GLsizeiptr size,
+		     const GLvoid* data, GLenum usage )
+{
+    count( TRACE_glBufferData );
+    if ( data != NULL )
+	current.bytes_uploaded += size;
+    glBufferData( target, size, data, usage );
+}
+
+void
+traced_glBufferSubData( GLenum target, GLintptr offset,
+			GLsizeiptr size, const GLvoid* data )
+{
+    count( TRACE_glBufferSubData );
+    current.bytes_uploaded += size;
+    glBufferSubData( target, offset, size, data );
+}
+
+GLenum
+traced_glCheckFramebufferStatus( GLenum target )
+{
+    count( TRACE_glCheckFramebufferStatus );
+    return glCheckFramebufferStatus( target );
+}
+
+void
+traced_glClear( GLbitfield mask )
+{
+    count( TRACE_glClear );
+    glClear( mask );
+}
+
+void
+traced_glClearBufferuiv( GLenum buffer, GLint drawbuffer, const GLuint* value )
+{
+    count( TRACE_glClearBufferuiv );
+    glClearBufferuiv( buffer, drawbuffer, value );
+}
+
+void
+traced_glClearColor( GLclampf r, GLclampf g, GLclampf b, GLclampf a )
+{
+    count( TRACE_glClearColor );
+    glClearColor( r, g, b, a );
+}
+
+GLenum
+traced_glClientWaitSync( GLsync sync, GLbitfield flags, GLuint64 timeout )
+{
+    count( TRACE_glClientWaitSync );
+    return glClientWaitSync( sync, flags, timeout );
+}
+
+void
+traced_glColorMask( GLboolean r, GLboolean g, GLboolean b, GLboolean a )
+{
+    count( TRACE_glColorMask );
+    glColorMask( r, g, b, a );
+}
+
+void
+traced_glCompileShader( GLuint shader )
+{
+    count( TRACE_glCompileShader );
+    glCompileShader( shader );
+}
+
+GLuint
+traced_glCreateProgram()
+{
+    count( TRACE_glCreateProgram );
+    return glCreateProgram();
+}
+
+GLuint
+traced_glCreateShader( GLenum type )
+{
+    count( TRACE_glCreateShader );
+    return glCreateShader( type );
+}
+
+void
+traced_glDeleteSync( GLsync sync )
+{
+    count( TRACE_glDeleteSync );
+    glDeleteSync( sync );
+}
+
+void
+traced_glDepthMask( GLboolean flag )
+{
+    count( TRACE_glDepthMask );
+    glDepthMask( flag );
+}
+
+void
+traced_glDisable( GLenum cap )
+{
+    count( TRACE_glDisable );
+    glDisable( cap );
+}
+
+void
+traced_glDisableVertexAttribArray( GLuint index )
+{
+    count( TRACE_glDisableVertexAttribArray );
+    glDisableVertexAttribArray( index );
+}
+
+void
+traced_glDispatchCompute( GLuint x, GLuint y, GLuint z )
+{
+    count( TRACE_glDispatchCompute );
+    glDispatchCompute( x, y, z );
+}
+
+void
+traced_glDrawArrays( GLenum mode, GLint first, GLsizei n )
+{
+    count( TRACE_glDrawArrays );
+    current.draw_calls++;
+    current.primitives += primitive_count( mode, n );
+    glDrawArrays( mode, first, n );
+}
+
+void
+traced_glDrawArraysInstanced( GLenum mode, GLint first, GLsizei n,
+			      GLsizei instances )
+{
+    count( TRACE_glDrawArraysInstanced );
+    current.draw_calls++;
+    current.primitives += primitive_count( mode, n ) * instances;
+    glDrawArraysInstanced( mode, first, n, instances );
+}
+
+void
+traced_glDrawBuffers( GLsizei n, const GLenum* buffers )
+{
+    count( TRACE_glDrawBuffers );
+    glDrawBuffers( n, buffers );
+}
+
+void
+traced_glDrawElements( GLenum mode, GLsizei n, GLenum type,
+		       const GLvoid* indices )
+{
+    count( TRACE_glDrawElements );
+    current.draw_calls++;
+    current.primitives += primitive_count( mode, n );
+    glDrawElements( mode, n, type, indices );
+}
+
+void
+traced_glEnable( GLenum cap )
+{
+    count( TRACE_glEnable );
+    glEnable( cap );
+}
+
+void
+traced_glEnableVertexAttribArray( GLuint index )
+{
+    count( TRACE_glEnableVertexAttribArray );
+    glEnableVertexAttribArray( index );
+}
+
+void
+traced_glEndConditionalRender()
+{
+    count( TRACE_glEndConditionalRender );
+    glEndConditionalRender();
+}
+
+void
+traced_glEndQuery( GLenum target )
+{
+    count( TRACE_glEndQuery );
+    glEndQuery( target );
+}
+
+GLsync
+traced_glFenceSync( GLenum condition, GLbitfield flags )
+{
+    count( TRACE_glFenceSync );
+    return glFenceSync( condition, flags );
+}
+
+void
+traced_glFramebufferRenderbuffer( GLenum target, GLenum attachment,
+				  GLenum renderbuffertarget,
+				  GLuint renderbuffer )
+{
+    count( TRACE_glFramebufferRenderbuffer );
+    glFramebufferRenderbuffer( target, attachment, renderbuffertarget,
+			       renderbuffer );
+}
+
+void
+traced_glFramebufferTexture2D( GLenum target, GLenum attachment,
+			       GLenum textarget, GLuint texture, GLint level )
+{
+    count( TRACE_glFramebufferTexture2D );
+    glFramebufferTexture2D( target, attachment, textarget, texture, level );
+}
+
+void
+traced_glGenBuffers( GLsizei n, GLuint* buffers )
+{
+    count( TRACE_glGenBuffers );
+    glGenBuffers( n, buffers );
+}
+
+void
+traced_glGenFramebuffers( GLsizei n, GLuint* framebuffers )
+{
+    count( TRACE_glGenFramebuffers );
+    glGenFramebuffers( n, framebuffers );
+}
+
+void
+traced_glGenQueries( GLsizei n, GLuint* ids )
+{
+    count( TRACE_glGenQueries );
+    glGenQueries( n, ids );
+}
+
+void
+traced_glGenRenderbuffers( GLsizei n, GLuint* renderbuffers )
+{
+    count( TRACE_glGenRenderbuffers );
+    glGenRenderbuffers( n, renderbuffers );
+}
+
+void
+traced_glGenTextures( GLsizei n, GLuint* textures )
+{
+    count( TRACE_glGenTextures );
+    glGenTextures( n, textures );
+}
+
+void
+traced_glGenVertexArrays( GLsizei n, GLuint* arrays )
+{
+    count( TRACE_glGenVertexArrays );
+    glGenVertexArrays( n, arrays );
+}
+
+GLint
+traced_glGetAttribLocation( GLuint program, const GLchar* name )
+{
+    count( TRACE_glGetAttribLocation );
+    return glGetAttribLocation( program, name );
+}
+
+void
+traced_glGetBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size,
+			   GLvoid* data )
+{
+    count( TRACE_glGetBufferSubData );
+    glGetBufferSubData( target, offset, size, data );
+}
+
+void
+traced_glGetProgramInfoLog( GLuint program, GLsizei size,
+			    GLsizei* length, GLchar* log )
+{
+    count( TRACE_glGetProgramInfoLog );
+    glGetProgramInfoLog( program, size, length, log );
+}
+
+void
+traced_glGetProgramiv( GLuint program, GLenum pname, GLint* params )
+{
+    count( TRACE_glGetProgramiv );
+    glGetProgramiv( program, pname, params );
+}
+
+void
+traced_glGetQueryObjectui64v( GLuint id, GLenum pname, GLuint64* params )
+{
+    count( TRACE_glGetQueryObjectui64v );
+    glGetQueryObjectui64v( id, pname, params );
+}
+
+void
+traced_glGetQueryObjectuiv( GLuint id, GLenum pname, GLuint* params )
+{
+    count( TRACE_glGetQueryObjectuiv );
+    glGetQueryObjectuiv( id, pname, params );
+}
+
+void
+traced_glGetShaderInfoLog( GLuint shader, GLsizei size,
+			   GLsizei* length, GLchar* log )
+{
+    count( TRACE_glGetShaderInfoLog );
+    glGetShaderInfoLog( shader, size, length, log );
+}
+
+void
+traced_glGetShaderiv( GLuint shader, GLenum pname, GLint* params )
+{
+    count( TRACE_glGetShaderiv );
+    glGetShaderiv( shader, pname, params );
+}
+
+GLuint
+traced_glGetUniformBlockIndex( GLuint program, const GLchar* name )
+{
+    count( TRACE_glGetUniformBlockIndex );
+    return glGetUniformBlockIndex( program, name );
+}
+
+GLint
+traced_glGetUniformLocation( GLuint program, const GLchar* name )
+{
+    count( TRACE_glGetUniformLocation );
+    return glGetUniformLocation( program, name );
+}
+
+void
+traced_glLinkProgram( GLuint program )
+{
+    count( TRACE_glLinkProgram );
+    glLinkProgram( program );
+}
+
+void*
+traced_glMapBufferRange( GLenum target, GLintptr offset,
+			 GLsizeiptr length, GLbitfield access )
+{
+    count( TRACE_glMapBufferRange );
+    if ( access & GL_MAP_WRITE_BIT )
+	current.bytes_uploaded += length;
+    return glMapBufferRange( target, offset, length, access );
+}
+
+void
+traced_glMemoryBarrier( GLbitfield barriers )
+{
+    count( TRACE_glMemoryBarrier );
+    glMemoryBarrier( barriers );
+}
+
+//  The GPU fills in the counts, so no primitives are counted
+void
+traced_glMultiDrawElementsIndirect( GLenum mode, GLenum type,
+				    const GLvoid* indirect, GLsizei drawcount,
+				    GLsizei stride )
+{
+    count( TRACE_glMultiDrawElementsIndirect );
+    current.draw_calls++;
+    glMultiDrawElementsIndirect( mode, type, indirect, drawcount, stride );
+}
+
+void
+traced_glPixelStorei( GLenum pname, GLint param )
+{
+    count( TRACE_glPixelStorei );
+    glPixelStorei( pname, param );
+}
+
+void
+traced_glReadBuffer( GLenum buffer )
+{
+    count( TRACE_glReadBuffer );
+    glReadBuffer( buffer );
+}
+
+void
+traced_glReadPixels( GLint x, GLint y, GLsizei width, GLsizei height,
+		     GLenum format, GLenum type, GLvoid* pixels )
+{
+    count( TRACE_glReadPixels );
+    glReadPixels( x, y, width, height, format, type, pixels );
+}
+
+void
+traced_glRenderbufferStorage( GLenum target, GLenum internal, GLsizei width,
+			      GLsizei height )
+{
+    count( TRACE_glRenderbufferStorage );
+    glRenderbufferStorage( target, internal, width, height );
+}
+
+void
+traced_glScissor( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+    count( TRACE_glScissor );
+    glScissor( x, y, width, height );
+}
+
+void
+traced_glShaderSource( GLuint shader, GLsizei n,
+		       const GLchar** string, const GLint* length )
+{
+    count( TRACE_glShaderSource );
+    glShaderSource( shader, n, string, length );
+}
+
+void
+traced_glTexBuffer( GLenum target, GLenum internal, GLuint buffer )
+{
+    count( TRACE_glTexBuffer );
+    glTexBuffer( target, internal, buffer );
+}
+
+//  The bytes of a width x height x depth image read from client memory,
+//    or 0 if it comes from an unpack buffer or there is none; rows are
+//    taken as tightly packed
+static GLsizeiptr
+texture_bytes( GLsizei width, GLsizei height, GLsizei depth, GLenum format,
+	       GLenum type, const GLvoid* pixels )
+{
+    if ( pixels == NULL || unpack_buffer != 0 )
+	return 0;
+
+    GLsizeiptr components;
+    switch ( format ) {
+	case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT:
+	    components = 1;  break;
+	case GL_RG: case GL_RG_INTEGER:
+	    components = 2;  break;
+	case GL_RGB: case GL_BGR: case GL_RGB_INTEGER:
+	    components = 3;  break;
+	default:
+	    components = 4;  break;
+    }
+
+    GLsizeiptr texel;
+    switch ( type ) {
+	case GL_UNSIGNED_BYTE: case GL_BYTE:
+	    texel = components;  break;
+	case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT:
+	    texel = 2 * components;  break;
+	case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT:
+	    texel = 4 * components;  break;
+	default:			// packed, the whole texel in one value
+	    texel = 4;  break;
+    }
+    return texel * width * height * depth;
+}
+
+void
+traced_glTexImage2D( GLenum target, GLint level, GLint internal,
+		     GLsizei width, GLsizei height, GLint border,
+		     GLenum format, GLenum type, const GLvoid* pixels )
+{
+    count( TRACE_glTexImage2D );
+    current.bytes_uploaded += texture_bytes( width, height, 1, format, type,
+					     pixels );
+    glTexImage2D( target, level, internal, width, height, border, format,
+		  type, pixels );
+}
+
+void
+traced_glTexImage3D( GLenum target, GLint level, GLint internal,
+		     GLsizei width, GLsizei height, GLsizei depth,
+		     GLint border, GLenum format, GLenum type,
+		     const GLvoid* pixels )
+{
+    count( TRACE_glTexImage3D );
+    current.bytes_uploaded += texture_bytes( width, height, depth, format, type,
+					     pixels );
+    glTexImage3D( target, level, internal, width, height, depth, border,
+		  format, type, pixels );
+}
+
+void
+traced_glTexParameteri( GLenum target, GLenum pname, GLint param )
+{
+    count( TRACE_glTexParameteri );
+    glTexParameteri( target, pname, param );
+}
+
+//  From a pixel buffer the bytes were counted when it was mapped or filled
+void
+traced_glTexSubImage3D( GLenum target, GLint level, GLint x, GLint y,
+			GLint z, GLsizei width, GLsizei height, GLsizei depth,
+			GLenum format, GLenum type, const GLvoid* pixels )
+{
+    count( TRACE_glTexSubImage3D );
+    current.bytes_uploaded += texture_bytes( width, height, depth, format, type,
+					     pixels );
+    glTexSubImage3D( target, level, x, y, z, width, height, depth, format,
+		     type, pixels );
+}
+
+void
+traced_glUniform1f( GLint location, GLfloat v0 )
+{
+    count( TRACE_glUniform1f );
+    glUniform1f( location, v0 );
+}
+
+void
+traced_glUniform1fv( GLint location, GLsizei n, const GLfloat* value )
+{
+    count( TRACE_glUniform1fv );
+    glUniform1fv( location, n, value );
+}
+
+void
+traced_glUniform1i( GLint location, GLint v0 )
+{
+    count( TRACE_glUniform1i );
+    glUniform1i( location, v0 );
+}
+
+void
+traced_glUniform1ui( GLint location, GLuint v0 )
+{
+    count( TRACE_glUniform1ui );
+    glUniform1ui( location, v0 );
+}
+
+void
+traced_glUniform2f( GLint location, GLfloat v0, GLfloat v1 )
+{
+    count( TRACE_glUniform2f );
+    glUniform2f( location, v0, v1 );
+}
+
+void
+traced_glUniform4f( GLint location, GLfloat v0, GLfloat v1,
+		    GLfloat v2, GLfloat v3 )
+{
+    count( TRACE_glUniform4f );
+    glUniform4f( location, v0, v1, v2, v3 );
+}
+
+void
+traced_glUniform4fv( GLint location, GLsizei n, const GLfloat* v )
+{
+    count( TRACE_glUniform4fv );
+    glUniform4fv( location, n, v );
+}
+
+void
+traced_glUniform4iv( GLint location, GLsizei n, const GLint* v )
+{
+    count( TRACE_glUniform4iv );
+    glUniform4iv( location, n, v );
+}
+
+void
+traced_glUniformBlockBinding( GLuint program, GLuint index, GLuint binding )
+{
+    count( TRACE_glUniformBlockBinding );
+    glUniformBlockBinding( program, index, binding );
+}
+
+void
+traced_glUniformMatrix4fv( GLint location, GLsizei n,
+			   GLboolean transpose, const GLfloat* value )
+{
+    count( TRACE_glUniformMatrix4fv );
+    glUniformMatrix4fv( location, n, transpose, value );
+}
+
+GLboolean
+traced_glUnmapBuffer( GLenum target )
+{
+    count( TRACE_glUnmapBuffer );
+    return glUnmapBuffer( target );
+}
+
+void
+traced_glUseProgram( GLuint program )
+{
+    count( TRACE_glUseProgram );
+    glUseProgram( program );
+}
+
+void
+traced_glVertexAttrib4f( GLuint index, GLfloat x, GLfloat y,
+			 GLfloat z, GLfloat w )
+{
+    count( TRACE_glVertexAttrib4f );
+    glVertexAttrib4f( index, x, y, z, w );
+}
+
+void
+traced_glVertexAttribDivisor( GLuint index, GLuint divisor )
+{
+    count( TRACE_glVertexAttribDivisor );
+    glVertexAttribDivisor( index, divisor );
+}
+
+void
+traced_glVertexAttribIPointer( GLuint index, GLint size, GLenum type,
+			       GLsizei stride, const GLvoid* pointer )
+{
+    count( TRACE_glVertexAttribIPointer );
+    glVertexAttribIPointer( index, size, type, stride, pointer );
+}
+
+void
+traced_glVertexAttribPointer( GLuint index, GLint size, GLenum type,
+			      GLboolean normalized, GLsizei stride,
+			      const GLvoid* pointer )
+{
+    count( TRACE_glVertexAttribPointer );
+    glVertexAttribPointer( index, size, type, normalized, stride, pointer );
+}
+
+void
+traced_glViewport( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+    count( TRACE_glViewport );
+    glViewport( x, y, width, height );
+}
+
+#endif // GL_TRACE
@@ -0,0 +1,483 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- GLTrace.h ---
+//
+//   Optional counting layer over the GL entry points used by the program.
+//     Compile with -DGL_TRACE to route every call through a wrapper that
+//     tallies calls, draws, primitives and bytes uploaded for the current
+//     frame.  Without GL_TRACE the calls go straight to GL and the
+//     statistics stay zero.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __GLTRACE_H__
+#define __GLTRACE_H__
+
+#include <stdio.h>
+
+//----------------------------------------------------------------------------
+//
+//  Traced entry points and the kind of work each one represents
+//
+
+enum GLTraceCategory {
+    TRACE_DRAW,		// draw calls
+    TRACE_UPLOAD,	// buffer and texture uploads
+    TRACE_UNIFORM,	// uniform updates
+    TRACE_STATE,	// binds, enables and other pipeline state changes
+    TRACE_QUERY,	// round trips such as glGet*Location and glGet*iv
+    TRACE_RESOURCE,	// object creation, shader compilation and linking
+    TRACE_FRAME,	// clears
+    TRACE_NUM_CATEGORIES
+};
+
+#define GL_TRACE_ENTRY_POINTS( X )			\
+    X( glActiveTexture,		TRACE_STATE )		\
+    X( glAttachShader,		TRACE_RESOURCE )	\
+    X( glBeginConditionalRender, TRACE_STATE )		\
+    X( glBeginQuery,		TRACE_STATE )		\
+    X( glBindBuffer,		TRACE_STATE )		\
+    X( glBindBufferBase,	TRACE_STATE )		\
+    X( glBindFramebuffer,	TRACE_STATE )		\
+    X( glBindRenderbuffer,	TRACE_STATE )		\
+    X( glBindTexture,		TRACE_STATE )		\
+    X( glBindVertexArray,	TRACE_STATE )		\
+    X( glBlendFunc,		TRACE_STATE )		\
+    X( glBlitFramebuffer,	TRACE_DRAW )		\
+    X( glBufferData,		TRACE_UPLOAD )		\
+    X( glBufferSubData,		TRACE_UPLOAD )		\
+    X( glCheckFramebufferStatus, TRACE_QUERY )		\
+    X( glClear,			TRACE_FRAME )		\
+    X( glClearBufferuiv,	TRACE_FRAME )		\
+    X( glClearColor,		TRACE_STATE )		\
+    X( glClientWaitSync,	TRACE_QUERY )		\
+    X( glColorMask,		TRACE_STATE )		\
+    X( glCompileShader,		TRACE_RESOURCE )	\
+    X( glCreateProgram,		TRACE_RESOURCE )	\
+    X( glCreateShader,		TRACE_RESOURCE )	\
+    X( glDeleteSync,		TRACE_RESOURCE )	\
+    X( glDepthMask,		TRACE_STATE )		\
+    X( glDisable,		TRACE_STATE )		\
+    X( glDisableVertexAttribArray, TRACE_STATE )	\
+    X( glDispatchCompute,	TRACE_DRAW )		\
+    X( glDrawArrays,		TRACE_DRAW )		\
+    X( glDrawArraysInstanced,	TRACE_DRAW )		\
+    X( glDrawBuffers,		TRACE_STATE )		\
+    X( glDrawElements,		TRACE_DRAW )		\
+    X( glEnable,		TRACE_STATE )		\
+    X( glEnableVertexAttribArray, TRACE_STATE )		\
+    X( glEndConditionalRender,	TRACE_STATE )		\
+    X( glEndQuery,		TRACE_STATE )		\
+    X( glFenceSync,		TRACE_RESOURCE )	\
+    X( glFramebufferRenderbuffer, TRACE_RESOURCE )	\
+    X( glFramebufferTexture2D,	TRACE_RESOURCE )	\
+    X( glGenBuffers,		TRACE_RESOURCE )	\
+    X( glGenFramebuffers,	TRACE_RESOURCE )	\
+    X( glGenQueries,		TRACE_RESOURCE )	\
+    X( glGenRenderbuffers,	TRACE_RESOURCE )	\
+    X( glGenTextures,		TRACE_RESOURCE )	\
+    X( glGenVertexArrays,	TRACE_RESOURCE )	\
+    X( glGetAttribLocation,	TRACE_QUERY )		\
+    X( glGetBufferSubData,	TRACE_QUERY )		\
+    X( glGetProgramInfoLog,	TRACE_QUERY )		\
+    X( glGetProgramiv,		TRACE_QUERY )		\
+    X( glGetQueryObjectui64v,	TRACE_QUERY )		\
+    X( glGetQueryObjectuiv,	TRACE_QUERY )		\
+    X( glGetShaderInfoLog,	TRACE_QUERY )		\
+    X( glGetShaderiv,		TRACE_QUERY )		\
+    X( glGetUniformBlockIndex,	TRACE_QUERY )		\
+    X( glGetUniformLocation,	TRACE_QUERY )		\
+    X( glLinkProgram,		TRACE_RESOURCE )	\
+    X( glMapBufferRange,	TRACE_UPLOAD )		\
+    X( glMemoryBarrier,		TRACE_STATE )		\
+    X( glMultiDrawElementsIndirect, TRACE_DRAW )	\
+    X( glPixelStorei,		TRACE_STATE )		\
+    X( glReadBuffer,		TRACE_STATE )		\
+    X( glReadPixels,		TRACE_QUERY )		\
+    X( glRenderbufferStorage,	TRACE_RESOURCE )	\
+    X( glScissor,		TRACE_STATE )		\
+    X( glShaderSource,		TRACE_RESOURCE )	\
+    X( glTexBuffer,		TRACE_RESOURCE )	\
+    X( glTexImage2D,		TRACE_UPLOAD )		\
+    X( glTexImage3D,		TRACE_UPLOAD )		\
+    X( glTexParameteri,		TRACE_STATE )		\
+    X( glTexSubImage3D,		TRACE_UPLOAD )		\
+    X( glUniform1f,		TRACE_UNIFORM )		\
+    X( glUniform1fv,		TRACE_UNIFORM )		\
+    X( glUniform1i,		TRACE_UNIFORM )		\
+    X( glUniform1ui,		TRACE_UNIFORM )		\
+    X( glUniform2f,		TRACE_UNIFORM )		\
+    X( glUniform4f,		TRACE_UNIFORM )		\
+    X( glUniform4fv,		TRACE_UNIFORM )		\
+    X( glUniform4iv,		TRACE_UNIFORM )		\
+    X( glUniformBlockBinding,	TRACE_UNIFORM )		\
+    X( glUniformMatrix4fv,	TRACE_UNIFORM )		\
+    X( glUnmapBuffer,		TRACE_UPLOAD )		\
+    X( glUseProgram,		TRACE_STATE )		\
+    X( glVertexAttrib4f,	TRACE_STATE )		\
+    X( glVertexAttribDivisor,	TRACE_STATE )		\
+    X( glVertexAttribIPointer,	TRACE_STATE )		\
+    X( glVertexAttribPointer,	TRACE_STATE )		\
+    X( glViewport,		TRACE_STATE )
+
+enum GLTraceEntry {
+#define TRACE_ENUM( name, category )  TRACE_##name,
+    GL_TRACE_ENTRY_POINTS( TRACE_ENUM )
+#undef TRACE_ENUM
+    TRACE_NUM_ENTRIES
+};
+
+//----------------------------------------------------------------------------
+//
+//  Per-frame counters
+//
+
+struct GLTraceStats {
+    unsigned int   calls[TRACE_NUM_ENTRIES];
+    unsigned int   category_calls[TRACE_NUM_CATEGORIES];
+    unsigned int   total_calls;
+    unsigned int   draw_calls;
+    unsigned long  primitives;
+    unsigned long  bytes_uploaded;
+};
+
+#ifdef GL_TRACE
+const bool GLTraceEnabled = true;
+#else
+const bool GLTraceEnabled = false;
+#endif
+
+//  Counters accumulated since the last GLTraceEndFrame()
+const GLTraceStats& GLTraceCurrentFrame();
+
+//  Counters of the most recently completed frame
+const GLTraceStats& GLTraceLastFrame();
+
+//  Close the current frame: it becomes the last frame and counting restarts
+void GLTraceEndFrame();
+
+//  Add the counters of one frame into a running total (for averaging)
+void GLTraceAccumulate( GLTraceStats& total, const GLTraceStats& frame );
+
+//  Write the counters divided by "frames", listing every entry point used
+void GLTracePrint( FILE* out, const GLTraceStats& stats, unsigned int frames );
+
+//  One-line summary suitable for the frame-stats overlay
+void GLTraceSummary( char* buf, int size, const GLTraceStats& stats );
+
+const char* GLTraceEntryName( int entry );
+
+//----------------------------------------------------------------------------
+//
+//  Wrappers -- each counts its call and forwards to the real entry point
+//
+
+#if defined(GL_TRACE) && !defined(GL_TRACE_IMPLEMENTATION)
+
+void   traced_glActiveTexture( GLenum texture );
+void   traced_glAttachShader( GLuint program, GLuint shader );
+void   traced_glBeginConditionalRender( GLuint id, GLenum mode );
+void   traced_glBeginQuery( GLenum target, GLuint id );
+void   traced_glBindBuffer( GLenum target, GLuint buffer );
+void   traced_glBindBufferBase( GLenum target, GLuint index, GLuint buffer );
+void   traced_glBindFramebuffer( GLenum target, GLuint framebuffer );
+void   traced_glBindRenderbuffer( GLenum target, GLuint renderbuffer );
+void   traced_glBindTexture( GLenum target, GLuint texture );
+void   traced_glBindVertexArray( GLuint array );
+void   traced_glBlendFunc( GLenum sfactor, GLenum dfactor );
+void   traced_glBlitFramebuffer( GLint x0, GLint y0, GLint x1, GLint y1,
+				 GLint dx0, GLint dy0, GLint dx1, GLint dy1,
+				 GLbitfield mask, GLenum filter );
+void   traced_glBufferData( GLenum target, GLsizeiptr size,
+			    const GLvoid* data, GLenum usage );
+void   traced_glBufferSubData( GLenum target, GLintptr offset,
+			       GLsizeiptr size, const GLvoid* data );
+GLenum traced_glCheckFramebufferStatus( GLenum target );
+void   traced_glClear( GLbitfield mask );
+void   traced_glClearBufferuiv( GLenum buffer, GLint drawbuffer,
+				const GLuint* value );
+void   traced_glClearColor( GLclampf r, GLclampf g, GLclampf b, GLclampf a );
+GLenum traced_glClientWaitSync( GLsync sync, GLbitfield flags,
+				GLuint64 timeout );
+void   traced_glColorMask( GLboolean r, GLboolean g, GLboolean b, GLboolean a );
+void   traced_glCompileShader( GLuint shader );
+GLuint traced_glCreateProgram();
+GLuint traced_glCreateShader( GLenum type );
+void   traced_glDeleteSync( GLsync sync );
+void   traced_glDepthMask( GLboolean flag );
+void   traced_glDisable( GLenum cap );
+void   traced_glDisableVertexAttribArray( GLuint index );
+void   traced_glDispatchCompute( GLuint x, GLuint y, GLuint z );
+void   traced_glDrawArrays( GLenum mode, GLint first, GLsizei count );
+void   traced_glDrawArraysInstanced( GLenum mode, GLint first, GLsizei n,
+				      GLsizei instances );
+void   traced_glDrawBuffers( GLsizei n, const GLenum* buffers );
+void   traced_glDrawElements( GLenum mode, GLsizei count, GLenum type,
+			      const GLvoid* indices );
+void   traced_glEnable( GLenum cap );
+void   traced_glEnableVertexAttribArray( GLuint index );
+void   traced_glEndConditionalRender();
+void   traced_glEndQuery( GLenum target );
+GLsync traced_glFenceSync( GLenum condition, GLbitfield flags );
+void   traced_glFramebufferRenderbuffer( GLenum target, GLenum attachment,
+					 GLenum renderbuffertarget,
+					 GLuint renderbuffer );
+void   traced_glFramebufferTexture2D( GLenum target, GLenum attachment,
+				      GLenum textarget, GLuint texture,
+				      GLint level );
+void   traced_glGenBuffers( GLsizei n, GLuint* buffers );
+void   traced_glGenFramebuffers( GLsizei n, GLuint* framebuffers );
+void   traced_glGenQueries( GLsizei n, GLuint* ids );
+void   traced_glGenRenderbuffers( GLsizei n, GLuint* renderbuffers );
+void   traced_glGenTextures( GLsizei n, GLuint* textures );
+void   traced_glGenVertexArrays( GLsizei n, GLuint* arrays );
+GLint  traced_glGetAttribLocation( GLuint program, const GLchar* name );
+void   traced_glGetBufferSubData( GLenum target, GLintptr offset,
+				  GLsizeiptr size, GLvoid* data );
+void   traced_glGetProgramInfoLog( GLuint program, GLsizei size,
+				   GLsizei* length, GLchar* log );
+void   traced_glGetProgramiv( GLuint program, GLenum pname, GLint* params );
+void   traced_glGetQueryObjectui64v( GLuint id, GLenum pname,
+				     GLuint64* params );
+void   traced_glGetQueryObjectuiv( GLuint id, GLenum pname, GLuint* params );
+void   traced_glGetShaderInfoLog( GLuint shader, GLsizei size,
+				  GLsizei* length, GLchar* log );
+void   traced_glGetShaderiv( GLuint shader, GLenum pname, GLint* params );
+GLuint traced_glGetUniformBlockIndex( GLuint program, const GLchar* name );
+GLint  traced_glGetUniformLocation( GLuint program, const GLchar* name );
+void   traced_glLinkProgram( GLuint program );
+void*  traced_glMapBufferRange( GLenum target, GLintptr offset,
+				GLsizeiptr length, GLbitfield access );
+void   traced_glMemoryBarrier( GLbitfield barriers );
+void   traced_glMultiDrawElementsIndirect( GLenum mode, GLenum type,
+					   const GLvoid* indirect,
+					   GLsizei drawcount, GLsizei stride );
+void   traced_glPixelStorei( GLenum pname, GLint param );
+void   traced_glReadBuffer( GLenum buffer );
+void   traced_glReadPixels( GLint x, GLint y, GLsizei width, GLsizei height,
+			    GLenum format, GLenum type, GLvoid* pixels );
+void   traced_glRenderbufferStorage( GLenum target, GLenum internal,
+				     GLsizei width, GLsizei height );
+void   traced_glScissor( GLint x, GLint y, GLsizei width, GLsizei height );
+void   traced_glShaderSource( GLuint shader, GLsizei count,
+			      const GLchar** string, const GLint* length );
+void   traced_glTexBuffer( GLenum target, GLenum internal, GLuint buffer );
+void   traced_glTexImage2D( GLenum target, GLint level, GLint internal,
+			    GLsizei width, GLsizei height, GLint border,
+			    GLenum format, GLenum type,
+			    const GLvoid* pixels );
+void   traced_glTexImage3D( GLenum target, GLint level, GLint internal,
+			    GLsizei width, GLsizei height, GLsizei depth,
+			    GLint border, GLenum format, GLenum type,
+			    const GLvoid* pixels );
+void   traced_glTexParameteri( GLenum target, GLenum pname, GLint param );
+void   traced_glTexSubImage3D( GLenum target, GLint level, GLint x,
+			       GLint y, GLint z, GLsizei width,
+			       GLsizei height, GLsizei depth, GLenum format,
+			       GLenum type, const GLvoid* pixels );
+void   traced_glUniform1f( GLint location, GLfloat v0 );
+void   traced_glUniform1fv( GLint location, GLsizei count,
+			    const GLfloat* value );
+void   traced_glUniform1i( GLint location, GLint v0 );
+void   traced_glUniform1ui( GLint location, GLuint v0 );
+void   traced_glUniform2f( GLint location, GLfloat v0, GLfloat v1 );
+void   traced_glUniform4f( GLint location, GLfloat v0, GLfloat v1,
+			   GLfloat v2, GLfloat v3 );
+void   traced_glUniform4fv( GLint location, GLsizei n, const GLfloat* v );
+void   traced_glUniform4iv( GLint location, GLsizei n, const GLint* v );
+void   traced_glUniformBlockBinding( GLuint program, GLuint index,
+				     GLuint binding );
+void   traced_glUniformMatrix4fv( GLint location, GLsizei count,
+				  GLboolean transpose, const GLfloat* value );
+GLboolean traced_glUnmapBuffer( GLenum target );
+void   traced_glUseProgram( GLuint program );
+void   traced_glVertexAttrib4f( GLuint index, GLfloat x, GLfloat y,
+				GLfloat z, GLfloat w );
+void   traced_glVertexAttribDivisor( GLuint index, GLuint divisor );
+void   traced_glVertexAttribIPointer( GLuint index, GLint size, GLenum type,
+				      GLsizei stride, const GLvoid* pointer );
+void   traced_glVertexAttribPointer( GLuint index, GLint size, GLenum type,
+				     GLboolean normalized, GLsizei stride,
+				     const GLvoid* pointer );
+void   traced_glViewport( GLint x, GLint y, GLsizei width, GLsizei height );
+
+//  GLEW defines most entry points as macros, so drop those first
+#undef glActiveTexture
+#undef glAttachShader
+#undef glBeginConditionalRender
+#undef glBeginQuery
+#undef glBindBuffer
+#undef glBindBufferBase
+#undef glBindFramebuffer
+#undef glBindRenderbuffer
+#undef glBindTexture
+#undef glBindVertexArray
+#undef glBlendFunc
+#undef glBlitFramebuffer
+#undef glBufferData
+#undef glBufferSubData
+#undef glCheckFramebufferStatus
+#undef glClear
+#undef glClearBufferuiv
+#undef glClearColor
+#undef glClientWaitSync
+#undef glColorMask
+#undef glCompileShader
+#undef glCreateProgram
+#undef glCreateShader
+#undef glDeleteSync
+#undef glDepthMask
+#undef glDisable
+#undef glDisableVertexAttribArray
+#undef glDispatchCompute
+#undef glDrawArrays
+#undef glDrawArraysInstanced
+#undef glDrawBuffers
+#undef glDrawElements
+#undef glEnable
+#undef glEnableVertexAttribArray
+#undef glEndConditionalRender
+#undef glEndQuery
+#undef glFenceSync
+#undef glFramebufferRenderbuffer
+#undef glFramebufferTexture2D
+#undef glGenBuffers
+#undef glGenFramebuffers
+#undef glGenQueries
+#undef glGenRenderbuffers
+#undef glGenTextures
+#undef glGenVertexArrays
+#undef glGetAttribLocation
+#undef glGetBufferSubData
+#undef glGetProgramInfoLog
+#undef glGetProgramiv
+#undef glGetQueryObjectui64v
+#undef glGetQueryObjectuiv
+#undef glGetShaderInfoLog
+#undef glGetShaderiv
+#undef glGetUniformBlockIndex
+#undef glGetUniformLocation
+#undef glLinkProgram
+#undef glMapBufferRange
+#undef glMemoryBarrier
+#undef glMultiDrawElementsIndirect
+#undef glPixelStorei
+#undef glReadBuffer
+#undef glReadPixels
+#undef glRenderbufferStorage
+#undef glScissor
+#undef glShaderSource
+#undef glTexBuffer
+#undef glTexImage2D
+#undef glTexImage3D
+#undef glTexParameteri
+#undef glTexSubImage3D
+#undef glUniform1f
+#undef glUniform1fv
+#undef glUniform1i
+#undef glUniform1ui
+#undef glUniform2f
+#undef glUniform4f
+#undef glUniform4fv
+#undef glUniform4iv
+#undef glUniformBlockBinding
+#undef glUniformMatrix4fv
+#undef glUnmapBuffer
+#undef glUseProgram
+#undef glVertexAttrib4f
+#undef glVertexAttribDivisor
+#undef glVertexAttribIPointer
+#undef glVertexAttribPointer
+#undef glViewport
+
+#define glActiveTexture			traced_glActiveTexture
+#define glAttachShader			traced_glAttachShader
+#define glBeginConditionalRender	traced_glBeginConditionalRender
+#define glBeginQuery			traced_glBeginQuery
+#define glBindBuffer			traced_glBindBuffer
+#define glBindBufferBase		traced_glBindBufferBase
+#define glBindFramebuffer		traced_glBindFramebuffer
+#define glBindRenderbuffer		traced_glBindRenderbuffer
+#define glBindTexture			traced_glBindTexture
+#define glBindVertexArray		traced_glBindVertexArray
+#define glBlendFunc			traced_glBlendFunc
+#define glBlitFramebuffer		traced_glBlitFramebuffer
+#define glBufferData			traced_glBufferData
+#define glBufferSubData			traced_glBufferSubData
+#define glCheckFramebufferStatus	traced_glCheckFramebufferStatus
+#define glClear				traced_glClear
+#define glClearBufferuiv		traced_glClearBufferuiv
+#define glClearColor			traced_glClearColor
+#define glClientWaitSync		traced_glClientWaitSync
+#define glColorMask			traced_glColorMask
+#define glCompileShader			traced_glCompileShader
+#define glCreateProgram			traced_glCreateProgram
+#define glCreateShader			traced_glCreateShader
+#define glDeleteSync			traced_glDeleteSync
+#define glDepthMask			traced_glDepthMask
+#define glDisable			traced_glDisable
+#define glDisableVertexAttribArray	traced_glDisableVertexAttribArray
+#define glDispatchCompute		traced_glDispatchCompute
+#define glDrawArrays			traced_glDrawArrays
+#define glDrawArraysInstanced		traced_glDrawArraysInstanced
+#define glDrawBuffers			traced_glDrawBuffers
+#define glDrawElements			traced_glDrawElements
+#define glEnable			traced_glEnable
+#define glEnableVertexAttribArray	traced_glEnableVertexAttribArray
+#define glEndConditionalRender		traced_glEndConditionalRender
+#define glEndQuery			traced_glEndQuery
+#define glFenceSync			traced_glFenceSync
+#define glFramebufferRenderbuffer	traced_glFramebufferRenderbuffer
+#define glFramebufferTexture2D		traced_glFramebufferTexture2D
+#define glGenBuffers			traced_glGenBuffers
+#define glGenFramebuffers		traced_glGenFramebuffers
+#define glGenQueries			traced_glGenQueries
+#define glGenRenderbuffers		traced_glGenRenderbuffers
+#define glGenTextures			traced_glGenTextures
+#define glGenVertexArrays		traced_glGenVertexArrays
+#define glGetAttribLocation		traced_glGetAttribLocation
+#define glGetBufferSubData		traced_glGetBufferSubData
+#define glGetProgramInfoLog		traced_glGetProgramInfoLog
+#define glGetProgramiv			traced_glGetProgramiv
+#define glGetQueryObjectui64v		traced_glGetQueryObjectui64v
+#define glGetQueryObjectuiv		traced_glGetQueryObjectuiv
+#define glGetShaderInfoLog		traced_glGetShaderInfoLog
+#define glGetShaderiv			traced_glGetShaderiv
+#define glGetUniformBlockIndex		traced_glGetUniformBlockIndex
+#define glGetUniformLocation		traced_glGetUniformLocation
+#define glLinkProgram			traced_glLinkProgram
+#define glMapBufferRange		traced_glMapBufferRange
+#define glMemoryBarrier			traced_glMemoryBarrier
+#define glMultiDrawElementsIndirect	traced_glMultiDrawElementsIndirect
+#define glPixelStorei			traced_glPixelStorei
+#define glReadBuffer			traced_glReadBuffer
+#define glReadPixels			traced_glReadPixels
+#define glRenderbufferStorage		traced_glRenderbufferStorage
+#define glScissor			traced_glScissor
+#define glShaderSource			traced_glShaderSource
+#define glTexBuffer			traced_glTexBuffer
+#define glTexImage2D			traced_glTexImage2D
+#define glTexImage3D			traced_glTexImage3D
+#define glTexParameteri			traced_glTexParameteri
+#define glTexSubImage3D			traced_glTexSubImage3D
+#define glUniform1f			traced_glUniform1f
+#define glUniform1fv			traced_glUniform1fv
+#define glUniform1i			traced_glUniform1i
+#define glUniform1ui			traced_glUniform1ui
+#define glUniform2f			traced_glUniform2f
+#define glUniform4f			traced_glUniform4f
+#define glUniform4fv			traced_glUniform4fv
+#define glUniform4iv			traced_glUniform4iv
+#define glUniformBlockBinding		traced_glUniformBlockBinding
+#define glUniformMatrix4fv		traced_glUniformMatrix4fv
+#define glUnmapBuffer			traced_glUnmapBuffer
+#define glUseProgram			traced_glUseProgram
+#define glVertexAttrib4f		traced_glVertexAttrib4f
+#define glVertexAttribDivisor		traced_glVertexAttribDivisor
+#define glVertexAttribIPointer		traced_glVertexAttribIPointer
+#define glVertexAttribPointer		traced_glVertexAttribPointer
+#define glViewport			traced_glViewport
+
+#endif // GL_TRACE && !GL_TRACE_IMPLEMENTATION
+
+#endif // __GLTRACE_H__
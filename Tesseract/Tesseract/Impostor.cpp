@@ -0,0 +1,214 @@
+#include "Impostor.h"
+#include "Cull.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------
+
+ImpostorCache::ImpostorCache() : frame( 0 )
+{
+    memset( &last, 0, sizeof(last) );
+}
+
+void
+ImpostorCache::reset( int tiles, int count )
+{
+    Entry none;
+    memset( &none, 0, sizeof(none) );
+    none.tile = -1;
+    objects.assign( count, none );
+
+    owners.assign( tiles, -1 );
+    free_tiles.resize( tiles );
+    for ( int t = 0; t < tiles; ++t )
+	free_tiles[t] = tiles - 1 - t;	// handed out from tile 0 up
+    frame = 0;
+}
+
+//  A tile for "object": a free one, or else the one unused the longest,
+//    as long as that wasn't this frame.  -1 if there is none.
+int
+ImpostorCache::take_tile( int object )
+{
+    int tile = -1;
+    if ( !free_tiles.empty() ) {
+	tile = free_tiles.back();
+	free_tiles.pop_back();
+    } else {
+	unsigned long oldest = frame;
+	for ( int t = 0; t < (int) owners.size(); ++t ) {
+	    unsigned long used = objects[owners[t]].used;
+	    if ( used < oldest ) {
+		oldest = used;
+		tile = t;
+	    }
+	}
+	if ( tile < 0 )
+	    return -1;
+	objects[owners[tile]].tile = -1;
+	last.evictions++;
+    }
+    owners[tile] = object;
+    objects[object].tile = tile;
+    return tile;
+}
+
+//----------------------------------------------------------------------------
+
+void
+ImpostorCache::plan( const ImpostorView& view, const int* visible, int n,
+		     ImpostorPlan& plan )
+{
+    frame++;
+    memset( &last, 0, sizeof(last) );
+    plan.geometry.clear();
+    plan.billboards.clear();
+    plan.boxes.clear();
+    plan.captures.clear();
+    waiting.clear();
+    priority.clear();
+
+    const mat4& mv = view.model_view;
+
+    for ( int v = 0; v < n; ++v ) {
+	int i = visible[v];
+	GLfloat s[4];
+	ProjectedSphere( &view.centers[4*i], view.mesh_radius * view.scales[i], s );
+	GLfloat e[3];
+	for ( int k = 0; k < 3; ++k )
+	    e[k] = mv[k][0]*s[0] + mv[k][1]*s[1] + mv[k][2]*s[2] + mv[k][3];
+
+	// The square at the center's depth that holds the sphere's outline:
+	// wider than the sphere by the perspective, and more off to the side
+	GLfloat depth = -e[2], rho = s[3];
+	GLfloat distance = sqrtf( e[0]*e[0] + e[1]*e[1] + e[2]*e[2] );
+	if ( depth <= 0.0f || distance <= 2.0f*rho ) {
+	    plan.geometry.push_back( i );
+	    continue;
+	}
+	GLfloat half = rho * distance / sqrtf( distance*distance - rho*rho )
+	    * distance / depth;
+	GLfloat pixels = half * view.pixels / depth;
+	if ( pixels > view.max_pixels ) {
+	    plan.geometry.push_back( i );
+	    continue;
+	}
+
+	// How far it has turned from its tile, as the cosine of the largest
+	// angle; a new object goes ahead of every old one
+	Entry& o = objects[i];
+	GLfloat worst = -2.0f;
+	if ( o.tile >= 0 ) {
+	    o.used = frame;
+	    worst = (e[0]*o.direction[0] + e[1]*o.direction[1]
+		     + e[2]*o.direction[2]) / distance;
+	    for ( int k = 0; k < 6; ++k )
+		worst = std::min( worst, view.cosines[6*i + k]*o.cosines[k]
+				  + view.sines[6*i + k]*o.sines[k] );
+	}
+
+	int b = (int) plan.billboards.size();
+	plan.billboards.push_back( i );
+	plan.boxes.push_back( e[0] );
+	plan.boxes.push_back( e[1] );
+	plan.boxes.push_back( e[2] );
+	plan.boxes.push_back( half );
+	GLfloat error = view.max_error * view.max_pixels / std::max( pixels, 0.5f );
+	if ( worst < cos( std::min( error, GLfloat( M_PI ) ) ) ) {
+	    waiting.push_back( b );
+	    priority.push_back( -worst );
+	}
+    }
+
+    // New objects past the tiles there are to give them would only take
+    // the old ones' turns; they stay meshes
+    int spare = (int) free_tiles.size();
+    for ( size_t t = 0; t < owners.size(); ++t )
+	spare += owners[t] >= 0 && objects[owners[t]].used < frame;
+    size_t kept = 0;
+    for ( size_t k = 0; k < waiting.size(); ++k ) {
+	if ( priority[k] >= 2.0f && spare-- <= 0 )
+	    continue;
+	waiting[kept] = waiting[k];
+	priority[kept++] = priority[k];
+    }
+    waiting.resize( kept );
+    priority.resize( kept );
+
+    // The worst first, as many as may be drawn
+    int captures = std::min( (int) waiting.size(), std::max( view.refresh, 0 ) );
+    if ( captures < (int) waiting.size() ) {
+	order.resize( waiting.size() );
+	for ( size_t k = 0; k < order.size(); ++k )
+	    order[k] = k;
+	std::nth_element( order.begin(), order.begin() + captures, order.end(),
+			  [this]( int a, int b ) { return priority[a] > priority[b]; } );
+	for ( int k = 0; k < captures; ++k )
+	    order[k] = waiting[order[k]];
+	order.resize( captures );
+	waiting.swap( order );
+    }
+
+    int out_of_date = 0;
+    for ( size_t k = 0; k < priority.size(); ++k )
+	out_of_date += priority[k] < 2.0f;
+    for ( int k = 0; k < captures; ++k ) {
+	int b = waiting[k], i = plan.billboards[b];
+	Entry& o = objects[i];
+	if ( o.tile >= 0 )
+	    out_of_date--;
+	else if ( take_tile( i ) < 0 )
+	    continue;
+
+	const GLfloat* e = &plan.boxes[4*b];
+	GLfloat distance = sqrtf( e[0]*e[0] + e[1]*e[1] + e[2]*e[2] );
+	for ( int c = 0; c < 3; ++c )
+	    o.direction[c] = e[c] / distance;
+	memcpy( o.sines, &view.sines[6*i], sizeof(o.sines) );
+	memcpy( o.cosines, &view.cosines[6*i], sizeof(o.cosines) );
+	o.used = frame;
+	plan.captures.push_back( b );
+    }
+
+    // Billboards left without a tile are drawn as meshes after all
+    kept = 0;
+    moved.resize( plan.billboards.size() );
+    for ( size_t b = 0; b < plan.billboards.size(); ++b ) {
+	int i = plan.billboards[b];
+	if ( objects[i].tile < 0 ) {
+	    plan.geometry.push_back( i );
+	    continue;
+	}
+	moved[b] = kept;
+	plan.billboards[kept] = i;
+	memmove( &plan.boxes[4*kept], &plan.boxes[4*b], 4*sizeof(GLfloat) );
+	kept++;
+    }
+    plan.billboards.resize( kept );
+    plan.boxes.resize( 4*kept );
+    for ( size_t k = 0; k < plan.captures.size(); ++k )
+	plan.captures[k] = moved[plan.captures[k]];
+
+    last.geometry = plan.geometry.size();
+    last.billboards = (int) kept;
+    last.captures = plan.captures.size();
+    last.stale = out_of_date;
+}
+
+//----------------------------------------------------------------------------
+
+mat4
+ImpostorProjection( const mat4& p, const GLfloat box[4] )
+{
+    GLfloat x = p[0][0]*box[0] + p[0][1]*box[1] + p[0][2]*box[2] + p[0][3];
+    GLfloat y = p[1][0]*box[0] + p[1][1]*box[1] + p[1][2]*box[2] + p[1][3];
+    GLfloat w = p[3][0]*box[0] + p[3][1]*box[1] + p[3][2]*box[2] + p[3][3];
+    GLfloat hx = p[0][0]*box[3] / w, hy = p[1][1]*box[3] / w;
+
+    mat4 zoom( vec4( 1.0/hx, 0.0, 0.0, -x/w/hx ),
+	       vec4( 0.0, 1.0/hy, 0.0, -y/w/hy ),
+	       vec4( 0.0, 0.0, 1.0, 0.0 ),
+	       vec4( 0.0, 0.0, 0.0, 1.0 ) );
+    return zoom * p;
+}
@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Impostor.h ---
+//
+//   Billboards standing in for distant objects.  An object whose bounding
+//     sphere covers few pixels is drawn once into a tile of an atlas, as
+//     seen from where the eye is, and from then on as a camera-facing
+//     square textured with that tile.
+//
+//   A tile is good for as long as the object looks about the same: the
+//     direction from the eye to it, in eye space, and each of its six
+//     rotation angles must stay within an angular error of what they were
+//     when it was drawn.  The error allowed is max_error for the largest
+//     billboards and grows as they shrink, which keeps the error in pixels
+//     about the same.  Each frame the worst of the tiles out of date,
+//     and the objects new to the distance, are redrawn, up to a limit;
+//     the rest of the old tiles are shown as they are, and new objects
+//     left over are drawn as meshes.
+//
+//   ImpostorCache does the bookkeeping -- which object draws how, which
+//     tile it has, which tile to give up when the atlas is full (the one
+//     unused the longest) -- and the drawing is left to the caller.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __IMPOSTOR_H__
+#define __IMPOSTOR_H__
+
+#include "Angel.h"
+#include <vector>
+
+//  The view and the objects, as of this frame
+struct ImpostorView {
+    const GLfloat*  centers;	// 4 per object
+    const GLfloat*  scales;
+    const GLfloat*  sines;	// of the rotation angles, 6 per object
+    const GLfloat*  cosines;
+    GLfloat         mesh_radius;
+    mat4            model_view;
+    GLfloat         pixels;	// per unit at distance 1
+    GLfloat         max_pixels;	// largest billboard half size, in pixels
+    GLfloat         max_error;	// radians, at max_pixels
+    int             refresh;	// most tiles drawn a frame
+};
+
+//  How the visible objects are drawn this frame.  "boxes" holds each
+//    billboard's center in eye space and half size, 4 floats, and
+//    "captures" the billboards (indices into "billboards") whose tiles are
+//    to be drawn first.
+struct ImpostorPlan {
+    std::vector<int>      geometry;
+    std::vector<int>      billboards;
+    std::vector<GLfloat>  boxes;
+    std::vector<int>      captures;
+};
+
+struct ImpostorStats {
+    int  geometry;
+    int  billboards;
+    int  captures;
+    int  stale;			// shown out of date, over the refresh limit
+    int  evictions;		// tiles taken from other objects
+};
+
+class ImpostorCache {
+   public:
+    ImpostorCache();
+
+    //  Room for "tiles" tiles, for objects 0 .. objects - 1.  Forgets any
+    //    tiles drawn before.
+    void reset( int tiles, int objects );
+
+    //  Sort the visible objects, and give a tile to each one to capture.
+    //    The caller draws the captures' tiles, then the billboards and
+    //    the meshes.
+    void plan( const ImpostorView& view, const int* visible, int n,
+	       ImpostorPlan& plan );
+
+    //  An object's tile, or -1
+    int tile( int object ) const { return objects[object].tile; }
+
+    const ImpostorStats& stats() const { return last; }
+    int tile_count() const { return (int) owners.size(); }
+
+   private:
+    struct Entry {
+	int            tile;
+	unsigned long  used;		// frame last drawn from its tile
+	GLfloat        direction[3];	// eye to center, in eye space, when drawn
+	GLfloat        sines[6];
+	GLfloat        cosines[6];
+    };
+
+    int take_tile( int object );
+
+    std::vector<Entry>  objects;
+    std::vector<int>    owners;		// per tile, or -1
+    std::vector<int>    free_tiles;
+    unsigned long       frame;
+    ImpostorStats       last;
+
+    //  Scratch for plan(), kept to save allocating it every frame
+    std::vector<int>      waiting;	// billboards that want capturing
+    std::vector<GLfloat>  priority;
+    std::vector<int>      order;
+    std::vector<int>      moved;
+};
+
+//  The projection to draw a billboard's tile with: "projection", zoomed
+//    so that the square at eye-space "box" (center, half size) fills the
+//    viewport
+mat4 ImpostorProjection( const mat4& projection, const GLfloat box[4] );
+
+#endif // __IMPOSTOR_H__
@@ -1,11 +1,12 @@
 
 #include "Angel.h"
+#include "Arena.h"
 
 namespace Angel {
 
-// Create a NULL-terminated string by reading the provided file
+// Create a NULL-terminated string in "arena" by reading the provided file
 static char*
-readShaderSource(const char* shaderFile)
+readShaderSource(const char* shaderFile, Arena& arena)
 {
     FILE* fp = fopen(shaderFile, "r");
 
@@ -15,7 +16,7 @@ readShaderSource(const char* shaderFile)
     long size = ftell(fp);
 
     fseek(fp, 0L, SEEK_SET);
-    char* buf = new char[size + 1];
+    char* buf = arena.allocate<char>(size + 1);
     fread(buf, 1, size, fp);
 
     buf[size] = '\0';
@@ -25,49 +26,39 @@ readShaderSource(const char* shaderFile)
 }
 
 
-// Create a GLSL program object from vertex and fragment shader files
-GLuint
-InitShader(const char* vShaderFile, const char* fShaderFile)
+// Compile the given shader files into a program, link it and use it
+static GLuint
+make_program(const char* const* files, const GLenum* types, int count)
 {
-    struct Shader {
-	const char*  filename;
-	GLenum       type;
-	GLchar*      source;
-    }  shaders[2] = {
-	{ vShaderFile, GL_VERTEX_SHADER, NULL },
-	{ fShaderFile, GL_FRAGMENT_SHADER, NULL }
-    };
+    // Sources and logs, all freed on return
+    Arena scratch( 16*1024 );
 
     GLuint program = glCreateProgram();
     
-    for ( int i = 0; i < 2; ++i ) {
-	Shader& s = shaders[i];
-	s.source = readShaderSource( s.filename );
-	if ( shaders[i].source == NULL ) {
-	    std::cerr << "Failed to read " << s.filename << std::endl;
+    for ( int i = 0; i < count; ++i ) {
+	GLchar* source = readShaderSource( files[i], scratch );
+	if ( source == NULL ) {
+	    std::cerr << "Failed to read " << files[i] << std::endl;
 	    exit( EXIT_FAILURE );
 	}
 
-	GLuint shader = glCreateShader( s.type );
-	glShaderSource( shader, 1, (const GLchar**) &s.source, NULL );
+	GLuint shader = glCreateShader( types[i] );
+	glShaderSource( shader, 1, (const GLchar**) &source, NULL );
 	glCompileShader( shader );
 
 	GLint  compiled;
 	glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
 	if ( !compiled ) {
-	    std::cerr << s.filename << " failed to compile:" << std::endl;
+	    std::cerr << files[i] << " failed to compile:" << std::endl;
 	    GLint  logSize;
 	    glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &logSize );
-	    char* logMsg = new char[logSize];
+	    char* logMsg = scratch.allocate<char>( logSize );
 	    glGetShaderInfoLog( shader, logSize, NULL, logMsg );
 	    std::cerr << logMsg << std::endl;
-	    delete [] logMsg;
 
 	    exit( EXIT_FAILURE );
 	}
 
-	delete [] s.source;
-
 	glAttachShader( program, shader );
     }
 
@@ -80,10 +71,9 @@ InitShader(const char* vShaderFile, const char* fShaderFile)
 	std::cerr << "Shader program failed to link" << std::endl;
 	GLint  logSize;
 	glGetProgramiv( program, GL_INFO_LOG_LENGTH, &logSize);
-	char* logMsg = new char[logSize];
+	char* logMsg = scratch.allocate<char>( logSize );
 	glGetProgramInfoLog( program, logSize, NULL, logMsg );
 	std::cerr << logMsg << std::endl;
-	delete [] logMsg;
 
 	exit( EXIT_FAILURE );
     }
@@ -94,4 +84,21 @@ InitShader(const char* vShaderFile, const char* fShaderFile)
     return program;
 }
 
+// Create a GLSL program object from vertex and fragment shader files
+GLuint
+InitShader(const char* vShaderFile, const char* fShaderFile)
+{
+    const char* files[2] = { vShaderFile, fShaderFile };
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    return make_program( files, types, 2 );
+}
+
+// Same for a compute shader file (OpenGL 4.3)
+GLuint
+InitComputeShader(const char* cShaderFile)
+{
+    const GLenum type = GL_COMPUTE_SHADER;
+    return make_program( &cShaderFile, &type, 1 );
+}
+
 }  // Close namespace Angel block
@@ -0,0 +1,378 @@
+#include "JobSystem.h"
+#include <iostream>
+#include <stdlib.h>
+
+const int MaxContinuations = 8;
+
+//  Threads other than the workers that may submit jobs (GLUT, simulation)
+const int MaxExternalThreads = 8;
+
+struct Job {
+    std::function<void()>  task;
+    Job*                   parent;
+    std::atomic<int>       unfinished;	  // itself plus unfinished children
+    std::atomic<int>       dependencies;  // jobs to wait for, +1 until run()
+    std::atomic<bool>      done;	  // set last; the slot may be reused after
+
+    std::atomic_flag       lock;	  // guards the continuation list
+    bool                   closed;	  // finished; no more continuations
+    int                    continuation_count;
+    Job*                   continuations[MaxContinuations];
+};
+
+//----------------------------------------------------------------------------
+//
+//  Fixed-size Chase-Lev deque.  Only the owning thread calls push() and
+//    pop(); any thread may steal().
+//
+
+class JobDeque {
+   public:
+    static const int Capacity = 4096;
+
+    JobDeque() : top( 0 ), bottom( 0 ) {
+	for ( int i = 0; i < Capacity; ++i )
+	    slots[i].store( NULL, std::memory_order_relaxed );
+    }
+
+    bool push( Job* job ) {
+	long b = bottom.load( std::memory_order_relaxed );
+	long t = top.load( std::memory_order_acquire );
+	if ( b - t >= Capacity )
+	    return false;
+
+	slots[b & (Capacity-1)].store( job, std::memory_order_relaxed );
+	bottom.store( b + 1, std::memory_order_release );
+	return true;
+    }
+
+    Job* pop() {
+	long b = bottom.load( std::memory_order_relaxed ) - 1;
+	bottom.store( b, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	long t = top.load( std::memory_order_relaxed );
+
+	if ( t > b ) {
+	    bottom.store( b + 1, std::memory_order_relaxed );
+	    return NULL;
+	}
+
+	Job* job = slots[b & (Capacity-1)].load( std::memory_order_relaxed );
+	if ( t == b ) {
+	    // Last job: race the thieves for it
+	    if ( !top.compare_exchange_strong( t, t + 1,
+					       std::memory_order_seq_cst,
+					       std::memory_order_relaxed ) )
+		job = NULL;
+	    bottom.store( b + 1, std::memory_order_relaxed );
+	}
+	return job;
+    }
+
+    Job* steal() {
+	long t = top.load( std::memory_order_acquire );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	long b = bottom.load( std::memory_order_acquire );
+	if ( t >= b )
+	    return NULL;
+
+	Job* job = slots[t & (Capacity-1)].load( std::memory_order_relaxed );
+	if ( !top.compare_exchange_strong( t, t + 1,
+					   std::memory_order_seq_cst,
+					   std::memory_order_relaxed ) )
+	    return NULL;
+	return job;
+    }
+
+   private:
+    std::atomic<long>  top;
+    std::atomic<long>  bottom;
+    std::atomic<Job*>  slots[Capacity];
+};
+
+//----------------------------------------------------------------------------
+
+struct JobSystem::ThreadState {
+    JobDeque      deque;
+    Job           jobs[JobSystem::JobsPerThread];
+    unsigned int  next_job;
+    unsigned int  victim;	// where to start looking when stealing
+
+    ThreadState() : next_job( 0 ), victim( 0 ) {}
+};
+
+//  Which deque the current thread owns, per JobSystem instance.  A thread
+//    that submits to several systems by turns keeps its deque in each;
+//    the one used last is looked at first.
+struct ThreadSlot {
+    int  system;
+    int  index;
+};
+
+static thread_local ThreadSlot               current_slot = { -1, -1 };
+static thread_local std::vector<ThreadSlot>  known_slots;
+static std::atomic<int>  next_system_id( 0 );
+
+//----------------------------------------------------------------------------
+
+JobSystem::JobSystem( int threads )
+    : registered( 0 ), queued( 0 ), quit( false ), sleeping( 0 )
+{
+    id = next_system_id++;
+
+    if ( threads <= 0 )
+	threads = (int) std::thread::hardware_concurrency();
+    if ( threads <= 0 )
+	threads = 1;
+
+    int worker_count = threads - 1;
+    for ( int i = 0; i < worker_count + MaxExternalThreads; ++i )
+	states.push_back( new ThreadState );
+
+    registered = worker_count;
+    for ( int i = 0; i < worker_count; ++i )
+	workers.push_back( std::thread( &JobSystem::worker, this, i ) );
+}
+
+JobSystem::~JobSystem()
+{
+    {
+	std::lock_guard<std::mutex> lock( sleep_mutex );
+	quit = true;
+    }
+    wake.notify_all();
+
+    for ( unsigned int i = 0; i < workers.size(); ++i )
+	workers[i].join();
+    for ( unsigned int i = 0; i < states.size(); ++i )
+	delete states[i];
+}
+
+JobSystem::ThreadState&
+JobSystem::this_thread()
+{
+    if ( current_slot.system != id ) {
+	size_t k = 0;
+	while ( k < known_slots.size() && known_slots[k].system != id )
+	    k++;
+	if ( k == known_slots.size() ) {
+	    ThreadSlot slot = { id, registered++ };
+	    if ( slot.index >= (int) states.size() ) {
+		std::cerr << "JobSystem: too many threads submit jobs" << std::endl;
+		exit( EXIT_FAILURE );
+	    }
+	    known_slots.push_back( slot );
+	}
+	current_slot = known_slots[k];
+    }
+    return *states[current_slot.index];
+}
+
+//----------------------------------------------------------------------------
+
+Job*
+JobSystem::allocate()
+{
+    ThreadState& self = this_thread();
+    Job* job = &self.jobs[self.next_job++ % JobsPerThread];
+
+    job->parent = NULL;
+    job->unfinished.store( 1, std::memory_order_relaxed );
+    job->dependencies.store( 1, std::memory_order_relaxed );
+    job->done.store( false, std::memory_order_relaxed );
+    job->lock.clear();
+    job->closed = false;
+    job->continuation_count = 0;
+    return job;
+}
+
+Job*
+JobSystem::create( const std::function<void()>& task, Job* parent )
+{
+    Job* job = allocate();
+    job->task = task;
+    job->parent = parent;
+    if ( parent )
+	parent->unfinished.fetch_add( 1, std::memory_order_relaxed );
+    return job;
+}
+
+void
+JobSystem::depends( Job* job, Job* on )
+{
+    job->dependencies.fetch_add( 1, std::memory_order_relaxed );
+
+    while ( on->lock.test_and_set( std::memory_order_acquire ) )
+	;
+    bool added = false;
+    if ( !on->closed ) {
+	if ( on->continuation_count == MaxContinuations ) {
+	    std::cerr << "JobSystem: too many dependents on one job" << std::endl;
+	    exit( EXIT_FAILURE );
+	}
+	on->continuations[on->continuation_count++] = job;
+	added = true;
+    }
+    on->lock.clear( std::memory_order_release );
+
+    if ( !added )
+	job->dependencies.fetch_sub( 1, std::memory_order_relaxed );
+}
+
+void
+JobSystem::run( Job* job )
+{
+    if ( job->dependencies.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+	push( job );
+}
+
+bool
+JobSystem::finished( const Job* job ) const
+{
+    return job->done.load( std::memory_order_acquire );
+}
+
+void
+JobSystem::wait( Job* job )
+{
+    ThreadState& self = this_thread();
+
+    while ( !finished( job ) ) {
+	Job* next = find_job( self );
+	if ( next )
+	    execute( next );
+	else
+	    std::this_thread::yield();
+    }
+}
+
+//----------------------------------------------------------------------------
+
+void
+JobSystem::push( Job* job )
+{
+    if ( !this_thread().deque.push( job ) ) {
+	// Deque full: run it right here rather than wait for room
+	execute( job );
+	return;
+    }
+
+    queued.fetch_add( 1 );
+    if ( sleeping.load() > 0 ) {
+	std::lock_guard<std::mutex> lock( sleep_mutex );
+	wake.notify_one();
+    }
+}
+
+Job*
+JobSystem::find_job( ThreadState& self )
+{
+    Job* job = self.deque.pop();
+
+    if ( !job ) {
+	int count = registered.load();
+	if ( count > (int) states.size() )
+	    count = (int) states.size();
+
+	for ( int i = 0; i < count && !job; ++i ) {
+	    ThreadState* other = states[(self.victim + i) % count];
+	    if ( other != &self )
+		job = other->deque.steal();
+	}
+	self.victim++;
+    }
+
+    if ( job )
+	queued.fetch_sub( 1 );
+    return job;
+}
+
+void
+JobSystem::execute( Job* job )
+{
+    if ( job->task )
+	job->task();
+    finish( job );
+}
+
+void
+JobSystem::finish( Job* job )
+{
+    if ( job->unfinished.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+	return;
+
+    Job* parent = job->parent;
+    Job* continuations[MaxContinuations];
+
+    while ( job->lock.test_and_set( std::memory_order_acquire ) )
+	;
+    job->closed = true;
+    int count = job->continuation_count;
+    for ( int i = 0; i < count; ++i )
+	continuations[i] = job->continuations[i];
+    job->lock.clear( std::memory_order_release );
+
+    // Waiters may return and the slot be reused from here on
+    job->done.store( true, std::memory_order_release );
+
+    for ( int i = 0; i < count; ++i )
+	run( continuations[i] );
+    if ( parent )
+	finish( parent );
+}
+
+//----------------------------------------------------------------------------
+
+void
+JobSystem::worker( int index )
+{
+    current_slot.system = id;
+    current_slot.index = index;
+    known_slots.push_back( current_slot );
+    ThreadState& self = *states[index];
+
+    while ( !quit.load() ) {
+	Job* job = find_job( self );
+	if ( job ) {
+	    execute( job );
+	    continue;
+	}
+
+	// Nothing to steal: sleep until something is queued
+	std::unique_lock<std::mutex> lock( sleep_mutex );
+	sleeping++;
+	wake.wait( lock, [this] { return quit.load() || queued.load() > 0; } );
+	sleeping--;
+    }
+}
+
+//----------------------------------------------------------------------------
+
+void
+JobSystem::parallel_for( int begin, int end, int grain,
+			 const std::function<void(int, int)>& body )
+{
+    int n = end - begin;
+    if ( n <= 0 )
+	return;
+
+    if ( grain <= 0 )
+	grain = n / (4*threads());
+    if ( grain < n / 1024 )	// keep well inside the job ring
+	grain = n / 1024;
+    if ( grain < 1 )
+	grain = 1;
+
+    if ( n <= grain || threads() == 1 ) {
+	body( begin, end );
+	return;
+    }
+
+    Job* root = create( std::function<void()>() );
+    for ( int first = begin; first < end; first += grain ) {
+	int last = first + grain < end ? first + grain : end;
+	run( create( [&body, first, last] { body( first, last ); }, root ) );
+    }
+    run( root );
+    wait( root );
+}
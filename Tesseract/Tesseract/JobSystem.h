@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- JobSystem.h ---
+//
+//   Work-stealing task scheduler for the per-frame CPU work.  Every thread
+//     that submits jobs owns a deque: it pushes and pops at the bottom, and
+//     idle threads steal from the top of the others.  Jobs may have a
+//     parent (the parent finishes only after all its children) and may
+//     depend on other jobs (they are started when those have finished).
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __JOBSYSTEM_H__
+#define __JOBSYSTEM_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+class JobSystem {
+   public:
+    //  "threads" counts the calling thread too; 0 means one per core
+    explicit JobSystem( int threads = 0 );
+    ~JobSystem();
+
+    int threads() const { return (int) workers.size() + 1; }
+
+    //  A job runs "task" once.  With a parent, the parent is not finished
+    //    until this job is.  Jobs stay valid until the creating thread
+    //    has made JobsPerThread newer ones.
+    Job* create( const std::function<void()>& task, Job* parent = NULL );
+
+    //  "job" will not start before "on" has finished.  Call before run().
+    void depends( Job* job, Job* on );
+
+    //  Submit a job; it starts as soon as its dependencies are done
+    void run( Job* job );
+
+    //  Work on queued jobs until "job" has finished
+    void wait( Job* job );
+
+    bool finished( const Job* job ) const;
+
+    //  Call body(first, last) over [begin, end) split in ranges of about
+    //    "grain" items (0 picks one from the thread count), and wait
+    void parallel_for( int begin, int end, int grain,
+		       const std::function<void(int, int)>& body );
+
+    static const int JobsPerThread = 4096;
+
+   private:
+    struct ThreadState;
+
+    ThreadState& this_thread();
+    Job* allocate();
+    void push( Job* job );
+    Job* find_job( ThreadState& self );
+    void execute( Job* job );
+    void finish( Job* job );
+    void worker( int index );
+
+    std::vector<std::thread>   workers;
+    std::vector<ThreadState*>  states;
+    std::atomic<int>           registered;
+    std::atomic<int>           queued;
+    std::atomic<bool>          quit;
+
+    std::mutex                 sleep_mutex;
+    std::condition_variable    wake;
+    std::atomic<int>           sleeping;
+
+    int                        id;	// tells apart JobSystem instances
+};
+
+#endif // __JOBSYSTEM_H__
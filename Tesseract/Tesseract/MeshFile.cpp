@@ -0,0 +1,352 @@
+#include "MeshFile.h"
+#include "FixedMesh.h"
+#include <limits.h>
+#include <string.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------
+//
+//  Reading
+//
+
+MeshFile::MeshFile() :
+    base( NULL ), size( 0 )
+#ifdef _WIN32
+    , file( NULL ), mapping( NULL )
+#endif
+{
+}
+
+MeshFile::~MeshFile()
+{
+    close();
+}
+
+//  Whether the "n" indices at "data" are all of the first "vertices"
+template <class T>
+static bool
+indices_below( const void* data, uint64_t n, uint64_t vertices )
+{
+    const T* index = (const T*) data;
+    for ( uint64_t i = 0; i < n; ++i )
+	if ( index[i] >= vertices )
+	    return false;
+    return true;
+}
+
+//  The header and the table are in bounds, and every section is too.  The
+//    kinds of section this format defines have the shapes it gives them:
+//    positions of "dimension" floats, edges and triangles (and cells) of
+//    2 and 3 (and 4 or more) indices of one size, all below the vertex
+//    count, and a color of 4 floats for every vertex.  Each kind is there
+//    at most once.
+static bool
+check( const char* base, size_t size )
+{
+    if ( size < sizeof(MeshFileHeader) )
+	return false;
+
+    const MeshFileHeader* h = (const MeshFileHeader*) base;
+    if ( memcmp( h->magic, "M4D", 4 ) != 0
+	 || h->version != MeshFileVersion
+	 || h->byte_order != MeshFileByteOrder
+	 || h->file_size != size
+	 || h->dimension < 1 )
+	return false;
+
+    uint64_t table_end = sizeof(MeshFileHeader)
+	+ (uint64_t) h->sections * sizeof(MeshFileSection);
+    if ( table_end > size )
+	return false;
+
+    // Sizes are checked by division, so that no count, however large,
+    // overflows; counts of values must fit an int
+    const MeshFileSection* s = (const MeshFileSection*) (h + 1);
+    const MeshFileSection* kinds[MESH_NUM_SECTION_KINDS] = { NULL };
+    for ( uint32_t i = 0; i < h->sections; ++i ) {
+	uint64_t each = (uint64_t) s[i].group * s[i].value_size;
+	if ( s[i].offset < table_end || s[i].offset > size
+	     || s[i].offset % MeshFileAlignment != 0
+	     || (each != 0 && s[i].count > (size - s[i].offset) / each)
+	     || (s[i].group != 0 && s[i].count > (uint64_t) INT_MAX / s[i].group) )
+	    return false;
+	if ( s[i].kind < MESH_NUM_SECTION_KINDS ) {
+	    if ( kinds[s[i].kind] )
+		return false;
+	    kinds[s[i].kind] = &s[i];
+	}
+    }
+
+    const MeshFileSection* positions = kinds[MESH_POSITIONS];
+    if ( positions && (positions->value_size != sizeof(float)
+		       || positions->group != h->dimension) )
+	return false;
+    uint64_t vertices = positions ? positions->count : 0;
+
+    const MeshFileSection* colors = kinds[MESH_COLORS];
+    if ( colors && (colors->value_size != sizeof(float) || colors->group != 4
+		    || colors->count != vertices) )
+	return false;
+
+    uint32_t index_size = 0;
+    for ( int k = MESH_EDGES; k <= MESH_CELLS; ++k ) {
+	const MeshFileSection* x = kinds[k];
+	if ( x == NULL )
+	    continue;
+	bool shaped = k == MESH_EDGES ? x->group == 2
+	    : k == MESH_TRIANGLES ? x->group == 3 : x->group >= 4;
+	if ( !shaped || (x->value_size != 2 && x->value_size != 4)
+	     || (index_size && x->value_size != index_size) )
+	    return false;
+	index_size = x->value_size;
+
+	const void* data = base + x->offset;
+	uint64_t n = x->count * x->group;
+	if ( !(x->value_size == 2 ? indices_below<uint16_t>( data, n, vertices )
+	       : indices_below<uint32_t>( data, n, vertices )) )
+	    return false;
+    }
+    return true;
+}
+
+bool
+MeshFile::open( const char* filename )
+{
+    close();
+
+#ifdef _WIN32
+    file = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( file == INVALID_HANDLE_VALUE ) {
+	file = NULL;
+	return false;
+    }
+    LARGE_INTEGER length;
+    if ( !GetFileSizeEx( (HANDLE) file, &length ) || length.QuadPart == 0 ) {
+	close();
+	return false;
+    }
+    mapping = CreateFileMappingA( (HANDLE) file, NULL, PAGE_READONLY, 0, 0, NULL );
+    if ( mapping == NULL ) {
+	close();
+	return false;
+    }
+    size = (size_t) length.QuadPart;
+    base = (const char*) MapViewOfFile( (HANDLE) mapping, FILE_MAP_READ, 0, 0, 0 );
+#else
+    int fd = ::open( filename, O_RDONLY );
+    if ( fd < 0 )
+	return false;
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || st.st_size == 0 ) {
+	::close( fd );
+	return false;
+    }
+    size = (size_t) st.st_size;
+    void* p = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );		// the mapping keeps the file
+    base = p == MAP_FAILED ? NULL : (const char*) p;
+#endif
+
+    if ( base == NULL || !check( base, size ) ) {
+	close();
+	return false;
+    }
+    return true;
+}
+
+void
+MeshFile::close()
+{
+#ifdef _WIN32
+    if ( base )
+	UnmapViewOfFile( base );
+    if ( mapping )
+	CloseHandle( (HANDLE) mapping );
+    if ( file )
+	CloseHandle( (HANDLE) file );
+    mapping = file = NULL;
+#else
+    if ( base )
+	munmap( (void*) base, size );
+#endif
+    base = NULL;
+    size = 0;
+}
+
+int
+MeshFile::dimension() const
+{
+    return base ? (int) ((const MeshFileHeader*) base)->dimension : 0;
+}
+
+const MeshFileSection*
+MeshFile::find( MeshSectionKind kind ) const
+{
+    if ( base == NULL )
+	return NULL;
+
+    const MeshFileHeader* h = (const MeshFileHeader*) base;
+    const MeshFileSection* s = (const MeshFileSection*) (h + 1);
+    for ( uint32_t i = 0; i < h->sections; ++i )
+	if ( s[i].kind == (uint32_t) kind )
+	    return &s[i];
+    return NULL;
+}
+
+int
+MeshFile::vertex_count() const
+{
+    const MeshFileSection* s = find( MESH_POSITIONS );
+    return s ? (int) s->count : 0;
+}
+
+//----------------------------------------------------------------------------
+//
+//  Writing
+//
+
+MeshFileWriter::MeshFileWriter( int dimension ) :
+    dimension( dimension )
+{
+}
+
+void
+MeshFileWriter::add( MeshSectionKind kind, int value_size, int group,
+		     size_t count, const void* data )
+{
+    MeshFileSection s;
+    memset( &s, 0, sizeof(s) );
+    s.kind = kind;
+    s.value_size = value_size;
+    s.group = group;
+    s.count = count;
+    sections.push_back( s );
+    arrays.push_back( data );
+}
+
+static uint64_t
+align( uint64_t offset )
+{
+    return (offset + MeshFileAlignment - 1) & ~(uint64_t) (MeshFileAlignment - 1);
+}
+
+bool
+MeshFileWriter::save( const char* filename ) const
+{
+    // Lay out the sections after the table
+    std::vector<MeshFileSection> table( sections );
+    uint64_t offset = sizeof(MeshFileHeader) + table.size() * sizeof(MeshFileSection);
+    for ( size_t i = 0; i < table.size(); ++i ) {
+	table[i].offset = align( offset );
+	offset = table[i].offset + table[i].bytes();
+    }
+
+    MeshFileHeader h;
+    memset( &h, 0, sizeof(h) );
+    memcpy( h.magic, "M4D", 4 );
+    h.version = MeshFileVersion;
+    h.byte_order = MeshFileByteOrder;
+    h.dimension = dimension;
+    h.sections = (uint32_t) table.size();
+    h.file_size = offset;
+
+    FILE* fp = fopen( filename, "wb" );
+    if ( fp == NULL )
+	return false;
+
+    static const char zeros[MeshFileAlignment] = { 0 };
+    uint64_t at = sizeof(h) + table.size() * sizeof(MeshFileSection);
+    bool ok = fwrite( &h, sizeof(h), 1, fp ) == 1
+	&& (table.empty()
+	    || fwrite( &table[0], sizeof(MeshFileSection), table.size(), fp ) == table.size());
+    for ( size_t i = 0; ok && i < table.size(); ++i ) {
+	size_t pad = (size_t) (table[i].offset - at);
+	size_t bytes = (size_t) table[i].bytes();
+	ok = fwrite( zeros, 1, pad, fp ) == pad
+	    && (bytes == 0 || fwrite( arrays[i], 1, bytes, fp ) == bytes);
+	at = table[i].offset + bytes;
+    }
+    ok = fclose( fp ) == 0 && ok;
+
+    if ( !ok )
+	remove( filename );
+    return ok;
+}
+
+//----------------------------------------------------------------------------
+//
+//  Converters
+//
+
+//  The face colors, cycled over the vertices, with the solid shader's w
+static std::vector<vec4>
+vertex_colors( int count )
+{
+    std::vector<vec4> colors( count );
+    for ( int i = 0; i < count; ++i ) {
+	colors[i] = FaceColors[i % 24];
+	colors[i].w = FaceShadeAlpha;
+    }
+    return colors;
+}
+
+bool
+SavePolytopeMeshFile( const Polytope& p, const char* filename )
+{
+    std::vector<PolytopeIndex> triangles;
+    int fs = p.face_size;
+    for ( int f = 0; f < p.face_count(); ++f ) {
+	const PolytopeIndex* corner = &p.faces[f*fs];
+	for ( int i = 1; i + 1 < fs; ++i ) {
+	    triangles.push_back( corner[PolytopeFaceLoop( p, 0 )] );
+	    triangles.push_back( corner[PolytopeFaceLoop( p, i )] );
+	    triangles.push_back( corner[PolytopeFaceLoop( p, i+1 )] );
+	}
+    }
+    std::vector<vec4> colors = vertex_colors( p.vertex_count() );
+
+    const int index = sizeof(PolytopeIndex);
+    MeshFileWriter w( p.dimension );
+    w.add( MESH_POSITIONS, sizeof(GLfloat), p.dimension, p.vertex_count(),
+	   p.positions.data() );
+    w.add( MESH_EDGES, index, 2, p.edge_count(), p.edges.data() );
+    w.add( MESH_TRIANGLES, index, 3, triangles.size() / 3, triangles.data() );
+    if ( p.cell_size )
+	w.add( MESH_CELLS, index, p.cell_size, p.cell_count(), p.cells.data() );
+    w.add( MESH_COLORS, sizeof(GLfloat), 4, colors.size(), colors.data() );
+    return w.save( filename );
+}
+
+bool
+SaveWythoffMeshFile( const WythoffMesh& mesh, const char* filename )
+{
+    std::vector<PolytopeIndex> triangles;
+    for ( int f = 0; f < mesh.face_count(); ++f ) {
+	const PolytopeIndex* corner = &mesh.face_indices[mesh.face_start[f]];
+	int corners = mesh.face_start[f+1] - mesh.face_start[f];
+	for ( int i = 1; i + 1 < corners; ++i ) {
+	    triangles.push_back( corner[0] );
+	    triangles.push_back( corner[i] );
+	    triangles.push_back( corner[i+1] );
+	}
+    }
+    std::vector<vec4> colors = vertex_colors( mesh.vertex_count() );
+
+    const int index = sizeof(PolytopeIndex);
+    MeshFileWriter w( 4 );
+    w.add( MESH_POSITIONS, sizeof(GLfloat), 4, mesh.vertex_count(),
+	   mesh.positions.data() );
+    w.add( MESH_EDGES, index, 2, mesh.edge_count(), mesh.edges.data() );
+    w.add( MESH_TRIANGLES, index, 3, triangles.size() / 3, triangles.data() );
+    w.add( MESH_COLORS, sizeof(GLfloat), 4, colors.size(), colors.data() );
+    return w.save( filename );
+}
@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- MeshFile.h ---
+//
+//   A binary format for N-dimensional meshes that is used straight from a
+//     memory map.  The file is a header, a table of sections, and then
+//     each section's array exactly as it goes into a buffer object,
+//     starting on a 64-byte boundary.  Opening a file maps it and checks
+//     the header, the table and the sections' shapes, with one pass over
+//     the indices; nothing is parsed or copied, and the arrays can go to
+//     glBufferData() as they are.
+//
+//     MeshFileHeader         "M4D", version, byte order, dimension
+//     MeshFileSection[n]     kind, value size, values per element, count,
+//                              offset from the start of the file
+//     section data ...
+//
+//   Positions are floats, "dimension" per vertex (a vec4 each for 4D);
+//     indices are 16 or 32 bits, as the section's value size says.
+//     Readers skip section kinds they don't know, so new kinds of
+//     attribute don't change the version; only a change to the header or
+//     the table does.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __MESHFILE_H__
+#define __MESHFILE_H__
+
+#include "Polytope.h"
+#include "Wythoff.h"
+#include <stdint.h>
+#include <vector>
+
+const uint32_t MeshFileVersion = 1;
+const uint32_t MeshFileByteOrder = 0x01020304;
+const int MeshFileAlignment = 64;
+
+enum MeshSectionKind {
+    MESH_POSITIONS,	// float, "dimension" per vertex
+    MESH_EDGES,		// index, 2 per edge
+    MESH_TRIANGLES,	// index, 3 per triangle (the 2-faces, fanned)
+    MESH_CELLS,		// index, the vertices of each 3-face
+    MESH_COLORS,	// float, RGBA per vertex
+    MESH_NUM_SECTION_KINDS
+};
+
+struct MeshFileHeader {
+    char      magic[4];		// "M4D\0"
+    uint32_t  version;
+    uint32_t  byte_order;	// MeshFileByteOrder as the writer stored it
+    uint32_t  dimension;
+    uint32_t  sections;
+    uint32_t  reserved;
+    uint64_t  file_size;
+};
+
+struct MeshFileSection {
+    uint32_t  kind;		// MeshSectionKind
+    uint32_t  value_size;	// bytes per value: 4 for floats, 2 or 4 for indices
+    uint32_t  group;		// values per element (vertex, edge, ...)
+    uint32_t  reserved;
+    uint64_t  count;		// elements
+    uint64_t  offset;		// of the data from the start of the file
+
+    //  No overflow in a file MeshFile::open() took
+    uint64_t bytes() const { return count * group * value_size; }
+};
+
+//----------------------------------------------------------------------------
+
+//  A mesh file mapped into memory, read-only
+class MeshFile {
+   public:
+    MeshFile();
+    ~MeshFile();
+
+    //  Map "filename" and check it.  False if it can't be read, is not a
+    //    mesh file, is of another version or the other byte order, has a
+    //    section that runs past its end, or has a section of a known kind
+    //    not shaped as MeshSectionKind says -- including an index of a
+    //    vertex that isn't there.  A file that opens can be read by the
+    //    sections' counts without further checks.
+    bool open( const char* filename );
+    void close();
+
+    bool is_open() const { return base != NULL; }
+    int dimension() const;
+    size_t file_size() const { return size; }
+
+    //  The section of a kind, or NULL if there is none
+    const MeshFileSection* find( MeshSectionKind kind ) const;
+    const void* data( const MeshFileSection* section ) const
+	{ return base + section->offset; }
+
+    int vertex_count() const;
+
+   private:
+    const char*  base;
+    size_t       size;
+#ifdef _WIN32
+    void*        file;
+    void*        mapping;
+#endif
+
+    MeshFile( const MeshFile& );
+    MeshFile& operator = ( const MeshFile& );
+};
+
+//----------------------------------------------------------------------------
+
+//  Collects sections and writes a mesh file.  The arrays are not copied,
+//    so they must stay put until save().
+class MeshFileWriter {
+   public:
+    explicit MeshFileWriter( int dimension );
+
+    void add( MeshSectionKind kind, int value_size, int group, size_t count,
+	      const void* data );
+
+    bool save( const char* filename ) const;
+
+   private:
+    int                           dimension;
+    std::vector<MeshFileSection>  sections;
+    std::vector<const void*>      arrays;
+};
+
+//  Converters from the built-in generators: positions, edges, the 2-faces
+//    as triangles, the cells (polytopes only) and a color per vertex
+bool SavePolytopeMeshFile( const Polytope& p, const char* filename );
+bool SaveWythoffMeshFile( const WythoffMesh& mesh, const char* filename );
+
+#endif // __MESHFILE_H__
@@ -0,0 +1,226 @@
+#include "PointCloud.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+PointCloud::PointCloud()
+{
+}
+
+//  The 8-bit cell of each coordinate, bits interleaved, so that points
+//    close in 4D are mostly close in the sorted order
+static unsigned int
+morton_key( const GLfloat* p, const GLfloat* lo, const GLfloat* scale )
+{
+    unsigned int key = 0;
+    for ( int k = 0; k < 4; ++k ) {
+	int cell = (int) ((p[k] - lo[k]) * scale[k]);
+	cell = cell < 0 ? 0 : cell > 255 ? 255 : cell;
+	for ( int bit = 0; bit < 8; ++bit )
+	    key |= ((cell >> bit) & 1u) << (4*bit + k);
+    }
+    return key;
+}
+
+void
+PointCloud::build( const GLfloat* positions, const GLubyte* rgba, int count,
+		   int chunk_size )
+{
+    chunks.clear();
+    quantized.assign( (size_t) 4 * count, 0 );
+    colors.assign( count, 0xffffffffu );
+    if ( count <= 0 )
+	return;
+    if ( chunk_size < 1 )
+	chunk_size = count;
+
+    GLfloat lo[4], hi[4], scale[4];
+    for ( int k = 0; k < 4; ++k )
+	lo[k] = hi[k] = positions[k];
+    for ( int i = 1; i < count; ++i )
+	for ( int k = 0; k < 4; ++k ) {
+	    GLfloat x = positions[4*i + k];
+	    if ( x < lo[k] ) lo[k] = x;
+	    if ( x > hi[k] ) hi[k] = x;
+	}
+    for ( int k = 0; k < 4; ++k )
+	scale[k] = hi[k] > lo[k] ? 256.0f / (hi[k] - lo[k]) : 0.0f;
+
+    // Radix sort on the keys, 16 bits a pass
+    std::vector<unsigned int> keys( count );
+    for ( int i = 0; i < count; ++i )
+	keys[i] = morton_key( &positions[4*i], lo, scale );
+
+    const int Buckets = 1 << 16;
+    std::vector<int> order( count ), sorted( count ), start( Buckets + 1 );
+    for ( int i = 0; i < count; ++i )
+	order[i] = i;
+    for ( int shift = 0; shift < 32; shift += 16 ) {
+	std::fill( start.begin(), start.end(), 0 );
+	for ( int i = 0; i < count; ++i )
+	    start[((keys[i] >> shift) & 0xffff) + 1]++;
+	for ( int b = 0; b < Buckets; ++b )
+	    start[b + 1] += start[b];
+	for ( int i = 0; i < count; ++i ) {
+	    int from = order[i];
+	    sorted[start[(keys[from] >> shift) & 0xffff]++] = from;
+	}
+	order.swap( sorted );
+    }
+
+    // Gather each chunk's points in sorted order once, then work on the copy
+    std::vector<GLfloat> gathered( (size_t) 4 * chunk_size );
+    for ( int first = 0; first < count; first += chunk_size ) {
+	PointChunk c;
+	c.first = first;
+	c.count = count - first < chunk_size ? count - first : chunk_size;
+
+	for ( int i = 0; i < c.count; ++i ) {
+	    int from = order[first + i];
+	    memcpy( &gathered[4*i], &positions[4*from], 4 * sizeof(GLfloat) );
+	    if ( rgba )
+		memcpy( &colors[first + i], &rgba[4*from], 4 );
+	}
+
+	GLfloat chi[4];
+	for ( int k = 0; k < 4; ++k )
+	    c.lo[k] = chi[k] = gathered[k];
+	for ( int i = 1; i < c.count; ++i )
+	    for ( int k = 0; k < 4; ++k ) {
+		GLfloat x = gathered[4*i + k];
+		if ( x < c.lo[k] ) c.lo[k] = x;
+		if ( x > chi[k] ) chi[k] = x;
+	    }
+
+	GLfloat inverse[4];
+	for ( int k = 0; k < 4; ++k ) {
+	    c.extent[k] = chi[k] - c.lo[k];
+	    c.center[k] = 0.5f * (c.lo[k] + chi[k]);
+	    inverse[k] = c.extent[k] > 0.0f ? 65535.0f / c.extent[k] : 0.0f;
+	}
+
+	GLfloat r2 = 0.0f;
+	GLushort* q = &quantized[(size_t) 4 * first];
+	for ( int i = 0; i < c.count; ++i ) {
+	    const GLfloat* p = &gathered[4*i];
+	    GLfloat d2 = 0.0f;
+	    for ( int k = 0; k < 4; ++k ) {
+		GLfloat d = p[k] - c.center[k];
+		d2 += d*d;
+		q[4*i + k] = (GLushort) ((p[k] - c.lo[k]) * inverse[k] + 0.5f);
+	    }
+	    if ( d2 > r2 )
+		r2 = d2;
+	}
+	c.radius = sqrtf( r2 );
+	chunks.push_back( c );
+    }
+}
+
+//----------------------------------------------------------------------------
+
+void
+PointCloud::position( int i, GLfloat out[4] ) const
+{
+    // Chunks are all the same length but the last
+    const PointChunk& c = chunks[i / chunks[0].count];
+    for ( int k = 0; k < 4; ++k )
+	out[k] = c.lo[k] + quantized[4*i + k] * (c.extent[k] / 65535.0f);
+}
+
+GLfloat
+PointCloud::max_error() const
+{
+    GLfloat error = 0.0f;
+    for ( size_t i = 0; i < chunks.size(); ++i )
+	for ( int k = 0; k < 4; ++k )
+	    if ( chunks[i].extent[k] > error )
+		error = chunks[i].extent[k];
+    return 0.5f * error / 65535.0f;
+}
+
+//----------------------------------------------------------------------------
+
+int
+PointCloud::cull( const GLfloat* m, const GLfloat* t, const mat4& clip,
+		  int* visible ) const
+{
+    // The six frustum planes, from the rows of the clip matrix
+    GLfloat plane[6][4];
+    for ( int p = 0; p < 6; ++p ) {
+	GLfloat sign = p & 1 ? -1.0f : 1.0f;
+	GLfloat length = 0.0f;
+	for ( int k = 0; k < 4; ++k ) {
+	    plane[p][k] = clip[3][k] + sign * clip[p/2][k];
+	    if ( k < 3 )
+		length += plane[p][k] * plane[p][k];
+	}
+	length = length > 0.0f ? 1.0f / sqrtf( length ) : 0.0f;
+	for ( int k = 0; k < 4; ++k )
+	    plane[p][k] *= length;
+    }
+
+    // The rotation is scaled uniformly
+    GLfloat scale = sqrtf( m[0]*m[0] + m[1]*m[1] + m[2]*m[2] + m[3]*m[3] );
+
+    int n = 0;
+    for ( int i = 0; i < (int) chunks.size(); ++i ) {
+	const PointChunk& c = chunks[i];
+	GLfloat x[4];
+	for ( int r = 0; r < 4; ++r )
+	    x[r] = m[4*r]*c.center[0] + m[4*r+1]*c.center[1]
+		+ m[4*r+2]*c.center[2] + m[4*r+3]*c.center[3] + t[r];
+
+	// A point d away from x lands d.xyz (w + 1) + xyz d.w + d.xyz d.w
+	// from x's own projection, which is within |d| (|(xyz, w + 1)| + |d|)
+	GLfloat r4 = scale * c.radius;
+	GLfloat w = x[3] + 1.0f;
+	GLfloat r3 = r4 * (sqrtf( x[0]*x[0] + x[1]*x[1] + x[2]*x[2] + w*w ) + r4);
+
+	bool inside = true;
+	for ( int p = 0; p < 6 && inside; ++p )
+	    inside = plane[p][0]*x[0]*w + plane[p][1]*x[1]*w + plane[p][2]*x[2]*w
+		+ plane[p][3] >= -r3;
+	if ( inside )
+	    visible[n++] = i;
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------------
+
+//  Small deterministic generator, as for the scene
+static GLfloat
+random_unit( unsigned int& state )
+{
+    state = state*1664525u + 1013904223u;
+    return GLfloat( state >> 8 ) / GLfloat( 1 << 24 );
+}
+
+void
+MakeTestPointCloud( std::vector<GLfloat>& positions, std::vector<GLubyte>& colors,
+		    int count )
+{
+    const GLfloat R = 0.5f, thickness = 0.06f;
+    unsigned int state = 1;
+
+    positions.resize( (size_t) 4 * count );
+    colors.resize( (size_t) 4 * count );
+    for ( int i = 0; i < count; ++i ) {
+	GLfloat a = 2.0f * M_PI * random_unit( state );
+	GLfloat b = 2.0f * M_PI * random_unit( state );
+	GLfloat* p = &positions[4*i];
+	p[0] = R * cosf( a );
+	p[1] = R * sinf( a );
+	p[2] = R * cosf( b );
+	p[3] = R * sinf( b );
+	for ( int k = 0; k < 4; ++k )
+	    p[k] += thickness * (random_unit( state ) - 0.5f);
+
+	GLubyte* c = &colors[4*i];
+	c[0] = (GLubyte) (127.5f + 127.0f * cosf( a ));
+	c[1] = (GLubyte) (127.5f + 127.0f * sinf( b ));
+	c[2] = (GLubyte) (127.5f + 127.0f * cosf( a + b ));
+	c[3] = 255;
+    }
+}
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- PointCloud.h ---
+//
+//   Large sets of 4D points, stored the way they are drawn: 16 bits per
+//     coordinate and 8 per color channel, 12 bytes a point against 32 for
+//     a vec4 position and a vec4 color.
+//
+//   The points are sorted into chunks of nearby points.  Each chunk keeps
+//     the box its coordinates are quantized against -- a point is
+//     lo + q / 65535 * extent, with q the stored value -- and a 4D
+//     bounding sphere.  A chunk's sphere is carried through the same
+//     rotation and projection as its points, so chunks entirely outside
+//     the view can be skipped without looking at their points.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __POINTCLOUD_H__
+#define __POINTCLOUD_H__
+
+#include "Angel.h"
+#include <vector>
+
+const int PointCloudBytesPerPoint = 4 * sizeof(GLushort) + sizeof(GLuint);
+const int PointCloudNaiveBytesPerPoint = 2 * sizeof(vec4);
+
+struct PointChunk {
+    GLfloat  lo[4];		// quantization box
+    GLfloat  extent[4];
+    GLfloat  center[4];		// bounding sphere
+    GLfloat  radius;
+    int      first;		// points [first, first + count)
+    int      count;
+};
+
+class PointCloud {
+   public:
+    PointCloud();
+
+    //  Sort, chunk and quantize "count" points of 4 floats each, with an
+    //    RGBA color of 4 bytes each (NULL for white)
+    void build( const GLfloat* positions, const GLubyte* colors, int count,
+		int chunk_size = 16384 );
+
+    int point_count() const { return (int) colors.size(); }
+    int chunk_count() const { return (int) chunks.size(); }
+    const PointChunk& chunk( int i ) const { return chunks[i]; }
+
+    //  4 values per point, to be read as normalized unsigned shorts
+    const GLushort* quantized_positions() const { return quantized.data(); }
+    //  RGBA8, one per point
+    const GLuint* packed_colors() const { return colors.data(); }
+
+    //  Point i as floats again
+    void position( int i, GLfloat out[4] ) const;
+
+    //  Largest difference between a coordinate and its quantized value,
+    //    from the chunk boxes
+    GLfloat max_error() const;
+
+    //  Fill "visible" with the chunks that may show, and return how many.
+    //    The points are placed by the 4 x 4 matrix "m" (row by row) and the
+    //    offset "t" -- Projector::matrix() and offset() -- then projected
+    //    to 3D as the shaders do, and then "clip" (projection times model
+    //    view) takes them to clip space.
+    int cull( const GLfloat* m, const GLfloat* t, const mat4& clip,
+	      int* visible ) const;
+
+   private:
+    std::vector<PointChunk>  chunks;
+    std::vector<GLushort>    quantized;
+    std::vector<GLuint>      colors;
+};
+
+//  A synthetic cloud of "count" points: a thickened Clifford torus,
+//    colored by its two angles, the same on every run
+void MakeTestPointCloud( std::vector<GLfloat>& positions,
+			 std::vector<GLubyte>& colors, int count );
+
+#endif // __POINTCLOUD_H__
@@ -0,0 +1,277 @@
+#include "Polytope.h"
+#include <string.h>
+
+//----------------------------------------------------------------------------
+//
+//  Bit helpers
+//
+
+//  Next larger integer with the same number of set bits (Gosper's hack)
+static inline unsigned int
+next_combination( unsigned int x )
+{
+    unsigned int lowest = x & (0u - x);
+    unsigned int ripple = x + lowest;
+    return (((ripple ^ x) >> 2) / lowest) | ripple;
+}
+
+//  Indices of the set bits of "mask", lowest first; returns how many
+static inline int
+bit_indices( unsigned int mask, int* out )
+{
+    int n = 0;
+    for ( int i = 0; mask; ++i, mask >>= 1 ) {
+	if ( mask & 1 )
+	    out[n++] = i;
+    }
+    return n;
+}
+
+//  Number of ways to choose k of n
+static size_t
+choose( int n, int k )
+{
+    size_t c = 1;
+    for ( int i = 1; i <= k; ++i )
+	c = c * (n - k + i) / i;
+    return c;
+}
+
+//----------------------------------------------------------------------------
+
+size_t
+Polytope::bytes() const
+{
+    return positions.size() * sizeof(GLfloat)
+	+ (edges.size() + faces.size() + cells.size()) * sizeof(PolytopeIndex);
+}
+
+static void
+begin( Polytope& p, PolytopeFamily family, int dimension, int vertices )
+{
+    p.dimension = dimension;
+    p.family = family;
+    p.positions.assign( (size_t) vertices * dimension, 0.0f );
+    p.edges.clear();
+    p.faces.clear();
+    p.cells.clear();
+
+    // The lists hold proper faces only, so the whole polytope is never
+    // one; but the 1-polytope is a segment, and is kept as its one edge
+    if ( dimension == 1 ) {
+	p.edges.push_back( 0 );
+	p.edges.push_back( 1 );
+    }
+}
+
+//----------------------------------------------------------------------------
+//
+//  N-cube
+//
+
+//  Append every k-face of the N-cube: all bases of every k-axis mask
+static void
+hypercube_faces( std::vector<PolytopeIndex>& out, int n, int k )
+{
+    if ( k >= n )
+	return;
+
+    unsigned int all = (1u << n) - 1;
+    int corners = 1 << k;
+    out.reserve( choose( n, k ) * ((size_t) 1 << (n - k)) * corners );
+
+    for ( unsigned int mask = (1u << k) - 1; mask <= all;
+	  mask = next_combination( mask ) ) {
+	// The free axes as single bits, so corner j is the base plus the
+	// axis bits picked out by the bits of j
+	unsigned int axis[32];
+	int axes = 0;
+	for ( unsigned int m = mask; m; m &= m - 1 )
+	    axis[axes++] = m & (0u - m);
+
+	unsigned int fixed = all & ~mask;
+	unsigned int base = 0;
+	do {
+	    for ( int j = 0; j < corners; ++j ) {
+		unsigned int v = base;
+		for ( int a = 0; a < axes; ++a )
+		    if ( j & (1 << a) )
+			v |= axis[a];
+		out.push_back( (PolytopeIndex) v );
+	    }
+	    base = (base - fixed) & fixed;	// next subset of the fixed axes
+	} while ( base != 0 );
+
+	if ( k == 0 )
+	    break;
+    }
+}
+
+bool
+MakeHypercube( Polytope& p, int n )
+{
+    if ( n < 1 || n > MaxPolytopeDimension )
+	return false;
+
+    int vertices = 1 << n;
+    begin( p, POLYTOPE_HYPERCUBE, n, vertices );
+
+    // On the unit sphere: every coordinate +-1/sqrt(n)
+    GLfloat s = 1.0f / sqrt( (GLfloat) n );
+    for ( int v = 0; v < vertices; ++v )
+	for ( int i = 0; i < n; ++i )
+	    p.positions[v*n + i] = (v & (1 << i)) ? s : -s;
+
+    hypercube_faces( p.edges, n, 1 );
+    hypercube_faces( p.faces, n, 2 );
+    hypercube_faces( p.cells, n, 3 );
+    p.face_size = n >= 3 ? 4 : 0;
+    p.cell_size = n >= 4 ? 8 : 0;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//
+//  N-simplex
+//
+
+//  Append every k-face of the N-simplex: every (k+1)-subset of its N+1
+//    vertices
+static void
+simplex_faces( std::vector<PolytopeIndex>& out, int n, int k )
+{
+    if ( k >= n )
+	return;
+
+    int size = k + 1;
+    unsigned int end = 1u << (n + 1);
+    out.reserve( choose( n + 1, size ) * size );
+
+    for ( unsigned int mask = (1u << size) - 1; mask < end;
+	  mask = next_combination( mask ) ) {
+	int index[32];
+	bit_indices( mask, index );
+	for ( int i = 0; i < size; ++i )
+	    out.push_back( (PolytopeIndex) index[i] );
+    }
+}
+
+bool
+MakeSimplex( Polytope& p, int n )
+{
+    if ( n < 1 || n > MaxPolytopeDimension )
+	return false;
+
+    int vertices = n + 1;
+    begin( p, POLYTOPE_SIMPLEX, n, vertices );
+
+    // The unit vectors e_0 .. e_n-1 plus a point on the diagonal at the
+    // same distance (sqrt 2) from all of them; then center and scale
+    std::vector<GLfloat>& x = p.positions;
+    for ( int i = 0; i < n; ++i )
+	x[i*n + i] = 1.0f;
+    GLfloat a = (1.0f - sqrt( (GLfloat) (n + 1) )) / n;
+    for ( int i = 0; i < n; ++i )
+	x[n*n + i] = a;
+
+    GLfloat center = (1.0f + n*a) / (n + 1);	// same on every axis
+    for ( size_t i = 0; i < x.size(); ++i )
+	x[i] -= center;
+
+    GLfloat r2 = 0.0f;
+    for ( int i = 0; i < n; ++i )
+	r2 += x[i] * x[i];
+    GLfloat s = 1.0f / sqrt( r2 );
+    for ( size_t i = 0; i < x.size(); ++i )
+	x[i] *= s;
+
+    simplex_faces( p.edges, n, 1 );
+    simplex_faces( p.faces, n, 2 );
+    simplex_faces( p.cells, n, 3 );
+    p.face_size = n >= 3 ? 3 : 0;
+    p.cell_size = n >= 4 ? 4 : 0;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//
+//  N-orthoplex
+//
+
+//  Append every k-face of the N-orthoplex: k+1 distinct axes, each with
+//    either sign
+static void
+orthoplex_faces( std::vector<PolytopeIndex>& out, int n, int k )
+{
+    if ( k >= n )
+	return;
+
+    int size = k + 1;
+    unsigned int end = 1u << n;
+    int signs = 1 << size;
+    out.reserve( choose( n, size ) * signs * size );
+
+    for ( unsigned int mask = (1u << size) - 1; mask < end;
+	  mask = next_combination( mask ) ) {
+	int axis[32];
+	bit_indices( mask, axis );
+	for ( int s = 0; s < signs; ++s )
+	    for ( int i = 0; i < size; ++i )
+		out.push_back( (PolytopeIndex) (2*axis[i] + ((s >> i) & 1)) );
+    }
+}
+
+bool
+MakeOrthoplex( Polytope& p, int n )
+{
+    if ( n < 1 || n > MaxPolytopeDimension )
+	return false;
+
+    int vertices = 2 * n;
+    begin( p, POLYTOPE_ORTHOPLEX, n, vertices );
+
+    for ( int i = 0; i < n; ++i ) {
+	p.positions[(2*i)*n + i] = 1.0f;
+	p.positions[(2*i + 1)*n + i] = -1.0f;
+    }
+
+    orthoplex_faces( p.edges, n, 1 );
+    orthoplex_faces( p.faces, n, 2 );
+    orthoplex_faces( p.cells, n, 3 );
+    p.face_size = n >= 3 ? 3 : 0;
+    p.cell_size = n >= 4 ? 4 : 0;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+MakePolytope( Polytope& p, PolytopeFamily family, int dimension )
+{
+    switch ( family ) {
+    case POLYTOPE_HYPERCUBE:  return MakeHypercube( p, dimension );
+    case POLYTOPE_SIMPLEX:    return MakeSimplex( p, dimension );
+    case POLYTOPE_ORTHOPLEX:  return MakeOrthoplex( p, dimension );
+    default:                  return false;
+    }
+}
+
+static const char* family_names[POLYTOPE_NUM_FAMILIES] = {
+    "hypercube", "simplex", "orthoplex"
+};
+
+const char*
+PolytopeFamilyName( PolytopeFamily family )
+{
+    return family >= 0 && family < POLYTOPE_NUM_FAMILIES
+	? family_names[family] : "unknown";
+}
+
+int
+PolytopeFamilyFromName( const char* name )
+{
+    for ( int i = 0; i < POLYTOPE_NUM_FAMILIES; ++i )
+	if ( strcmp( name, family_names[i] ) == 0 )
+	    return i;
+    return -1;
+}
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Polytope.h ---
+//
+//   Combinatorial generators for the three regular polytopes that exist in
+//     every dimension: the N-cube, the N-simplex and the N-orthoplex (the
+//     N-dimensional octahedron).  Each produces its vertices plus indexed
+//     lists of edges, 2-faces and 3-faces (cells).  The lists hold proper
+//     faces only: the N-polytope is never a face of itself, save that the
+//     1-polytope keeps its segment as an edge.
+//
+//   Vertices are numbered so that the faces follow from bit operations on
+//     the vertex indices alone -- no pairs of vertices are ever compared:
+//
+//     N-cube       vertex v has coordinate i = +1 if bit i of v is set,
+//                    else -1.  A k-face is a set of k free axes (a mask
+//                    with k bits) plus a base vertex with those bits clear.
+//     N-simplex    vertices 0..N; a k-face is any set of k+1 of them.
+//     N-orthoplex  vertex 2i+s is -1^s along axis i; a k-face takes k+1
+//                    different axes and one sign on each.
+//
+//   Sets of k axes are walked in order with Gosper's hack.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __POLYTOPE_H__
+#define __POLYTOPE_H__
+
+#include "Angel.h"
+#include <vector>
+
+//  Indices are 16 bits, so at most 2^16 vertices (the 16-cube)
+typedef GLushort PolytopeIndex;
+
+const int MaxPolytopeDimension = 12;
+
+enum PolytopeFamily {
+    POLYTOPE_HYPERCUBE,
+    POLYTOPE_SIMPLEX,
+    POLYTOPE_ORTHOPLEX,
+    POLYTOPE_NUM_FAMILIES
+};
+
+struct Polytope {
+    int                         dimension;
+    PolytopeFamily              family;
+
+    //  "dimension" coordinates per vertex, on the unit sphere
+    std::vector<GLfloat>        positions;
+
+    //  Vertex indices: 2 per edge, face_size per 2-face and cell_size per
+    //    3-face.  Square faces and cubic cells of the N-cube list their
+    //    vertices in the order of the free axes' bits (0, x, y, xy, z, ...);
+    //    use PolytopeFaceLoop() to walk a face around its boundary.
+    std::vector<PolytopeIndex>  edges;
+    std::vector<PolytopeIndex>  faces;
+    std::vector<PolytopeIndex>  cells;
+    int                         face_size;
+    int                         cell_size;
+
+    int vertex_count() const { return (int) positions.size() / dimension; }
+    int edge_count() const { return (int) edges.size() / 2; }
+    int face_count() const { return face_size ? (int) faces.size() / face_size : 0; }
+    int cell_count() const { return cell_size ? (int) cells.size() / cell_size : 0; }
+
+    //  Memory taken by the arrays above
+    size_t bytes() const;
+};
+
+//  Fill "p" with the regular polytope of the given family in "dimension"
+//    dimensions (1 .. MaxPolytopeDimension).  Returns false if the
+//    dimension is out of range.
+bool MakePolytope( Polytope& p, PolytopeFamily family, int dimension );
+
+bool MakeHypercube( Polytope& p, int dimension );
+bool MakeSimplex( Polytope& p, int dimension );
+bool MakeOrthoplex( Polytope& p, int dimension );
+
+//  Position in the face's vertex list of its i-th corner going around it
+inline int
+PolytopeFaceLoop( const Polytope& p, int i )
+{
+    static const int square[4] = { 0, 1, 3, 2 };
+    return p.face_size == 4 ? square[i] : i;
+}
+
+//  "hypercube", "simplex" or "orthoplex", and back; -1 if not recognized
+const char* PolytopeFamilyName( PolytopeFamily family );
+int PolytopeFamilyFromName( const char* name );
+
+#endif // __POLYTOPE_H__
@@ -0,0 +1,197 @@
+#include "Projector.h"
+
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+
+//  The 4D planes as the shaders have them; -1 where the shader's matrix
+//    turns the second axis towards the first
+static const int      shader_planes[6][2] = {
+    { 0, 1 }, { 1, 2 }, { 0, 2 }, { 0, 3 }, { 1, 3 }, { 2, 3 }
+};
+static const GLfloat  shader_signs[6] = { 1.0, 1.0, -1.0, 1.0, -1.0, -1.0 };
+
+void
+RotationPlaneAxes( int p, int& a, int& b, GLfloat& sign )
+{
+    if ( p < 6 ) {
+	a = shader_planes[p][0];
+	b = shader_planes[p][1];
+	sign = shader_signs[p];
+	return;
+    }
+
+    // Axis j owns planes j(j-1)/2 .. j(j+1)/2 - 1
+    int j = 4;
+    while ( (j + 1) * j / 2 <= p )
+	j++;
+    a = p - j * (j - 1) / 2;
+    b = j;
+    sign = 1.0;
+}
+
+//----------------------------------------------------------------------------
+
+Projector::Projector() :
+    n( 0 ), count( 0 ), stride( 0 )
+{
+}
+
+bool
+Projector::set_vertices( int dimension, const GLfloat* positions, int vertices )
+{
+    if ( dimension < 3 || dimension > MaxProjectorDimension )
+	return false;
+
+    n = dimension;
+    count = vertices;
+    stride = (count + 3) & ~3;
+
+    coords.assign( (size_t) n * stride, 0.0f );
+    for ( int v = 0; v < count; ++v )
+	for ( int k = 0; k < n; ++k )
+	    coords[k*stride + v] = positions[v*n + k];
+
+    transform.assign( n * n, 0.0f );
+    for ( int i = 0; i < n; ++i ) {
+	transform[i*n + i] = 1.0;
+	translate[i] = 0.0;
+    }
+    return true;
+}
+
+//  Each plane rotation multiplies on the left, so it only mixes two rows
+//    of what has been composed so far
+void
+Projector::set_rotation( const GLfloat* angles, GLfloat scale,
+			 const GLfloat* center )
+{
+    GLfloat* m = &transform[0];
+    for ( int i = 0; i < n; ++i )
+	for ( int k = 0; k < n; ++k )
+	    m[i*n + k] = i == k ? scale : 0.0f;
+
+    for ( int p = 0; p < RotationPlaneCount( n ); ++p ) {
+	int a, b;
+	GLfloat sign;
+	RotationPlaneAxes( p, a, b, sign );
+
+	GLfloat angle = angles[p] * DegreesToRadians;
+	GLfloat c = cos( angle );
+	GLfloat s = sign * sin( angle );
+	GLfloat* ra = m + a*n;
+	GLfloat* rb = m + b*n;
+	for ( int k = 0; k < n; ++k ) {
+	    GLfloat x = ra[k], y = rb[k];
+	    ra[k] = c*x - s*y;
+	    rb[k] = s*x + c*y;
+	}
+    }
+
+    for ( int i = 0; i < n; ++i )
+	translate[i] = center ? center[i] : 0.0f;
+}
+
+//----------------------------------------------------------------------------
+
+#ifdef __SSE__
+//  Four vertices at a time, first and last multiples of 4.  With N fixed
+//    the loops unroll and the N sums stay in registers.
+template <int N>
+static void
+project_simd( const GLfloat* m, const GLfloat* t, const GLfloat* coords,
+	      int stride, int first, int last, vec4* out )
+{
+    const __m128 one = _mm_set1_ps( 1.0f );
+    __m128 y[N];
+
+    for ( int v = first; v < last; v += 4 ) {
+	for ( int i = 0; i < N; ++i )
+	    y[i] = _mm_set1_ps( t[i] );
+	for ( int k = 0; k < N; ++k ) {
+	    __m128 x = _mm_loadu_ps( coords + k*stride + v );
+	    for ( int i = 0; i < N; ++i )
+		y[i] = _mm_add_ps( y[i], _mm_mul_ps( _mm_set1_ps( m[i*N + k] ), x ) );
+	}
+
+	for ( int d = N - 1; d >= 3; --d ) {
+	    __m128 f = _mm_add_ps( y[d], one );
+	    for ( int i = 0; i < d; ++i )
+		y[i] = _mm_mul_ps( y[i], f );
+	}
+
+	// Four x's, y's and z's to four (x, y, z, 1) points
+	__m128 x0 = y[0], x1 = y[1], x2 = y[2], x3 = one;
+	_MM_TRANSPOSE4_PS( x0, x1, x2, x3 );
+	_mm_storeu_ps( out[v], x0 );
+	_mm_storeu_ps( out[v+1], x1 );
+	_mm_storeu_ps( out[v+2], x2 );
+	_mm_storeu_ps( out[v+3], x3 );
+    }
+}
+#endif
+
+//  y = M x + t, then for d = n-1 down to 3: y[0..d-1] *= y[d] + 1.  Both
+//    versions add the terms in the same order, so they agree exactly.
+void
+Projector::project( int first, int last, vec4* out ) const
+{
+    if ( first >= last )
+	return;
+
+#ifdef __SSE__
+    // Scalar up to the next multiple of 4, so each load is four whole
+    // vertices of one coordinate array
+    int simd_first = (first + 3) & ~3;
+    if ( simd_first > last )
+	simd_first = last;
+    int simd_last = simd_first + ((last - simd_first) & ~3);
+    project_scalar( first, simd_first, out );
+
+    const GLfloat* m = &transform[0];
+    const GLfloat* x = &coords[0];
+    switch ( n ) {
+    case 3:  project_simd<3>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 4:  project_simd<4>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 5:  project_simd<5>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 6:  project_simd<6>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 7:  project_simd<7>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 8:  project_simd<8>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 9:  project_simd<9>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 10: project_simd<10>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 11: project_simd<11>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    case 12: project_simd<12>( m, translate, x, stride, simd_first, simd_last, out ); break;
+    }
+
+    project_scalar( simd_last, last, out );
+#else
+    project_scalar( first, last, out );
+#endif
+}
+
+void
+Projector::project_scalar( int first, int last, vec4* out ) const
+{
+    const GLfloat* m = &transform[0];
+    GLfloat y[MaxProjectorDimension];
+
+    for ( int v = first; v < last; ++v ) {
+	for ( int i = 0; i < n; ++i )
+	    y[i] = translate[i];
+	for ( int k = 0; k < n; ++k ) {
+	    GLfloat x = coords[k*stride + v];
+	    for ( int i = 0; i < n; ++i )
+		y[i] += m[i*n + k] * x;
+	}
+
+	for ( int d = n - 1; d >= 3; --d ) {
+	    GLfloat f = y[d] + 1.0f;
+	    for ( int i = 0; i < d; ++i )
+		y[i] *= f;
+	}
+
+	out[v] = vec4( y[0], y[1], y[2], 1.0 );
+    }
+}
@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Projector.h ---
+//
+//   Rotation and projection of N-dimensional vertices down to 3D on the
+//     CPU, for shapes the vertex shaders (fixed at 4D) cannot draw.
+//
+//   An N-dimensional rotation is one angle in each of the N(N-1)/2 axis
+//     planes.  set_rotation() composes them, together with the object's
+//     scale and center, into a single N x N matrix plus offset once per
+//     frame; project() then applies it to every vertex and follows with
+//     the chain of perspective steps N -> N-1 -> ... -> 3 that the shaders
+//     do for 4D (w += 1, then scale the other coordinates by w).
+//
+//   Vertices are kept as one array per coordinate so the SIMD pass reads
+//     four vertices at a time.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __PROJECTOR_H__
+#define __PROJECTOR_H__
+
+#include "Angel.h"
+#include "Polytope.h"
+#include <vector>
+
+const int MaxProjectorDimension = MaxPolytopeDimension;
+
+//  Number of rotation planes in N dimensions
+inline int
+RotationPlaneCount( int n )
+{
+    return n * (n - 1) / 2;
+}
+
+//  Plane p turns axis a towards axis b by sign*angle.  The first six are
+//    the 4D planes in the order and direction used by the vertex shaders
+//    (XY, YZ, XZ, XW, YW, ZW); the rest take each further axis j against
+//    the axes below it.
+void RotationPlaneAxes( int p, int& a, int& b, GLfloat& sign );
+
+class Projector {
+   public:
+    Projector();
+
+    //  Take a copy of "count" vertices of n coordinates each, stored one
+    //    vertex after another (the Polytope layout).  Returns false if n
+    //    is below 3 or above MaxProjectorDimension.
+    bool set_vertices( int n, const GLfloat* positions, int count );
+
+    //  Compose the rotation from RotationPlaneCount(n) angles in degrees,
+    //    followed by a uniform scale and a move to "center" (n
+    //    coordinates; NULL for the origin)
+    void set_rotation( const GLfloat* angles, GLfloat scale = 1.0,
+		       const GLfloat* center = NULL );
+
+    //  Rotate, place and project vertices [first, last) into out[first] ..
+    //    out[last-1] as 3D points (w = 1).  Different ranges can be done
+    //    on different threads.
+    void project( int first, int last, vec4* out ) const;
+
+    //  Plain scalar loop, kept as the reference for the SIMD one
+    void project_scalar( int first, int last, vec4* out ) const;
+
+    int dimension() const { return n; }
+    int vertex_count() const { return count; }
+
+    //  The composed n x n matrix, row by row, and the offset added after it
+    const GLfloat* matrix() const { return &transform[0]; }
+    const GLfloat* offset() const { return translate; }
+
+   private:
+    int                   n;
+    int                   count;
+    int                   stride;	// count rounded up to a multiple of 4
+    std::vector<GLfloat>  coords;	// n arrays of "stride" floats
+    std::vector<GLfloat>  transform;
+    GLfloat               translate[MaxProjectorDimension];
+};
+
+#endif // __PROJECTOR_H__
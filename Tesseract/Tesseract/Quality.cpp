@@ -0,0 +1,189 @@
+#include "Quality.h"
+#include <algorithm>
+
+//  How far each knob goes, and in what steps
+static const GLfloat  ResolutionStep = 0.125;
+static const GLfloat  LodStep = 0.5;
+static const GLfloat  MaxLodBias = 3.0;
+static const int      MinObjects = 16;
+
+static const char* knob_names[] = {
+    "resolution", "lod bias", "wireframe", "object cap"
+};
+
+//----------------------------------------------------------------------------
+
+QualityController::QualityController() :
+    budget( 1000.0 / 60.0 ), log( NULL ), objects( 0 ), min_resolution( 0.5 ),
+    frames( 0 ), cost_sum( 0.0 ), cpu_sum( 0.0 ), gpu_sum( 0.0 ),
+    gpu_frames( 0 ), calm_windows( 0 ), frame_number( 0 ), changes( 0 )
+{
+    current.resolution_scale = 1.0;
+    current.lod_bias = 0.0;
+    current.object_cap = 0;
+    current.wireframe = true;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+QualityController::lower( Knob knob, double cost, double cpu, double gpu )
+{
+    switch ( knob ) {
+    case RESOLUTION:
+	if ( current.resolution_scale <= min_resolution )
+	    return false;
+	current.resolution_scale = std::max( current.resolution_scale - ResolutionStep,
+					     min_resolution );
+	break;
+    case LOD:
+	if ( current.lod_bias >= MaxLodBias )
+	    return false;
+	current.lod_bias = std::min( current.lod_bias + LodStep, MaxLodBias );
+	break;
+    case WIREFRAME:
+	if ( !current.wireframe )
+	    return false;
+	current.wireframe = false;
+	break;
+    case CAP: {
+	int cap = current.object_cap ? current.object_cap : objects;
+	if ( cap <= MinObjects )
+	    return false;
+	current.object_cap = std::max( cap * 3 / 4, MinObjects );
+	break;
+    }
+    }
+    Lowering l = { knob, cost, cpu, gpu, 0.0, 0.0, 0.0 };
+    lowered.push_back( l );
+    return true;
+}
+
+void
+QualityController::raise( Knob knob )
+{
+    switch ( knob ) {
+    case RESOLUTION:
+	current.resolution_scale = std::min( current.resolution_scale + ResolutionStep,
+					     GLfloat( 1.0 ) );
+	break;
+    case LOD:
+	current.lod_bias = std::max( current.lod_bias - LodStep, GLfloat( 0.0 ) );
+	break;
+    case WIREFRAME:
+	current.wireframe = true;
+	break;
+    case CAP:
+	current.object_cap = current.object_cap * 4 / 3 + 1;
+	if ( current.object_cap >= objects )
+	    current.object_cap = 0;
+	break;
+    }
+}
+
+//----------------------------------------------------------------------------
+
+bool
+QualityController::update( double frame_ms, double cpu_ms, double gpu_ms )
+{
+    frame_number++;
+
+    // Without a GPU time, the whole frame-to-frame time stands in for it
+    cost_sum += gpu_ms >= 0.0 ? std::max( cpu_ms, gpu_ms ) : frame_ms;
+    cpu_sum += cpu_ms;
+    if ( gpu_ms >= 0.0 ) {
+	gpu_sum += gpu_ms;
+	gpu_frames++;
+    }
+    if ( ++frames < Window )
+	return false;
+
+    double cost = cost_sum / frames, cpu = cpu_sum / frames;
+    double gpu = gpu_frames ? gpu_sum / gpu_frames : -1.0;
+
+    // With no GPU time, a frame that mostly waits outside display() is
+    // taken to be waiting on the GPU
+    bool gpu_bound = gpu >= 0.0 ? gpu >= cpu : cpu < 0.5*cost;
+
+    frames = gpu_frames = 0;
+    cost_sum = cpu_sum = gpu_sum = 0.0;
+
+    // The first window since the last knob went down tells what it saved
+    if ( !lowered.empty() && lowered.back().cost_gain == 0.0 ) {
+	Lowering& l = lowered.back();
+	l.cost_gain = std::max( l.cost / cost, 1.0 );
+	l.cpu_gain = std::max( l.cpu / cpu, 1.0 );
+	l.gpu_gain = l.gpu >= 0.0 && gpu > 0.0 ? std::max( l.gpu / gpu, 1.0 ) : 0.0;
+    }
+
+    if ( cost > budget ) {
+	calm_windows = 0;
+
+	static const Knob gpu_order[] = { RESOLUTION, LOD, WIREFRAME, CAP };
+	static const Knob cpu_order[] = { WIREFRAME, CAP, LOD, RESOLUTION };
+	const Knob* order = gpu_bound ? gpu_order : cpu_order;
+	for ( int i = 0; i < 4; ++i )
+	    if ( lower( order[i], cost, cpu, gpu ) ) {
+		report( "lower", order[i], cost, cpu, gpu, gpu_bound );
+		return true;
+	    }
+	return false;		// nothing left to give
+    }
+
+    if ( cost >= LowWater*budget || lowered.empty() ) {
+	calm_windows = 0;
+	return false;
+    }
+    // What the frame would cost with the knob back up.  The CPU and GPU
+    // are told apart where possible, since the one that was the bottleneck
+    // when it went down may not be any more.
+    const Lowering& last = lowered.back();
+    double raised = last.gpu_gain > 0.0 && gpu >= 0.0
+	? std::max( cpu * last.cpu_gain, gpu * last.gpu_gain )
+	: cost * last.cost_gain;
+    if ( ++calm_windows < RaiseAfter || raised > budget )
+	return false;
+
+    calm_windows = 0;
+    Knob knob = lowered.back().knob;
+    lowered.pop_back();
+    raise( knob );
+    report( "raise", knob, cost, cpu, gpu, gpu_bound );
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+void
+QualityController::describe( char* buf, size_t size ) const
+{
+    char cap[16] = "all";
+    if ( current.object_cap )
+	snprintf( cap, sizeof(cap), "%d", current.object_cap );
+
+    snprintf( buf, size, "resolution %.3f  lod bias %.1f  wireframe %s  objects %s",
+	      current.resolution_scale, current.lod_bias,
+	      current.wireframe ? "on" : "off", cap );
+}
+
+void
+QualityController::report( const char* action, Knob knob, double cost,
+			   double cpu, double gpu, bool gpu_bound )
+{
+    changes++;
+    if ( !log )
+	return;
+
+    char timing[64];
+    if ( gpu >= 0.0 )
+	snprintf( timing, sizeof(timing), "cpu %.2f gpu %.2f", cpu, gpu );
+    else
+	snprintf( timing, sizeof(timing), "cpu %.2f gpu ?", cpu );
+
+    char knobs[128];
+    describe( knobs, sizeof(knobs) );
+
+    fprintf( log, "quality: frame %lu  %.2f ms of %.2f (%s, %s bound): %s %s  ->  %s\n",
+	     frame_number, cost, budget, timing, gpu_bound ? "gpu" : "cpu",
+	     action, knob_names[knob], knobs );
+}
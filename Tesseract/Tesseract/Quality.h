@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Quality.h ---
+//
+//   Holds the frame time near a budget by turning quality knobs down when
+//     frames run long and back up when there is room.  The measured cost
+//     of a frame is the larger of its CPU and GPU times (the frame-to-
+//     frame time if the GPU time is unknown), averaged over a window of
+//     frames.
+//
+//   Hysteresis keeps it from hunting: a knob is turned down after a
+//     window averaging over the budget, but back up only after RaiseAfter
+//     windows in a row under LowWater of it, and only if the CPU and GPU
+//     time it saved when turned down would still fit.  Every window is
+//     measured afresh at the setting of the one before.  With vsync on
+//     and no GPU timer, the frame time can't fall below the refresh
+//     interval, so the budget should be set above it.
+//
+//   Which knob moves depends on where the time goes.  A GPU-bound frame
+//     lowers the resolution, then coarsens the levels of detail; a
+//     CPU-bound one drops the wireframe pass, then caps the number of
+//     objects drawn.  Each falls back on the other side's knobs once its
+//     own are at their limits.  Quality comes back in the opposite order,
+//     the last knob turned down first.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __QUALITY_H__
+#define __QUALITY_H__
+
+#include "Angel.h"
+#include <vector>
+
+struct QualityKnobs {
+    GLfloat  resolution_scale;	// of the offscreen target, 1 for full size
+    GLfloat  lod_bias;		// levels coarser than picked, 0 or more
+    int      object_cap;	// most objects drawn, 0 for no limit
+    bool     wireframe;		// draw the wireframe pass
+};
+
+class QualityController {
+   public:
+    static const int  Window = 30;		// frames averaged
+    static const int  RaiseAfter = 2;		// windows under LowWater
+    static constexpr double  LowWater = 0.8;	// of the budget
+
+    //  Starts at full quality, with a budget of 60 Hz
+    QualityController();
+
+    void set_budget( double ms ) { budget = ms; }
+
+    //  Every decision is written as a line to "file", if not NULL
+    void set_log( FILE* file ) { log = file; }
+
+    //  The objects in the scene, the most the cap can allow
+    void set_object_count( int n ) { objects = n; }
+
+    //  The lowest resolution scale to go to; 1 leaves the resolution alone
+    void set_min_resolution( GLfloat scale ) { min_resolution = scale; }
+
+    //  One frame's times; gpu_ms < 0 if it wasn't measured.  Returns true
+    //    if a knob changed.
+    bool update( double frame_ms, double cpu_ms, double gpu_ms );
+
+    const QualityKnobs& knobs() const { return current; }
+
+    //  Knob changes so far
+    int decisions() const { return changes; }
+
+    //  The knobs as text, for reports
+    void describe( char* buf, size_t size ) const;
+
+   private:
+    enum Knob { RESOLUTION, LOD, WIREFRAME, CAP };
+
+    bool lower( Knob knob, double cost, double cpu, double gpu );
+    void raise( Knob knob );
+    void report( const char* action, Knob knob, double cost, double cpu,
+		 double gpu, bool gpu_bound );
+
+    double        budget;
+    FILE*         log;
+    int           objects;
+    GLfloat       min_resolution;
+    QualityKnobs  current;
+
+    //  The window so far
+    int           frames;
+    double        cost_sum, cpu_sum, gpu_sum;
+    int           gpu_frames;
+    int           calm_windows;	// in a row under LowWater
+
+    unsigned long frame_number;
+    int           changes;
+
+    //  Knobs turned down, most recent last, to turn up in reverse.  With
+    //    each, the times of the window before it went down, and then the
+    //    ratios of those to the window after (0 until measured).
+    struct Lowering {
+	Knob    knob;
+	double  cost, cpu, gpu;
+	double  cost_gain, cpu_gain, gpu_gain;
+    };
+    std::vector<Lowering>  lowered;
+};
+
+#endif // __QUALITY_H__
@@ -0,0 +1,550 @@
+#include "RayCast.h"
+#include "Projector.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+//
+//  One ray: where from, which way, and one over each of the direction's
+//    components for the slab test (a huge number for a zero, so that no
+//    zero ever multiplies an infinity)
+//
+
+struct Ray {
+    GLfloat  o[3], d[3], inv[3];
+};
+
+static void
+make_ray( const vec3& origin, const vec3& direction, Ray& r )
+{
+    for ( int k = 0; k < 3; ++k ) {
+	r.o[k] = origin[k];
+	r.d[k] = direction[k];
+	r.inv[k] = fabsf( r.d[k] ) > 1e-30f ? 1.0f / r.d[k] : 1e30f;
+    }
+}
+
+//  Moller-Trumbore against a triangle given as a corner and the two edges
+//    from it.  A hit at t, nearer than "best", replaces it.  A ray in the
+//    triangle's plane makes a NaN or an infinity that fails the tests.
+//    The SSE version in cast() does the very same arithmetic, four rays
+//    at a time.
+static bool
+intersect( const Ray& r, const GLfloat v0[3], const GLfloat e1[3],
+	   const GLfloat e2[3], GLfloat& best )
+{
+    GLfloat px = r.d[1]*e2[2] - r.d[2]*e2[1];
+    GLfloat py = r.d[2]*e2[0] - r.d[0]*e2[2];
+    GLfloat pz = r.d[0]*e2[1] - r.d[1]*e2[0];
+    GLfloat inv = 1.0f / (e1[0]*px + e1[1]*py + e1[2]*pz);
+
+    GLfloat tx = r.o[0] - v0[0], ty = r.o[1] - v0[1], tz = r.o[2] - v0[2];
+    GLfloat u = (tx*px + ty*py + tz*pz) * inv;
+    GLfloat qx = ty*e1[2] - tz*e1[1];
+    GLfloat qy = tz*e1[0] - tx*e1[2];
+    GLfloat qz = tx*e1[1] - ty*e1[0];
+    GLfloat v = (r.d[0]*qx + r.d[1]*qy + r.d[2]*qz) * inv;
+    GLfloat t = (e2[0]*qx + e2[1]*qy + e2[2]*qz) * inv;
+
+    if ( u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < best ) {
+	best = t;
+	return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------
+
+RayCaster::RayCaster() : objects( 0 ), built_area( 0.0 )
+{
+    memset( &last, 0, sizeof(last) );
+}
+
+void
+RayCaster::set_mesh( const vec4* v, int vertex_count,
+		     const GLushort* t, int triangle_count )
+{
+    vertices.assign( v, v + vertex_count );
+    triangles.assign( t, t + 3*triangle_count );
+    objects = 0;
+    order.clear();
+    nodes.clear();
+}
+
+//----------------------------------------------------------------------------
+
+void
+RayCaster::update( const GLfloat* centers, const GLfloat* scales,
+		   const GLfloat* sines, const GLfloat* cosines, int count,
+		   JobSystem* jobs )
+{
+    int V = (int) vertices.size();
+    objects = count;
+    projected.resize( 3*V*count );
+
+    // Each object's rotation composed as the shaders do it, then its
+    // vertices placed and projected
+    auto place = [&]( int first, int last ) {
+	for ( int i = first; i < last; ++i ) {
+	    GLfloat m[4][4];
+	    for ( int j = 0; j < 4; ++j )
+		for ( int k = 0; k < 4; ++k )
+		    m[j][k] = j == k ? 1.0f : 0.0f;
+	    for ( int p = 0; p < 6; ++p ) {
+		int a, b;
+		GLfloat sign;
+		RotationPlaneAxes( p, a, b, sign );
+		GLfloat c = cosines[6*i + p], s = sign * sines[6*i + p];
+		for ( int k = 0; k < 4; ++k ) {
+		    GLfloat x = m[a][k], y = m[b][k];
+		    m[a][k] = c*x - s*y;
+		    m[b][k] = s*x + c*y;
+		}
+	    }
+
+	    const GLfloat* center = &centers[4*i];
+	    GLfloat* out = &projected[3*V*i];
+	    for ( int v = 0; v < V; ++v ) {
+		vec4 p = scales[i] * vertices[v];
+		GLfloat y[4];
+		for ( int j = 0; j < 4; ++j )
+		    y[j] = m[j][0]*p.x + m[j][1]*p.y + m[j][2]*p.z + m[j][3]*p.w
+			+ center[j];
+		GLfloat w = y[3] + 1.0f;
+		for ( int k = 0; k < 3; ++k )
+		    out[3*v + k] = y[k] * w;
+	    }
+	}
+    };
+    if ( jobs )
+	jobs->parallel_for( 0, count, 0, place );
+    else
+	place( 0, count );
+
+    // Refit the tree as it is, unless there is none or its boxes have
+    // grown too far
+    int total = count * (int) (triangles.size() / 3);
+    last.rebuilt = nodes.empty() || (int) order.size() != total;
+    if ( !last.rebuilt ) {
+	GLfloat area = refit( jobs );
+	last.growth = built_area > 0.0f ? area / built_area : 1.0f;
+	last.rebuilt = last.growth > RebuildGrowth;
+    }
+    if ( last.rebuilt ) {
+	build( jobs );
+	built_area = refit( jobs );
+	last.growth = 1.0;
+    }
+    last.triangles = total;
+    last.nodes = (int) nodes.size();
+}
+
+//----------------------------------------------------------------------------
+//
+//  The tree.  A range of more than LeafSize triangles is split in half at
+//    the median, so how many nodes a range takes depends only on how many
+//    triangles it has: the top levels can leave room for each subtree
+//    before it is built.
+//
+
+int
+RayCaster::node_count( int count )
+{
+    if ( count <= LeafSize )
+	return 1;
+    return 1 + node_count( count / 2 ) + node_count( count - count / 2 );
+}
+
+//  Order triangles [first, first + count) about their median along the
+//    axis their centroids spread the most; returns the axis
+int
+RayCaster::split( int first, int count, const GLfloat* centroids )
+{
+    GLfloat lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    GLfloat hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for ( int i = first; i < first + count; ++i ) {
+	const GLfloat* c = &centroids[3*order[i]];
+	for ( int k = 0; k < 3; ++k ) {
+	    lo[k] = std::min( lo[k], c[k] );
+	    hi[k] = std::max( hi[k], c[k] );
+	}
+    }
+    int axis = 0;
+    for ( int k = 1; k < 3; ++k )
+	if ( hi[k] - lo[k] > hi[axis] - lo[axis] )
+	    axis = k;
+
+    int* begin = &order[first];
+    std::nth_element( begin, begin + count / 2, begin + count,
+		      [centroids, axis]( int a, int b ) {
+			  return centroids[3*a + axis] < centroids[3*b + axis];
+		      } );
+    return axis;
+}
+
+//  Node "node" over the range, its descendants from "next" on
+void
+RayCaster::build_node( int node, int first, int count, const GLfloat* centroids,
+		       int& next )
+{
+    Node& n = nodes[node];
+    if ( count <= LeafSize ) {
+	n.first = first;
+	n.count = count;
+	return;
+    }
+    n.count = 0;
+    n.axis = split( first, count, centroids );
+    int half = count / 2;
+    build_node( next++, first, half, centroids, next );
+    n.right = next++;
+    build_node( n.right, first + half, count - half, centroids, next );
+}
+
+//  The same down to TopDepth, where the ranges are left as subtrees
+void
+RayCaster::build_top( int node, int first, int count, int depth,
+		      const GLfloat* centroids, int& next )
+{
+    if ( depth == TopDepth || count <= LeafSize ) {
+	Subtree s = { node, node_count( count ), first, count, 0.0f };
+	subtrees.push_back( s );
+	next = node + s.size;
+	return;
+    }
+    Node& n = nodes[node];
+    top.push_back( node );
+    n.count = 0;
+    n.axis = split( first, count, centroids );
+    int half = count / 2;
+    build_top( next++, first, half, depth + 1, centroids, next );
+    n.right = next++;
+    build_top( n.right, first + half, count - half, depth + 1, centroids, next );
+}
+
+void
+RayCaster::build( JobSystem* jobs )
+{
+    int V = (int) vertices.size(), T = (int) (triangles.size() / 3);
+    int total = T * objects;
+    order.resize( total );
+    for ( int k = 0; k < 3; ++k ) {
+	corner[k].resize( total );
+	edge1[k].resize( total );
+	edge2[k].resize( total );
+    }
+    nodes.clear();
+    subtrees.clear();
+    top.clear();
+    if ( total == 0 )
+	return;
+
+    // Three times each triangle's centroid, which splits the same
+    std::vector<GLfloat> centroids( 3*total );
+    for ( int i = 0; i < objects; ++i ) {
+	const GLfloat* p = &projected[3*V*i];
+	for ( int t = 0; t < T; ++t ) {
+	    const GLushort* c = &triangles[3*t];
+	    GLfloat* out = &centroids[3*(T*i + t)];
+	    for ( int k = 0; k < 3; ++k )
+		out[k] = p[3*c[0] + k] + p[3*c[1] + k] + p[3*c[2] + k];
+	}
+    }
+    for ( int i = 0; i < total; ++i )
+	order[i] = i;
+
+    nodes.resize( node_count( total ) );
+    int next = 1;
+    build_top( 0, 0, total, 0, &centroids[0], next );
+
+    auto subtree = [&]( int first, int last ) {
+	for ( int s = first; s < last; ++s ) {
+	    const Subtree& st = subtrees[s];
+	    int after = st.node + 1;
+	    build_node( st.node, st.first, st.count, &centroids[0], after );
+	}
+    };
+    if ( jobs )
+	jobs->parallel_for( 0, (int) subtrees.size(), 1, subtree );
+    else
+	subtree( 0, (int) subtrees.size() );
+}
+
+//----------------------------------------------------------------------------
+
+//  Nodes [first, last), last to first, so that children come before their
+//    parents.  Leaves gather their triangles from the projected vertices.
+//    Returns the surface area of the boxes, halved.
+GLfloat
+RayCaster::refit_nodes( int first, int last )
+{
+    int V = (int) vertices.size(), T = (int) (triangles.size() / 3);
+    GLfloat area = 0.0;
+    for ( int i = last - 1; i >= first; --i ) {
+	Node& n = nodes[i];
+	if ( n.count > 0 ) {
+	    for ( int k = 0; k < 3; ++k ) {
+		n.lo[k] = FLT_MAX;
+		n.hi[k] = -FLT_MAX;
+	    }
+	    for ( int j = n.first; j < n.first + n.count; ++j ) {
+		int which = order[j];
+		const GLfloat* p = &projected[3*V*(which / T)];
+		const GLushort* c = &triangles[3*(which % T)];
+		const GLfloat* a = &p[3*c[0]];
+		const GLfloat* b = &p[3*c[1]];
+		const GLfloat* d = &p[3*c[2]];
+		for ( int k = 0; k < 3; ++k ) {
+		    corner[k][j] = a[k];
+		    edge1[k][j] = b[k] - a[k];
+		    edge2[k][j] = d[k] - a[k];
+		    n.lo[k] = std::min( n.lo[k], std::min( a[k], std::min( b[k], d[k] ) ) );
+		    n.hi[k] = std::max( n.hi[k], std::max( a[k], std::max( b[k], d[k] ) ) );
+		}
+	    }
+	} else {
+	    const Node& l = nodes[i + 1];
+	    const Node& r = nodes[n.right];
+	    for ( int k = 0; k < 3; ++k ) {
+		n.lo[k] = std::min( l.lo[k], r.lo[k] );
+		n.hi[k] = std::max( l.hi[k], r.hi[k] );
+	    }
+	}
+	GLfloat dx = n.hi[0] - n.lo[0], dy = n.hi[1] - n.lo[1], dz = n.hi[2] - n.lo[2];
+	area += dx*dy + dy*dz + dz*dx;
+    }
+    return area;
+}
+
+GLfloat
+RayCaster::refit( JobSystem* jobs )
+{
+    auto subtree = [this]( int first, int last ) {
+	for ( int s = first; s < last; ++s )
+	    subtrees[s].area = refit_nodes( subtrees[s].node,
+					    subtrees[s].node + subtrees[s].size );
+    };
+    if ( jobs )
+	jobs->parallel_for( 0, (int) subtrees.size(), 1, subtree );
+    else
+	subtree( 0, (int) subtrees.size() );
+
+    GLfloat area = 0.0;
+    for ( size_t s = 0; s < subtrees.size(); ++s )
+	area += subtrees[s].area;
+    for ( int k = (int) top.size() - 1; k >= 0; --k )
+	area += refit_nodes( top[k], top[k] + 1 );
+    return area;
+}
+
+//----------------------------------------------------------------------------
+
+//  Triangle "tri" in tree order, or -1, as a hit
+void
+RayCaster::resolve( int tri, GLfloat t, RayHit& hit ) const
+{
+    int T = (int) (triangles.size() / 3);
+    if ( tri < 0 ) {
+	hit.t = FLT_MAX;
+	hit.object = hit.triangle = -1;
+	return;
+    }
+    hit.t = t;
+    hit.object = order[tri] / T;
+    hit.triangle = order[tri] % T;
+}
+
+void
+RayCaster::cast_scalar( const vec3* origins, const vec3* directions, int n,
+			RayHit* hits ) const
+{
+    for ( int r = 0; r < n; ++r ) {
+	Ray ray;
+	make_ray( origins[r], directions[r], ray );
+	GLfloat best = FLT_MAX;
+	int found = -1;
+
+	int stack[64], depth = 0;
+	int node = nodes.empty() ? -1 : 0;
+	while ( node >= 0 ) {
+	    const Node& nd = nodes[node];
+	    GLfloat t_in = -FLT_MAX, t_out = FLT_MAX;
+	    for ( int k = 0; k < 3; ++k ) {
+		GLfloat t0 = (nd.lo[k] - ray.o[k]) * ray.inv[k];
+		GLfloat t1 = (nd.hi[k] - ray.o[k]) * ray.inv[k];
+		t_in = std::max( t_in, std::min( t0, t1 ) );
+		t_out = std::min( t_out, std::max( t0, t1 ) );
+	    }
+	    if ( t_in <= t_out && t_out >= 0.0f && t_in < best ) {
+		if ( nd.count > 0 ) {
+		    for ( int j = nd.first; j < nd.first + nd.count; ++j ) {
+			GLfloat v0[3] = { corner[0][j], corner[1][j], corner[2][j] };
+			GLfloat e1[3] = { edge1[0][j], edge1[1][j], edge1[2][j] };
+			GLfloat e2[3] = { edge2[0][j], edge2[1][j], edge2[2][j] };
+			if ( intersect( ray, v0, e1, e2, best ) )
+			    found = j;
+		    }
+		} else {
+		    // The nearer child first
+		    bool back = ray.d[nd.axis] < 0.0f;
+		    stack[depth++] = back ? node + 1 : nd.right;
+		    node = back ? nd.right : node + 1;
+		    continue;
+		}
+	    }
+	    node = depth > 0 ? stack[--depth] : -1;
+	}
+	resolve( found, best, hits[r] );
+    }
+}
+
+RayHit
+RayCaster::cast_brute( const vec3& origin, const vec3& direction ) const
+{
+    int V = (int) vertices.size(), T = (int) (triangles.size() / 3);
+    Ray ray;
+    make_ray( origin, direction, ray );
+    RayHit hit = { FLT_MAX, -1, -1 };
+    for ( int i = 0; i < objects; ++i ) {
+	const GLfloat* p = &projected[3*V*i];
+	for ( int t = 0; t < T; ++t ) {
+	    const GLushort* c = &triangles[3*t];
+	    GLfloat v0[3], e1[3], e2[3];
+	    for ( int k = 0; k < 3; ++k ) {
+		v0[k] = p[3*c[0] + k];
+		e1[k] = p[3*c[1] + k] - v0[k];
+		e2[k] = p[3*c[2] + k] - v0[k];
+	    }
+	    if ( intersect( ray, v0, e1, e2, hit.t ) ) {
+		hit.object = i;
+		hit.triangle = t;
+	    }
+	}
+    }
+    return hit;
+}
+
+//----------------------------------------------------------------------------
+
+#ifdef __SSE2__
+void
+RayCaster::cast( const vec3* origins, const vec3* directions, int n,
+		 RayHit* hits ) const
+{
+    for ( int r = 0; r < n; r += 4 ) {
+	// A short last packet repeats its last ray
+	int lanes = std::min( 4, n - r );
+	alignas(16) GLfloat o[3][4], d[3][4], inv[3][4];
+	for ( int l = 0; l < 4; ++l ) {
+	    Ray ray;
+	    int k = r + std::min( l, lanes - 1 );
+	    make_ray( origins[k], directions[k], ray );
+	    for ( int c = 0; c < 3; ++c ) {
+		o[c][l] = ray.o[c];
+		d[c][l] = ray.d[c];
+		inv[c][l] = ray.inv[c];
+	    }
+	}
+	__m128 ox = _mm_load_ps( o[0] ), oy = _mm_load_ps( o[1] ), oz = _mm_load_ps( o[2] );
+	__m128 dx = _mm_load_ps( d[0] ), dy = _mm_load_ps( d[1] ), dz = _mm_load_ps( d[2] );
+	__m128 ix = _mm_load_ps( inv[0] ), iy = _mm_load_ps( inv[1] ),
+	    iz = _mm_load_ps( inv[2] );
+	__m128 best = _mm_set1_ps( FLT_MAX );
+	__m128i found = _mm_set1_epi32( -1 );
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps( 1.0f );
+
+	int stack[64], depth = 0;
+	int node = nodes.empty() ? -1 : 0;
+	while ( node >= 0 ) {
+	    const Node& nd = nodes[node];
+	    __m128 t0 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( nd.lo[0] ), ox ), ix );
+	    __m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( nd.hi[0] ), ox ), ix );
+	    __m128 t_in = _mm_min_ps( t0, t1 ), t_out = _mm_max_ps( t0, t1 );
+	    t0 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( nd.lo[1] ), oy ), iy );
+	    t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( nd.hi[1] ), oy ), iy );
+	    t_in = _mm_max_ps( t_in, _mm_min_ps( t0, t1 ) );
+	    t_out = _mm_min_ps( t_out, _mm_max_ps( t0, t1 ) );
+	    t0 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( nd.lo[2] ), oz ), iz );
+	    t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( nd.hi[2] ), oz ), iz );
+	    t_in = _mm_max_ps( t_in, _mm_min_ps( t0, t1 ) );
+	    t_out = _mm_min_ps( t_out, _mm_max_ps( t0, t1 ) );
+	    __m128 enter = _mm_and_ps( _mm_and_ps( _mm_cmple_ps( t_in, t_out ),
+						   _mm_cmpge_ps( t_out, zero ) ),
+				       _mm_cmplt_ps( t_in, best ) );
+
+	    if ( _mm_movemask_ps( enter ) ) {
+		if ( nd.count > 0 ) {
+		    for ( int j = nd.first; j < nd.first + nd.count; ++j ) {
+			__m128 e1x = _mm_set1_ps( edge1[0][j] ), e1y = _mm_set1_ps( edge1[1][j] ),
+			    e1z = _mm_set1_ps( edge1[2][j] );
+			__m128 e2x = _mm_set1_ps( edge2[0][j] ), e2y = _mm_set1_ps( edge2[1][j] ),
+			    e2z = _mm_set1_ps( edge2[2][j] );
+			__m128 px = _mm_sub_ps( _mm_mul_ps( dy, e2z ), _mm_mul_ps( dz, e2y ) );
+			__m128 py = _mm_sub_ps( _mm_mul_ps( dz, e2x ), _mm_mul_ps( dx, e2z ) );
+			__m128 pz = _mm_sub_ps( _mm_mul_ps( dx, e2y ), _mm_mul_ps( dy, e2x ) );
+			__m128 det = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e1x, px ),
+							     _mm_mul_ps( e1y, py ) ),
+						 _mm_mul_ps( e1z, pz ) );
+			__m128 inv_det = _mm_div_ps( one, det );
+
+			__m128 tx = _mm_sub_ps( ox, _mm_set1_ps( corner[0][j] ) );
+			__m128 ty = _mm_sub_ps( oy, _mm_set1_ps( corner[1][j] ) );
+			__m128 tz = _mm_sub_ps( oz, _mm_set1_ps( corner[2][j] ) );
+			__m128 u = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( tx, px ),
+								       _mm_mul_ps( ty, py ) ),
+							   _mm_mul_ps( tz, pz ) ), inv_det );
+			__m128 qx = _mm_sub_ps( _mm_mul_ps( ty, e1z ), _mm_mul_ps( tz, e1y ) );
+			__m128 qy = _mm_sub_ps( _mm_mul_ps( tz, e1x ), _mm_mul_ps( tx, e1z ) );
+			__m128 qz = _mm_sub_ps( _mm_mul_ps( tx, e1y ), _mm_mul_ps( ty, e1x ) );
+			__m128 v = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, qx ),
+								       _mm_mul_ps( dy, qy ) ),
+							   _mm_mul_ps( dz, qz ) ), inv_det );
+			__m128 t = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( e2x, qx ),
+								       _mm_mul_ps( e2y, qy ) ),
+							   _mm_mul_ps( e2z, qz ) ), inv_det );
+
+			__m128 hit = _mm_and_ps( _mm_cmpge_ps( u, zero ), _mm_cmpge_ps( v, zero ) );
+			hit = _mm_and_ps( hit, _mm_cmple_ps( _mm_add_ps( u, v ), one ) );
+			hit = _mm_and_ps( hit, _mm_cmpgt_ps( t, zero ) );
+			hit = _mm_and_ps( hit, _mm_cmplt_ps( t, best ) );
+			if ( !_mm_movemask_ps( hit ) )
+			    continue;
+			best = _mm_or_ps( _mm_and_ps( hit, t ), _mm_andnot_ps( hit, best ) );
+			__m128i mask = _mm_castps_si128( hit );
+			found = _mm_or_si128( _mm_and_si128( mask, _mm_set1_epi32( j ) ),
+					      _mm_andnot_si128( mask, found ) );
+		    }
+		} else {
+		    // The nearer child first, as the first ray sees it
+		    bool back = d[nd.axis][0] < 0.0f;
+		    stack[depth++] = back ? node + 1 : nd.right;
+		    node = back ? nd.right : node + 1;
+		    continue;
+		}
+	    }
+	    node = depth > 0 ? stack[--depth] : -1;
+	}
+
+	alignas(16) GLfloat t[4];
+	alignas(16) int tri[4];
+	_mm_store_ps( t, best );
+	_mm_store_si128( (__m128i*) tri, found );
+	for ( int l = 0; l < lanes; ++l )
+	    resolve( tri[l], t[l], hits[r + l] );
+    }
+}
+#else
+void
+RayCaster::cast( const vec3* origins, const vec3* directions, int n,
+		 RayHit* hits ) const
+{
+    cast_scalar( origins, directions, n, hits );
+}
+#endif
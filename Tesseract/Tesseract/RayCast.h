@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- RayCast.h ---
+//
+//   Exact ray casting against the objects as they are drawn: each one's
+//     triangles rotated, scaled and placed in 4D, then projected to 3D the
+//     way the vertex shaders do it, so a hit is on the very triangle the
+//     GPU drew there.  Rays are given in the space ModelView applies to.
+//
+//   The triangles of all the objects share one bounding volume hierarchy,
+//     split at the median along the widest spread of their centers down
+//     to leaves of LeafSize.  The nodes are laid out depth first, and the
+//     subtrees below the first TopDepth levels are built and refitted on
+//     different threads.  Every update() projects the vertices again and
+//     refits the boxes; the tree is rebuilt only once the boxes' total
+//     surface area has grown to RebuildGrowth times what it was when
+//     built.
+//
+//   cast() takes rays in packets of four, one per SSE lane: a node is
+//     entered if any ray of the packet hits its box, and each triangle of
+//     a leaf is tested against the four at once.  Rays next to each other
+//     on the screen make good packets.  cast_scalar() takes one ray at a
+//     time and is the reference for it.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __RAYCAST_H__
+#define __RAYCAST_H__
+
+#include "Angel.h"
+#include <vector>
+
+class JobSystem;
+
+struct RayHit {
+    GLfloat  t;		// along the direction, in its lengths; FLT_MAX if none
+    int      object;	// -1 for a miss
+    int      triangle;	// of the object's mesh
+};
+
+struct RayCastStats {
+    int      triangles;
+    int      nodes;
+    bool     rebuilt;	// by the last update()
+    GLfloat  growth;	// surface area over what it was when built
+};
+
+class RayCaster {
+   public:
+    static const int  LeafSize = 4;
+    static const int  TopDepth = 6;		// 64 subtrees
+    static constexpr GLfloat  RebuildGrowth = 1.5;
+
+    RayCaster();
+
+    //  The mesh every object draws: "vertex_count" 4D vertices, and
+    //    "triangle_count" triangles of three vertex indices each
+    void set_mesh( const vec4* vertices, int vertex_count,
+		   const GLushort* triangles, int triangle_count );
+
+    //  Place the "count" objects -- centers 4 floats each, and the sines
+    //    and cosines of their rotation angles 6 each -- and refit or
+    //    rebuild.  Spread over "jobs" if not NULL.
+    void update( const GLfloat* centers, const GLfloat* scales,
+		 const GLfloat* sines, const GLfloat* cosines, int count,
+		 JobSystem* jobs = NULL );
+
+    //  The nearest hit of each of the "n" rays, four at a time.  Different
+    //    rays can be cast on different threads at once.
+    void cast( const vec3* origins, const vec3* directions, int n,
+	       RayHit* hits ) const;
+
+    //  One ray at a time, the reference for cast()
+    void cast_scalar( const vec3* origins, const vec3* directions, int n,
+		      RayHit* hits ) const;
+
+    //  Every triangle against one ray, without the hierarchy
+    RayHit cast_brute( const vec3& origin, const vec3& direction ) const;
+
+    const RayCastStats& stats() const { return last; }
+
+   private:
+    struct Node {
+	GLfloat  lo[3], hi[3];
+	int      first;		// leaf: triangles [first, first + count)
+	int      count;		//   in tree order; 0 for an inner node
+	int      right;		// inner: the right child; the left follows
+	int      axis;		// inner: the one split along
+    };
+
+    //  Trees below the top levels, each nodes [node, node + size)
+    struct Subtree {
+	int      node, size;
+	int      first, count;	// triangles
+	GLfloat  area;		// of its boxes, as last refitted
+    };
+
+    static int node_count( int triangles );
+    int split( int first, int count, const GLfloat* centroids );
+    void build_top( int node, int first, int count, int depth,
+		    const GLfloat* centroids, int& next );
+    void build_node( int node, int first, int count, const GLfloat* centroids,
+		     int& next );
+    void build( JobSystem* jobs );
+    GLfloat refit_nodes( int first, int last );
+    GLfloat refit( JobSystem* jobs );
+    void resolve( int tri, GLfloat t, RayHit& hit ) const;
+
+    //  The mesh
+    std::vector<vec4>      vertices;
+    std::vector<GLushort>  triangles;	// 3 per triangle
+
+    //  The objects' projected vertices, 3 floats each, object by object
+    int                    objects;
+    std::vector<GLfloat>   projected;
+
+    //  The triangles in tree order: which one (object times the mesh's
+    //    count, plus the triangle), and as a corner and the two edges
+    //    from it, a coordinate per array
+    std::vector<int>       order;
+    std::vector<GLfloat>   corner[3], edge1[3], edge2[3];
+
+    std::vector<Node>      nodes;
+    std::vector<Subtree>   subtrees;
+    std::vector<int>       top;		// the nodes above them, depth first
+    GLfloat                built_area;
+    RayCastStats           last;
+};
+
+#endif // __RAYCAST_H__
@@ -0,0 +1,214 @@
+#include "Scene.h"
+
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+
+Scene::Scene()
+{
+}
+
+SceneHandle
+Scene::add( const vec4& c, GLfloat s, const vec4& rgba,
+	    const GLfloat velocity[NumPlanes] )
+{
+    unsigned int slot;
+    if ( free_slots.empty() ) {
+	slot = (unsigned int) slot_index.size();
+	slot_index.push_back( 0 );
+	slot_generation.push_back( 0 );
+    }
+    else {
+	slot = free_slots.back();
+	free_slots.pop_back();
+    }
+
+    slot_index[slot] = (unsigned int) scale.size();
+    index_slot.push_back( slot );
+
+    for ( int i = 0; i < 4; ++i ) {
+	center[i].push_back( c[i] );
+	color[i].push_back( rgba[i] );
+    }
+    for ( int p = 0; p < NumPlanes; ++p ) {
+	angle[p].push_back( 0.0 );
+	angular_velocity[p].push_back( velocity[p] );
+    }
+    scale.push_back( s );
+
+    SceneHandle h = { slot, slot_generation[slot] };
+    return h;
+}
+
+//  Move the last object into the hole so the arrays stay dense
+void
+Scene::remove( SceneHandle h )
+{
+    if ( !valid( h ) )
+	return;
+
+    unsigned int i = slot_index[h.slot];
+    unsigned int last = (unsigned int) scale.size() - 1;
+
+    for ( int k = 0; k < 4; ++k ) {
+	center[k][i] = center[k][last];  center[k].pop_back();
+	color[k][i] = color[k][last];    color[k].pop_back();
+    }
+    for ( int p = 0; p < NumPlanes; ++p ) {
+	angle[p][i] = angle[p][last];  angle[p].pop_back();
+	angular_velocity[p][i] = angular_velocity[p][last];
+	angular_velocity[p].pop_back();
+    }
+    scale[i] = scale[last];  scale.pop_back();
+
+    unsigned int moved = index_slot[last];
+    index_slot[i] = moved;
+    slot_index[moved] = i;
+    index_slot.pop_back();
+
+    slot_generation[h.slot]++;
+    free_slots.push_back( h.slot );
+}
+
+void
+Scene::clear()
+{
+    for ( int k = 0; k < 4; ++k ) {
+	center[k].clear();
+	color[k].clear();
+    }
+    for ( int p = 0; p < NumPlanes; ++p ) {
+	angle[p].clear();
+	angular_velocity[p].clear();
+    }
+    scale.clear();
+
+    // Invalidate every outstanding handle
+    free_slots.clear();
+    for ( unsigned int s = 0; s < slot_generation.size(); ++s ) {
+	slot_generation[s]++;
+	free_slots.push_back( s );
+    }
+    index_slot.clear();
+}
+
+bool
+Scene::valid( SceneHandle h ) const
+{
+    return h.slot < slot_generation.size() &&
+	slot_generation[h.slot] == h.generation;
+}
+
+int
+Scene::index( SceneHandle h ) const
+{
+    return valid( h ) ? (int) slot_index[h.slot] : -1;
+}
+
+//----------------------------------------------------------------------------
+
+void
+Scene::update( GLfloat dt )
+{
+    update( 0, size(), dt );
+}
+
+//  angle += velocity*dt, wrapped back into [0, 360).  A step never exceeds
+//    a full turn, so one conditional add or subtract is enough.
+void
+Scene::update( int first, int last, GLfloat dt )
+{
+    if ( first >= last )
+	return;
+
+#ifdef __SSE__
+    const __m128 step = _mm_set1_ps( dt );
+    const __m128 full = _mm_set1_ps( 360.0f );
+    const __m128 zero = _mm_setzero_ps();
+
+    int simd_last = first + ((last - first) & ~3);
+
+    for ( int p = 0; p < NumPlanes; ++p ) {
+	GLfloat* a = &angle[p][0];
+	const GLfloat* v = &angular_velocity[p][0];
+
+	for ( int i = first; i < simd_last; i += 4 ) {
+	    __m128 x = _mm_add_ps( _mm_loadu_ps( a + i ),
+				   _mm_mul_ps( _mm_loadu_ps( v + i ), step ) );
+	    x = _mm_sub_ps( x, _mm_and_ps( _mm_cmpge_ps( x, full ), full ) );
+	    x = _mm_add_ps( x, _mm_and_ps( _mm_cmplt_ps( x, zero ), full ) );
+	    _mm_storeu_ps( a + i, x );
+	}
+    }
+
+    update_scalar( simd_last, last, dt );
+#else
+    update_scalar( first, last, dt );
+#endif
+}
+
+void
+Scene::update_scalar( int first, int last, GLfloat dt )
+{
+    if ( first >= last )
+	return;
+
+    for ( int p = 0; p < NumPlanes; ++p ) {
+	for ( int i = first; i < last; ++i ) {
+	    GLfloat a = angle[p][i] + angular_velocity[p][i]*dt;
+	    if ( a >= 360.0 )
+		a -= 360.0;
+	    if ( a < 0.0 )
+		a += 360.0;
+	    angle[p][i] = a;
+	}
+    }
+}
+
+//----------------------------------------------------------------------------
+
+//  Small deterministic generator so every run builds the same scene
+static GLfloat
+random_unit( unsigned int& state )
+{
+    state = state*1664525u + 1013904223u;
+    return GLfloat( state >> 8 ) / GLfloat( 1 << 24 );
+}
+
+void
+PopulateScene( Scene& scene, int n, const GLfloat base_velocity[NumPlanes] )
+{
+    scene.clear();
+
+    int side = 1;
+    while ( side*side*side < n )
+	side++;
+
+    GLfloat spacing = 1.6 / side;
+    unsigned int state = 12345u;
+
+    for ( int i = 0; i < n; ++i ) {
+	int x = i % side;
+	int y = (i / side) % side;
+	int z = i / (side*side);
+
+	vec4 center( -0.8 + (x + 0.5)*spacing,
+		     -0.8 + (y + 0.5)*spacing,
+		     -0.8 + (z + 0.5)*spacing,
+		     0.2*(random_unit( state ) - 0.5) );
+
+	GLfloat velocity[NumPlanes];
+	for ( int p = 0; p < NumPlanes; ++p ) {
+	    GLfloat sign = random_unit( state ) < 0.5 ? -1.0 : 1.0;
+	    velocity[p] = sign * base_velocity[p] * (0.5 + random_unit( state ));
+	}
+
+	vec4 color( 0.4 + 0.6*random_unit( state ),
+		    0.4 + 0.6*random_unit( state ),
+		    0.4 + 0.6*random_unit( state ), 1.0 );
+
+	scene.add( center, 0.6 / side, color, velocity );
+    }
+}
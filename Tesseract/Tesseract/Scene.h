@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Scene.h ---
+//
+//   Structure-of-arrays store for many animated 4D objects.  Every
+//     per-object quantity lives in its own contiguous array so the update
+//     loop can stream through one attribute at a time with SIMD.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+#include "Angel.h"
+#include <vector>
+
+//  Number of rotation planes in 4D: XY, YZ, XZ, XW, YW, ZW (the order
+//    used by the vertex shaders)
+const int NumPlanes = 6;
+
+//  Stable reference to an object.  Removing other objects never
+//    invalidates it; removing the object itself does.
+struct SceneHandle {
+    unsigned int  slot;
+    unsigned int  generation;
+};
+
+class Scene {
+   public:
+    Scene();
+
+    SceneHandle add( const vec4& center, GLfloat scale, const vec4& color,
+		     const GLfloat angular_velocity[NumPlanes] );
+    void remove( SceneHandle h );
+    void clear();
+
+    bool valid( SceneHandle h ) const;
+
+    //  Position of the object in the arrays below, or -1 if removed.
+    //    Indices change when objects are removed; handles do not.
+    int index( SceneHandle h ) const;
+
+    int size() const { return (int) scale.size(); }
+
+    //  Advance every rotation by dt seconds
+    void update( GLfloat dt );
+
+    //  Same, for objects [first, last) only -- lets callers split the work
+    void update( int first, int last, GLfloat dt );
+
+    //  Plain scalar loop, kept as the reference for the SIMD one
+    void update_scalar( int first, int last, GLfloat dt );
+
+    //
+    //  --- Per-object data, indexed 0 .. size()-1 ---
+    //
+
+    std::vector<GLfloat>  center[4];			// 4D position
+    std::vector<GLfloat>  angle[NumPlanes];		// degrees, [0, 360)
+    std::vector<GLfloat>  angular_velocity[NumPlanes];	// degrees/second
+    std::vector<GLfloat>  scale;
+    std::vector<GLfloat>  color[4];			// RGBA tint
+
+   private:
+    //  Handle slot -> array index and back; slots are recycled, and the
+    //    generation counter tells a stale handle from a live one
+    std::vector<unsigned int>  slot_index;
+    std::vector<unsigned int>  slot_generation;
+    std::vector<unsigned int>  index_slot;
+    std::vector<unsigned int>  free_slots;
+};
+
+//  Replace the contents with n objects on a grid, each with its own tint
+//    and spin (a random multiple of base_velocity in every plane)
+void PopulateScene( Scene& scene, int n,
+		    const GLfloat base_velocity[NumPlanes] );
+
+#endif // __SCENE_H__
@@ -0,0 +1,84 @@
+#include "Simulation.h"
+#include "FrameStats.h"
+#include <chrono>
+#include <string.h>
+
+Simulation::Simulation()
+    : running( false ), reset_pending( false ), period_ms( 0.0 )
+{
+    memset( &counters, 0, sizeof(counters) );
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void
+Simulation::start( double hz, const std::function<void(double)>& fn )
+{
+    stop();
+
+    period_ms = 1000.0 / hz;
+    step = fn;
+    running = true;
+    thread = std::thread( &Simulation::run, this );
+}
+
+void
+Simulation::stop()
+{
+    if ( !running )
+	return;
+
+    running = false;
+    thread.join();
+}
+
+//----------------------------------------------------------------------------
+
+void
+Simulation::run()
+{
+    typedef std::chrono::steady_clock  clock;
+
+    clock::duration period = std::chrono::duration_cast<clock::duration>(
+	std::chrono::duration<double, std::milli>( period_ms ) );
+    clock::time_point next = clock::now();
+    double last = -1.0;
+
+    while ( running ) {
+	if ( reset_pending.exchange( false ) )
+	    memset( &counters, 0, sizeof(counters) );
+
+	double now = FrameStatsNow();
+	double dt = last < 0.0 ? 0.0 : (now - last) / 1000.0;
+
+	// Never step more than a tenth of a second at once
+	if ( dt > 0.1 )
+	    dt = 0.1;
+
+	if ( last >= 0.0 ) {
+	    double interval = now - last;
+	    counters.interval_sum += interval;
+	    counters.interval_sq_sum += interval*interval;
+	}
+	last = now;
+
+	step( dt );
+
+	double spent = FrameStatsNow() - now;
+	counters.ticks++;
+	counters.step_sum += spent;
+	if ( spent > counters.step_max )
+	    counters.step_max = spent;
+
+	// Fixed rate; after a long step, start counting again from now
+	// rather than running a burst of catch-up ticks
+	next += period;
+	clock::time_point current = clock::now();
+	if ( next < current )
+	    next = current;
+	std::this_thread::sleep_until( next );
+    }
+}
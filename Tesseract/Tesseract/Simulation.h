@@ -0,0 +1,53 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Simulation.h ---
+//
+//   Runs the simulation step on its own thread at a fixed rate, so a slow
+//     frame on the GLUT thread never delays input handling or animation,
+//     and a slow step never delays drawing.  Results travel to display()
+//     through a TripleBuffer of snapshots (see Tesseract.cpp).
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SIMULATION_H__
+#define __SIMULATION_H__
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+struct SimulationStats {
+    unsigned long  ticks;
+    double         interval_sum;	// ms between consecutive ticks
+    double         interval_sq_sum;
+    double         step_sum;		// ms spent inside the step function
+    double         step_max;
+};
+
+class Simulation {
+   public:
+    Simulation();
+    ~Simulation();
+
+    //  Call step(dt) "hz" times a second on a new thread; dt in seconds
+    void start( double hz, const std::function<void(double)>& step );
+    void stop();
+
+    //  Statistics since the last reset -- read them from the step function
+    const SimulationStats& stats() const { return counters; }
+
+    //  Ask for the statistics to be cleared before the next tick (any thread)
+    void reset_stats() { reset_pending = true; }
+
+   private:
+    void run();
+
+    std::thread                  thread;
+    std::atomic<bool>            running;
+    std::atomic<bool>            reset_pending;
+    double                       period_ms;
+    std::function<void(double)>  step;
+    SimulationStats              counters;
+};
+
+#endif // __SIMULATION_H__
@@ -0,0 +1,289 @@
+#include "Surface.h"
+#include "FixedMesh.h"
+#include "JobSystem.h"
+#include "Cull.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------
+//
+//  The sheets, each a map from [0, 1]^2 into 4D
+//
+
+enum SheetKind {
+    SHEET_TORUS,	// (a cos 2pi u, a sin 2pi u, b cos 2pi v, b sin 2pi v)
+    SHEET_DISC_ZW,	// the point at angle t on the xy circle of radius a,
+			//   times the zw disc of radius b
+    SHEET_DISC_XY,	// and the other way around
+    SHEET_SPHERE,	// 2-sphere of radius a in xyz, at w = b
+    SHEET_BAND_XY,	// circle of radius a in xy, swept over w in [-b, b]
+    SHEET_BAND_XZ	// same in xz
+};
+
+struct Sheet {
+    SheetKind  kind;
+    GLfloat    a, b, t;
+};
+
+static vec4
+sheet_point( const Sheet& s, GLfloat u, GLfloat v )
+{
+    const GLfloat TwoPi = 2.0 * M_PI;
+    switch ( s.kind ) {
+    case SHEET_TORUS:
+	return vec4( s.a*cos( TwoPi*u ), s.a*sin( TwoPi*u ),
+		     s.b*cos( TwoPi*v ), s.b*sin( TwoPi*v ) );
+    case SHEET_DISC_ZW:
+	return vec4( s.a*cos( s.t ), s.a*sin( s.t ),
+		     u*s.b*cos( TwoPi*v ), u*s.b*sin( TwoPi*v ) );
+    case SHEET_DISC_XY:
+	return vec4( u*s.a*cos( TwoPi*v ), u*s.a*sin( TwoPi*v ),
+		     s.b*cos( s.t ), s.b*sin( s.t ) );
+    case SHEET_SPHERE:
+	return vec4( s.a*sin( M_PI*u )*cos( TwoPi*v ),
+		     s.a*sin( M_PI*u )*sin( TwoPi*v ), s.a*cos( M_PI*u ), s.b );
+    case SHEET_BAND_XY:
+	return vec4( s.a*cos( TwoPi*u ), s.a*sin( TwoPi*u ), 0.0, s.b*(2.0*v - 1.0) );
+    default:
+	return vec4( s.a*cos( TwoPi*u ), 0.0, s.a*sin( TwoPi*u ), s.b*(2.0*v - 1.0) );
+    }
+}
+
+static void
+make_sheets( SurfaceFamily family, std::vector<Sheet>& sheets )
+{
+    const GLfloat r = SurfaceRadius, half = SurfaceRadius / sqrt( 2.0 );
+    sheets.clear();
+    switch ( family ) {
+    case SURFACE_GLOME:
+	// Hopf coordinates: tori of radii r sin(eta), r cos(eta)
+	for ( int k = 0; k < 4; ++k ) {
+	    GLfloat eta = (k + 0.5) / 4.0 * M_PI / 2.0;
+	    Sheet s = { SHEET_TORUS, GLfloat( r*sin( eta ) ), GLfloat( r*cos( eta ) ), 0.0 };
+	    sheets.push_back( s );
+	}
+	break;
+    case SURFACE_CLIFFORD_TORUS: {
+	Sheet s = { SHEET_TORUS, half, half, 0.0 };
+	sheets.push_back( s );
+	break;
+    }
+    case SURFACE_DUOCYLINDER: {
+	Sheet ridge = { SHEET_TORUS, half, half, 0.0 };
+	sheets.push_back( ridge );
+	for ( int k = 0; k < 4; ++k ) {
+	    GLfloat t = k * M_PI / 2.0;
+	    Sheet zw = { SHEET_DISC_ZW, half, half, t };
+	    Sheet xy = { SHEET_DISC_XY, half, half, t };
+	    sheets.push_back( zw );
+	    sheets.push_back( xy );
+	}
+	break;
+    }
+    default: {
+	Sheet bottom = { SHEET_SPHERE, half, -half, 0.0 };
+	Sheet top = { SHEET_SPHERE, half, half, 0.0 };
+	Sheet xy = { SHEET_BAND_XY, half, half, 0.0 };
+	Sheet xz = { SHEET_BAND_XZ, half, half, 0.0 };
+	sheets.push_back( bottom );
+	sheets.push_back( top );
+	sheets.push_back( xy );
+	sheets.push_back( xz );
+	break;
+    }
+    }
+}
+
+//----------------------------------------------------------------------------
+
+static const char* family_names[SURFACE_NUM_FAMILIES] = {
+    "glome", "clifford", "duocylinder", "spherinder"
+};
+
+const char*
+SurfaceFamilyName( SurfaceFamily family )
+{
+    return family >= 0 && family < SURFACE_NUM_FAMILIES
+	? family_names[family] : "unknown";
+}
+
+int
+SurfaceFamilyFromName( const char* name )
+{
+    for ( int i = 0; i < SURFACE_NUM_FAMILIES; ++i )
+	if ( strcmp( name, family_names[i] ) == 0 )
+	    return i;
+    return -1;
+}
+
+//----------------------------------------------------------------------------
+
+//  Where one sheet of one level goes in the mesh
+struct SheetJob {
+    int  sheet;
+    int  level;
+    int  segments;
+    bool coarser;		// there is a next level to morph toward
+    int  first_vertex;
+    int  first_line;
+    int  first_triangle;
+};
+
+//  An n x n grid of cells: (n + 1)^2 vertices, row by row
+static void
+fill_sheet( const Sheet& sheet, const SheetJob& job, const vec4& color,
+	    SurfaceMesh& mesh )
+{
+    int n = job.segments, row = n + 1;
+    vec4* position = &mesh.positions[job.first_vertex];
+    vec4* morph = &mesh.morphs[job.first_vertex];
+    vec4* shade = &mesh.shades[job.first_vertex];
+
+    for ( int j = 0; j <= n; ++j )
+	for ( int i = 0; i <= n; ++i ) {
+	    GLfloat u = GLfloat( i ) / n, v = GLfloat( j ) / n;
+	    vec4 p = sheet_point( sheet, u, v );
+	    position[j*row + i] = p;
+	    shade[j*row + i] = color;
+
+	    // Midway along the coarser edge or diagonal this vertex splits
+	    int di = i & 1, dj = j & 1;
+	    if ( !job.coarser || (di == 0 && dj == 0) )
+		morph[j*row + i] = p;
+	    else
+		morph[j*row + i] = 0.5 * (sheet_point( sheet, GLfloat( i - di ) / n,
+						       GLfloat( j - dj ) / n )
+					  + sheet_point( sheet, GLfloat( i + di ) / n,
+							 GLfloat( j + dj ) / n ));
+	}
+
+    GLuint base = job.first_vertex;
+    GLuint* line = &mesh.lines[job.first_line];
+    for ( int j = 0; j <= n; ++j )
+	for ( int i = 0; i < n; ++i ) {
+	    *line++ = base + j*row + i;
+	    *line++ = base + j*row + i + 1;
+	    *line++ = base + i*row + j;
+	    *line++ = base + (i + 1)*row + j;
+	}
+
+    // Split along the (i, j) - (i + 1, j + 1) diagonal, as the morph
+    // targets expect
+    GLuint* triangle = &mesh.triangles[job.first_triangle];
+    for ( int j = 0; j < n; ++j )
+	for ( int i = 0; i < n; ++i ) {
+	    GLuint a = base + j*row + i, b = a + 1, c = b + row, d = a + row;
+	    *triangle++ = a; *triangle++ = b; *triangle++ = c;
+	    *triangle++ = a; *triangle++ = c; *triangle++ = d;
+	}
+}
+
+void
+SurfaceMesh::build( SurfaceFamily family, int segments, int level_count,
+		    JobSystem* jobs )
+{
+    std::vector<Sheet> sheets;
+    make_sheets( family, sheets );
+    int count = sheets.size();
+
+    // Lay out every level's sheets first, so they can be filled in any order
+    levels.clear();
+    std::vector<SheetJob> work;
+    int vertices = 0, line_indices = 0, triangle_indices = 0;
+    for ( int n = segments; n >= 4 && (int) levels.size() < level_count; n /= 2 ) {
+	SurfaceLevel level;
+	level.segments = n;
+	level.first_vertex = vertices;
+	level.first_line = line_indices;
+	level.first_triangle = triangle_indices;
+
+	bool coarser = n % 2 == 0 && n / 2 >= 4 && (int) levels.size() + 1 < level_count;
+	for ( int s = 0; s < count; ++s ) {
+	    SheetJob job = { s, (int) levels.size(), n, coarser,
+			     vertices, line_indices, triangle_indices };
+	    work.push_back( job );
+	    vertices += (n + 1)*(n + 1);
+	    line_indices += 4*n*(n + 1);
+	    triangle_indices += 6*n*n;
+	}
+
+	level.vertex_count = vertices - level.first_vertex;
+	level.line_count = line_indices - level.first_line;
+	level.triangle_count = triangle_indices - level.first_triangle;
+	levels.push_back( level );
+	if ( n % 2 != 0 )
+	    break;
+    }
+
+    positions.resize( vertices );
+    morphs.resize( vertices );
+    shades.resize( vertices );
+    lines.resize( line_indices );
+    triangles.resize( triangle_indices );
+
+    std::vector<vec4> colors( count );
+    for ( int s = 0; s < count; ++s ) {
+	colors[s] = FaceColors[s % 24];
+	colors[s].w = FaceShadeAlpha;
+    }
+
+    auto fill = [&]( int first, int last )
+    {
+	for ( int k = first; k < last; ++k )
+	    fill_sheet( sheets[work[k].sheet], work[k], colors[work[k].sheet], *this );
+    };
+    if ( jobs )
+	jobs->parallel_for( 0, work.size(), 1, fill );
+    else
+	fill( 0, work.size() );
+}
+
+//----------------------------------------------------------------------------
+
+int
+ChooseSurfaceLods( const SurfaceMesh& mesh, const GLfloat* centers,
+		   const GLfloat* scales, const int* objects, int count,
+		   const mat4& mv, GLfloat pixels, GLfloat edge_pixels,
+		   int budget, ObjectLod* lods )
+{
+    int last = mesh.level_count() - 1;
+    if ( last < 0 )
+	return 0;
+
+    // Each object's level before any coarsening, as a real number: the
+    // edge of a level of n segments is about 2 pi rho / n pixels, for a
+    // projected radius of rho pixels
+    const GLfloat TwoPi = 2.0 * M_PI;
+    GLfloat finest = mesh.level( 0 ).segments * edge_pixels / TwoPi;
+    std::vector<GLfloat> ideal( count );
+    for ( int k = 0; k < count; ++k ) {
+	int i = objects[k];
+	GLfloat sphere[4];
+	ProjectedSphere( &centers[4*i], SurfaceRadius * scales[i], sphere );
+	GLfloat depth = -(mv[2][0]*sphere[0] + mv[2][1]*sphere[1]
+			  + mv[2][2]*sphere[2] + mv[2][3]);
+	if ( depth <= sphere[3] ) {
+	    ideal[k] = 0.0;		// up close, or around the eye
+	    continue;
+	}
+	GLfloat rho = sphere[3] * pixels / depth;
+	ideal[k] = log2f( finest / std::max( rho, 1.0e-6f ) );
+    }
+
+    int triangles = 0;
+    for ( GLfloat bias = 0.0; ; bias += 0.5 ) {
+	triangles = 0;
+	bool coarsest = true;
+	for ( int k = 0; k < count; ++k ) {
+	    GLfloat t = std::min( std::max( ideal[k] + bias, 0.0f ), GLfloat( last ) );
+	    int level = std::min( int( t ), last );
+	    lods[k].level = level;
+	    lods[k].morph = level < last ? t - level : 0.0;
+	    triangles += mesh.level( level ).triangle_count / 3;
+	    coarsest = coarsest && level == last;
+	}
+	if ( budget <= 0 || triangles <= budget || coarsest )
+	    return triangles;
+    }
+}
@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Surface.h ---
+//
+//   Curved 4D objects, tessellated from parametric 2D sheets the way the
+//     tesseract is drawn from its square faces:
+//
+//     SURFACE_GLOME           the 3-sphere, as four nested Hopf tori
+//     SURFACE_CLIFFORD_TORUS  the flat torus on the 3-sphere
+//     SURFACE_DUOCYLINDER     its ridge torus, and four discs across each
+//                               of its two solid tori
+//     SURFACE_SPHERINDER      the 2-spheres capping the two ends, and two
+//                               great circles swept between them
+//
+//   All of them fit in a 4D sphere of radius SurfaceRadius.
+//
+//   A SurfaceMesh holds a chain of levels of detail, each a grid of half
+//     the cells along each side of the one before.  Every vertex also
+//     carries its morph target: where it lies on the next coarser level's
+//     triangles.  Corners of a coarser cell stay put, and the rest move
+//     to the middle of the coarser edge they split.  Drawn morphed all
+//     the way, a level is the next one exactly, so an object can slide
+//     from level to level without popping.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SURFACE_H__
+#define __SURFACE_H__
+
+#include "Angel.h"
+#include <vector>
+
+class JobSystem;
+
+enum SurfaceFamily {
+    SURFACE_GLOME,
+    SURFACE_CLIFFORD_TORUS,
+    SURFACE_DUOCYLINDER,
+    SURFACE_SPHERINDER,
+    SURFACE_NUM_FAMILIES
+};
+
+const GLfloat SurfaceRadius = 0.6;
+
+//  "glome", "clifford", "duocylinder" or "spherinder", and back; -1 if not
+//    recognized
+const char* SurfaceFamilyName( SurfaceFamily family );
+int SurfaceFamilyFromName( const char* name );
+
+//  One level of detail: its vertices and its line and triangle indices,
+//    which count from the start of the whole mesh
+struct SurfaceLevel {
+    int  segments;		// grid cells along each side of a sheet
+    int  first_vertex;
+    int  vertex_count;
+    int  first_line;
+    int  line_count;
+    int  first_triangle;
+    int  triangle_count;	// indices, three per triangle
+};
+
+class SurfaceMesh {
+   public:
+    //  Tessellate "family" into "levels" levels, the finest with
+    //    "segments" cells along each side of a sheet (halved per level,
+    //    down to no fewer than 4).  With "jobs", the sheets of all the
+    //    levels are filled in parallel.
+    void build( SurfaceFamily family, int segments, int levels,
+		JobSystem* jobs = NULL );
+
+    int level_count() const { return (int) levels.size(); }
+    const SurfaceLevel& level( int i ) const { return levels[i]; }
+
+    //  Each a vec4 per vertex, all levels one after the other
+    std::vector<vec4>    positions;
+    std::vector<vec4>    morphs;
+    std::vector<vec4>    shades;
+
+    std::vector<GLuint>  lines;
+    std::vector<GLuint>  triangles;
+
+   private:
+    std::vector<SurfaceLevel>  levels;
+};
+
+//  The level an object is drawn at, and how far it is morphed toward the
+//    next coarser one
+struct ObjectLod {
+    int      level;
+    GLfloat  morph;
+};
+
+//  Pick levels for objects[0 .. count) -- indices into "centers" (4 floats
+//    each) and "scales" -- so that a mesh edge covers about "edge_pixels"
+//    pixels.  "pixels" is the window's height over 2 tan(fovy / 2), the
+//    pixels per unit at distance 1.  If the triangles would come to more
+//    than "budget" (0 for no limit), every object is coarsened alike until
+//    they fit or all are at the coarsest level.  Returns the triangles.
+int ChooseSurfaceLods( const SurfaceMesh& mesh, const GLfloat* centers,
+		       const GLfloat* scales, const int* objects, int count,
+		       const mat4& model_view, GLfloat pixels,
+		       GLfloat edge_pixels, int budget, ObjectLod* lods );
+
+#endif // __SURFACE_H__
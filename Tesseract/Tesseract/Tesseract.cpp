@@ -6,9 +6,32 @@
 //
 
 #include "Angel.h"
+#include "FrameStats.h"
+#include "Scene.h"
+#include "Bench.h"
+#include "JobSystem.h"
+#include "Simulation.h"
+#include "TripleBuffer.h"
+#include "Camera.h"
+#include "Polytope.h"
+#include "Wythoff.h"
+#include "Projector.h"
+#include "FixedMesh.h"
+#include "Arena.h"
+#include "MeshFile.h"
+#include "VolumeStream.h"
+#include "PointCloud.h"
+#include "VertexFormat.h"
+#include "Cull.h"
+#include "Surface.h"
+#include "Quality.h"
+#include "Impostor.h"
+#include "RayCast.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string.h>
 
 typedef Angel::vec4  color4;
 typedef Angel::vec4  point4;
@@ -19,27 +42,129 @@ vec4 base_square[4] = {vec4(-10.0, -0.75, -10.0, 1.0), vec4(-10.0, -0.75, 10.0,
 vec4 base_square_colors[4] = {vec4(1.0, 1.0, 1.0, 0.0), vec4(1.0, 0.0, 1.0, 0.0), vec4(1.0, 1.0, 0.0, 0.0), vec4(0.0, 1.0, 1.0, 0.0)};
 
 
-// Parameters for LookAt -- spherical coordinates (r, phi, theta, w)
-// phi = angle down from from +y
-// theta = angle from +x towards +z
-// Keep the eye stationary at the camera-space origin
-const point4  sph_eye( 0.0, 0.0, 0.0, 1.0 );
-point4		  sph_at( 1.0, 90.0, -90.0, 1.0 );
-vec4		  sph_up( 1.0, 0.0, -90.0, 0.0 );
-
-// Cartesian coordinates position for eye
-point4	eye_offset( 0.0, 0.0, 1.0, 1.0 );
-
-// Rotation angles
-GLfloat Angles[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+// Rotation speeds (degrees/second) about (XY, YZ, XZ, XW, YW, ZW)
 GLfloat angle_step_ratios[6] = { 1.0, 2.0, 3.0, 5.0, 7.0, 11.0 };
-GLfloat angle_step = 0.1;
-
-
-// Previous mouse coordinates -- default to somewhere mid-screen
-int x_prev = 256;
-int y_prev = 256;
-GLfloat step = 0.1;
+GLfloat angle_step = 6.0;
+
+// The 4D objects, each with its own center, spin, size and tint.  Owned by
+// the simulation thread once it has started.
+Scene scene;
+int scene_objects = 1;
+
+// Generated shape to draw instead of the tesseract (-shape NAME): one of
+// the PolytopeFamily values, or a uniform polytope if use_wythoff is set
+int shape_family = -1;
+bool use_wythoff = false;
+WythoffSymbol wythoff_symbol;
+
+// Curved surface to draw instead (-shape glome and so on), or -1.  Its
+// levels of detail are picked per object for edges of about
+// lod_edge_pixels (-lod-pixels N), coarsened to stay under lod_budget
+// triangles a frame (-lod-budget N, 0 for no limit).
+int surface_family = -1;
+SurfaceMesh surface;
+const int SurfaceSegments = 64, SurfaceLevels = 5;
+GLfloat lod_edge_pixels = 8.0;
+int lod_budget = 0;
+
+// Dimension of the generated shape (-dim N).  Above 4 the shaders can't
+// draw it: it is rotated and projected to 3D on the CPU every frame, into
+// frame_arena and from there
+// projected_buffer, and drawn with the floor program from index buffers.
+int shape_dimension = 4;
+bool use_projector = false;
+Projector projector;
+GLsizei projected_edge_count = 0, projected_face_count = 0;
+GLenum projected_index_type = GL_UNSIGNED_SHORT;
+
+// A mesh file to draw instead (-mesh FILE), mapped for as long as it is
+// in use.  4D ones go through the shaders, others through the projector.
+MeshFile mesh_file;
+bool use_mesh_file = false;
+
+// -write-mesh FILE: save the -shape as a mesh file and exit
+const char* write_mesh_name = NULL;
+
+// A time-varying volume to draw instead (-volume FILE W H D), streamed
+// from disk and played at volume_fps frames a second (-volume-fps N)
+// once animating.  volume_time counts frames and is owned by the
+// simulation thread.
+VolumeStream volume_stream;
+bool use_volume = false;
+double volume_fps = 24.0;
+double volume_time = 0.0;
+
+// A 4D point cloud to draw instead (-points FILE or -points N): the
+// vertices of a 4D mesh file, or N synthetic points
+PointCloud point_cloud;
+bool use_points = false;
+
+// Its rotation, one angle per plane (degrees).  Owned by the simulation
+// thread once it has started.
+std::vector<GLfloat> plane_angle;
+std::vector<GLfloat> plane_velocity;
+
+// View culling of the objects (off with -nocull).  mesh_radius is the
+// largest length of a vertex of the mesh drawn, set as it is uploaded.
+SceneCuller culler;
+bool use_culling = true;
+GLfloat mesh_radius = 0.0;
+
+// Quality held to a frame budget (-budget MS): the resolution, the
+// wireframe pass, the objects drawn, nearest first, and the surface levels
+// of detail, each decision printed as it is made.  The GPU times come from
+// timer queries.
+QualityController quality;
+bool use_quality = false;
+
+// Worker threads for the per-frame CPU work (-threads N, default one per core)
+JobSystem* jobs = NULL;
+int job_threads = 0;
+
+// Everything display() needs from the simulation, published once per tick
+struct FrameSnapshot {
+	unsigned long         sequence;
+	mat4                  model_view;
+	int                   objects;
+	std::vector<GLfloat>  center;   // 4 per object
+	std::vector<GLfloat>  scale;
+	std::vector<GLfloat>  tint;     // 4 per object
+	std::vector<GLfloat>  sines;    // sines and cosines of the rotation
+	std::vector<GLfloat>  cosines;  //   angles, 6 per object
+	std::vector<GLfloat>  plane_angles; // -dim shape, one per plane
+	double                volume_time;
+	SimulationStats       sim;
+
+	FrameSnapshot() : sequence( 0 ), objects( 0 ), volume_time( 0.0 ) {}
+};
+
+TripleBuffer<FrameSnapshot> snapshots;
+unsigned long snapshot_sequence = 0;
+
+// Raw input from the GLUT callbacks, applied by the simulation thread
+struct InputEvent {
+	enum { Key, Motion, Release } type;
+	unsigned char key;
+	int x, y;
+	int width, height;
+};
+
+SpscQueue<InputEvent, 256> input_events;
+
+// The simulation thread and its rate (-simhz N)
+Simulation simulation;
+double sim_hz = 120.0;
+
+// Set by a left click; the objects spin from then on
+std::atomic<bool> animating( false );
+
+
+// The camera, driven from the simulation thread
+CameraController camera;
+
+// Window size, cached by reshape() for the input callbacks
+int window_width = 512;
+int window_height = 512;
 
 
 // Perspective parameters
@@ -47,247 +172,2286 @@ GLfloat  fovy = 45.0;  // Field-of-view in Y direction angle (in degrees)
 GLfloat  aspect;       // Viewport aspect ratio
 GLfloat  zNear = 0.5, zFar = 3.0;
 
-GLuint  model_view;  // model-view matrix uniform shader variable location
-GLuint  projection; // projection matrix uniform shader variable location
-GLuint  sines;   // sines and cosines of 4D rotation angles
-GLuint  cosines;
+// Uniform and attribute locations, looked up once in init()
+struct ProgramUniforms {
+	GLint  model_view;  // model-view matrix uniform shader variable location
+	GLint  projection;  // projection matrix uniform shader variable location
+	GLint  sines;       // sines and cosines of 4D rotation angles
+	GLint  cosines;
+	GLint  center;      // 4D position of the object
+	GLint  scale;
+	GLint  tint;
+	GLint  morph;       // toward the next level of detail
+	GLint  object;      // picking ID, counted from 1
+	GLint  vPosition;
+	GLint  vColor;
+	GLint  vNormal;
+	GLint  vMorph;      // -1 if the program has none
+};
+
+ProgramUniforms solid_uniforms, wireframe_uniforms, floor_uniforms;
 
 GLuint solid_program, wireframe_program, floor_program;
 GLuint solid, wireframe, floor_buffer;
 
+// Meshes from a file are drawn indexed: mesh_index_type is the type of the
+// indices in wireframe_indices and solid_indices, or 0 for glDrawArrays.
+// Either way the solid buffer's shades start at solid_shade_offset.
+GLuint wireframe_indices, solid_indices;
+GLenum mesh_index_type = 0;
+GLintptr solid_shade_offset = 0;
+
+// Where the morph targets of a surface's vertices start in the wireframe
+// and solid buffers, or 0 if the mesh has none
+GLintptr wireframe_morph_offset = 0, solid_morph_offset = 0;
+
+// Layout of the solid buffer (-vertex-format vec4, packed or half).  The
+// packed ones index a palette in palette_buffer and are drawn with their
+// own program; solid_layout is what the buffer holds now, which is vec4
+// for mesh files and for meshes of more colors than the palette.
+SolidVertexFormat solid_format = SOLID_VEC4;
+SolidVertexFormat solid_layout = SOLID_VEC4;
+GLuint solid_packed_program, palette_buffer;
+ProgramUniforms solid_packed_uniforms;
+const GLuint PaletteBinding = 0;
+
+// Instanced drawing of the tesseract (-instanced), one draw call for all
+// the objects with their data in a texture buffer, and the same with the
+// vertices made in the shader from gl_VertexID (-pull).  Pulled draws use
+// empty_vertex_array, which has no attributes at all.
+bool use_instancing = false;
+bool use_pulling = false;
+GLuint instanced_program, instance_buffer, instance_texture;
+GLuint vertex_array, empty_vertex_array;
+const int InstanceFloats = 24;
+
+struct InstancedUniforms {
+	GLint  model_view;
+	GLint  projection;
+	GLint  instances;
+	GLint  pulled;
+	GLint  lines;
+	GLint  first;
+	GLint  vPosition;
+	GLint  vNormal;
+	GLint  vObject;
+};
+
+InstancedUniforms instanced_uniforms;
+
+// Culling on the GPU (-gpu-cull, needs OpenGL 4.3): cshader_cull.glsl tests
+// the objects in instance_buffer and writes a wireframe and a solid draw
+// command for each into indirect_buffer, and each mesh is drawn for all
+// the objects with one glMultiDrawElementsIndirect.  object_ids holds 0, 1,
+// 2, ... for the draws' vObject attribute, and cull_counter the number of
+// objects found visible.  Meshes drawn with glDrawArrays get index buffers
+// of 0, 1, 2, ... too.
+bool use_gpu_culling = false;
+GLuint cull_program, indirect_buffer, object_ids, cull_counter;
+GLsizei indirect_objects = 0;	// objects indirect_buffer and object_ids hold
+GLenum indirect_index_type;
+
+struct DrawElementsIndirectCommand {
+	GLuint  count;
+	GLuint  instance_count;
+	GLuint  first_index;
+	GLint   base_vertex;
+	GLuint  base_instance;
+};
+
+struct GpuCullUniforms {
+	GLint  object_count;
+	GLint  line_indices;
+	GLint  triangle_indices;
+	GLint  mesh_radius;
+	GLint  planes;
+	GLint  indirect;	// in instanced_program
+};
+
+GpuCullUniforms gpu_cull_uniforms;
+
+// Occlusion culling (-occlusion).  Once the objects are drawn, a box around
+// each one's projection is drawn, with color and depth writes off, inside
+// an any-samples-passed query.  The next frame draws an object only if its
+// box showed, through conditional rendering that doesn't wait for the
+// result.  The two query sets take turns; occlusion_issued says which
+// objects' queries of a set were run.
+bool use_occlusion = false;
+GLuint occlusion_program, proxy_buffer;
+ProgramUniforms occlusion_uniforms;
+GLint occlusion_box;
+GLenum occlusion_target;
+std::vector<GLuint> occlusion_queries[2];
+std::vector<char> occlusion_issued[2];
+int occlusion_set = 0;
+const int ProxyVertices = 36;
+
+// Dynamic resolution (-scale S, and with -budget): the scene is drawn into
+// scene_framebuffer at render_scale times the window's size, then
+// stretched over the window by a linear blit (-upscale bilinear) or the
+// sharpening pass of fshader_upscale.glsl (-upscale sharpen).  The target
+// is sized for the whole window, so a new scale only moves the viewport;
+// render_width and render_height are the part of it drawn.
+enum UpscaleFilter { UPSCALE_BILINEAR, UPSCALE_SHARPEN };
+bool use_scene_target = false;
+UpscaleFilter upscale_filter = UPSCALE_BILINEAR;
+const GLfloat MinRenderScale = 0.25;
+GLfloat render_scale = 1.0;
+int render_width = 512, render_height = 512;
+GLuint scene_framebuffer, scene_color, scene_depth;
+GLuint upscale_program;
+
+struct UpscaleUniforms {
+	GLint  region;
+	GLint  texel;
+	GLint  sharpness;
+};
+
+UpscaleUniforms upscale_uniforms;
+
+// Impostors (-impostors, with -instanced or -pull): an object whose
+// billboard would be at most impostor_pixels across is drawn as a square
+// facing the camera, textured with its tile of an atlas of
+// ImpostorAtlasTiles^2.  A tile is redrawn once the view of its object has
+// turned more than impostor_error degrees (more for smaller billboards),
+// at most impostor_refresh tiles a frame.
+bool use_impostors = false;
+GLfloat impostor_pixels = 24.0;
+GLfloat impostor_error = 2.0;
+int impostor_refresh = 32;
+const int ImpostorTileSize = 32;
+const int ImpostorAtlasTiles = 64;
+GLuint impostor_framebuffer, impostor_color, impostor_depth;
+GLuint impostor_program, impostor_buffer;
+GLint impostor_projection, impostor_box, impostor_tile;
+ImpostorCache impostors;
+ImpostorPlan impostor_plan;
+
+// Picking (-pick, objects drawn one at a time): the solid pass also
+// writes each pixel's object, counted from 1, and triangle into pick_ids,
+// a second attachment of the scene target.  A right click copies the
+// pixel under the cursor into a free one of PickSlots pixel buffers behind
+// a fence, and the fences are polled without waiting, each frame and when
+// idle, until the pick lands.  With -bench the middle of the window is
+// picked every frame.
+struct PickSlot {
+	GLuint         buffer;
+	GLsync         fence;	// NULL while free
+	unsigned long  frame;	// pick_frame when issued
+	double         issued_ms;
+};
+
+bool use_picking = false;
+const int PickSlots = 4;
+const GLenum PickDrawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+GLuint pick_ids;
+PickSlot pick_slots[PickSlots];
+int pick_x = -1, pick_y = -1;	// a click waiting for the next frame
+unsigned long pick_frame = 0;	// frames begun
+
+// With the built-in tesseract a click is also cast as a ray on the CPU, at
+// once, against every object of the snapshot: an exact answer to hold the
+// pick to when it lands, though it knows nothing of the floor or culling
+RayCaster pick_caster;
+GLuint projected_buffer, projected_colors, projected_edges, projected_faces;
+
+// The streamed volume: the frames lately drawn or read ahead, each in a 3D
+// texture filled through volume_pbo, and the box they are marched through.
+// volume_shown is the pair of textures last drawn, kept to draw again when
+// the stream falls behind.
+const int VolumeTextures = 6;
+GLuint volume_textures[VolumeTextures];
+int volume_texture_frame[VolumeTextures];
+unsigned long volume_texture_used[VolumeTextures];
+unsigned long volume_texture_clock = 0;
+int volume_shown[2] = { -1, -1 };
+GLfloat volume_shown_between = 0.0;
+unsigned long volume_stalls = 0;
+GLuint volume_program, volume_pbo, volume_box;
+
+struct VolumeUniforms {
+	GLint  model_view;
+	GLint  projection;
+	GLint  eye;
+	GLint  frame0;
+	GLint  frame1;
+	GLint  between;
+	GLint  steps;
+	GLint  vPosition;
+};
+
+VolumeUniforms volume_uniforms;
+
+// The point cloud's buffers, and the program that unpacks them.  Only the
+// matrix of point_projector is used, to place the chunks for culling.
+GLuint point_program, point_positions, point_colors;
+ProgramUniforms point_uniforms;
+GLint point_chunk_lo, point_chunk_extent;
+Projector point_projector;
+unsigned long point_frames = 0;
+double points_drawn = 0.0, point_chunks_drawn = 0.0;
+
+// Level of detail totals for the -bench report
+unsigned long lod_frames = 0;
+double lod_ms = 0.0, lod_objects = 0.0, lod_level_sum = 0.0, lod_triangles = 0.0,
+	lod_full_triangles = 0.0;
+
+// Culling totals for the -bench report
+unsigned long cull_frames = 0;
+double cull_ms = 0.0, cull_visible = 0.0, cull_nodes = 0.0;
+unsigned long occlusion_frames = 0;
+double occlusion_ms = 0.0, occlusion_queried = 0.0, occlusion_answered = 0.0,
+	occlusion_hidden = 0.0;
+
+// Impostor totals for the -bench report
+unsigned long impostor_frames = 0;
+double impostor_ms = 0.0, impostor_billboards = 0.0, impostor_geometry = 0.0,
+	impostor_captures = 0.0, impostor_stale = 0.0, impostor_evictions = 0.0;
+
+// Picking totals for the -bench report
+unsigned long picks_issued = 0, picks_landed = 0, picks_dropped = 0, pick_polls = 0;
+unsigned long pick_latency_frames = 0, pick_latency_max = 0;
+double pick_latency_ms = 0.0, pick_ms = 0.0;
+
+const char* window_title = "Teseseract";
+
+// Benchmark mode (-bench N): animate continuously, print averages of N
+// frames after a warm-up, then exit
+int bench_frames = 0;
+int bench_warmup = 60;
+int bench_frame = 0;
+GLTraceStats startup_gl;
+
+// -scale-sweep: run the -bench frames at each of these scales in turn
+bool scale_sweep = false;
+const GLfloat SweepScales[] = { 1.0, 0.875, 0.75, 0.625, 0.5 };
+const int SweepSteps = sizeof(SweepScales)/sizeof(SweepScales[0]);
+int sweep_step = 0;
+FrameStats sweep_totals[SweepSteps];
+
+// Scratch memory for one frame, reset at the top of display()
+Arena frame_arena;
+
 //----------------------------------------------------------------------------
 
-int  Index = 0;
-int VerticesUsed = 0;
-const int NumVertices = 6*24;      // 6 vertices / face
+// Memory for building meshes, reset by clear_meshes()
+Arena mesh_arena;
 
-vec4 points[NumVertices];
-vec4 normals[NumVertices];
+// Solid mesh: 3 vertices per triangle, with the face colors in "normals"
+int VerticesUsed = 0;
+ArenaArray<vec4> points( mesh_arena );
+ArenaArray<vec4> normals( mesh_arena );
 
 
-int  face_index = 0;
+// Wireframe mesh: 2 vertices per line
 int FaceVerticesUsed = 0;
-const int FaceVertices = 8*24;
-vec4 face_vertices[FaceVertices];
+ArenaArray<vec4> face_vertices( mesh_arena );
+
+
+//----------------------------------------------------------------------------
+void
+triangle( const vec4& a, const vec4& b, const vec4& c, int color )
+{
+	vec4 shade = FaceColors[color];
+	shade.w = FaceShadeAlpha;
+    points.push_back( a );  normals.push_back( shade );
+    points.push_back( b );  normals.push_back( shade );
+    points.push_back( c );  normals.push_back( shade );
+	VerticesUsed += 3;
+}
+
+// Faces emitted so far, for their colors
+int face_num = 0;
+
+// Start over with empty meshes
+void
+clear_meshes()
+{
+	points.reset();
+	normals.reset();
+	face_vertices.reset();
+	mesh_arena.reset();
+	VerticesUsed = FaceVerticesUsed = 0;
+	face_num = 0;
+}
+
+//----------------------------------------------------------------------------
+
+// Build the solid and wireframe meshes from a generated 4D polytope: its
+// 2-faces as triangles, one color per face, and its edges as lines
+void
+polytope( const Polytope& shape, const vec4& center, GLfloat radius )
+{
+	clear_meshes();
+
+	int n = shape.dimension < 4 ? shape.dimension : 4;
+	vec4* v = mesh_arena.allocate<vec4>( shape.vertex_count() );
+	for( int i=0; i<shape.vertex_count(); i++ )
+	{
+		v[i] = center;
+		for( int k=0; k<n; k++ )
+			v[i][k] += radius*shape.positions[i*shape.dimension + k];
+	}
 
+	int fs = shape.face_size;
+	int triangles = fs > 2 ? 3*shape.face_count()*(fs-2) : 0;
+	points.reserve( triangles );
+	normals.reserve( triangles );
+	face_vertices.reserve( 2*shape.edge_count() );
+	for( int f=0; f<shape.face_count(); f++ )
+	{
+		const PolytopeIndex* corner = &shape.faces[f*fs];
+		const vec4& a = v[corner[PolytopeFaceLoop( shape, 0 )]];
+		for( int i=1; i+1<fs; i++ )
+			triangle( a, v[corner[PolytopeFaceLoop( shape, i )]],
+					  v[corner[PolytopeFaceLoop( shape, i+1 )]], face_num % 24 );
+		face_num++;
+	}
+
+	for( int e=0; e<shape.edge_count(); e++ )
+	{
+		face_vertices.push_back( v[shape.edges[2*e]] );
+		face_vertices.push_back( v[shape.edges[2*e+1]] );
+		FaceVerticesUsed += 2;
+	}
+}
 
 //----------------------------------------------------------------------------
 
+// Same for a uniform polytope from Wythoff's construction.  Its faces are
+// polygons of several sizes; each kind of face gets its own color.
+void
+wythoff( const WythoffMesh& shape, const vec4& center, GLfloat radius )
+{
+	clear_meshes();
+
+	vec4* v = mesh_arena.allocate<vec4>( shape.vertex_count() );
+	for( int i=0; i<shape.vertex_count(); i++ )
+		v[i] = center + radius*vec4( shape.positions[4*i], shape.positions[4*i+1],
+									 shape.positions[4*i+2], shape.positions[4*i+3] );
+
+	// A face of k corners is k-2 triangles
+	int triangles = 3*(shape.face_indices.size() - 2*shape.face_count());
+	points.reserve( triangles );
+	normals.reserve( triangles );
+	face_vertices.reserve( 2*shape.edge_count() );
+
+	for( int f=0; f<shape.face_count(); f++ )
+	{
+		const PolytopeIndex* corner = &shape.face_indices[shape.face_start[f]];
+		int corners = shape.face_start[f+1] - shape.face_start[f];
+		for( int i=1; i+1<corners; i++ )
+			triangle( v[corner[0]], v[corner[i]], v[corner[i+1]], shape.face_kind[f] );
+	}
+
+	for( int e=0; e<shape.edge_count(); e++ )
+	{
+		face_vertices.push_back( v[shape.edges[2*e]] );
+		face_vertices.push_back( v[shape.edges[2*e+1]] );
+		FaceVerticesUsed += 2;
+	}
+}
+
+//----------------------------------------------------------------------------
+
+// Set up a shape of other than 4 dimensions for projection on the CPU: its
+// vertices go to the projector, and its edges and triangles to index
+// buffers over the projected vertices.  The vertex colors cycle through
+// the face colors, unless given, so the faces shade from corner to corner.
+void
+projected_mesh( int dimension, const GLfloat* positions, int count,
+				const void* edges, int edge_indices, const void* triangles,
+				int triangle_indices, GLenum index_type, const vec4* colors )
+{
+	projector.set_vertices( dimension, positions, count );
+
+	if( colors == NULL )
+	{
+		vec4* shade = mesh_arena.allocate<vec4>( count );
+		for( int i=0; i<count; i++ )
+			shade[i] = FaceColors[i % 24];
+		colors = shade;
+	}
+
+	int index_size = index_type == GL_UNSIGNED_INT ? 4 : 2;
+	projected_edge_count = edge_indices;
+	projected_face_count = triangle_indices;
+	projected_index_type = index_type;
+
+	glBindBuffer( GL_ARRAY_BUFFER, projected_colors );
+	glBufferData( GL_ARRAY_BUFFER, count*sizeof(vec4), colors, GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, projected_edges );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, edge_indices*index_size, edges,
+				  GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, projected_faces );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, triangle_indices*index_size, triangles,
+				  GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+}
+
+// The same for a generated polytope, its 2-faces fanned into triangles
 void
-reset_params()
+projected_polytope( const Polytope& shape )
 {
-	// Parameters for LookAt
-	sph_at = vec4( 1.0, 90.0, -90.0, 1.0 );
-	sph_up = vec4( 1.0, 0.0, -90.0, 0.0 );
-	eye_offset = vec4( 0.0, 0.0, 1.0, 1.0 );
+	clear_meshes();
+
+	ArenaArray<PolytopeIndex> triangles( mesh_arena );
+	int fs = shape.face_size;
+	triangles.reserve( fs > 2 ? 3*shape.face_count()*(fs-2) : 0 );
+	for( int f=0; f<shape.face_count(); f++ )
+	{
+		const PolytopeIndex* corner = &shape.faces[f*fs];
+		for( int i=1; i+1<fs; i++ )
+		{
+			triangles.push_back( corner[PolytopeFaceLoop( shape, 0 )] );
+			triangles.push_back( corner[PolytopeFaceLoop( shape, i )] );
+			triangles.push_back( corner[PolytopeFaceLoop( shape, i+1 )] );
+		}
+	}
 
-	step = 0.1;
+	projected_mesh( shape.dimension, &shape.positions[0], shape.vertex_count(),
+					&shape.edges[0], shape.edges.size(), triangles.data(),
+					triangles.size(), GL_UNSIGNED_SHORT, NULL );
 }
 
 //----------------------------------------------------------------------------
 
-// Spherical coordinates represented as (r, phi, theta, w)
-vec4
-sph_to_cart( const vec4& v )
+// Pack the solid mesh into the -vertex-format layout and upload it with
+// its palette.  False if it has too many colors for the palette.
+bool
+upload_packed( const vec4* triangles, const vec4* shades, int triangle_vertices )
+{
+	void* packed = mesh_arena.allocate( triangle_vertices*SolidVertexSize( solid_format ),
+										sizeof(GLfloat) );
+	vec4* palette = mesh_arena.allocate<vec4>( MaxPaletteColors );
+	int colors = PackSolidMesh( solid_format, triangles, shades, triangle_vertices,
+								packed, palette );
+	if( colors < 0 )
+		return false;
+
+	glBindBuffer( GL_ARRAY_BUFFER, solid );
+	glBufferData( GL_ARRAY_BUFFER, triangle_vertices*SolidVertexSize( solid_format ),
+				  packed, GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	glBindBuffer( GL_UNIFORM_BUFFER, palette_buffer );
+	glBufferData( GL_UNIFORM_BUFFER, MaxPaletteColors*sizeof(vec4), NULL, GL_STATIC_DRAW );
+	glBufferSubData( GL_UNIFORM_BUFFER, 0, colors*sizeof(vec4), palette );
+	glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+
+	VerticesUsed = triangle_vertices;
+	solid_shade_offset = 0;
+	solid_layout = solid_format;
+	return true;
+}
+
+// The radius of the 4D sphere about the origin that holds "count" vertices
+GLfloat
+vertex_radius( const vec4* v, int count )
+{
+	GLfloat r2 = 0.0;
+	for( int i=0; i<count; i++ )
+		r2 = std::max( r2, dot( v[i], v[i] ) );
+	return sqrt( r2 );
+}
+
+// Fill the wireframe and solid buffers, resizing them to fit, and set the
+// vertex counts display() draws
+void
+upload_meshes( const vec4* lines, int line_vertices, const vec4* triangles,
+			   const vec4* shades, int triangle_vertices )
+{
+	GLsizeiptr line_bytes = line_vertices*sizeof(vec4);
+	GLsizeiptr triangle_bytes = triangle_vertices*sizeof(vec4);
+
+	glBindBuffer( GL_ARRAY_BUFFER, wireframe );
+	glBufferData( GL_ARRAY_BUFFER, line_bytes, lines, GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	FaceVerticesUsed = line_vertices;
+	mesh_index_type = 0;
+	wireframe_morph_offset = solid_morph_offset = 0;
+	mesh_radius = std::max( vertex_radius( lines, line_vertices ),
+							vertex_radius( triangles, triangle_vertices ) );
+	if( solid_format != SOLID_VEC4
+		&& upload_packed( triangles, shades, triangle_vertices ) )
+		return;
+
+	glBindBuffer( GL_ARRAY_BUFFER, solid );
+	glBufferData( GL_ARRAY_BUFFER, 2*triangle_bytes, NULL, GL_STATIC_DRAW );
+    glBufferSubData( GL_ARRAY_BUFFER, 0, triangle_bytes, triangles );
+	glBufferSubData( GL_ARRAY_BUFFER, triangle_bytes, triangle_bytes, shades );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	VerticesUsed = triangle_vertices;
+	solid_shade_offset = triangle_bytes;
+	solid_layout = SOLID_VEC4;
+}
+
+// Same for the meshes built by polytope() or wythoff()
+void
+upload_meshes()
+{
+	upload_meshes( face_vertices.data(), face_vertices.size(), points.data(),
+				   normals.data(), points.size() );
+}
+
+// The compile-time meshes go up as they are
+template <int V, int F, int E>
+void
+upload_meshes( const FixedMesh<V, F, E>& mesh )
+{
+	upload_meshes( mesh.lines, mesh.LineVertexCount, mesh.points,
+				   mesh.shades, mesh.TriangleVertexCount );
+}
+
+// Upload a mesh file straight from its mapping.  A 4D one becomes indexed
+// wireframe and solid meshes: its positions go to both buffers, its colors
+// after them in the solid one, and its edges and triangles to the index
+// buffers.  Other dimensions go to the projector.  MeshFile::open() has
+// checked the sections' shapes and indices, so their counts can be trusted.
+void
+mesh_file_meshes()
+{
+	const MeshFileSection* positions = mesh_file.find( MESH_POSITIONS );
+	const MeshFileSection* edges = mesh_file.find( MESH_EDGES );
+	const MeshFileSection* triangles = mesh_file.find( MESH_TRIANGLES );
+	const MeshFileSection* colors = mesh_file.find( MESH_COLORS );
+
+	int count = mesh_file.vertex_count();
+	GLenum index_type = edges->value_size == 4 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+
+	if( mesh_file.dimension() != 4 )
+	{
+		projected_mesh( mesh_file.dimension(),
+						(const GLfloat*) mesh_file.data( positions ), count,
+						mesh_file.data( edges ), 2*edges->count,
+						mesh_file.data( triangles ), 3*triangles->count, index_type,
+						colors ? (const vec4*) mesh_file.data( colors ) : NULL );
+		return;
+	}
+
+	const vec4* shades = colors ? (const vec4*) mesh_file.data( colors ) : NULL;
+	if( shades == NULL )
+	{
+		vec4* generated = mesh_arena.allocate<vec4>( count );
+		for( int i=0; i<count; i++ )
+		{
+			generated[i] = FaceColors[i % 24];
+			generated[i].w = FaceShadeAlpha;
+		}
+		shades = generated;
+	}
+
+	GLsizeiptr bytes = count*sizeof(vec4);
+	glBindBuffer( GL_ARRAY_BUFFER, wireframe );
+	glBufferData( GL_ARRAY_BUFFER, bytes, mesh_file.data( positions ), GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, solid );
+	glBufferData( GL_ARRAY_BUFFER, 2*bytes, NULL, GL_STATIC_DRAW );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, bytes, mesh_file.data( positions ) );
+	glBufferSubData( GL_ARRAY_BUFFER, bytes, bytes, shades );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, wireframe_indices );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, edges->bytes(), mesh_file.data( edges ),
+				  GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, solid_indices );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, triangles->bytes(),
+				  mesh_file.data( triangles ), GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+	FaceVerticesUsed = 2*edges->count;
+	VerticesUsed = 3*triangles->count;
+	mesh_radius = vertex_radius( (const vec4*) mesh_file.data( positions ), count );
+	wireframe_morph_offset = solid_morph_offset = 0;
+	solid_shade_offset = bytes;
+	solid_layout = SOLID_VEC4;
+	mesh_index_type = index_type;
+}
+
+// Upload all the levels of the surface, indexed: the wireframe buffer holds
+// positions then morph targets, the solid one positions, shades and morph
+// targets.  The counts display() draws are the finest level's.
+void
+surface_meshes()
+{
+	double start = FrameStatsNow();
+	surface.build( SurfaceFamily( surface_family ), SurfaceSegments, SurfaceLevels,
+				   jobs );
+	double build_ms = FrameStatsNow() - start;
+
+	int count = surface.positions.size();
+	GLsizeiptr bytes = count*sizeof(vec4);
+	glBindBuffer( GL_ARRAY_BUFFER, wireframe );
+	glBufferData( GL_ARRAY_BUFFER, 2*bytes, NULL, GL_STATIC_DRAW );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, bytes, surface.positions.data() );
+	glBufferSubData( GL_ARRAY_BUFFER, bytes, bytes, surface.morphs.data() );
+	glBindBuffer( GL_ARRAY_BUFFER, solid );
+	glBufferData( GL_ARRAY_BUFFER, 3*bytes, NULL, GL_STATIC_DRAW );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, bytes, surface.positions.data() );
+	glBufferSubData( GL_ARRAY_BUFFER, bytes, bytes, surface.shades.data() );
+	glBufferSubData( GL_ARRAY_BUFFER, 2*bytes, bytes, surface.morphs.data() );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, wireframe_indices );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, surface.lines.size()*sizeof(GLuint),
+				  surface.lines.data(), GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, solid_indices );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, surface.triangles.size()*sizeof(GLuint),
+				  surface.triangles.data(), GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+	const SurfaceLevel& finest = surface.level( 0 );
+	FaceVerticesUsed = finest.line_count;
+	VerticesUsed = finest.triangle_count;
+	mesh_index_type = GL_UNSIGNED_INT;
+	mesh_radius = vertex_radius( surface.positions.data(), count );
+	solid_shade_offset = bytes;
+	wireframe_morph_offset = bytes;
+	solid_morph_offset = 2*bytes;
+	solid_layout = SOLID_VEC4;
+
+	std::cout << SurfaceFamilyName( SurfaceFamily( surface_family ) ) << ": "
+			  << surface.level_count() << " levels of " << finest.triangle_count/3;
+	for( int l=1; l<surface.level_count(); l++ )
+		std::cout << ", " << surface.level( l ).triangle_count/3;
+	std::cout << " triangles, built in " << build_ms << " ms" << std::endl;
+}
+
+// Build the shape picked on the command line and upload it
+void
+build_meshes()
+{
+	//upload_meshes( CubeMesh );
+	if( surface_family >= 0 )
+	{
+		surface_meshes();
+		return;
+	}
+	if( use_mesh_file )
+	{
+		clear_meshes();
+		mesh_file_meshes();
+		return;
+	}
+	if( use_wythoff )
+	{
+		// Generating the bigger ones takes a while, so keep them on disk
+		WythoffMesh shape;
+		if( !LoadOrMakeWythoff( shape, wythoff_symbol ) )
+		{
+			std::cerr << "not a finite Coxeter group" << std::endl;
+			exit( EXIT_FAILURE );
+		}
+		wythoff( shape, vec4(0.0,0.0,0.0,0.0), 0.6 );
+
+		std::cout << wythoff_symbol.branches[0] << "," << wythoff_symbol.branches[1]
+				  << "," << wythoff_symbol.branches[2] << " rings "
+				  << (wythoff_symbol.rings & 1) << ((wythoff_symbol.rings >> 1) & 1)
+				  << ((wythoff_symbol.rings >> 2) & 1) << ((wythoff_symbol.rings >> 3) & 1)
+				  << ": " << shape.vertex_count() << " vertices, "
+				  << shape.edge_count() << " edges, " << shape.face_count()
+				  << " faces" << std::endl;
+	}
+	else if( shape_family >= 0 )
+	{
+		// Same circumradius as the tesseract (the projector scales
+		// by it as it goes)
+		Polytope shape;
+		MakePolytope( shape, PolytopeFamily( shape_family ), shape_dimension );
+		if( use_projector )
+		{
+			projected_polytope( shape );
+			return;
+		}
+		polytope( shape, vec4(0.0,0.0,0.0,0.0), 0.6 );
+	}
+	else
+	{
+		// Pulled vertices need no buffers
+		if( use_pulling )
+			mesh_radius = vertex_radius( TesseractMesh.points,
+										 TesseractMesh.TriangleVertexCount );
+		else
+			upload_meshes( TesseractMesh );
+		return;
+	}
+	upload_meshes();
+}
+
+//----------------------------------------------------------------------------
+
+ProgramUniforms
+get_uniforms( GLuint program )
+{
+	ProgramUniforms u;
+	u.model_view = glGetUniformLocation( program, "ModelView" );
+	u.projection = glGetUniformLocation( program, "Projection" );
+	u.sines = glGetUniformLocation( program, "sines" );
+	u.cosines = glGetUniformLocation( program, "cosines" );
+	u.center = glGetUniformLocation( program, "center" );
+	u.scale = glGetUniformLocation( program, "scale" );
+	u.tint = glGetUniformLocation( program, "tint" );
+	u.morph = glGetUniformLocation( program, "morph" );
+	u.object = glGetUniformLocation( program, "object" );
+	u.vPosition = glGetAttribLocation( program, "vPosition" );
+	u.vColor = glGetAttribLocation( program, "vColor" );
+	u.vNormal = glGetAttribLocation( program, "vNormal" );
+	u.vMorph = glGetAttribLocation( program, "vMorph" );
+	return u;
+}
+
+//----------------------------------------------------------------------------
+
+// Fill the scene: a single tesseract at the origin, or a grid of them
+void
+init_scene( int n )
+{
+	GLfloat velocity[6];
+	for( int i=0; i<6; i++ )
+		velocity[i] = angle_step_ratios[i]*angle_step;
+
+	if( n <= 1 )
+	{
+		scene.clear();
+		scene.add( vec4( 0.0, 0.0, 0.0, 0.0 ), 1.0, vec4( 1.0, 1.0, 1.0, 1.0 ), velocity );
+	}
+	else
+		PopulateScene( scene, n, velocity );
+}
+
+// One angle per rotation plane of the -dim shape.  The six 4D planes turn
+// at the usual rates; the others repeat them, slower for each further axis.
+void
+init_plane_angles( int n )
+{
+	int planes = RotationPlaneCount( n );
+	plane_angle.assign( planes, 0.0 );
+	plane_velocity.resize( planes );
+	for( int p=0; p<planes; p++ )
+		plane_velocity[p] = angle_step_ratios[p % 6]*angle_step / (1 + p/6);
+}
+
+// The volume program, its textures and the box to draw them on
+void
+init_volume()
+{
+	volume_program = InitShader( "vshader_volume.glsl", "fshader_volume.glsl" );
+
+	VolumeUniforms& u = volume_uniforms;
+	u.model_view = glGetUniformLocation( volume_program, "ModelView" );
+	u.projection = glGetUniformLocation( volume_program, "Projection" );
+	u.eye = glGetUniformLocation( volume_program, "eye" );
+	u.frame0 = glGetUniformLocation( volume_program, "frame0" );
+	u.frame1 = glGetUniformLocation( volume_program, "frame1" );
+	u.between = glGetUniformLocation( volume_program, "between" );
+	u.steps = glGetUniformLocation( volume_program, "steps" );
+	u.vPosition = glGetAttribLocation( volume_program, "vPosition" );
+
+	// One step per voxel along the longest side
+	int w = volume_stream.width(), h = volume_stream.height(), d = volume_stream.depth();
+	glUseProgram( volume_program );
+	glUniform1i( u.frame0, 0 );
+	glUniform1i( u.frame1, 1 );
+	glUniform1i( u.steps, std::max( w, std::max( h, d ) ) );
+	glUseProgram( 0 );
+
+	glGenTextures( VolumeTextures, volume_textures );
+	for( int i=0; i<VolumeTextures; i++ )
+	{
+		glBindTexture( GL_TEXTURE_3D, volume_textures[i] );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+		glTexImage3D( GL_TEXTURE_3D, 0, GL_R8, w, h, d, 0, GL_RED,
+					  GL_UNSIGNED_BYTE, NULL );
+		volume_texture_frame[i] = -1;
+		volume_texture_used[i] = 0;
+	}
+	glBindTexture( GL_TEXTURE_3D, 0 );
+
+	// Rows of voxels are packed
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	glGenBuffers( 1, &volume_pbo );
+
+	glGenBuffers( 1, &volume_box );
+	glBindBuffer( GL_ARRAY_BUFFER, volume_box );
+	glBufferData( GL_ARRAY_BUFFER, sizeof(CubeMesh.points), CubeMesh.points,
+				  GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+// The point cloud's program and buffers, uploaded once
+void
+init_points()
+{
+	point_program = InitShader( "vshader_points.glsl", "fshader.glsl" );
+	point_uniforms = get_uniforms( point_program );
+	point_chunk_lo = glGetUniformLocation( point_program, "chunk_lo" );
+	point_chunk_extent = glGetUniformLocation( point_program, "chunk_extent" );
+	point_projector.set_vertices( 4, NULL, 0 );
+
+	GLsizeiptr count = point_cloud.point_count();
+	glGenBuffers( 1, &point_positions );
+	glBindBuffer( GL_ARRAY_BUFFER, point_positions );
+	glBufferData( GL_ARRAY_BUFFER, 4*sizeof(GLushort)*count,
+				  point_cloud.quantized_positions(), GL_STATIC_DRAW );
+	glGenBuffers( 1, &point_colors );
+	glBindBuffer( GL_ARRAY_BUFFER, point_colors );
+	glBufferData( GL_ARRAY_BUFFER, sizeof(GLuint)*count,
+				  point_cloud.packed_colors(), GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+// The instanced program, with the tesseract's tables for pulling, and
+// the texture buffer of per-instance data
+void
+init_instancing()
+{
+	instanced_program = InitShader( "vshader_instanced.glsl", "fshader.glsl" );
+
+	InstancedUniforms& u = instanced_uniforms;
+	u.model_view = glGetUniformLocation( instanced_program, "ModelView" );
+	u.projection = glGetUniformLocation( instanced_program, "Projection" );
+	u.instances = glGetUniformLocation( instanced_program, "instances" );
+	u.pulled = glGetUniformLocation( instanced_program, "pulled" );
+	u.lines = glGetUniformLocation( instanced_program, "lines" );
+	u.first = glGetUniformLocation( instanced_program, "first" );
+	u.vPosition = glGetAttribLocation( instanced_program, "vPosition" );
+	u.vNormal = glGetAttribLocation( instanced_program, "vNormal" );
+	u.vObject = glGetAttribLocation( instanced_program, "vObject" );
+
+	GLint quads[4*24], edges[2*TesseractEdgeCount];
+	vec4 colors[24];
+	for( int f=0; f<24; f++ )
+	{
+		for( int k=0; k<4; k++ )
+			quads[4*f+k] = TesseractQuads.faces[f][k];
+		colors[f] = TesseractMesh.shades[6*f] / TesseractMesh.shades[6*f].w;
+	}
+	for( int e=0; e<TesseractEdgeCount; e++ )
+	{
+		edges[2*e] = TesseractMesh.edges[e][0];
+		edges[2*e+1] = TesseractMesh.edges[e][1];
+	}
+
+	glUseProgram( instanced_program );
+	glUniform1i( u.instances, 0 );
+	glUniform1i( u.pulled, use_pulling );
+	glUniform4fv( glGetUniformLocation( instanced_program, "corners" ), 16,
+				  &TesseractMesh.vertices[0].x );
+	glUniform4iv( glGetUniformLocation( instanced_program, "quads" ), 24, quads );
+	glUniform4iv( glGetUniformLocation( instanced_program, "edges" ),
+				  TesseractEdgeCount/2, edges );
+	glUniform4fv( glGetUniformLocation( instanced_program, "face_colors" ), 24,
+				  &colors[0].x );
+	glUseProgram( 0 );
+
+	glGenBuffers( 1, &instance_buffer );
+	glGenTextures( 1, &instance_texture );
+	glBindTexture( GL_TEXTURE_BUFFER, instance_texture );
+	glTexBuffer( GL_TEXTURE_BUFFER, GL_RGBA32F, instance_buffer );
+	glBindTexture( GL_TEXTURE_BUFFER, 0 );
+
+	glGenVertexArrays( 1, &empty_vertex_array );
+}
+
+// The occlusion proxy's program and cube.  Conservative queries may count
+// a pixel the box only touches, which errs on the side of drawing.
+void
+init_occlusion()
+{
+	occlusion_program = InitShader( "vshader_proxy.glsl", "fshader.glsl" );
+	occlusion_uniforms = get_uniforms( occlusion_program );
+	occlusion_box = glGetUniformLocation( occlusion_program, "box" );
+
+	if( GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility )
+		occlusion_target = GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+	else
+		occlusion_target = GL_ANY_SAMPLES_PASSED;
+
+	// Two triangles for each side of the cube (+-1)^3
+	static const int sides[6][4] = {
+		{ 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 },
+		{ 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 }
+	};
+	vec4 cube[ProxyVertices];
+	for( int f=0; f<6; f++ )
+	{
+		static const int corner[6] = { 0, 1, 2, 0, 2, 3 };
+		for( int k=0; k<6; k++ )
+		{
+			int c = sides[f][corner[k]];
+			cube[6*f+k] = vec4( c & 1 ? 1.0 : -1.0, c & 2 ? 1.0 : -1.0,
+								c & 4 ? 1.0 : -1.0, 1.0 );
+		}
+	}
+	glGenBuffers( 1, &proxy_buffer );
+	glBindBuffer( GL_ARRAY_BUFFER, proxy_buffer );
+	glBufferData( GL_ARRAY_BUFFER, sizeof(cube), cube, GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+// Give the meshes just built indices of 0, 1, 2, ... if they have none,
+// for the indirect draws.  Runs after every build_meshes() under -gpu-cull.
+void
+index_meshes()
+{
+	indirect_index_type = mesh_index_type;
+	if( indirect_index_type )
+		return;
+
+	int count = std::max( FaceVerticesUsed, VerticesUsed );
+	GLuint* identity = mesh_arena.allocate<GLuint>( count );
+	for( int i=0; i<count; i++ )
+		identity[i] = i;
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, wireframe_indices );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, FaceVerticesUsed*sizeof(GLuint), identity,
+				  GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, solid_indices );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, VerticesUsed*sizeof(GLuint), identity,
+				  GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	indirect_index_type = GL_UNSIGNED_INT;
+}
+
+// The culling program and its buffers.  Runs after build_meshes(), to index
+// the meshes that have no indices.
+void
+init_gpu_culling()
+{
+	cull_program = InitComputeShader( "cshader_cull.glsl" );
+
+	GpuCullUniforms& u = gpu_cull_uniforms;
+	u.object_count = glGetUniformLocation( cull_program, "object_count" );
+	u.line_indices = glGetUniformLocation( cull_program, "line_indices" );
+	u.triangle_indices = glGetUniformLocation( cull_program, "triangle_indices" );
+	u.mesh_radius = glGetUniformLocation( cull_program, "mesh_radius" );
+	u.planes = glGetUniformLocation( cull_program, "planes" );
+	u.indirect = glGetUniformLocation( instanced_program, "indirect" );
+	glUseProgram( 0 );
+
+	glGenBuffers( 1, &indirect_buffer );
+	glGenBuffers( 1, &object_ids );
+	glGenBuffers( 1, &cull_counter );
+	glBindBuffer( GL_SHADER_STORAGE_BUFFER, cull_counter );
+	glBufferData( GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), NULL, GL_DYNAMIC_READ );
+	glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+
+	index_meshes();
+}
+
+// Draw the scene at "scale" times the window's width and height from the
+// next frame on, MinRenderScale to 1
+void
+set_render_scale( GLfloat scale )
+{
+	render_scale = std::min( std::max( scale, MinRenderScale ), GLfloat( 1.0 ) );
+	render_width = std::max( int( window_width*render_scale + 0.5 ), 1 );
+	render_height = std::max( int( window_height*render_scale + 0.5 ), 1 );
+}
+
+// Size the scene target for the window
+void
+resize_scene_target( int width, int height )
+{
+	glBindTexture( GL_TEXTURE_2D, scene_color );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+				  GL_UNSIGNED_BYTE, NULL );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	glBindRenderbuffer( GL_RENDERBUFFER, scene_depth );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height );
+	if( use_picking )
+	{
+		glBindRenderbuffer( GL_RENDERBUFFER, pick_ids );
+		glRenderbufferStorage( GL_RENDERBUFFER, GL_RG32UI, width, height );
+	}
+	glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+}
+
+void
+init_scene_target()
+{
+	glGenTextures( 1, &scene_color );
+	glBindTexture( GL_TEXTURE_2D, scene_color );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glGenRenderbuffers( 1, &scene_depth );
+	if( use_picking )
+		glGenRenderbuffers( 1, &pick_ids );
+	resize_scene_target( window_width, window_height );
+
+	glGenFramebuffers( 1, &scene_framebuffer );
+	glBindFramebuffer( GL_FRAMEBUFFER, scene_framebuffer );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+							scene_color, 0 );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+							   scene_depth );
+	if( use_picking )
+		glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
+								   GL_RENDERBUFFER, pick_ids );
+	if( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+	{
+		std::cerr << "can't render offscreen: incomplete framebuffer" << std::endl;
+		exit( EXIT_FAILURE );
+	}
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+	if( upscale_filter == UPSCALE_SHARPEN )
+	{
+		upscale_program = InitShader( "vshader_upscale.glsl", "fshader_upscale.glsl" );
+		upscale_uniforms.region = glGetUniformLocation( upscale_program, "region" );
+		upscale_uniforms.texel = glGetUniformLocation( upscale_program, "texel" );
+		upscale_uniforms.sharpness = glGetUniformLocation( upscale_program, "sharpness" );
+		if( !empty_vertex_array )
+			glGenVertexArrays( 1, &empty_vertex_array );
+	}
+}
+
+// Stretch this frame's part of the scene target over the window
+void
+upscale_scene()
+{
+	glViewport( 0, 0, window_width, window_height );
+	if( upscale_filter == UPSCALE_BILINEAR )
+	{
+		glBindFramebuffer( GL_READ_FRAMEBUFFER, scene_framebuffer );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, 0 );
+		glBlitFramebuffer( 0, 0, render_width, render_height,
+						   0, 0, window_width, window_height,
+						   GL_COLOR_BUFFER_BIT, GL_LINEAR );
+		glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+		return;
+	}
+
+	// One triangle over the window; the more the scene is stretched, the
+	// more it is sharpened
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+	glDisable( GL_DEPTH_TEST );
+	glUseProgram( upscale_program );
+	glUniform2f( upscale_uniforms.region, GLfloat( render_width ) / window_width,
+				 GLfloat( render_height ) / window_height );
+	glUniform2f( upscale_uniforms.texel, 1.0 / window_width, 1.0 / window_height );
+	glUniform1f( upscale_uniforms.sharpness, 1.0 - render_scale );
+	glBindTexture( GL_TEXTURE_2D, scene_color );
+	glBindVertexArray( empty_vertex_array );
+	glDrawArrays( GL_TRIANGLES, 0, 3 );
+	glBindVertexArray( vertex_array );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	glEnable( GL_DEPTH_TEST );
+}
+
+// The impostor atlas, its framebuffer, and the billboards' program and
+// instance buffer
+void
+init_impostors()
+{
+	int size = ImpostorAtlasTiles*ImpostorTileSize;
+	glGenTextures( 1, &impostor_color );
+	glBindTexture( GL_TEXTURE_2D, impostor_color );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA,
+				  GL_UNSIGNED_BYTE, NULL );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	glGenRenderbuffers( 1, &impostor_depth );
+	glBindRenderbuffer( GL_RENDERBUFFER, impostor_depth );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size );
+	glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+	glGenFramebuffers( 1, &impostor_framebuffer );
+	glBindFramebuffer( GL_FRAMEBUFFER, impostor_framebuffer );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+							impostor_color, 0 );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+							   impostor_depth );
+	if( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+	{
+		std::cerr << "can't draw impostors: incomplete framebuffer" << std::endl;
+		exit( EXIT_FAILURE );
+	}
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+	impostor_program = InitShader( "vshader_impostor.glsl", "fshader_impostor.glsl" );
+	impostor_projection = glGetUniformLocation( impostor_program, "Projection" );
+	impostor_box = glGetAttribLocation( impostor_program, "vBox" );
+	impostor_tile = glGetAttribLocation( impostor_program, "vTile" );
+	glGenBuffers( 1, &impostor_buffer );
+
+	impostors.reset( ImpostorAtlasTiles*ImpostorAtlasTiles, scene_objects );
+}
+
+// The pixel buffers picks are read into, two IDs each
+void
+init_picking()
+{
+	for( int k=0; k<PickSlots; k++ )
+	{
+		glGenBuffers( 1, &pick_slots[k].buffer );
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, pick_slots[k].buffer );
+		glBufferData( GL_PIXEL_PACK_BUFFER, 2*sizeof(GLuint), NULL, GL_STREAM_READ );
+		pick_slots[k].fence = NULL;
+	}
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+	pick_caster.set_mesh( TesseractMesh.vertices, TesseractMesh.VertexCount,
+						  &TesseractMesh.triangles[0][0], 2*TesseractMesh.FaceCount );
+}
+
+//----------------------------------------------------------------------------
+
+// OpenGL initialization
+void
+init()
+{
+    // Load shaders and use the resulting shader program
+    solid_program = InitShader( "vshader_solid.glsl",
+								use_picking ? "fshader_pick.glsl" : "fshader.glsl" );
+    wireframe_program = InitShader( "vshader_wireframe.glsl", "fshader.glsl" );
+	floor_program = InitShader( "vshader_floor.glsl", "fshader.glsl" );
+
+	solid_uniforms = get_uniforms( solid_program );
+	wireframe_uniforms = get_uniforms( wireframe_program );
+	floor_uniforms = get_uniforms( floor_program );
+    //glUseProgram( wireframe_program );
+
+    // Create a vertex array object
+    glGenVertexArrays( 1, &vertex_array );
+    glBindVertexArray( vertex_array );
+
+    // Create and initialize buffer objects for tesseract, wireframe, and floor
+    // (sized by upload_meshes())
+    glGenBuffers( 1, &wireframe );
+    glGenBuffers( 1, &solid );
+	glGenBuffers( 1, &wireframe_indices );
+	glGenBuffers( 1, &solid_indices );
+
+	// For -dim shapes: projected positions (rewritten every frame), vertex
+	// colors, and edge and face indices
+	glGenBuffers( 1, &projected_buffer );
+	glGenBuffers( 1, &projected_colors );
+	glGenBuffers( 1, &projected_edges );
+	glGenBuffers( 1, &projected_faces );
+
+	// The packed solid layouts' program, and its palette
+	if( solid_format != SOLID_VEC4 )
+	{
+		solid_packed_program = InitShader( "vshader_solid_packed.glsl",
+										   "fshader_flat.glsl" );
+		solid_packed_uniforms = get_uniforms( solid_packed_program );
+		glUniformBlockBinding( solid_packed_program,
+			glGetUniformBlockIndex( solid_packed_program, "Palette" ),
+			PaletteBinding );
+		glGenBuffers( 1, &palette_buffer );
+		glBindBufferBase( GL_UNIFORM_BUFFER, PaletteBinding, palette_buffer );
+	}
+
+	glGenBuffers( 1, &floor_buffer );
+	glBindBuffer( GL_ARRAY_BUFFER, floor_buffer );	
+	glBufferData( GL_ARRAY_BUFFER, sizeof(base_square) + sizeof(base_square_colors),
+		NULL, GL_STATIC_DRAW );
+    glBufferSubData( GL_ARRAY_BUFFER, 0, sizeof(base_square), base_square );
+    glBufferSubData( GL_ARRAY_BUFFER, sizeof(base_square), sizeof(base_square_colors), base_square_colors );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+
+	build_meshes();
+	init_scene( scene_objects );
+	init_plane_angles( use_projector ? shape_dimension : 4 );
+	if( use_volume )
+		init_volume();
+	if( use_points )
+		init_points();
+	if( use_instancing || use_gpu_culling )
+		init_instancing();
+	if( use_gpu_culling )
+		init_gpu_culling();
+	if( use_occlusion )
+		init_occlusion();
+	if( use_scene_target )
+		init_scene_target();
+	if( use_impostors )
+		init_impostors();
+	if( use_picking )
+		init_picking();
+	if( use_quality )
+	{
+		quality.set_min_resolution( 0.5 );
+		quality.set_object_count( scene_objects );
+		quality.set_log( stdout );
+	}
+	if( (use_quality || scale_sweep) && !FrameStatsEnableGpuTimer() )
+		std::cerr << "no timer queries: timing frames on the CPU only" << std::endl;
+
+    glEnable( GL_DEPTH_TEST );
+    glClearColor( 0.0, 0.0, 0.0, 1.0 ); 
+}
+
+//----------------------------------------------------------------------------
+
+// Fill the next snapshot from the scene and camera, and hand it to display()
+void
+publish_snapshot()
+{
+	FrameSnapshot& snap = snapshots.write_buffer();
+	int n = scene.size();
+
+	snap.sequence = ++snapshot_sequence;
+	snap.objects = n;
+	snap.center.resize( 4*n );
+	snap.scale.resize( n );
+	snap.tint.resize( 4*n );
+	snap.sines.resize( 6*n );
+	snap.cosines.resize( 6*n );
+
+	snap.model_view = camera.view();
+	snap.plane_angles = plane_angle;
+	snap.volume_time = volume_time;
+
+	jobs->parallel_for( 0, n, 0, [&snap]( int first, int last )
+	{
+		for( int i=first; i<last; i++ )
+		{
+			for( int k=0; k<4; k++ )
+			{
+				snap.center[4*i+k] = scene.center[k][i];
+				snap.tint[4*i+k] = scene.color[k][i];
+			}
+			snap.scale[i] = scene.scale[i];
+
+			for( int p=0; p<6; p++ )
+			{
+				snap.sines[6*i+p] = sin(scene.angle[p][i]*DegreesToRadians);
+				snap.cosines[6*i+p] = cos(scene.angle[p][i]*DegreesToRadians);
+			}
+		}
+	} );
+
+	snap.sim = simulation.stats();
+	snapshots.publish();
+}
+
+// Whether to draw the wireframes this frame
+bool
+wireframe_pass()
+{
+	return !use_quality || quality.knobs().wireframe;
+}
+
+// Draw the bound vertices (or indices) once per visible object with that
+// object's uniforms, each only if its query in "conditions" (if any)
+// passed; 0 draws it anyway.  With "lods", each object draws the surface
+// level picked for it instead of "count" indices.
+void
+draw_objects( const FrameSnapshot& snap, const int* visible, int n,
+			  const GLuint* conditions, const ObjectLod* lods,
+			  const ProgramUniforms& u, GLenum mode, GLsizei count )
+{
+	for( int v=0; v<n; v++ )
+	{
+		int i = visible[v];
+		GLuint condition = conditions ? conditions[v] : 0;
+		GLsizei first = 0;
+		if( lods )
+		{
+			const SurfaceLevel& level = surface.level( lods[v].level );
+			first = mode == GL_LINES ? level.first_line : level.first_triangle;
+			count = mode == GL_LINES ? level.line_count : level.triangle_count;
+			glUniform1f( u.morph, lods[v].morph );
+		}
+		glUniform1fv( u.sines, 6, &snap.sines[6*i] );
+		glUniform1fv( u.cosines, 6, &snap.cosines[6*i] );
+		glUniform4f( u.center, snap.center[4*i], snap.center[4*i+1],
+					 snap.center[4*i+2], snap.center[4*i+3] );
+		glUniform1f( u.scale, snap.scale[i] );
+		glUniform4f( u.tint, snap.tint[4*i], snap.tint[4*i+1],
+					 snap.tint[4*i+2], snap.tint[4*i+3] );
+		if( u.object >= 0 )
+			glUniform1ui( u.object, i + 1 );
+
+		if( condition )
+			glBeginConditionalRender( condition, GL_QUERY_NO_WAIT );
+		if( mesh_index_type == GL_UNSIGNED_INT )
+			glDrawElements( mode, count, mesh_index_type,
+							BUFFER_OFFSET(first*sizeof(GLuint)) );
+		else if( mesh_index_type )
+			glDrawElements( mode, count, mesh_index_type, BUFFER_OFFSET(0) );
+		else
+			glDrawArrays( mode, 0, count );
+		if( condition )
+			glEndConditionalRender();
+	}
+}
+
+// Fill instance_buffer with the snapshot's data for the visible objects,
+// or for all of them if "visible" is NULL
+void
+upload_instances( const FrameSnapshot& snap, const int* visible, int n )
+{
+	GLfloat* data = frame_arena.allocate<GLfloat>( InstanceFloats*n );
+	for( int v=0; v<n; v++ )
+	{
+		int i = visible ? visible[v] : v;
+		GLfloat* d = data + InstanceFloats*v;
+		for( int k=0; k<4; k++ )
+		{
+			d[k] = snap.center[4*i+k];
+			d[4+k] = snap.tint[4*i+k];
+		}
+		d[8] = snap.scale[i];
+		d[9] = d[10] = d[11] = 0.0;
+		for( int k=0; k<6; k++ )
+		{
+			d[12+k] = snap.sines[6*i+k];
+			d[18+k] = snap.cosines[6*i+k];
+		}
+	}
+
+	GLsizeiptr size = InstanceFloats*n*sizeof(GLfloat);
+	glBindBuffer( GL_TEXTURE_BUFFER, instance_buffer );
+	glBufferData( GL_TEXTURE_BUFFER, size, NULL, GL_STREAM_DRAW );
+	glBufferSubData( GL_TEXTURE_BUFFER, 0, size, data );
+	glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+}
+
+// Draw "count" objects of the texture buffer from "first" on, wireframes
+// and solids, with instanced_program in use and the buffer bound
+void
+draw_instances( int first, GLsizei count )
+{
+	glUniform1i( instanced_uniforms.first, first );
+	if( use_pulling )
+	{
+		glBindVertexArray( empty_vertex_array );
+		glUniform1i( instanced_uniforms.lines, 1 );
+		if( wireframe_pass() )
+			glDrawArraysInstanced( GL_LINES, 0, TesseractMesh.LineVertexCount, count );
+		glUniform1i( instanced_uniforms.lines, 0 );
+		glDrawArraysInstanced( GL_TRIANGLES, 0, TesseractMesh.TriangleVertexCount, count );
+		glBindVertexArray( vertex_array );
+	}
+	else
+	{
+		GLuint vPosition = instanced_uniforms.vPosition;
+		GLuint vNormal = instanced_uniforms.vNormal;
+
+		glBindBuffer( GL_ARRAY_BUFFER, wireframe );
+	    glEnableVertexAttribArray( vPosition );
+	    glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
+				   BUFFER_OFFSET(0) );
+		glDisableVertexAttribArray( vNormal );
+		glUniform1i( instanced_uniforms.lines, 1 );
+		if( wireframe_pass() )
+			glDrawArraysInstanced( GL_LINES, 0, FaceVerticesUsed, count );
+
+		glBindBuffer( GL_ARRAY_BUFFER, solid );
+	    glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
+				   BUFFER_OFFSET(0) );
+	    glEnableVertexAttribArray( vNormal );
+	    glVertexAttribPointer( vNormal, 4, GL_FLOAT, GL_FALSE, 0,
+				   BUFFER_OFFSET(solid_shade_offset) );
+		glUniform1i( instanced_uniforms.lines, 0 );
+		glDrawArraysInstanced( GL_TRIANGLES, 0, VerticesUsed, count );
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	}
+}
+
+// Draw every visible object's wireframe and solid tesseract in one
+// instanced call each, with their data from the snapshot in the texture
+// buffer
+void
+draw_instanced( const FrameSnapshot& snap, const int* visible, int n,
+				const mat4& p )
+{
+	if( n == 0 )
+		return;
+	upload_instances( snap, visible, n );
+
+	glUseProgram( instanced_program );
+	glUniformMatrix4fv( instanced_uniforms.model_view, 1, GL_TRUE, snap.model_view );
+	glUniformMatrix4fv( instanced_uniforms.projection, 1, GL_TRUE, p );
+	glBindTexture( GL_TEXTURE_BUFFER, instance_texture );
+	draw_instances( 0, n );
+	glBindTexture( GL_TEXTURE_BUFFER, 0 );
+}
+
+// Draw the tiles the plan captures this frame into the atlas, each object
+// on its own, zoomed to fill its tile
+void
+capture_impostors( const FrameSnapshot& snap, const mat4& p )
+{
+	const ImpostorPlan& plan = impostor_plan;
+	int n = plan.captures.size();
+	if( n == 0 )
+		return;
+	int* objects = frame_arena.allocate<int>( n );
+	for( int k=0; k<n; k++ )
+		objects[k] = plan.billboards[plan.captures[k]];
+	upload_instances( snap, objects, n );
+
+	// Cleared to alpha 0, so the billboards show only what the object covers
+	glBindFramebuffer( GL_FRAMEBUFFER, impostor_framebuffer );
+	glEnable( GL_SCISSOR_TEST );
+	glClearColor( 0.0, 0.0, 0.0, 0.0 );
+
+	glUseProgram( instanced_program );
+	glUniformMatrix4fv( instanced_uniforms.model_view, 1, GL_TRUE, snap.model_view );
+	glBindTexture( GL_TEXTURE_BUFFER, instance_texture );
+	for( int k=0; k<n; k++ )
+	{
+		int tile = impostors.tile( objects[k] );
+		int x = (tile % ImpostorAtlasTiles)*ImpostorTileSize;
+		int y = (tile / ImpostorAtlasTiles)*ImpostorTileSize;
+		glViewport( x, y, ImpostorTileSize, ImpostorTileSize );
+		glScissor( x, y, ImpostorTileSize, ImpostorTileSize );
+		glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+		mat4 zoomed = ImpostorProjection( p, &plan.boxes[4*plan.captures[k]] );
+		glUniformMatrix4fv( instanced_uniforms.projection, 1, GL_TRUE, zoomed );
+		draw_instances( k, 1 );
+	}
+	glBindTexture( GL_TEXTURE_BUFFER, 0 );
+
+	glDisable( GL_SCISSOR_TEST );
+	glClearColor( 0.0, 0.0, 0.0, 1.0 );
+	glBindFramebuffer( GL_FRAMEBUFFER, use_scene_target ? scene_framebuffer : 0 );
+	glViewport( 0, 0, render_width, render_height );
+}
+
+// Draw the plan's billboards in one instanced call, each a strip of 4 with
+// its box and tile from impostor_buffer.  The tiles are inset half a texel
+// so the filtering doesn't reach the next one.
+void
+draw_billboards( const mat4& p )
+{
+	const ImpostorPlan& plan = impostor_plan;
+	int n = plan.billboards.size();
+	if( n == 0 )
+		return;
+
+	const GLfloat size = 1.0 / ImpostorAtlasTiles;
+	const GLfloat texel = size / ImpostorTileSize;
+	GLfloat* data = frame_arena.allocate<GLfloat>( 8*n );
+	for( int b=0; b<n; b++ )
+	{
+		int tile = impostors.tile( plan.billboards[b] );
+		GLfloat* d = data + 8*b;
+		for( int k=0; k<4; k++ )
+			d[k] = plan.boxes[4*b+k];
+		d[4] = (tile % ImpostorAtlasTiles)*size + 0.5*texel;
+		d[5] = (tile / ImpostorAtlasTiles)*size + 0.5*texel;
+		d[6] = size - texel;
+		d[7] = 0.0;
+	}
+	GLsizeiptr bytes = 8*n*sizeof(GLfloat);
+	glBindBuffer( GL_ARRAY_BUFFER, impostor_buffer );
+	glBufferData( GL_ARRAY_BUFFER, bytes, NULL, GL_STREAM_DRAW );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, bytes, data );
+
+	glUseProgram( impostor_program );
+	glUniformMatrix4fv( impostor_projection, 1, GL_TRUE, p );
+	GLuint vBox = impostor_box;
+	GLuint vTile = impostor_tile;
+	glEnableVertexAttribArray( vBox );
+	glVertexAttribPointer( vBox, 4, GL_FLOAT, GL_FALSE, 8*sizeof(GLfloat),
+						   BUFFER_OFFSET(0) );
+	glVertexAttribDivisor( vBox, 1 );
+	glEnableVertexAttribArray( vTile );
+	glVertexAttribPointer( vTile, 4, GL_FLOAT, GL_FALSE, 8*sizeof(GLfloat),
+						   BUFFER_OFFSET(4*sizeof(GLfloat)) );
+	glVertexAttribDivisor( vTile, 1 );
+
+	glBindTexture( GL_TEXTURE_2D, impostor_color );
+	glDrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, n );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	// The other programs' attributes may share the locations
+	glVertexAttribDivisor( vBox, 0 );
+	glVertexAttribDivisor( vTile, 0 );
+	glDisableVertexAttribArray( vBox );
+	glDisableVertexAttribArray( vTile );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+// Split the visible objects between billboards and meshes, bring the tiles
+// due this frame up to date, and draw the billboards.  Leaves the objects
+// still to be drawn as meshes in "visible" and returns how many.
+int
+draw_impostors( const FrameSnapshot& snap, int* visible, int n, const mat4& p )
+{
+	ImpostorView view;
+	view.centers = snap.center.data();
+	view.scales = snap.scale.data();
+	view.sines = snap.sines.data();
+	view.cosines = snap.cosines.data();
+	view.mesh_radius = mesh_radius;
+	view.model_view = snap.model_view;
+	view.pixels = render_height / (2.0*tan( fovy*DegreesToRadians/2.0 ));
+	view.max_pixels = impostor_pixels / 2.0;
+	view.max_error = impostor_error*DegreesToRadians;
+	view.refresh = impostor_refresh;
+
+	double start = FrameStatsNow();
+	impostors.plan( view, visible, n, impostor_plan );
+	impostor_ms += FrameStatsNow() - start;
+
+	const ImpostorStats& s = impostors.stats();
+	impostor_billboards += s.billboards;
+	impostor_geometry += s.geometry;
+	impostor_captures += s.captures;
+	impostor_stale += s.stale;
+	impostor_evictions += s.evictions;
+	impostor_frames++;
+
+	capture_impostors( snap, p );
+	draw_billboards( p );
+
+	const std::vector<int>& geometry = impostor_plan.geometry;
+	std::copy( geometry.begin(), geometry.end(), visible );
+	return geometry.size();
+}
+
+// Upload every object, cull them on the GPU and draw what it kept: a
+// dispatch and two draws whatever the number of objects
+void
+draw_indirect( const FrameSnapshot& snap, const mat4& p )
+{
+	int n = snap.objects;
+	if( n == 0 )
+		return;
+	upload_instances( snap, NULL, n );
+
+	if( n > indirect_objects )
+	{
+		glBindBuffer( GL_DRAW_INDIRECT_BUFFER, indirect_buffer );
+		glBufferData( GL_DRAW_INDIRECT_BUFFER, 2*n*sizeof(DrawElementsIndirectCommand),
+					  NULL, GL_DYNAMIC_DRAW );
+		glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+
+		GLint* ids = frame_arena.allocate<GLint>( n );
+		for( int i=0; i<n; i++ )
+			ids[i] = i;
+		glBindBuffer( GL_ARRAY_BUFFER, object_ids );
+		glBufferData( GL_ARRAY_BUFFER, n*sizeof(GLint), ids, GL_STATIC_DRAW );
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+		indirect_objects = n;
+	}
+
+	// Cull, writing the commands
+	GLfloat planes[6][4];
+	FrustumPlanes( p*snap.model_view, planes );
+	const GpuCullUniforms& u = gpu_cull_uniforms;
+	GLuint zero = 0;
+
+	glUseProgram( cull_program );
+	glUniform1i( u.object_count, n );
+	glUniform1i( u.line_indices, FaceVerticesUsed );
+	glUniform1i( u.triangle_indices, VerticesUsed );
+	glUniform1f( u.mesh_radius, mesh_radius );
+	glUniform4fv( u.planes, 6, &planes[0][0] );
+	glBindBuffer( GL_SHADER_STORAGE_BUFFER, cull_counter );
+	glBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero );
+	glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, instance_buffer );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, indirect_buffer );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, cull_counter );
+	glDispatchCompute( (n + 63)/64, 1, 1 );
+	glMemoryBarrier( GL_COMMAND_BARRIER_BIT );
+
+	// Draw, with each command's base instance picking its object's id
+	glUseProgram( instanced_program );
+	glUniformMatrix4fv( instanced_uniforms.model_view, 1, GL_TRUE, snap.model_view );
+	glUniformMatrix4fv( instanced_uniforms.projection, 1, GL_TRUE, p );
+	glUniform1i( u.indirect, 1 );
+	glBindTexture( GL_TEXTURE_BUFFER, instance_texture );
+	glBindBuffer( GL_DRAW_INDIRECT_BUFFER, indirect_buffer );
+
+	GLuint vPosition = instanced_uniforms.vPosition;
+	GLuint vNormal = instanced_uniforms.vNormal;
+	GLuint vObject = instanced_uniforms.vObject;
+
+	glBindBuffer( GL_ARRAY_BUFFER, object_ids );
+	glEnableVertexAttribArray( vObject );
+	glVertexAttribIPointer( vObject, 1, GL_INT, 0, BUFFER_OFFSET(0) );
+	glVertexAttribDivisor( vObject, 1 );
+
+	glBindBuffer( GL_ARRAY_BUFFER, wireframe );
+	glEnableVertexAttribArray( vPosition );
+	glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0) );
+	glDisableVertexAttribArray( vNormal );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, wireframe_indices );
+	glUniform1i( instanced_uniforms.lines, 1 );
+	if( wireframe_pass() )
+		glMultiDrawElementsIndirect( GL_LINES, indirect_index_type, BUFFER_OFFSET(0), n, 0 );
+
+	glBindBuffer( GL_ARRAY_BUFFER, solid );
+	glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0) );
+	glEnableVertexAttribArray( vNormal );
+	glVertexAttribPointer( vNormal, 4, GL_FLOAT, GL_FALSE, 0,
+						   BUFFER_OFFSET(solid_shade_offset) );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, solid_indices );
+	glUniform1i( instanced_uniforms.lines, 0 );
+	glMultiDrawElementsIndirect( GL_TRIANGLES, indirect_index_type,
+		BUFFER_OFFSET(n*sizeof(DrawElementsIndirectCommand)), n, 0 );
+
+	// vertex_array is shared with the other paths
+	glVertexAttribDivisor( vObject, 0 );
+	glDisableVertexAttribArray( vObject );
+	glUniform1i( u.indirect, 0 );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+	glBindTexture( GL_TEXTURE_BUFFER, 0 );
+}
+
+// Rotate and project the -dim shape on the CPU, refill its buffer, and draw
+// its faces and edges with the floor program, which is bound and takes
+// positions as they are
+void
+draw_projected( const FrameSnapshot& snap )
+{
+	GLfloat center[MaxProjectorDimension] = { 0.0 };
+	for( int k=0; k<4; k++ )
+		center[k] = snap.center[k];
+	projector.set_rotation( &snap.plane_angles[0], 0.6*snap.scale[0], center );
+
+	int count = projector.vertex_count();
+	vec4* projected = frame_arena.allocate<vec4>( count );
+	jobs->parallel_for( 0, count, 1024, [projected]( int first, int last )
+	{
+		projector.project( first, last, projected );
+	} );
+
+	// Orphan last frame's storage instead of waiting for the GPU to
+	// finish drawing from it
+	GLsizeiptr size = count*sizeof(vec4);
+	glBindBuffer( GL_ARRAY_BUFFER, projected_buffer );
+	glBufferData( GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, size, projected );
+
+	GLuint vPosition = floor_uniforms.vPosition;
+    glEnableVertexAttribArray( vPosition );
+    glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
+			   BUFFER_OFFSET(0) );
+
+	GLuint vColor = floor_uniforms.vColor;
+	glBindBuffer( GL_ARRAY_BUFFER, projected_colors );
+    glVertexAttribPointer( vColor, 4, GL_FLOAT, GL_FALSE, 0,
+			   BUFFER_OFFSET(0) );
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, projected_faces );
+	glDrawElements( GL_TRIANGLES, projected_face_count, projected_index_type,
+					BUFFER_OFFSET(0) );
+
+	// Edges in the object's tint
+	glDisableVertexAttribArray( vColor );
+	glVertexAttrib4f( vColor, snap.tint[0], snap.tint[1], snap.tint[2], snap.tint[3] );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, projected_edges );
+	glDrawElements( GL_LINES, projected_edge_count, projected_index_type,
+					BUFFER_OFFSET(0) );
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+// The texture holding "frame", uploaded now if the stream has read it, or
+// -1 if it hasn't.  An upload takes the least recently used texture that
+// doesn't hold one of the frames in "keep".
+int
+volume_texture( int frame, const int keep[4] )
+{
+	int lru = -1;
+	for( int i=0; i<VolumeTextures; i++ )
+	{
+		if( volume_texture_frame[i] == frame )
+		{
+			volume_texture_used[i] = ++volume_texture_clock;
+			return i;
+		}
+		bool kept = false;
+		for( int k=0; k<4; k++ )
+			kept = kept || (keep[k] >= 0 && volume_texture_frame[i] == keep[k]);
+		if( !kept && (lru < 0 || volume_texture_used[i] < volume_texture_used[lru]) )
+			lru = i;
+	}
+
+	const unsigned char* voxels = volume_stream.acquire( frame );
+	if( voxels == NULL )
+		return -1;
+
+	// Copy into fresh pixel buffer storage, so the copy doesn't wait for
+	// the last upload, and let the driver move it into the texture
+	GLsizeiptr size = volume_stream.frame_bytes();
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, volume_pbo );
+	glBufferData( GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW );
+	void* mapped = glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, size,
+									 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+	if( mapped )
+		memcpy( mapped, voxels, size );
+	volume_stream.release( frame );
+	if( mapped == NULL || !glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER ) )
+	{
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+		return -1;
+	}
+
+	glBindTexture( GL_TEXTURE_3D, volume_textures[lru] );
+	glTexSubImage3D( GL_TEXTURE_3D, 0, 0, 0, 0, volume_stream.width(),
+					 volume_stream.height(), volume_stream.depth(), GL_RED,
+					 GL_UNSIGNED_BYTE, BUFFER_OFFSET(0) );
+	glBindTexture( GL_TEXTURE_3D, 0 );
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+	volume_texture_frame[lru] = frame;
+	volume_texture_used[lru] = ++volume_texture_clock;
+	return lru;
+}
+
+// Ray march the volume between the two frames either side of the
+// snapshot's time.  If the stream hasn't read them yet, draw the last
+// pair again rather than wait, and count a stall.
+void
+draw_volume( const FrameSnapshot& snap, const mat4& p )
+{
+	int frames = volume_stream.frames();
+	int f0 = int( snap.volume_time ) % frames;
+	int f1 = (f0 + 1) % frames;
+	GLfloat between = GLfloat( snap.volume_time - floor( snap.volume_time ) );
+
+	int keep[4] = { f0, f1, -1, -1 };
+	for( int k=0; k<2; k++ )
+		if( volume_shown[k] >= 0 )
+			keep[2+k] = volume_texture_frame[volume_shown[k]];
+
+	int t0 = volume_texture( f0, keep );
+	int t1 = t0 < 0 ? -1 : volume_texture( f1, keep );
+	if( t1 >= 0 )
+	{
+		volume_shown[0] = t0;
+		volume_shown[1] = t1;
+		volume_shown_between = between;
+
+		// Upload the next one ahead of time if it is in
+		volume_texture( (f1 + 1) % frames, keep );
+	}
+	else
+		volume_stalls++;
+	if( volume_shown[0] < 0 )
+		return;
+
+	// The eye in object space: LookAt() is a rotation and a translation
+	const mat4& mv = snap.model_view;
+	GLfloat eye[3];
+	for( int k=0; k<3; k++ )
+		eye[k] = -(mv[0][k]*mv[0][3] + mv[1][k]*mv[1][3] + mv[2][k]*mv[2][3]);
+
+	glUseProgram( volume_program );
+	glUniformMatrix4fv( volume_uniforms.model_view, 1, GL_TRUE, mv );
+	glUniformMatrix4fv( volume_uniforms.projection, 1, GL_TRUE, p );
+	glUniform4f( volume_uniforms.eye, eye[0], eye[1], eye[2], 1.0 );
+	glUniform1f( volume_uniforms.between, volume_shown_between );
+
+	glActiveTexture( GL_TEXTURE1 );
+	glBindTexture( GL_TEXTURE_3D, volume_textures[volume_shown[1]] );
+	glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_3D, volume_textures[volume_shown[0]] );
+
+	glBindBuffer( GL_ARRAY_BUFFER, volume_box );
+	GLuint vPosition = volume_uniforms.vPosition;
+    glEnableVertexAttribArray( vPosition );
+    glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
+			   BUFFER_OFFSET(0) );
+
+	// Premultiplied, over whatever is behind, without hiding it
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+	glDepthMask( GL_FALSE );
+	glDrawArrays( GL_TRIANGLES, 0, sizeof(CubeMesh.points)/sizeof(CubeMesh.points[0]) );
+	glDepthMask( GL_TRUE );
+	glDisable( GL_BLEND );
+
+	glBindTexture( GL_TEXTURE_3D, 0 );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+// Draw the chunks of the point cloud that survive culling against the
+// view, placed like the first object and turned by the plane angles
+void
+draw_points( const FrameSnapshot& snap, const mat4& p )
+{
+	point_projector.set_rotation( &snap.plane_angles[0], snap.scale[0],
+								  &snap.center[0] );
+	int* visible = frame_arena.allocate<int>( point_cloud.chunk_count() );
+	int n = point_cloud.cull( point_projector.matrix(), point_projector.offset(),
+							  p*snap.model_view, visible );
+
+	GLfloat sines[6], cosines[6];
+	for( int i=0; i<6; i++ )
+	{
+		sines[i] = sin( snap.plane_angles[i]*DegreesToRadians );
+		cosines[i] = cos( snap.plane_angles[i]*DegreesToRadians );
+	}
+
+	const ProgramUniforms& u = point_uniforms;
+	glUseProgram( point_program );
+	glUniformMatrix4fv( u.model_view, 1, GL_TRUE, snap.model_view );
+	glUniformMatrix4fv( u.projection, 1, GL_TRUE, p );
+	glUniform1fv( u.sines, 6, sines );
+	glUniform1fv( u.cosines, 6, cosines );
+	glUniform4f( u.center, snap.center[0], snap.center[1], snap.center[2],
+				 snap.center[3] );
+	glUniform1f( u.scale, snap.scale[0] );
+	glUniform4f( u.tint, snap.tint[0], snap.tint[1], snap.tint[2], snap.tint[3] );
+
+	// Both attributes are read normalized
+	GLuint vPosition = point_uniforms.vPosition;
+	glBindBuffer( GL_ARRAY_BUFFER, point_positions );
+    glEnableVertexAttribArray( vPosition );
+    glVertexAttribPointer( vPosition, 4, GL_UNSIGNED_SHORT, GL_TRUE, 0,
+			   BUFFER_OFFSET(0) );
+	GLuint vColor = point_uniforms.vColor;
+	glBindBuffer( GL_ARRAY_BUFFER, point_colors );
+    glEnableVertexAttribArray( vColor );
+    glVertexAttribPointer( vColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0,
+			   BUFFER_OFFSET(0) );
+
+	for( int i=0; i<n; i++ )
+	{
+		const PointChunk& c = point_cloud.chunk( visible[i] );
+		glUniform4f( point_chunk_lo, c.lo[0], c.lo[1], c.lo[2], c.lo[3] );
+		glUniform4f( point_chunk_extent, c.extent[0], c.extent[1], c.extent[2],
+					 c.extent[3] );
+		glDrawArrays( GL_POINTS, c.first, c.count );
+		points_drawn += c.count;
+	}
+	point_chunks_drawn += n;
+	point_frames++;
+
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+// Load the -points cloud: a 4D mesh file's vertices and colors, or a
+// synthetic one of that many points
+bool
+load_points( const char* source )
+{
+	std::vector<GLfloat> positions;
+	std::vector<GLubyte> colors;
+	if( source[0] >= '0' && source[0] <= '9' )
+		MakeTestPointCloud( positions, colors, atoi( source ) );
+	else
+	{
+		// MeshFile::open() has checked that a 4D file's positions are 4
+		// floats a vertex, and that its colors, if any, are one per vertex
+		MeshFile file;
+		if( !file.open( source ) || file.dimension() != 4
+			|| !file.find( MESH_POSITIONS ) )
+			return false;
+		const MeshFileSection* x = file.find( MESH_POSITIONS );
+		const GLfloat* p = (const GLfloat*) file.data( x );
+		positions.assign( p, p + 4*x->count );
+
+		const MeshFileSection* c = file.find( MESH_COLORS );
+		if( c )
+		{
+			const GLfloat* rgba = (const GLfloat*) file.data( c );
+			colors.resize( 4*c->count );
+			for( size_t i=0; i<colors.size(); i++ )
+				colors[i] = GLubyte( 255.0*std::min( std::max( rgba[i], 0.0f ), 1.0f ) + 0.5 );
+		}
+	}
+	if( positions.empty() )
+		return false;
+
+	point_cloud.build( &positions[0], colors.empty() ? NULL : &colors[0],
+					   int( positions.size()/4 ) );
+	return true;
+}
+
+// Print the tick statistics of the simulation thread for -bench
+void
+report_simulation( FILE* out, const SimulationStats& sim )
 {
-	return vec4( v.x*sin(v.y*DegreesToRadians)*cos(v.z*DegreesToRadians),
-				 v.x*cos(v.y*DegreesToRadians),
-				 v.x*sin(v.y*DegreesToRadians)*sin(v.z*DegreesToRadians),
-				 v.w );
+	double ticks = sim.ticks > 1 ? sim.ticks - 1 : 1;
+	double mean = sim.interval_sum / ticks;
+	double variance = sim.interval_sq_sum / ticks - mean*mean;
+
+	fprintf( out, "sim ticks:           %lu at %.0f Hz\n", sim.ticks, sim_hz );
+	fprintf( out, "sim interval (ms):   avg %.3f  stddev %.3f\n",
+			 mean, variance > 0.0 ? sqrt( variance ) : 0.0 );
+	fprintf( out, "sim step (ms):       avg %.3f  max %.3f\n",
+			 sim.ticks ? sim.step_sum / sim.ticks : 0.0, sim.step_max );
 }
 
 //----------------------------------------------------------------------------
 
-vec4
-get_normal( const vec4& a, const vec4& b, const vec4& c )
+// Levels of detail for the visible objects, into frame_arena
+ObjectLod*
+choose_lods( const FrameSnapshot& snap, const int* visible, int n )
 {
-	return 
-//	return normalize( cross( b-a, c-a ) );
+	ObjectLod* lods = frame_arena.allocate<ObjectLod>( n );
+	double start = FrameStatsNow();
+	GLfloat pixels = render_height / (2.0*tan( fovy*DegreesToRadians/2.0 ));
+
+	// Each doubling of the edge is a level coarser
+	GLfloat edge_pixels = lod_edge_pixels;
+	if( use_quality )
+		edge_pixels *= exp2f( quality.knobs().lod_bias );
+	int triangles = ChooseSurfaceLods( surface, snap.center.data(), snap.scale.data(),
+									   visible, n, snap.model_view, pixels,
+									   edge_pixels, lod_budget, lods );
+	lod_ms += FrameStatsNow() - start;
+
+	for( int v=0; v<n; v++ )
+		lod_level_sum += lods[v].level + lods[v].morph;
+	lod_objects += n;
+	lod_triangles += triangles;
+	lod_full_triangles += double( n )*(VerticesUsed/3);
+	lod_frames++;
+	return lods;
 }
 
-
-//----------------------------------------------------------------------------
-vec4 colors[24] = { vec4(1.0, 0.0, 0.0, 1.0), vec4(0.0, 1.0, 0.0, 1.0), vec4(0.0, 0.0, 1.0, 1.0), vec4(1.0, 1.0, 0.0, 1.0),
-					vec4(1.0, 0.0, 1.0, 1.0), vec4(0.0, 1.0, 1.0, 1.0), vec4(0.1, 0.2, 0.3, 1.0), vec4(0.2, 0.1, 0.3, 1.0),
-					vec4(0.1, 0.3, 0.2, 1.0), vec4(0.2, 0.3, 0.1, 0.0), vec4(0.3, 0.2, 0.1, 1.0), vec4(0.3, 0.1, 0.2, 1.0),
-					vec4(0.7, 0.2, 1.0, 1.0), vec4(0.7, 1.0, 0.2, 1.0), vec4(0.2, 0.7, 1.0, 1.0), vec4(0.2, 1.0, 0.7, 1.0),
-					vec4(1.0, 0.2, 0.7, 1.0), vec4(1.0, 0.7, 0.2, 1.0), vec4(0.5, 0.3, 0.0, 1.0), vec4(0.5, 0.0, 0.3, 1.0),
-					vec4(0.0, 0.3, 0.5, 1.0), vec4(0.0, 0.5, 0.3, 1.0), vec4(0.3, 0.0, 0.5, 1.0), vec4(0.3, 0.5, 0.0, 1.0)
-				  };
-
+// Point the bound program's vMorph at the morph targets, if the mesh has
+// them, from "offset" in the bound buffer
 void
-triangle( const vec4& a, const vec4& b, const vec4& c, int color )
+bind_morphs( const ProgramUniforms& u, GLintptr offset )
 {
-	vec4 n = get_normal( a, b, c );
-    points[Index] = a;  normals[Index] = colors[color]; normals[Index].w = 0.3;  Index++;
-    points[Index] = b;  normals[Index] = colors[color]; normals[Index].w = 0.3;  Index++;
-    points[Index] = c;  normals[Index] = colors[color]; normals[Index].w = 0.3;  Index++;
-	VerticesUsed += 3;
+	GLint vMorph = u.vMorph;
+	if( vMorph < 0 )
+		return;
+	if( offset )
+	{
+		glEnableVertexAttribArray( vMorph );
+		glVertexAttribPointer( vMorph, 4, GL_FLOAT, GL_FALSE, 0,
+							   BUFFER_OFFSET(offset) );
+	}
+	else
+		glDisableVertexAttribArray( vMorph );
 }
 
-/*****************************************************
-Make a cube by creating 6 square faces from triangles
-
-  h_______g
- /|      /|		
-d-------c |
-| e-----|-f
-|/      |/
-a-------b
-
-******************************************************/
-int face_num = 0;
-
-void
-face( const vec4& a, const vec4& b, const vec4& c, const vec4& d )
+// The queries of last frame's proxies, one per visible object (0 for
+// none), into frame_arena.  Also switches sets and tallies the results of
+// the set about to be reused, which decided what last frame drew.
+GLuint*
+occlusion_conditions( const FrameSnapshot& snap, const int* visible, int n )
 {
-	triangle(a,b,d, face_num);
-	triangle(d,b,c, face_num);
-	face_num++;
+	int last = occlusion_set;
+	occlusion_set ^= 1;
+	std::vector<GLuint>& queries = occlusion_queries[occlusion_set];
+	std::vector<char>& issued = occlusion_issued[occlusion_set];
 
-	face_vertices[face_index] = a; face_index++;
-	face_vertices[face_index] = b; face_index++;
+	for( size_t i=0; i<queries.size(); i++ )
+	{
+		if( !issued[i] )
+			continue;
+		GLuint available = 0, passed = 1;
+		glGetQueryObjectuiv( queries[i], GL_QUERY_RESULT_AVAILABLE, &available );
+		if( available )
+		{
+			glGetQueryObjectuiv( queries[i], GL_QUERY_RESULT, &passed );
+			occlusion_answered++;
+			occlusion_hidden += passed ? 0 : 1;
+		}
+		issued[i] = 0;
+	}
 
-	face_vertices[face_index] = b; face_index++;
-	face_vertices[face_index] = c; face_index++;
+	int objects = snap.objects;
+	for( int s=0; s<2; s++ )
+		if( (int) occlusion_queries[s].size() < objects )
+		{
+			int have = occlusion_queries[s].size();
+			occlusion_queries[s].resize( objects );
+			occlusion_issued[s].resize( objects, 0 );
+			glGenQueries( objects - have, &occlusion_queries[s][have] );
+		}
 
-	face_vertices[face_index] = c; face_index++;
-	face_vertices[face_index] = d; face_index++;
-	
-	face_vertices[face_index] = d; face_index++;
-	face_vertices[face_index] = a; face_index++;
-	FaceVerticesUsed += 8;
+	GLuint* conditions = frame_arena.allocate<GLuint>( n );
+	for( int v=0; v<n; v++ )
+	{
+		int i = visible[v];
+		conditions[v] = occlusion_issued[last][i] ? occlusion_queries[last][i] : 0;
+	}
+	return conditions;
 }
 
+// Draw the proxies of the visible objects in queries of the current set,
+// leaving out objects whose box reaches in front of the near plane: their
+// box could be clipped where the object shows
 void
-tesseract( const vec4& center, GLfloat face_dist )
+query_occlusion( const FrameSnapshot& snap, const int* visible, int n,
+				 const mat4& p )
 {
-	face_index = 0;
-
-	vec4 a = center + vec4(-1.0*face_dist,-1.0*face_dist,-1.0*face_dist,1.0*face_dist);
-	vec4 b = center + vec4(1.0*face_dist,-1.0*face_dist,-1.0*face_dist,1.0*face_dist);
-	vec4 c = center + vec4(1.0*face_dist,1.0*face_dist,-1.0*face_dist,1.0*face_dist);
-	vec4 d = center + vec4(-1.0*face_dist,1.0*face_dist,-1.0*face_dist,1.0*face_dist);
-	vec4 e = center + vec4(-1.0*face_dist,1.0*face_dist,1.0*face_dist,1.0*face_dist);
-	vec4 f = center + vec4(1.0*face_dist,1.0*face_dist,1.0*face_dist,1.0*face_dist);
-	vec4 g = center + vec4(1.0*face_dist,-1.0*face_dist,1.0*face_dist,1.0*face_dist);
-	vec4 h = center + vec4(-1.0*face_dist,-1.0*face_dist,1.0*face_dist,1.0*face_dist);
-	vec4 i = center + vec4(-1.0*face_dist,-1.0*face_dist,1.0*face_dist,-1.0*face_dist);
-	vec4 j = center + vec4(1.0*face_dist,-1.0*face_dist,1.0*face_dist,-1.0*face_dist);
-	vec4 k = center + vec4(1.0*face_dist,1.0*face_dist,1.0*face_dist,-1.0*face_dist);
-	vec4 l = center + vec4(-1.0*face_dist,1.0*face_dist,1.0*face_dist,-1.0*face_dist);
-	vec4 m = center + vec4(-1.0*face_dist,1.0*face_dist,-1.0*face_dist,-1.0*face_dist);
-	vec4 n = center + vec4(1.0*face_dist,1.0*face_dist,-1.0*face_dist,-1.0*face_dist);
-	vec4 o = center + vec4(1.0*face_dist,-1.0*face_dist,-1.0*face_dist,-1.0*face_dist);
-	vec4 p = center + vec4(-1.0*face_dist,-1.0*face_dist,-1.0*face_dist,-1.0*face_dist);
-
+	const mat4& mv = snap.model_view;
+	std::vector<GLuint>& queries = occlusion_queries[occlusion_set];
+	std::vector<char>& issued = occlusion_issued[occlusion_set];
+	double start = FrameStatsNow();
+
+	glUseProgram( occlusion_program );
+	glUniformMatrix4fv( occlusion_uniforms.model_view, 1, GL_TRUE, mv );
+	glUniformMatrix4fv( occlusion_uniforms.projection, 1, GL_TRUE, p );
+	glBindBuffer( GL_ARRAY_BUFFER, proxy_buffer );
+	GLuint vPosition = occlusion_uniforms.vPosition;
+	glEnableVertexAttribArray( vPosition );
+	glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0) );
+	glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+	glDepthMask( GL_FALSE );
+
+	// Nearest depth of a box about b, half size h, is the depth of b
+	// less h times the sum of the view axis's components
+	GLfloat reach = fabs( mv[2][0] ) + fabs( mv[2][1] ) + fabs( mv[2][2] );
+	int queried = 0;
+	for( int v=0; v<n; v++ )
+	{
+		int i = visible[v];
+		GLfloat box[4];
+		ProjectedSphere( &snap.center[4*i], mesh_radius*snap.scale[i], box );
+		GLfloat depth = -(mv[2][0]*box[0] + mv[2][1]*box[1] + mv[2][2]*box[2]
+						  + mv[2][3]);
+		if( depth - reach*box[3] <= zNear )
+			continue;
+
+		glUniform4f( occlusion_box, box[0], box[1], box[2], box[3] );
+		glBeginQuery( occlusion_target, queries[i] );
+		glDrawArrays( GL_TRIANGLES, 0, ProxyVertices );
+		glEndQuery( occlusion_target );
+		issued[i] = 1;
+		queried++;
+	}
 
-	face(a,b,c,d);
-	face(d,c,f,e);
-	face(a,d,e,h);
-	face(h,e,f,g);
-	face(g,f,c,b);
-	face(b,a,h,g);
+	glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+	glDepthMask( GL_TRUE );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
 
-	face(a,p,o,b);
-	face(b,o,j,g);
-	face(g,j,i,h);
-	face(h,i,p,a);
+	occlusion_ms += FrameStatsNow() - start;
+	occlusion_queried += queried;
+	occlusion_frames++;
+}
 
-	face(c,n,m,d);
-	face(d,m,l,e);
-	face(e,l,k,f);
-	face(f,k,n,c);
+// The objects that may show through p * mv, into frame_arena; all of them
+// with -nocull
+int
+cull_objects( const FrameSnapshot& snap, const mat4& p, int*& visible )
+{
+	visible = frame_arena.allocate<int>( snap.objects );
+	if( !use_culling )
+	{
+		for( int i=0; i<snap.objects; i++ )
+			visible[i] = i;
+		return snap.objects;
+	}
 
-	face(d,m,p,a);
-	face(e,l,i,h);
-	face(f,k,j,g);
-	face(c,n,o,b);
+	double start = FrameStatsNow();
+	culler.update( snap.center.data(), snap.scale.data(), snap.objects, mesh_radius );
+	int n = culler.cull( p*snap.model_view, visible );
 
-	face(o,p,m,n);
-	face(n,m,l,k);
-	face(k,l,i,j);
-	face(j,i,p,o);
-	face(m,p,i,l);
-	face(o,j,k,n);
-	
+	cull_ms += FrameStatsNow() - start;
+	cull_visible += n;
+	cull_nodes += culler.stats().nodes_visited;
+	cull_frames++;
+	return n;
+}
 
-	glBindBuffer( GL_ARRAY_BUFFER, wireframe );
-    glBufferSubData( GL_ARRAY_BUFFER, 0, sizeof(face_vertices), face_vertices );
-	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+// Cut "visible" down to the quality controller's cap, keeping the objects
+// nearest the eye; returns how many are left
+int
+cap_objects( const FrameSnapshot& snap, int* visible, int n )
+{
+	int cap = use_quality ? quality.knobs().object_cap : 0;
+	if( cap <= 0 || n <= cap )
+		return n;
 
-	glBindBuffer( GL_ARRAY_BUFFER, solid );
-    glBufferSubData( GL_ARRAY_BUFFER, 0, sizeof(points), points );
-	glBufferSubData( GL_ARRAY_BUFFER, sizeof(points), sizeof(normals), normals );
-	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	const mat4& mv = snap.model_view;
+	GLfloat* depth = frame_arena.allocate<GLfloat>( snap.objects );
+	for( int v=0; v<n; v++ )
+	{
+		int i = visible[v];
+		GLfloat c[4];
+		ProjectedSphere( &snap.center[4*i], 0.0, c );
+		depth[i] = -(mv[2][0]*c[0] + mv[2][1]*c[1] + mv[2][2]*c[2] + mv[2][3]);
+	}
+	std::nth_element( visible, visible + cap, visible + n,
+					  [depth]( int a, int b ) { return depth[a] < depth[b]; } );
+	return cap;
 }
 
-//----------------------------------------------------------------------------
-
+// The frames of each -scale-sweep step; the last one's full report follows
 void
-cube( const vec4& center, GLfloat face_dist )
+report_sweep( FILE* out )
 {
-	vec4 a = center + vec4(-1.0*face_dist,-1.0*face_dist,-1.0*face_dist, 0.0);
-	vec4 b = center + vec4(1.0*face_dist,-1.0*face_dist,-1.0*face_dist, 0.0);
-	vec4 c = center + vec4(1.0*face_dist,1.0*face_dist,-1.0*face_dist, 0.0);
-	vec4 d = center + vec4(-1.0*face_dist,1.0*face_dist,-1.0*face_dist, 0.0);
-	vec4 e = center + vec4(-1.0*face_dist,-1.0*face_dist,1.0*face_dist, 0.0);
-	vec4 f = center + vec4(1.0*face_dist,-1.0*face_dist,1.0*face_dist, 0.0);
-	vec4 g = center + vec4(1.0*face_dist,1.0*face_dist,1.0*face_dist, 0.0);
-	vec4 h = center + vec4(-1.0*face_dist,1.0*face_dist,1.0*face_dist, 0.0);
-
-	face(a,b,c,d);
-	face(d,c,g,h);
-	face(g,c,b,f);
-	face(b,f,e,a);
-	face(e,a,d,h);
-	face(e,f,g,h);
+	fprintf( out, "%-7s %11s %10s %10s %10s %12s\n", "scale", "pixels",
+			 "frame ms", "cpu ms", "gpu ms", "Mpixels/s" );
+	for( int k=0; k<SweepSteps; k++ )
+	{
+		const FrameStats& t = sweep_totals[k];
+		double frames = t.frames ? t.frames : 1;
+		int w = std::max( int( window_width*SweepScales[k] + 0.5 ), 1 );
+		int h = std::max( int( window_height*SweepScales[k] + 0.5 ), 1 );
+		char size[32], gpu[16] = "-";
+		snprintf( size, sizeof(size), "%dx%d", w, h );
+		if( t.gpu_frames )
+			snprintf( gpu, sizeof(gpu), "%.3f", t.gpu_ms / t.gpu_frames );
+		fprintf( out, "%-7.3f %11s %10.3f %10.3f %10s %12.1f\n", SweepScales[k],
+				 size, t.total_ms / frames, t.cpu_ms / frames, gpu,
+				 t.total_ms > 0.0 ? double( w )*h*t.frames / t.total_ms / 1000.0 : 0.0 );
+	}
 }
 
-//----------------------------------------------------------------------------
+// Whether the objects are the built-in tesseract, whose triangles are
+// TesseractMesh's
+bool
+builtin_tesseract()
+{
+	return shape_family < 0 && !use_wythoff && surface_family < 0 && !use_mesh_file;
+}
 
-// OpenGL initialization
+// Cast the ray through pixel (x, y) of the scene target into the
+// snapshot's objects, and print what it hits first
 void
-init()
+cast_pick( const FrameSnapshot& snap, int x, int y )
 {
-    // Load shaders and use the resulting shader program
-    solid_program = InitShader( "vshader_solid.glsl", "fshader.glsl" );
-    wireframe_program = InitShader( "vshader_wireframe.glsl", "fshader.glsl" );
-	floor_program = InitShader( "vshader_floor.glsl", "fshader.glsl" );
-    //glUseProgram( wireframe_program );
-
-    // Create a vertex array object
-	GLuint vao;
-    glGenVertexArrays( 1, &vao );
-    glBindVertexArray( vao );
+	pick_caster.update( &snap.center[0], &snap.scale[0], &snap.sines[0],
+						&snap.cosines[0], snap.objects, jobs );
+
+	// Out of eye space: ModelView is a LookAt, a rotation then a move, so
+	// the inverse is the move back then the transpose
+	const mat4& mv = snap.model_view;
+	GLfloat h = tan( fovy * DegreesToRadians / 2.0 );
+	vec3 eye( (2.0*(x + 0.5)/render_width - 1.0)*h*aspect,
+			  (2.0*(y + 0.5)/render_height - 1.0)*h, -1.0 );
+	vec3 origin, direction;
+	for( int k=0; k<3; k++ )
+	{
+		origin[k] = -(mv[0][k]*mv[0][3] + mv[1][k]*mv[1][3] + mv[2][k]*mv[2][3]);
+		direction[k] = mv[0][k]*eye.x + mv[1][k]*eye.y + mv[2][k]*eye.z;
+	}
 
-    // Create and initialize buffer objects for tesseract, wireframe, and floor
-    glGenBuffers( 1, &wireframe );
-	glBindBuffer( GL_ARRAY_BUFFER, wireframe );
-	glBufferData( GL_ARRAY_BUFFER, sizeof(face_vertices),
-		NULL, GL_STATIC_DRAW );
-	glBindBuffer( GL_ARRAY_BUFFER, 0 );
-	
-    glGenBuffers( 1, &solid );
-	glBindBuffer( GL_ARRAY_BUFFER, solid );
-	glBufferData( GL_ARRAY_BUFFER, sizeof(points) + sizeof(normals),
-		NULL, GL_STATIC_DRAW );
-	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	RayHit hit;
+	pick_caster.cast_scalar( &origin, &direction, 1, &hit );
+	if( hit.object < 0 )
+		printf( "ray: nothing\n" );
+	else
+		printf( "ray: object %d, triangle %d, at %.3f\n", hit.object, hit.triangle,
+				hit.t*length( direction ) );
+}
 
-	glGenBuffers( 1, &floor_buffer );
-	glBindBuffer( GL_ARRAY_BUFFER, floor_buffer );	
-	glBufferData( GL_ARRAY_BUFFER, sizeof(base_square) + sizeof(base_square_colors),
-		NULL, GL_STATIC_DRAW );
-    glBufferSubData( GL_ARRAY_BUFFER, 0, sizeof(base_square), base_square );
-    glBufferSubData( GL_ARRAY_BUFFER, sizeof(base_square), sizeof(base_square_colors), base_square_colors );
-	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+// Copy the pixel under a waiting click out of pick_ids into a free pixel
+// buffer, and fence it; with every buffer still in flight the click is
+// dropped rather than waited for
+void
+issue_pick( const FrameSnapshot& snap )
+{
+	if( pick_x < 0 )
+		return;
+	double start = FrameStatsNow();
+	int x = pick_x*render_width / window_width;
+	int y = (window_height - 1 - pick_y)*render_height / window_height;
+	pick_x = pick_y = -1;
+	if( bench_frames <= 0 && builtin_tesseract() )
+		cast_pick( snap, x, y );
+
+	PickSlot* slot = NULL;
+	for( int k=0; k<PickSlots && !slot; k++ )
+		if( !pick_slots[k].fence )
+			slot = &pick_slots[k];
+	if( !slot )
+	{
+		picks_dropped++;
+		return;
+	}
 
+	glBindFramebuffer( GL_READ_FRAMEBUFFER, scene_framebuffer );
+	glReadBuffer( GL_COLOR_ATTACHMENT1 );
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, slot->buffer );
+	glReadPixels( x, y, 1, 1, GL_RG_INTEGER, GL_UNSIGNED_INT, BUFFER_OFFSET(0) );
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	glReadBuffer( GL_COLOR_ATTACHMENT0 );
+	slot->fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	slot->frame = pick_frame;
+	slot->issued_ms = start;
+	picks_issued++;
+	pick_ms += FrameStatsNow() - start;
+}
 
-	//cube( vec3(0.0, 0.0, 0.0), 0.5 );
-	tesseract( vec4(0.0,0.0,0.0,0.0), 0.3 );
+// Print a pick: the object and triangle, and for the built-in tesseract
+// the square that triangle is half of and the two cubic cells it joins,
+// named by the axis they are flat in (the ones the square's corners agree
+// on) and its sign
+void
+report_pick( FILE* out, const GLuint id[2], unsigned long frames, double ms )
+{
+	if( id[0] == 0 )
+	{
+		fprintf( out, "pick: nothing, after %lu frames (%.2f ms)\n", frames, ms );
+		return;
+	}
+	fprintf( out, "pick: object %u, triangle %u", id[0] - 1, id[1] );
+	if( builtin_tesseract() && id[1] < 2*TesseractMesh.FaceCount )
+	{
+		int face = id[1] / 2;
+		const GLushort* c = TesseractQuads.faces[face];
+		fprintf( out, " (square %d, between cells", face );
+		for( int k=0; k<4; k++ )
+		{
+			GLfloat sign = TesseractQuads.vertices[c[0]][k];
+			if( TesseractQuads.vertices[c[1]][k] == sign
+				&& TesseractQuads.vertices[c[2]][k] == sign
+				&& TesseractQuads.vertices[c[3]][k] == sign )
+				fprintf( out, " %c%c", sign > 0.0 ? '+' : '-', "xyzw"[k] );
+		}
+		fprintf( out, ")" );
+	}
+	fprintf( out, ", after %lu frames (%.2f ms)\n", frames, ms );
+}
 
-    glEnable( GL_DEPTH_TEST );
-    glClearColor( 0.0, 0.0, 0.0, 1.0 ); 
+// Read back the picks whose fences have signaled, without waiting on any
+// that haven't
+void
+poll_picks()
+{
+	double start = FrameStatsNow();
+	for( int k=0; k<PickSlots; k++ )
+	{
+		PickSlot& slot = pick_slots[k];
+		if( !slot.fence )
+			continue;
+		pick_polls++;
+		GLenum state = glClientWaitSync( slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+		if( state == GL_TIMEOUT_EXPIRED )
+			continue;
+		glDeleteSync( slot.fence );
+		slot.fence = NULL;
+		if( state == GL_WAIT_FAILED )
+			continue;
+
+		GLuint id[2] = { 0, 0 };
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.buffer );
+		void* mapped = glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, sizeof(id),
+										 GL_MAP_READ_BIT );
+		if( mapped )
+		{
+			memcpy( id, mapped, sizeof(id) );
+			glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+		}
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+		unsigned long frames = pick_frame - slot.frame;
+		double ms = FrameStatsNow() - slot.issued_ms;
+		picks_landed++;
+		pick_latency_frames += frames;
+		pick_latency_max = std::max( pick_latency_max, frames );
+		pick_latency_ms += ms;
+		if( bench_frames <= 0 )
+			report_pick( stdout, id, frames, ms );
+	}
+	pick_ms += FrameStatsNow() - start;
 }
 
 //----------------------------------------------------------------------------
@@ -295,44 +2459,51 @@ init()
 void
 display( void )
 {
+	FrameStatsBeginFrame();
+	frame_arena.reset();
+	if( use_picking )
+	{
+		pick_frame++;
+		poll_picks();
+		if( bench_frames > 0 )
+		{
+			pick_x = window_width / 2;
+			pick_y = window_height / 2;
+		}
+	}
+
+	// Switch to the newest state from the simulation thread, if any
+	snapshots.update();
+	const FrameSnapshot& snap = snapshots.read_buffer();
+
+	// Into the part of the scene target this frame's resolution covers
+	if( use_scene_target )
+	{
+		glBindFramebuffer( GL_FRAMEBUFFER, scene_framebuffer );
+		glViewport( 0, 0, render_width, render_height );
+	}
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
 	GLuint vPosition, vColor, vNormal;
 
-	// Bring camera into Cartesian coordinates
-	vec4 cart_eye = Translate( eye_offset ) * sph_to_cart( sph_eye );
-	vec4 cart_at = Translate( eye_offset ) * sph_to_cart( sph_at );
-	vec4 cart_up = sph_to_cart( sph_up );
-    
-
-	mat4 mv = LookAt( cart_eye, cart_at, cart_up );
+	const mat4& mv = snap.model_view;
 	mat4 p = Perspective( fovy, aspect, zNear, zFar );
 
-	// Calculate sines and cosines of rotation angles
-	GLfloat sine_values[6];
-	GLfloat cosine_values[6];
-
-	for( int i=0; i<6; i++ )
-	{
-		sine_values[i] = sin(Angles[i]*DegreesToRadians);
-		cosine_values[i] = cos(Angles[i]*DegreesToRadians);
-	}
-
 
 	// Set up uniforms for the floor
 	glUseProgram( floor_program );
-	glUniformMatrix4fv( model_view, 1, GL_TRUE, mv );
-	glUniformMatrix4fv( projection, 1, GL_TRUE, p );
+	glUniformMatrix4fv( floor_uniforms.model_view, 1, GL_TRUE, mv );
+	glUniformMatrix4fv( floor_uniforms.projection, 1, GL_TRUE, p );
 
 	// Bind floor_buffer and display floor
 	glBindBuffer( GL_ARRAY_BUFFER, floor_buffer );
 
-	vPosition = glGetAttribLocation( floor_program, "vPosition" );
+	vPosition = floor_uniforms.vPosition;
     glEnableVertexAttribArray( vPosition );
     glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
 			   BUFFER_OFFSET(0) );
 
-    vColor = glGetAttribLocation( floor_program, "vColor" ); 
+    vColor = floor_uniforms.vColor;
     glEnableVertexAttribArray( vColor );
     glVertexAttribPointer( vColor, 4, GL_FLOAT, GL_FALSE, 0,
 			   BUFFER_OFFSET(sizeof(base_square)) );
@@ -340,61 +2511,295 @@ display( void )
 	glDrawArrays( GL_TRIANGLE_STRIP, 0, sizeof(base_square)/sizeof(base_square[0]) );
 	glBindBuffer( GL_ARRAY_BUFFER, 0 );
 
-	
-	// Set up uniforms for the wireframe
-	glUseProgram( wireframe_program );
-    model_view = glGetUniformLocation( wireframe_program, "ModelView" );
-    projection = glGetUniformLocation( wireframe_program, "Projection" );
-    sines = glGetUniformLocation( wireframe_program, "sines" );
-    cosines = glGetUniformLocation( wireframe_program, "cosines" );
 
-	glUniformMatrix4fv( model_view, 1, GL_TRUE, mv );
-	glUniformMatrix4fv( projection, 1, GL_TRUE, p );
-	glUniform1fv( sines, 6, sine_values );
-	glUniform1fv( cosines, 6, cosine_values );
+	// Shapes of more than 4 dimensions have been projected on the CPU
+	if( use_volume )
+		draw_volume( snap, p );
+	else if( use_points )
+		draw_points( snap, p );
+	else if( use_projector )
+		draw_projected( snap );
+	else if( use_gpu_culling )
+		draw_indirect( snap, p );
+	else if( use_instancing )
+	{
+		int* visible;
+		int n = cull_objects( snap, p, visible );
+		n = cap_objects( snap, visible, n );
+		if( use_impostors )
+			n = draw_impostors( snap, visible, n, p );
+		draw_instanced( snap, visible, n, p );
+	}
+	else
+	{
+		int* visible;
+		int n = cull_objects( snap, p, visible );
+		n = cap_objects( snap, visible, n );
+		GLuint* conditions = use_occlusion
+			? occlusion_conditions( snap, visible, n ) : NULL;
+		ObjectLod* lods = surface_family >= 0 ? choose_lods( snap, visible, n ) : NULL;
+
+		if( wireframe_pass() )
+		{
+			// Set up uniforms for the wireframe
+			glUseProgram( wireframe_program );
+			glUniformMatrix4fv( wireframe_uniforms.model_view, 1, GL_TRUE, mv );
+			glUniformMatrix4fv( wireframe_uniforms.projection, 1, GL_TRUE, p );
+
+			// Bind buffer and display wireframe
+			glBindBuffer( GL_ARRAY_BUFFER, wireframe );
+
+			vPosition = wireframe_uniforms.vPosition;
+			glEnableVertexAttribArray( vPosition );
+			glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
+								   BUFFER_OFFSET(0) );
+			bind_morphs( wireframe_uniforms, wireframe_morph_offset );
+
+			glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, wireframe_indices );
+			draw_objects( snap, visible, n, conditions, lods, wireframe_uniforms,
+						  GL_LINES, FaceVerticesUsed );
+			glBindBuffer( GL_ARRAY_BUFFER, 0 );
+		}
 
-	// Bind buffer and display wireframe
-	glBindBuffer( GL_ARRAY_BUFFER, wireframe );
 
-	vPosition = glGetAttribLocation( wireframe_program, "vPosition" );
-    glEnableVertexAttribArray( vPosition );
-    glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
-			   BUFFER_OFFSET(0) );
+		// Set up uniforms for the solid object
+		bool packed = solid_layout != SOLID_VEC4;
+		GLuint program = packed ? solid_packed_program : solid_program;
+		const ProgramUniforms& u = packed ? solid_packed_uniforms : solid_uniforms;
+		glUseProgram( program );
+		glUniformMatrix4fv( u.model_view, 1, GL_TRUE, mv );
+		glUniformMatrix4fv( u.projection, 1, GL_TRUE, p );
 
-    glDrawArrays( GL_LINES, 0, FaceVerticesUsed );
-	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+		// Bind buffer and display solid
+		glBindBuffer( GL_ARRAY_BUFFER, solid );
 
+		vPosition = u.vPosition;
+	    glEnableVertexAttribArray( vPosition );
+		if( packed )
+		{
+			// Position and palette index interleaved
+			GLsizei stride = SolidVertexSize( solid_layout );
+			bool half = solid_layout == SOLID_HALF;
+			glVertexAttribPointer( vPosition, 4, half ? GL_HALF_FLOAT : GL_FLOAT,
+								   GL_FALSE, stride, BUFFER_OFFSET(0) );
+			vColor = u.vColor;
+			glEnableVertexAttribArray( vColor );
+			glVertexAttribPointer( vColor, 1, GL_UNSIGNED_BYTE, GL_FALSE, stride,
+				BUFFER_OFFSET(half ? offsetof(HalfVertex, color)
+							  : offsetof(PackedVertex, color)) );
+		}
+		else
+		{
+		    glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
+					   BUFFER_OFFSET(0) );
+		    vNormal = u.vNormal;
+		    glEnableVertexAttribArray( vNormal );
+		    glVertexAttribPointer( vNormal, 4, GL_FLOAT, GL_FALSE, 0,
+					   BUFFER_OFFSET(solid_shade_offset) );
+			bind_morphs( u, solid_morph_offset );
+		}
 
-	// Set up uniforms for the solid object
-	glUseProgram( solid_program );
-    model_view = glGetUniformLocation( solid_program, "ModelView" );
-    projection = glGetUniformLocation( solid_program, "Projection" );
-    sines = glGetUniformLocation( solid_program, "sines" );
-    cosines = glGetUniformLocation( solid_program, "cosines" );
+		// The IDs come from the solid pass alone
+		if( use_picking )
+		{
+			static const GLuint none[4] = { 0, 0, 0, 0 };
+			glDrawBuffers( 2, PickDrawBuffers );
+			glClearBufferuiv( GL_COLOR, 1, none );
+		}
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, solid_indices );
+		draw_objects( snap, visible, n, conditions, lods, u, GL_TRIANGLES, VerticesUsed );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+		if( use_picking )
+		{
+			glDrawBuffers( 1, PickDrawBuffers );
+			issue_pick( snap );
+		}
 
-	glUniformMatrix4fv( model_view, 1, GL_TRUE, mv );
-	glUniformMatrix4fv( projection, 1, GL_TRUE, p );
-	glUniform1fv( sines, 6, sine_values );
-	glUniform1fv( cosines, 6, cosine_values );
+		if( use_occlusion )
+			query_occlusion( snap, visible, n, p );
+	}
 
-	// Bind buffer and display solid
-	glBindBuffer( GL_ARRAY_BUFFER, solid );
+	if( use_scene_target )
+		upscale_scene();
 
-	vPosition = glGetAttribLocation( solid_program, "vPosition" );
-    glEnableVertexAttribArray( vPosition );
-    glVertexAttribPointer( vPosition, 4, GL_FLOAT, GL_FALSE, 0,
-			   BUFFER_OFFSET(0) );
-    vNormal = glGetAttribLocation( solid_program, "vNormal" ); 
-    glEnableVertexAttribArray( vNormal );
-    glVertexAttribPointer( vNormal, 4, GL_FLOAT, GL_FALSE, 0,
-			   BUFFER_OFFSET(sizeof(points)) );
+	FrameStatsEndFrame();
+    glutSwapBuffers();
 
-    glDrawArrays( GL_TRIANGLES, 0, VerticesUsed );
-	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	FrameStatsUpdateOverlay( window_title );
 
+	if( use_quality )
+	{
+		double frame_ms, cpu_ms, gpu_ms;
+		FrameStatsLastFrame( frame_ms, cpu_ms, gpu_ms );
+		if( quality.update( frame_ms, cpu_ms, gpu_ms ) )
+			set_render_scale( quality.knobs().resolution_scale );
+	}
 
-	
-    glutSwapBuffers();
+	if( bench_frames > 0 )
+	{
+		bench_frame++;
+		if( bench_frame == bench_warmup )
+		{
+			FrameStatsReset();
+			point_frames = 0;
+			points_drawn = point_chunks_drawn = 0.0;
+			cull_frames = 0;
+			cull_ms = cull_visible = cull_nodes = 0.0;
+			occlusion_frames = 0;
+			lod_frames = 0;
+			lod_ms = lod_objects = lod_level_sum = lod_triangles = 0.0;
+			lod_full_triangles = 0.0;
+			occlusion_ms = occlusion_queried = occlusion_answered = 0.0;
+			occlusion_hidden = 0.0;
+			impostor_frames = 0;
+			impostor_ms = impostor_billboards = impostor_geometry = 0.0;
+			impostor_captures = impostor_stale = impostor_evictions = 0.0;
+			picks_issued = picks_landed = picks_dropped = pick_polls = 0;
+			pick_latency_frames = pick_latency_max = 0;
+			pick_latency_ms = pick_ms = 0.0;
+			simulation.reset_stats();
+		}
+		if( scale_sweep && bench_frame == bench_warmup + bench_frames )
+		{
+			sweep_totals[sweep_step++] = FrameStatsTotals();
+			if( sweep_step < SweepSteps )
+			{
+				// Again at the next scale, after another warm-up
+				set_render_scale( SweepScales[sweep_step] );
+				bench_frame = 0;
+			}
+			else
+				report_sweep( stdout );
+		}
+		if( bench_frame == bench_warmup + bench_frames )
+		{
+			printf( "startup gl calls:    %u (%u glGetUniformLocation)\n",
+					startup_gl.total_calls,
+					startup_gl.calls[TRACE_glGetUniformLocation] );
+			FrameStatsReport( stdout );
+			report_simulation( stdout, snap.sim );
+			if( use_volume )
+			{
+				VolumeStreamStats vs = volume_stream.stats();
+				printf( "volume stream:       %lu frames read, %lu misses, %.1f MB/s, %lu stalls\n",
+						vs.frames_read, vs.misses,
+						vs.read_ms > 0.0 ? vs.bytes_read / vs.read_ms / 1000.0 : 0.0,
+						volume_stalls );
+			}
+			if( use_instancing )
+			{
+				// Vertices pulled from the tables fetch nothing
+				int size = use_pulling ? 0 : sizeof(vec4);
+				int per_object = use_pulling ? 0 : 2*VerticesUsed*size
+					+ FaceVerticesUsed*size;
+				printf( "instanced:           %d objects, %s, %.1f MB vertex data"
+						" + %.1f KB instance data/frame\n", snap.objects,
+						use_pulling ? "pulled" : "from buffers",
+						double( snap.objects )*per_object / 1048576.0,
+						snap.objects*InstanceFloats*sizeof(GLfloat) / 1024.0 );
+			}
+			else if( !use_volume && !use_points && !use_projector )
+			{
+				// Vertex fetch of the solid mesh, leaving out caching
+				int size = SolidVertexSize( solid_layout );
+				printf( "solid vertices:      %d bytes each, %d vertices, %.1f KB,"
+						" %.1f MB fetched/frame\n", size, VerticesUsed,
+						VerticesUsed*size / 1024.0,
+						double( snap.objects )*VerticesUsed*size / 1048576.0 );
+			}
+			if( use_gpu_culling )
+			{
+				// The count of the last frame only: reading it every frame
+				// would wait for the GPU
+				GLuint visible = 0;
+				glBindBuffer( GL_SHADER_STORAGE_BUFFER, cull_counter );
+				glGetBufferSubData( GL_SHADER_STORAGE_BUFFER, 0, sizeof(visible), &visible );
+				glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+				printf( "gpu culling:         %u of %d objects visible, 1 dispatch"
+						" + 2 indirect draws of %d commands/frame\n", visible,
+						snap.objects, snap.objects );
+			}
+			if( cull_frames > 0 )
+			{
+				double frames = cull_frames;
+				printf( "culling:             %.1f of %d objects visible, %.1f culled,"
+						" %.1f of %d nodes, %.3f ms/frame\n", cull_visible / frames,
+						culler.object_count(), culler.object_count() - cull_visible / frames,
+						cull_nodes / frames, culler.node_count(), cull_ms / frames );
+			}
+			if( lod_frames > 0 )
+			{
+				double frames = lod_frames;
+				printf( "levels of detail:    %.2f mean level, %.0f triangles/frame"
+						" of %.0f at full detail", lod_objects > 0.0
+						? lod_level_sum / lod_objects : 0.0, lod_triangles / frames,
+						lod_full_triangles / frames );
+				if( lod_budget > 0 )
+					printf( " (budget %d)", lod_budget );
+				printf( ", picked in %.3f ms/frame\n", lod_ms / frames );
+			}
+			if( occlusion_frames > 0 )
+			{
+				// Each query is 12 triangles of proxy against the objects'
+				// solid triangles it may save
+				double frames = occlusion_frames;
+				printf( "occlusion:           %.1f objects queried, %.1f hidden,"
+						" %.1f answered late/frame\n", occlusion_queried / frames,
+						occlusion_hidden / frames,
+						(occlusion_queried - occlusion_answered) / frames );
+				printf( "occlusion cost:      %.3f ms/frame issuing, %.0f proxy"
+						" triangles for %.0f object triangles skipped/frame\n",
+						occlusion_ms / frames, occlusion_queried*ProxyVertices/3 / frames,
+						occlusion_hidden*(VerticesUsed/3) / frames );
+			}
+			if( impostor_frames > 0 )
+			{
+				double frames = impostor_frames;
+				printf( "impostors:           %.1f billboards, %.1f meshes, %.1f tiles"
+						" drawn, %.1f stale, %.1f evicted/frame, planned in %.3f"
+						" ms/frame\n", impostor_billboards / frames,
+						impostor_geometry / frames, impostor_captures / frames,
+						impostor_stale / frames, impostor_evictions / frames,
+						impostor_ms / frames );
+			}
+			if( use_picking )
+			{
+				double landed = picks_landed ? picks_landed : 1;
+				printf( "picking:             %lu issued, %lu landed, %lu dropped;"
+						" %.2f frames (%.2f ms) to land, at most %lu; %.1f polls"
+						" each, %.3f ms/frame\n", picks_issued, picks_landed,
+						picks_dropped, pick_latency_frames / landed,
+						pick_latency_ms / landed, pick_latency_max,
+						pick_polls / landed, pick_ms / bench_frames );
+			}
+			if( use_scene_target )
+				printf( "resolution:          %dx%d of %dx%d (scale %.3f), %s upscale\n",
+						render_width, render_height, window_width, window_height,
+						render_scale,
+						upscale_filter == UPSCALE_SHARPEN ? "sharpened" : "bilinear" );
+			if( use_quality )
+			{
+				char knobs[128];
+				quality.describe( knobs, sizeof(knobs) );
+				printf( "quality:             %d decisions, now %s\n",
+						quality.decisions(), knobs );
+			}
+			if( use_points )
+			{
+				const FrameStats& t = FrameStatsTotals();
+				double frames = point_frames ? point_frames : 1;
+				printf( "point cloud:         %d points in %d chunks, %d bytes/point"
+						" (%d as vec4 floats)\n", point_cloud.point_count(),
+						point_cloud.chunk_count(), PointCloudBytesPerPoint,
+						PointCloudNaiveBytesPerPoint );
+				printf( "points/frame:        %.0f in %.1f chunks, %.1f M points/s\n",
+						points_drawn / frames, point_chunks_drawn / frames,
+						t.total_ms > 0.0 ? points_drawn / t.total_ms / 1000.0 : 0.0 );
+			}
+			exit( EXIT_SUCCESS );
+		}
+	}
 }
 
 //----------------------------------------------------------------------------
@@ -402,108 +2807,99 @@ display( void )
 void
 keyboard( unsigned char key, int x, int y )
 {
-	vec4 temp;
-
-	switch( key ) {
-
-	case 033: // Escape Key
+	if( key == 033 ) // Escape Key
 	    exit( EXIT_SUCCESS );
-	    break;
-
-	// Move the camera
-	case 'w':
-		//temp = sph_to_cart(sph_at);
-		temp = -1.0*sph_to_cart(sph_up);
-		temp.w = 0.0;
-		eye_offset += step*normalize(temp);
-		break;
-	case 's':
-		//temp = sph_to_cart(sph_at);
-		temp = -1.0*sph_to_cart(sph_up);
-		temp.w = 0.0;
-		eye_offset -= step*normalize(temp);
-		break;
 
-	case 'a':
-		temp = cross(sph_to_cart(sph_at),sph_to_cart(sph_up));
-		temp.w = 0;
-		eye_offset -= step*normalize(temp);
-		break;
-	case 'd':
-		temp = cross(sph_to_cart(sph_at),sph_to_cart(sph_up));
-		temp.w = 0;
-		eye_offset += step*normalize(temp);
-		break;
-
-	// Change camera movement speed
-	case ']':
-		step += 0.05;
-		break;
-	case '[':
-		step -= 0.05;
-		if (step < 0)
-			step = 0;
-		break;
+	// Toggle the rings of a uniform polytope; the mesh lives on this thread
+	if( use_wythoff && key >= '1' && key <= '4' )
+	{
+		int rings = wythoff_symbol.rings ^ (1 << (key - '1'));
+		if( rings != 0 )
+		{
+			wythoff_symbol.rings = rings;
+			build_meshes();
+			if( use_gpu_culling )
+				index_meshes();
+			glutPostRedisplay();
+		}
+		return;
+	}
 
+	InputEvent e = { InputEvent::Key, key, x, y, 0, 0 };
+	input_events.push( e );
+}
 
-	case ' ':  // reset values to their defaults
-		reset_params();
-	    break;
-    }
+//----------------------------------------------------------------------------
 
-    glutPostRedisplay();
+// Redraw whenever the simulation has published something new.  Otherwise
+// nap briefly instead of spinning; the simulation never waits on us.
+void
+idle( void )
+{
+	if( use_picking )
+		poll_picks();
+	if( snapshots.fresh() || bench_frames > 0 )
+		glutPostRedisplay();
+	else
+		std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
 }
 
 //----------------------------------------------------------------------------
 
 void
-idle( void )
+apply_input( const InputEvent& e )
 {
-	for( int i=0; i<6; i++ )
+	switch( e.type ) {
+	case InputEvent::Key:
+		camera.key( e.key );
+		break;
+	case InputEvent::Motion:
+		camera.pointer( e.x, e.y, e.height );
+		break;
+	case InputEvent::Release:
+		camera.release( e.width, e.height );
+		break;
+	}
+}
+
+// One simulation step, run on the simulation thread: apply the queued
+// input as one batch, advance the animation, and publish the result if
+// anything changed
+void
+simulate( double dt )
+{
+	InputEvent e;
+	while( input_events.pop( e ) )
+		apply_input( e );
+
+	bool changed = camera.update() || snapshot_sequence == 0;
+
+	if( animating )
 	{
-		Angles[i] += angle_step_ratios[i]*angle_step;
-		if (Angles[i] >= 360)
+		GLfloat step = GLfloat( dt );
+		jobs->parallel_for( 0, scene.size(), 0, [step]( int first, int last )
+		{
+			scene.update( first, last, step );
+		} );
+		for( size_t p=0; p<plane_angle.size(); p++ )
+			plane_angle[p] = fmod( plane_angle[p] + plane_velocity[p]*step, 360.0f );
+		if( use_volume )
 		{
-			Angles[i] -= 360;
+			volume_time = fmod( volume_time + volume_fps*dt, volume_stream.frames() );
+			volume_stream.seek( int( volume_time ) );
 		}
+		changed = true;
 	}
 
-	glutPostRedisplay();
+	if( changed )
+		publish_snapshot();
 }
 
-//----------------------------------------------------------------------------
-
 void
 move_mouse( int x, int y )
 {
-	int width = glutGet(GLUT_WINDOW_WIDTH);
-	int height = glutGet(GLUT_WINDOW_HEIGHT);
-
-	// Look horizontally
-	sph_at.z += 5.0*((GLfloat)(x-x_prev))/(GLfloat)height;
-	sph_up.z += 5.0*((GLfloat)(x-x_prev))/(GLfloat)height;
-	if (sph_at.z > 360.0)
-		sph_at.z -= 360.0;
-	if (sph_at.z < 0.0)
-		sph_at.z += 360.0;
-	if (sph_up.z > 360.0)
-		sph_up.z -= 360.0;
-	if (sph_up.z < 0.0)
-		sph_up.z += 360.0;
-
-	// Look vertically
-	sph_at.y -= 5.0*((GLfloat)(y-y_prev))/(GLfloat)height;
-	sph_up.y -= 5.0*((GLfloat)(y-y_prev))/(GLfloat)height;
-	if (sph_at.y > 360.0)
-		sph_at.y -= 360.0;
-	if (sph_at.y < 0.0)
-		sph_at.y += 360.0;
-	if (sph_up.y > 360.0)
-		sph_up.y -= 360.0;
-	if (sph_up.y < 0.0)
-		sph_up.y += 360.0;
-
-	glutPostRedisplay();
+	InputEvent e = { InputEvent::Motion, 0, x, y, window_width, window_height };
+	input_events.push( e );
 }
 
 void mouse( int button, int state, int x, int y )
@@ -513,16 +2909,24 @@ void mouse( int button, int state, int x, int y )
 		if( state == GLUT_DOWN )
 		{
 			//glutMotionFunc( move_mouse );
-			glutIdleFunc( idle );
+			animating = true;
 		}
 		else
 		{
-			x_prev = glutGet( GLUT_WINDOW_WIDTH ) / 2;
-			y_prev = glutGet( GLUT_WINDOW_HEIGHT ) / 2;
+			InputEvent e = { InputEvent::Release, 0, x, y,
+							 window_width, window_height };
+			input_events.push( e );
 		}
 	}
 	else
 	{
+		// A right click picks what is under the cursor in the next frame
+		if( use_picking && button == GLUT_RIGHT_BUTTON && state == GLUT_DOWN )
+		{
+			pick_x = x;
+			pick_y = y;
+			glutPostRedisplay();
+		}
 		glutMotionFunc( NULL );
 	}
 }
@@ -534,26 +2938,302 @@ reshape( int width, int height )
 {
     glViewport( 0, 0, width, height );
 
+	window_width = width;
+	window_height = height;
+	set_render_scale( render_scale );
+	if( use_scene_target )
+		resize_scene_target( width, height );
+
     aspect = GLfloat(width)/height;
 }
 
 //----------------------------------------------------------------------------
 
+// -write-mesh: the converter from the built-in generators to mesh files
+bool
+write_mesh( const char* filename )
+{
+	bool ok;
+	if( use_wythoff )
+	{
+		WythoffMesh shape;
+		ok = LoadOrMakeWythoff( shape, wythoff_symbol )
+			&& SaveWythoffMeshFile( shape, filename );
+	}
+	else
+	{
+		Polytope shape;
+		MakePolytope( shape, shape_family >= 0 ? PolytopeFamily( shape_family )
+					  : POLYTOPE_HYPERCUBE, shape_dimension );
+		ok = SavePolytopeMeshFile( shape, filename );
+	}
+
+	MeshFile check;
+	if( !ok || !check.open( filename ) )
+	{
+		std::cerr << "can't write mesh file " << filename << std::endl;
+		return false;
+	}
+	std::cout << filename << ": " << check.dimension() << "D, "
+			  << check.vertex_count() << " vertices, "
+			  << check.find( MESH_EDGES )->count << " edges, "
+			  << check.find( MESH_TRIANGLES )->count << " triangles, "
+			  << check.file_size() << " bytes" << std::endl;
+	return true;
+}
+
+//----------------------------------------------------------------------------
+
 int
 main( int argc, char **argv )
 {
+	int status;
+	if( RunBenchmark( argc, argv, status ) )
+		return status;
+
+	for( int i=1; i<argc; i++ )
+	{
+		if( strcmp( argv[i], "-bench" ) == 0 && i+1 < argc )
+			bench_frames = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-objects" ) == 0 && i+1 < argc )
+			scene_objects = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-threads" ) == 0 && i+1 < argc )
+			job_threads = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-simhz" ) == 0 && i+1 < argc )
+			sim_hz = atof( argv[++i] );
+		else if( strcmp( argv[i], "-dim" ) == 0 && i+1 < argc )
+			shape_dimension = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-mesh" ) == 0 && i+1 < argc )
+		{
+			if( !mesh_file.open( argv[++i] ) || !mesh_file.find( MESH_POSITIONS )
+				|| !mesh_file.find( MESH_EDGES ) || !mesh_file.find( MESH_TRIANGLES )
+				|| mesh_file.dimension() < 3 || mesh_file.dimension() > MaxProjectorDimension )
+			{
+				std::cerr << "can't read mesh file " << argv[i] << std::endl;
+				exit( EXIT_FAILURE );
+			}
+			use_mesh_file = true;
+		}
+		else if( strcmp( argv[i], "-write-mesh" ) == 0 && i+1 < argc )
+			write_mesh_name = argv[++i];
+		else if( strcmp( argv[i], "-volume" ) == 0 && i+4 < argc )
+		{
+			const char* name = argv[++i];
+			int w = atoi( argv[++i] ), h = atoi( argv[++i] ), d = atoi( argv[++i] );
+			if( !volume_stream.open( name, w, h, d ) )
+			{
+				std::cerr << "can't read a " << w << "x" << h << "x" << d
+						  << " volume from " << name << std::endl;
+				exit( EXIT_FAILURE );
+			}
+			use_volume = true;
+		}
+		else if( strcmp( argv[i], "-points" ) == 0 && i+1 < argc )
+		{
+			if( !load_points( argv[++i] ) )
+			{
+				std::cerr << "can't make a point cloud from " << argv[i]
+						  << " (a 4D mesh file or a count)" << std::endl;
+				exit( EXIT_FAILURE );
+			}
+			use_points = true;
+		}
+		else if( strcmp( argv[i], "-vertex-format" ) == 0 && i+1 < argc )
+		{
+			if( !SolidVertexFormatFromName( argv[++i], solid_format ) )
+			{
+				std::cerr << "unknown vertex format " << argv[i]
+						  << " (vec4, packed or half)" << std::endl;
+				exit( EXIT_FAILURE );
+			}
+		}
+		else if( strcmp( argv[i], "-nocull" ) == 0 )
+			use_culling = false;
+		else if( strcmp( argv[i], "-gpu-cull" ) == 0 )
+			use_gpu_culling = true;
+		else if( strcmp( argv[i], "-occlusion" ) == 0 )
+			use_occlusion = true;
+		else if( strcmp( argv[i], "-lod-pixels" ) == 0 && i+1 < argc )
+			lod_edge_pixels = atof( argv[++i] );
+		else if( strcmp( argv[i], "-lod-budget" ) == 0 && i+1 < argc )
+			lod_budget = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-budget" ) == 0 && i+1 < argc )
+		{
+			quality.set_budget( atof( argv[++i] ) );
+			use_quality = use_scene_target = true;
+		}
+		else if( strcmp( argv[i], "-scale" ) == 0 && i+1 < argc )
+		{
+			render_scale = atof( argv[++i] );
+			use_scene_target = true;
+		}
+		else if( strcmp( argv[i], "-upscale" ) == 0 && i+1 < argc )
+		{
+			if( strcmp( argv[++i], "bilinear" ) == 0 )
+				upscale_filter = UPSCALE_BILINEAR;
+			else if( strcmp( argv[i], "sharpen" ) == 0 )
+				upscale_filter = UPSCALE_SHARPEN;
+			else
+			{
+				std::cerr << "unknown upscale filter " << argv[i]
+						  << " (bilinear or sharpen)" << std::endl;
+				exit( EXIT_FAILURE );
+			}
+			use_scene_target = true;
+		}
+		else if( strcmp( argv[i], "-scale-sweep" ) == 0 )
+			scale_sweep = use_scene_target = true;
+		else if( strcmp( argv[i], "-instanced" ) == 0 )
+			use_instancing = true;
+		else if( strcmp( argv[i], "-pull" ) == 0 )
+			use_instancing = use_pulling = true;
+		else if( strcmp( argv[i], "-pick" ) == 0 )
+			use_picking = use_scene_target = true;
+		else if( strcmp( argv[i], "-impostors" ) == 0 )
+			use_impostors = true;
+		else if( strcmp( argv[i], "-impostor-pixels" ) == 0 && i+1 < argc )
+			impostor_pixels = atof( argv[++i] );
+		else if( strcmp( argv[i], "-impostor-error" ) == 0 && i+1 < argc )
+			impostor_error = atof( argv[++i] );
+		else if( strcmp( argv[i], "-impostor-refresh" ) == 0 && i+1 < argc )
+			impostor_refresh = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-eye-distance" ) == 0 && i+1 < argc )
+		{
+			// Back along z from the middle of the scene, far enough to see
+			// all of it
+			GLfloat distance = atof( argv[++i] );
+			camera.set_start( vec4( 0.0, 0.0, distance, 1.0 ) );
+			zFar = std::max( zFar, distance + GLfloat( 2.0 ) );
+		}
+		else if( strcmp( argv[i], "-volume-fps" ) == 0 && i+1 < argc )
+			volume_fps = atof( argv[++i] );
+		else if( strcmp( argv[i], "-write-volume" ) == 0 && i+3 < argc )
+		{
+			// A test dataset: FILE SIZE FRAMES
+			const char* name = argv[++i];
+			int size = atoi( argv[++i] ), frames = atoi( argv[++i] );
+			if( size < 1 || frames < 1 || !WriteTestVolume( name, size, frames ) )
+			{
+				std::cerr << "can't write volume " << name << std::endl;
+				exit( EXIT_FAILURE );
+			}
+			std::cout << name << ": " << frames << " frames of " << size << "^3"
+					  << std::endl;
+			exit( EXIT_SUCCESS );
+		}
+		else if( strcmp( argv[i], "-shape" ) == 0 && i+1 < argc )
+		{
+			shape_family = PolytopeFamilyFromName( argv[++i] );
+			surface_family = shape_family < 0 ? SurfaceFamilyFromName( argv[i] ) : -1;
+			use_wythoff = shape_family < 0 && surface_family < 0
+				&& WythoffSymbolFromName( argv[i], wythoff_symbol );
+			if( shape_family < 0 && surface_family < 0 && !use_wythoff )
+			{
+				std::cerr << "unknown shape " << argv[i] << " (hypercube, simplex,"
+						  << " orthoplex, 24-cell, 120-cell, 600-cell, ...,"
+						  << " p,q,r:rings such as 5,3,3:1100, glome, clifford,"
+						  << " duocylinder or spherinder)" << std::endl;
+				exit( EXIT_FAILURE );
+			}
+		}
+	}
+
+	if( surface_family >= 0 && (shape_dimension != 4 || use_mesh_file || write_mesh_name
+								|| use_instancing || use_gpu_culling
+								|| solid_format != SOLID_VEC4) )
+	{
+		std::cerr << "curved surfaces are 4D, drawn one object at a time with vec4"
+				  << " vertices, and not written to mesh files" << std::endl;
+		exit( EXIT_FAILURE );
+	}
+
+	// -dim on its own means the N-cube
+	if( shape_dimension != 4 && shape_family < 0 && !use_wythoff
+		&& surface_family < 0 )
+		shape_family = POLYTOPE_HYPERCUBE;
+	if( shape_dimension < 1 || shape_dimension > MaxProjectorDimension )
+	{
+		std::cerr << "-dim must be 1 to " << MaxProjectorDimension << std::endl;
+		exit( EXIT_FAILURE );
+	}
+	use_projector = shape_family >= 0 && shape_dimension > 4;
+
+	if( write_mesh_name )
+		exit( write_mesh( write_mesh_name ) ? EXIT_SUCCESS : EXIT_FAILURE );
+
+	if( use_instancing && (use_mesh_file || use_wythoff || shape_family >= 0
+						   || use_points || use_volume || solid_format != SOLID_VEC4) )
+	{
+		std::cerr << "-instanced and -pull draw the built-in tesseract only" << std::endl;
+		exit( EXIT_FAILURE );
+	}
+
+	if( use_impostors && !use_instancing )
+	{
+		std::cerr << "-impostors works with -instanced or -pull only" << std::endl;
+		exit( EXIT_FAILURE );
+	}
+
+	if( use_mesh_file )
+	{
+		shape_dimension = mesh_file.dimension();
+		use_projector = shape_dimension != 4;
+	}
+	if( use_gpu_culling && (use_instancing || use_projector || use_points || use_volume
+							|| solid_format != SOLID_VEC4) )
+	{
+		std::cerr << "-gpu-cull draws 4D meshes with vec4 vertices only" << std::endl;
+		exit( EXIT_FAILURE );
+	}
+	if( use_picking && (use_instancing || use_gpu_culling || use_projector || use_points
+						|| use_volume || solid_format != SOLID_VEC4) )
+	{
+		std::cerr << "-pick works with objects drawn one at a time, with vec4 vertices"
+				  << std::endl;
+		exit( EXIT_FAILURE );
+	}
+
+	if( use_occlusion && (use_instancing || use_gpu_culling || use_projector
+						  || use_points || use_volume) )
+	{
+		std::cerr << "-occlusion works with objects drawn one at a time only"
+				  << std::endl;
+		exit( EXIT_FAILURE );
+	}
+
+	if( scale_sweep && (use_quality || bench_frames <= 0) )
+	{
+		std::cerr << "-scale-sweep needs -bench N, and sets the scale itself"
+				  << " without -budget" << std::endl;
+		exit( EXIT_FAILURE );
+	}
+	set_render_scale( scale_sweep ? SweepScales[0] : render_scale );
+
+	jobs = new JobSystem( job_threads );
+
     glutInit( &argc, argv );
     glutInitDisplayMode( GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH );
     glutInitWindowSize( 512, 512 );
-    glutInitContextVersion( 3, 2 );
+    glutInitContextVersion( use_gpu_culling ? 4 : 3, use_gpu_culling ? 3 : 2 );
     glutInitContextProfile( GLUT_CORE_PROFILE );
-    glutCreateWindow( "Teseseract" );
+    glutCreateWindow( window_title );
 
 	glewExperimental = GL_TRUE;
     glewInit();
 
     init();
 
+	// Keep the setup calls out of the first frame's counters
+	GLTraceEndFrame();
+	startup_gl = GLTraceLastFrame();
+	FrameStatsReset();
+
+	if( bench_frames > 0 )
+		animating = true;
+
+	simulation.start( sim_hz, simulate );
+	glutIdleFunc( idle );
+
     glutDisplayFunc( display );
     glutKeyboardFunc( keyboard );
     glutReshapeFunc( reshape );
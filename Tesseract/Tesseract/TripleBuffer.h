@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- TripleBuffer.h ---
+//
+//   Lock-free hand-off of whole values between one writer thread and one
+//     reader thread.  The writer fills the back slot and publishes it; the
+//     reader picks up the newest published slot.  Three slots mean neither
+//     side ever waits for the other: the writer always has a slot the
+//     reader is not looking at, and the reader keeps its slot until it
+//     asks for a newer one.
+//
+//   SpscQueue is the companion for a stream of small items (input events)
+//     from one producer to one consumer.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __TRIPLEBUFFER_H__
+#define __TRIPLEBUFFER_H__
+
+#include <atomic>
+
+template <class T>
+class TripleBuffer {
+   public:
+    TripleBuffer() : back( 0 ), middle( 1 ), front( 2 ) {}
+
+    //  Writer side: fill this slot, then publish() it
+    T& write_buffer() { return slots[back]; }
+
+    void publish() {
+	back = middle.exchange( back | Fresh, std::memory_order_acq_rel ) & Index;
+    }
+
+    //  Reader side: switch to the newest published slot.  Returns false
+    //    (and keeps the current slot) if nothing new was published.
+    bool update() {
+	if ( !(middle.load( std::memory_order_relaxed ) & Fresh) )
+	    return false;
+	front = middle.exchange( front, std::memory_order_acq_rel ) & Index;
+	return true;
+    }
+
+    bool fresh() const
+	{ return (middle.load( std::memory_order_acquire ) & Fresh) != 0; }
+
+    const T& read_buffer() const { return slots[front]; }
+
+   private:
+    enum { Index = 3, Fresh = 4 };
+
+    T                          slots[3];
+    unsigned int               back;		// owned by the writer
+    std::atomic<unsigned int>  middle;		// index | Fresh
+    unsigned int               front;		// owned by the reader
+};
+
+//----------------------------------------------------------------------------
+
+//  Capacity must be a power of two
+template <class T, int Capacity>
+class SpscQueue {
+   public:
+    SpscQueue() : head( 0 ), tail( 0 ) {}
+
+    //  Producer side; false (and the item dropped) if the queue is full
+    bool push( const T& item ) {
+	unsigned int t = tail.load( std::memory_order_relaxed );
+	if ( t - head.load( std::memory_order_acquire ) == Capacity )
+	    return false;
+	items[t % Capacity] = item;
+	tail.store( t + 1, std::memory_order_release );
+	return true;
+    }
+
+    //  Consumer side; false if the queue is empty
+    bool pop( T& item ) {
+	unsigned int h = head.load( std::memory_order_relaxed );
+	if ( h == tail.load( std::memory_order_acquire ) )
+	    return false;
+	item = items[h % Capacity];
+	head.store( h + 1, std::memory_order_release );
+	return true;
+    }
+
+   private:
+    T                          items[Capacity];
+    std::atomic<unsigned int>  head;
+    std::atomic<unsigned int>  tail;
+};
+
+#endif // __TRIPLEBUFFER_H__
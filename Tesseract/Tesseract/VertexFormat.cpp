@@ -0,0 +1,142 @@
+#include "VertexFormat.h"
+#include <string.h>
+
+bool
+SolidVertexFormatFromName( const char* name, SolidVertexFormat& format )
+{
+    if ( strcmp( name, "vec4" ) == 0 )
+	format = SOLID_VEC4;
+    else if ( strcmp( name, "packed" ) == 0 )
+	format = SOLID_PACKED;
+    else if ( strcmp( name, "half" ) == 0 )
+	format = SOLID_HALF;
+    else
+	return false;
+    return true;
+}
+
+int
+SolidVertexSize( SolidVertexFormat format )
+{
+    switch ( format ) {
+    case SOLID_PACKED:  return sizeof(PackedVertex);
+    case SOLID_HALF:    return sizeof(HalfVertex);
+    default:            return 2 * sizeof(vec4);
+    }
+}
+
+//----------------------------------------------------------------------------
+
+//  The palette entry for "shade", added if it is new.  Faces come in runs
+//    of one shade, so the last one found is tried first.
+static int
+palette_index( const vec4& shade, vec4* palette, int& size, int& last )
+{
+    GLfloat w = shade.w != 0.0 ? shade.w : 1.0;
+    vec4 color = shade / w;
+    if ( last >= 0 && memcmp( &palette[last], &color, sizeof(vec4) ) == 0 )
+	return last;
+
+    for ( int i = 0; i < size; ++i )
+	if ( memcmp( &palette[i], &color, sizeof(vec4) ) == 0 )
+	    return last = i;
+
+    if ( size == MaxPaletteColors )
+	return -1;
+    palette[size] = color;
+    return last = size++;
+}
+
+int
+PackSolidMesh( SolidVertexFormat format, const vec4* points, const vec4* shades,
+	       int count, void* out, vec4 palette[MaxPaletteColors] )
+{
+    int size = 0, last = -1;
+    for ( int i = 0; i < count; ++i ) {
+	int color = palette_index( shades[i], palette, size, last );
+	if ( color < 0 )
+	    return -1;
+
+	const vec4& p = points[i];
+	if ( format == SOLID_HALF ) {
+	    HalfVertex& v = ((HalfVertex*) out)[i];
+	    v.position[0] = FloatToHalf( p.x );
+	    v.position[1] = FloatToHalf( p.y );
+	    v.position[2] = FloatToHalf( p.z );
+	    v.position[3] = FloatToHalf( p.w );
+	    v.color = (GLubyte) color;
+	    v.pad[0] = v.pad[1] = v.pad[2] = 0;
+	} else {
+	    PackedVertex& v = ((PackedVertex*) out)[i];
+	    v.position[0] = p.x;
+	    v.position[1] = p.y;
+	    v.position[2] = p.z;
+	    v.position[3] = p.w;
+	    v.color = (GLubyte) color;
+	    v.pad[0] = v.pad[1] = v.pad[2] = 0;
+	}
+    }
+    return size;
+}
+
+//----------------------------------------------------------------------------
+
+GLushort
+FloatToHalf( GLfloat x )
+{
+    GLuint f;
+    memcpy( &f, &x, sizeof(f) );
+    GLuint sign = (f >> 16) & 0x8000;
+    int exponent = (int) ((f >> 23) & 0xff) - 127 + 15;
+    GLuint mantissa = f & 0x7fffff;
+
+    if ( ((f >> 23) & 0xff) == 0xff )		// infinity or NaN
+	return (GLushort) (sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    if ( exponent >= 31 )			// too big
+	return (GLushort) (sign | 0x7c00);
+
+    int shift = 13;
+    if ( exponent <= 0 ) {			// subnormal, or zero
+	if ( exponent < -10 )
+	    return (GLushort) sign;
+	mantissa |= 0x800000;
+	shift = 14 - exponent;
+	exponent = 0;
+    }
+
+    // A carry out of the mantissa moves up the exponent, as it should
+    GLuint half = ((GLuint) exponent << 10) + (mantissa >> shift);
+    GLuint rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+    if ( rest > halfway || (rest == halfway && (half & 1)) )
+	half++;
+    return (GLushort) (sign | half);
+}
+
+GLfloat
+HalfToFloat( GLushort h )
+{
+    GLuint sign = (GLuint) (h & 0x8000) << 16;
+    GLuint exponent = (h >> 10) & 0x1f;
+    GLuint mantissa = h & 0x3ff;
+
+    GLuint f;
+    if ( exponent == 31 )
+	f = sign | 0x7f800000 | (mantissa << 13);
+    else if ( exponent != 0 )
+	f = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    else if ( mantissa == 0 )
+	f = sign;
+    else {
+	// Subnormal: normalize it
+	int e = -1;
+	do {
+	    mantissa <<= 1;
+	    ++e;
+	} while ( (mantissa & 0x400) == 0 );
+	f = sign | ((GLuint) (127 - 15 - e) << 23) | ((mantissa & 0x3ff) << 13);
+    }
+
+    GLfloat x;
+    memcpy( &x, &f, sizeof(x) );
+    return x;
+}
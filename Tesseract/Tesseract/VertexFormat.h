@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- VertexFormat.h ---
+//
+//   Layouts for the solid mesh.  The original one is a vec4 position and
+//     a vec4 shade per triangle corner, 32 bytes, and all six corners of
+//     a face carry the same shade.  The packed layouts interleave the
+//     position with a one-byte index into a palette of at most 256
+//     colors, which the shader reads from a uniform block:
+//
+//     SOLID_VEC4     vec4 position, then (after all of them) vec4 shade
+//     SOLID_PACKED   4 floats, palette index, 3 bytes pad      20 bytes
+//     SOLID_HALF     4 half floats, palette index, 3 bytes pad 12 bytes
+//
+//   The palette holds each color as drawn -- the shade divided by its w,
+//     as vshader_solid.glsl does per vertex.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VERTEXFORMAT_H__
+#define __VERTEXFORMAT_H__
+
+#include "Angel.h"
+
+enum SolidVertexFormat {
+    SOLID_VEC4,
+    SOLID_PACKED,
+    SOLID_HALF
+};
+
+const int MaxPaletteColors = 256;
+
+struct PackedVertex {
+    GLfloat   position[4];
+    GLubyte   color;		// palette index
+    GLubyte   pad[3];
+};
+
+struct HalfVertex {
+    GLushort  position[4];	// IEEE half floats
+    GLubyte   color;
+    GLubyte   pad[3];
+};
+
+//  The format named "vec4", "packed" or "half"; false for anything else
+bool SolidVertexFormatFromName( const char* name, SolidVertexFormat& format );
+
+//  Bytes per vertex of the position and color, counting SOLID_VEC4's
+//    shade
+int SolidVertexSize( SolidVertexFormat format );
+
+//  Pack "count" corners and their shades into "out", which has room for
+//    count * SolidVertexSize(format) bytes, and their colors into
+//    "palette".  Returns the number of palette entries, or -1 if there are
+//    more than MaxPaletteColors distinct shades.  Not for SOLID_VEC4.
+int PackSolidMesh( SolidVertexFormat format, const vec4* points,
+		   const vec4* shades, int count, void* out,
+		   vec4 palette[MaxPaletteColors] );
+
+//  Round to the nearest half float, ties to even
+GLushort FloatToHalf( GLfloat x );
+GLfloat HalfToFloat( GLushort h );
+
+#endif // __VERTEXFORMAT_H__
@@ -0,0 +1,240 @@
+#include "VolumeStream.h"
+#include "FrameStats.h"
+#include <math.h>
+#include <string.h>
+
+//  Large-file seeks
+#ifdef _WIN32
+#  define volume_seek  _fseeki64
+#  define volume_tell  _ftelli64
+#else
+#  define volume_seek  fseeko
+#  define volume_tell  ftello
+#endif
+
+VolumeStream::VolumeStream() :
+    file( NULL ), frame_count( 0 ), bytes( 0 ), playhead( 0 ), quit( false )
+{
+    size[0] = size[1] = size[2] = 0;
+    memset( &counters, 0, sizeof(counters) );
+}
+
+VolumeStream::~VolumeStream()
+{
+    close();
+}
+
+bool
+VolumeStream::open( const char* filename, int width, int height, int depth,
+		    int slot_count )
+{
+    close();
+    if ( width < 1 || height < 1 || depth < 1 || slot_count < 2 )
+	return false;
+
+    file = fopen( filename, "rb" );
+    if ( file == NULL )
+	return false;
+
+    volume_seek( file, 0, SEEK_END );
+    long long file_bytes = volume_tell( file );
+
+    size[0] = width;
+    size[1] = height;
+    size[2] = depth;
+    bytes = (size_t) width * height * depth;
+    frame_count = (int) (file_bytes / (long long) bytes);
+    if ( frame_count < 1 ) {
+	close();
+	return false;
+    }
+
+    // No more slots than frames, so a short loop is never read twice over
+    if ( slot_count > frame_count )
+	slot_count = frame_count;
+    slots.resize( slot_count );
+    for ( size_t i = 0; i < slots.size(); ++i ) {
+	slots[i].frame = -1;
+	slots[i].ready = false;
+	slots[i].pins = 0;
+	slots[i].voxels.resize( bytes );
+    }
+
+    playhead = 0;
+    quit = false;
+    memset( &counters, 0, sizeof(counters) );
+    thread = std::thread( &VolumeStream::reader, this );
+    return true;
+}
+
+void
+VolumeStream::close()
+{
+    if ( thread.joinable() ) {
+	{
+	    std::lock_guard<std::mutex> hold( lock );
+	    quit = true;
+	}
+	work.notify_one();
+	thread.join();
+    }
+    if ( file )
+	fclose( file );
+    file = NULL;
+    slots.clear();
+    frame_count = 0;
+}
+
+VolumeStream::Slot*
+VolumeStream::find( int frame )
+{
+    for ( size_t i = 0; i < slots.size(); ++i )
+	if ( slots[i].frame == frame )
+	    return &slots[i];
+    return NULL;
+}
+
+void
+VolumeStream::seek( int frame )
+{
+    {
+	std::lock_guard<std::mutex> hold( lock );
+	frame %= frame_count;
+	if ( frame == playhead )
+	    return;
+	playhead = frame;
+    }
+    work.notify_one();
+}
+
+const unsigned char*
+VolumeStream::acquire( int frame )
+{
+    std::lock_guard<std::mutex> hold( lock );
+    Slot* s = find( frame );
+    if ( s == NULL || !s->ready ) {
+	counters.misses++;
+	return NULL;
+    }
+    s->pins++;
+    return &s->voxels[0];
+}
+
+void
+VolumeStream::release( int frame )
+{
+    {
+	std::lock_guard<std::mutex> hold( lock );
+	Slot* s = find( frame );
+	if ( s && s->pins > 0 )
+	    s->pins--;
+    }
+    work.notify_one();		// the slot may be free for reuse now
+}
+
+VolumeStreamStats
+VolumeStream::stats() const
+{
+    std::lock_guard<std::mutex> hold( lock );
+    return counters;
+}
+
+//----------------------------------------------------------------------------
+
+//  Fill the slots with the frames from the playhead on, nearest first.  A
+//    slot can be reused once its frame has fallen out of that window and
+//    nobody holds it.  The read itself runs without the lock.
+void
+VolumeStream::reader()
+{
+    std::unique_lock<std::mutex> hold( lock );
+    for ( ;; ) {
+	Slot* target = NULL;
+	int frame = -1;
+	for ( size_t i = 0; i < slots.size() && target == NULL; ++i ) {
+	    if ( find( wanted( (int) i ) ) )
+		continue;
+
+	    // Any slot holding a frame outside the window will do
+	    for ( size_t k = 0; k < slots.size(); ++k ) {
+		Slot& s = slots[k];
+		if ( s.pins > 0 )
+		    continue;
+		bool in_window = false;
+		for ( size_t j = 0; j < slots.size() && !in_window; ++j )
+		    in_window = s.frame == wanted( (int) j );
+		if ( !in_window ) {
+		    target = &s;
+		    frame = wanted( (int) i );
+		    break;
+		}
+	    }
+	    if ( target == NULL )
+		break;		// all pinned or in use; wait for a release
+	}
+
+	if ( quit )
+	    return;
+	if ( target == NULL ) {
+	    work.wait( hold );
+	    continue;
+	}
+
+	target->frame = frame;
+	target->ready = false;
+	unsigned char* voxels = &target->voxels[0];
+	hold.unlock();
+
+	double start = FrameStatsNow();
+	bool ok = volume_seek( file, (long long) frame * (long long) bytes, SEEK_SET ) == 0
+	    && fread( voxels, 1, bytes, file ) == bytes;
+	double ms = FrameStatsNow() - start;
+
+	hold.lock();
+	if ( !ok ) {
+	    target->frame = -1;
+	    work.wait( hold );	// a short file; try again when asked
+	    continue;
+	}
+	target->ready = true;
+	counters.frames_read++;
+	counters.read_ms += ms;
+	counters.bytes_read += bytes;
+    }
+}
+
+//----------------------------------------------------------------------------
+
+bool
+WriteTestVolume( const char* filename, int size, int frames )
+{
+    FILE* fp = fopen( filename, "wb" );
+    if ( fp == NULL )
+	return false;
+
+    // (|xy| - R)^2 + (|zw| - R)^2 < r^2, in a cube of side 2.4 and w
+    // over the same range
+    const float R = 0.7f, r = 0.3f;
+    std::vector<unsigned char> frame( (size_t) size * size * size );
+    bool ok = true;
+    for ( int t = 0; t < frames && ok; ++t ) {
+	float w = -1.2f + 2.4f * (t + 0.5f) / frames;
+	size_t i = 0;
+	for ( int k = 0; k < size; ++k )
+	    for ( int j = 0; j < size; ++j )
+		for ( int n = 0; n < size; ++n, ++i ) {
+		    float x = -1.2f + 2.4f * (n + 0.5f) / size;
+		    float y = -1.2f + 2.4f * (j + 0.5f) / size;
+		    float z = -1.2f + 2.4f * (k + 0.5f) / size;
+		    float a = sqrtf( x*x + y*y ) - R;
+		    float b = sqrtf( z*z + w*w ) - R;
+		    float d = (r - sqrtf( a*a + b*b )) / r;	// 1 at the core
+		    frame[i] = d <= 0.0f ? 0 : (unsigned char) (255.0f * (d < 1.0f ? d : 1.0f));
+		}
+	ok = fwrite( &frame[0], 1, frame.size(), fp ) == frame.size();
+    }
+    ok = fclose( fp ) == 0 && ok;
+    if ( !ok )
+	remove( filename );
+    return ok;
+}
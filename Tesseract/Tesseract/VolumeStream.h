@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- VolumeStream.h ---
+//
+//   Playback of a time-varying 3D volume -- a 4D dataset with time as w --
+//     from a raw file: one byte per voxel, x fastest, then y, z and frame,
+//     with no header.
+//
+//   A reader thread keeps the frames just ahead of the playhead in a ring
+//     of "slots" frame buffers, so only that much of the dataset is ever
+//     in memory however long the file is.  The render thread asks for a
+//     frame with acquire(), which never blocks: it returns NULL, and
+//     counts a miss, if the reader has not got that far yet.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VOLUMESTREAM_H__
+#define __VOLUMESTREAM_H__
+
+#include <stdio.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct VolumeStreamStats {
+    unsigned long  frames_read;
+    unsigned long  misses;		// acquire() calls for frames not read yet
+    double         read_ms;		// time spent reading
+    double         bytes_read;
+};
+
+class VolumeStream {
+   public:
+    VolumeStream();
+    ~VolumeStream();
+
+    //  Open a file of width x height x depth frames and start reading from
+    //    frame 0.  False if it can't be read or holds no whole frame.
+    bool open( const char* filename, int width, int height, int depth,
+	       int slots = 8 );
+    void close();
+
+    int width() const { return size[0]; }
+    int height() const { return size[1]; }
+    int depth() const { return size[2]; }
+    int frames() const { return frame_count; }
+    size_t frame_bytes() const { return bytes; }
+
+    //  Move the playhead; the reader fills the slots from here on,
+    //    wrapping around at the end
+    void seek( int frame );
+
+    //  The voxels of "frame", or NULL if they are not in yet.  They stay
+    //    put until release( frame ).
+    const unsigned char* acquire( int frame );
+    void release( int frame );
+
+    VolumeStreamStats stats() const;
+
+   private:
+    struct Slot {
+	int                         frame;	// -1 if empty
+	bool                        ready;
+	int                         pins;
+	std::vector<unsigned char>  voxels;
+    };
+
+    void reader();
+    int wanted( int i ) const { return (playhead + i) % frame_count; }
+    Slot* find( int frame );
+
+    FILE*                    file;
+    int                      size[3];
+    int                      frame_count;
+    size_t                   bytes;
+
+    std::vector<Slot>        slots;
+    int                      playhead;
+    bool                     quit;
+    mutable std::mutex       lock;
+    std::condition_variable  work;
+    std::thread              thread;
+    VolumeStreamStats        counters;
+};
+
+//  Write a synthetic dataset for testing: the slices of a 4D Clifford
+//    torus by w, for w running across the frames
+bool WriteTestVolume( const char* filename, int size, int frames );
+
+#endif // __VOLUMESTREAM_H__
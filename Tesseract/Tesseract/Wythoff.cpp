@@ -0,0 +1,625 @@
+#include "Wythoff.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+#ifdef _WIN32
+#  include <process.h>
+#  define getpid _getpid
+#else
+#  include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------
+//
+//  Double precision 4-vectors and matrices -- the orbit of the 120-cell
+//    family is deep enough that float round-off would split vertices
+//
+
+struct Point4d {
+    double  x[4];
+};
+
+struct Matrix4d {
+    double  m[4][4];
+};
+
+static inline double
+dot( const Point4d& a, const Point4d& b )
+{
+    return a.x[0]*b.x[0] + a.x[1]*b.x[1] + a.x[2]*b.x[2] + a.x[3]*b.x[3];
+}
+
+//  Mirror image of "v" in the hyperplane through the origin with unit
+//    normal "n"
+static inline Point4d
+reflect( const Point4d& v, const Point4d& n )
+{
+    double d = 2.0 * dot( v, n );
+    Point4d r;
+    for ( int i = 0; i < 4; ++i )
+	r.x[i] = v.x[i] - d * n.x[i];
+    return r;
+}
+
+//  The reflection in "n" applied after "g"
+static inline Matrix4d
+reflect( const Matrix4d& g, const Point4d& n )
+{
+    Matrix4d r;
+    for ( int j = 0; j < 4; ++j ) {
+	double d = 0.0;
+	for ( int i = 0; i < 4; ++i )
+	    d += n.x[i] * g.m[i][j];
+	for ( int i = 0; i < 4; ++i )
+	    r.m[i][j] = g.m[i][j] - 2.0 * d * n.x[i];
+    }
+    return r;
+}
+
+static inline Point4d
+transform( const Matrix4d& g, const Point4d& v )
+{
+    Point4d r;
+    for ( int i = 0; i < 4; ++i )
+	r.x[i] = g.m[i][0]*v.x[0] + g.m[i][1]*v.x[1]
+	    + g.m[i][2]*v.x[2] + g.m[i][3]*v.x[3];
+    return r;
+}
+
+static Matrix4d
+identity4d()
+{
+    Matrix4d g;
+    for ( int i = 0; i < 4; ++i )
+	for ( int j = 0; j < 4; ++j )
+	    g.m[i][j] = i == j ? 1.0 : 0.0;
+    return g;
+}
+
+//----------------------------------------------------------------------------
+//
+//  Points looked up by position, rounded to a fine grid
+//
+
+struct PointKey {
+    long long  q[4];
+
+    bool operator==( const PointKey& k ) const
+	{ return q[0] == k.q[0] && q[1] == k.q[1] && q[2] == k.q[2] && q[3] == k.q[3]; }
+};
+
+struct PointKeyHash {
+    size_t operator()( const PointKey& k ) const {
+	unsigned long long h = 1469598103934665603ull;
+	for ( int i = 0; i < 4; ++i )
+	    h = (h ^ (unsigned long long) k.q[i]) * 1099511628211ull;
+	return (size_t) (h ^ (h >> 32));
+    }
+};
+
+class PointTable {
+   public:
+    //  Index of "p", adding it if it is new
+    int insert( const Point4d& p, bool& added ) {
+	std::pair<Map::iterator, bool> r =
+	    index.insert( Map::value_type( key( p ), (int) points.size() ) );
+	added = r.second;
+	if ( added )
+	    points.push_back( p );
+	return r.first->second;
+    }
+
+    //  Index of "p", or -1
+    int find( const Point4d& p ) const {
+	Map::const_iterator i = index.find( key( p ) );
+	return i == index.end() ? -1 : i->second;
+    }
+
+    int size() const { return (int) points.size(); }
+    const Point4d& operator[]( int i ) const { return points[i]; }
+
+   private:
+    typedef std::unordered_map<PointKey, int, PointKeyHash>  Map;
+
+    static PointKey key( const Point4d& p ) {
+	PointKey k;
+	for ( int i = 0; i < 4; ++i )
+	    k.q[i] = llround( p.x[i] * 1.0e6 );
+	return k;
+    }
+
+    Map                   index;
+    std::vector<Point4d>  points;
+};
+
+//----------------------------------------------------------------------------
+//
+//  The Coxeter group
+//
+
+//  Unit normals of the four mirrors: the rows of the Cholesky factor of
+//    the Gram matrix cos(angle between mirror normals).  The factor only
+//    exists -- and the group is only finite -- if that matrix is positive
+//    definite.
+static bool
+mirror_normals( const WythoffSymbol& s, Point4d n[4] )
+{
+    double gram[4][4];
+    for ( int i = 0; i < 4; ++i ) {
+	for ( int j = 0; j < 4; ++j ) {
+	    if ( i == j )
+		gram[i][j] = 1.0;
+	    else if ( abs( i - j ) == 1 )
+		gram[i][j] = -cos( M_PI / s.branches[i < j ? i : j] );
+	    else
+		gram[i][j] = 0.0;
+	}
+    }
+
+    memset( n, 0, 4 * sizeof(Point4d) );
+    for ( int i = 0; i < 4; ++i ) {
+	for ( int j = 0; j <= i; ++j ) {
+	    double sum = gram[i][j];
+	    for ( int k = 0; k < j; ++k )
+		sum -= n[i].x[k] * n[j].x[k];
+
+	    if ( i == j ) {
+		if ( sum < 1.0e-9 )
+		    return false;
+		n[i].x[i] = sqrt( sum );
+	    }
+	    else
+		n[i].x[j] = sum / n[j].x[j];
+	}
+    }
+    return true;
+}
+
+//  The point at the given distances from the mirrors; the normals form a
+//    lower triangular matrix, so this is a forward substitution
+static Point4d
+point_at( const Point4d n[4], const double distance[4] )
+{
+    Point4d p;
+    for ( int i = 0; i < 4; ++i ) {
+	double sum = distance[i];
+	for ( int k = 0; k < i; ++k )
+	    sum -= n[i].x[k] * p.x[k];
+	p.x[i] = sum / n[i].x[i];
+    }
+    return p;
+}
+
+//  Elements of the subgroup generated by the mirrors in "mask"
+static std::vector<Matrix4d>
+subgroup( const Point4d n[4], int mask )
+{
+    // Elements are told apart by where they send a point that no mirror
+    // fixes
+    static const double generic[4] = { 1.0, 1.13, 1.31, 1.57 };
+    Point4d probe = point_at( n, generic );
+
+    std::vector<Matrix4d> elements( 1, identity4d() );
+    PointTable seen;
+    bool added;
+    seen.insert( probe, added );
+
+    for ( size_t e = 0; e < elements.size(); ++e ) {
+	for ( int i = 0; i < 4; ++i ) {
+	    if ( !(mask & (1 << i)) )
+		continue;
+	    Matrix4d g = reflect( elements[e], n[i] );
+	    seen.insert( transform( g, probe ), added );
+	    if ( added )
+		elements.push_back( g );
+	}
+    }
+    return elements;
+}
+
+//----------------------------------------------------------------------------
+//
+//  The edges and faces around the starting vertex
+//
+
+struct LocalFace {
+    std::vector<int>  corners;	// indices into the local point table
+    int               kind;
+};
+
+static bool
+same_point( const Point4d& a, const Point4d& b )
+{
+    for ( int i = 0; i < 4; ++i )
+	if ( fabs( a.x[i] - b.x[i] ) > 1.0e-9 )
+	    return false;
+    return true;
+}
+
+//  The polygon around v0 generated by mirrors i and j, in order around
+//    its boundary (empty if it has fewer than three corners).  With v0 off
+//    both mirrors the corners alternate between reflections in i and j;
+//    with v0 on one of them they are its images under the rotation
+//    R_j R_i.
+static std::vector<Point4d>
+face_loop( const Point4d n[4], const Point4d& v0, int i, int j, int branch )
+{
+    std::vector<Point4d> loop( 1, v0 );
+    bool on_i = same_point( reflect( v0, n[i] ), v0 );
+    bool on_j = same_point( reflect( v0, n[j] ), v0 );
+
+    if ( !on_i || !on_j ) {
+	Point4d p = v0;
+	for ( int step = 1; step < 2*branch; ++step ) {
+	    if ( on_i || on_j )
+		p = reflect( reflect( p, n[i] ), n[j] );
+	    else
+		p = reflect( p, n[step & 1 ? i : j] );
+	    if ( same_point( p, v0 ) )
+		break;
+	    loop.push_back( p );
+	}
+    }
+
+    if ( loop.size() < 3 )
+	loop.clear();
+    return loop;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+MakeWythoff( WythoffMesh& mesh, const WythoffSymbol& symbol )
+{
+    const int rings = symbol.rings & 15;
+    if ( rings == 0 )
+	return false;
+    for ( int i = 0; i < 3; ++i )
+	if ( symbol.branches[i] < 2 )
+	    return false;
+
+    Point4d n[4];
+    if ( !mirror_normals( symbol, n ) )
+	return false;
+
+    double distance[4];
+    for ( int i = 0; i < 4; ++i )
+	distance[i] = (rings & (1 << i)) ? 1.0 : 0.0;
+    Point4d v0 = point_at( n, distance );
+
+    // The mirrors through v0 generate the subgroup that keeps it in place;
+    // its images of the edges and faces at v0 are all the edges and faces
+    // there
+    std::vector<Matrix4d> stabilizer = subgroup( n, ~rings & 15 );
+
+    PointTable local;
+    bool added;
+    local.insert( v0, added );
+
+    std::vector<int> local_edges;
+    for ( int i = 0; i < 4; ++i ) {
+	if ( !(rings & (1 << i)) )
+	    continue;
+	Point4d w = reflect( v0, n[i] );
+	for ( size_t s = 0; s < stabilizer.size(); ++s ) {
+	    int k = local.insert( transform( stabilizer[s], w ), added );
+	    if ( added )
+		local_edges.push_back( k );
+	}
+    }
+
+    std::vector<LocalFace> local_faces;
+    std::set< std::vector<int> > seen_faces;
+    int kind = 0;
+    for ( int i = 0; i < 4; ++i ) {
+	for ( int j = i+1; j < 4; ++j, ++kind ) {
+	    int branch = j == i+1 ? symbol.branches[i] : 2;
+	    std::vector<Point4d> loop = face_loop( n, v0, i, j, branch );
+	    if ( loop.empty() )
+		continue;
+
+	    for ( size_t s = 0; s < stabilizer.size(); ++s ) {
+		LocalFace f;
+		f.kind = kind;
+		for ( size_t c = 0; c < loop.size(); ++c )
+		    f.corners.push_back(
+			local.insert( transform( stabilizer[s], loop[c] ), added ) );
+
+		std::vector<int> sorted( f.corners );
+		std::sort( sorted.begin(), sorted.end() );
+		if ( seen_faces.insert( sorted ).second )
+		    local_faces.push_back( f );
+	    }
+	}
+    }
+
+    // Every vertex, with a group element that takes v0 to it
+    PointTable vertices;
+    std::vector<Matrix4d> element( 1, identity4d() );
+    vertices.insert( v0, added );
+
+    for ( int k = 0; k < vertices.size(); ++k ) {
+	for ( int i = 0; i < 4; ++i ) {
+	    vertices.insert( reflect( vertices[k], n[i] ), added );
+	    if ( !added )
+		continue;
+	    if ( vertices.size() > 65536 )
+		return false;		// past what PolytopeIndex can hold
+	    element.push_back( reflect( element[k], n[i] ) );
+	}
+    }
+
+    // Carry the local edges and faces to every vertex.  Each edge and face
+    // turns up once per corner; keep it only at its lowest-numbered one.
+    mesh.symbol = symbol;
+    mesh.edges.clear();
+    mesh.face_indices.clear();
+    mesh.face_start.assign( 1, 0 );
+    mesh.face_kind.clear();
+
+    std::vector<int> global( local.size() );
+    for ( int k = 0; k < vertices.size(); ++k ) {
+	global[0] = k;
+	for ( int l = 1; l < local.size(); ++l ) {
+	    global[l] = vertices.find( transform( element[k], local[l] ) );
+	    if ( global[l] < 0 )
+		return false;
+	}
+
+	for ( size_t e = 0; e < local_edges.size(); ++e ) {
+	    int other = global[local_edges[e]];
+	    if ( k < other ) {
+		mesh.edges.push_back( (PolytopeIndex) k );
+		mesh.edges.push_back( (PolytopeIndex) other );
+	    }
+	}
+
+	for ( size_t f = 0; f < local_faces.size(); ++f ) {
+	    const std::vector<int>& corners = local_faces[f].corners;
+	    bool lowest = true;
+	    for ( size_t c = 1; c < corners.size() && lowest; ++c )
+		lowest = global[corners[c]] > k;
+	    if ( !lowest )
+		continue;
+
+	    for ( size_t c = 0; c < corners.size(); ++c )
+		mesh.face_indices.push_back( (PolytopeIndex) global[corners[c]] );
+	    mesh.face_start.push_back( (GLuint) mesh.face_indices.size() );
+	    mesh.face_kind.push_back( (unsigned char) local_faces[f].kind );
+	}
+    }
+
+    // Scale onto the unit sphere
+    double radius = sqrt( dot( v0, v0 ) );
+    mesh.positions.resize( 4 * vertices.size() );
+    for ( int k = 0; k < vertices.size(); ++k )
+	for ( int i = 0; i < 4; ++i )
+	    mesh.positions[4*k + i] = (GLfloat) (vertices[k].x[i] / radius);
+
+    return true;
+}
+
+size_t
+WythoffMesh::bytes() const
+{
+    return positions.size() * sizeof(GLfloat)
+	+ (edges.size() + face_indices.size()) * sizeof(PolytopeIndex)
+	+ face_start.size() * sizeof(GLuint)
+	+ face_kind.size() * sizeof(unsigned char);
+}
+
+//----------------------------------------------------------------------------
+//
+//  Disk cache: a header followed by the arrays as they are in memory.
+//    A file is written under a name of its own and renamed into place, so
+//    another run never reads one half written; and a file is only taken
+//    if its size is what the header's counts make and every index in it
+//    is in range, so a damaged one is made again instead.
+//
+
+struct WythoffFileHeader {
+    char          magic[4];	// "W4D1"
+    int           branches[3];
+    int           rings;
+    unsigned int  positions;
+    unsigned int  edges;
+    unsigned int  face_indices;
+    unsigned int  faces;
+};
+
+template <class T>
+static bool
+write_array( FILE* fp, const std::vector<T>& v )
+{
+    return v.empty() || fwrite( &v[0], sizeof(T), v.size(), fp ) == v.size();
+}
+
+template <class T>
+static bool
+read_array( FILE* fp, std::vector<T>& v, unsigned int count )
+{
+    v.resize( count );
+    return v.empty() || fread( &v[0], sizeof(T), v.size(), fp ) == v.size();
+}
+
+bool
+SaveWythoff( const WythoffMesh& mesh, const char* filename )
+{
+    char partial[512];
+    snprintf( partial, sizeof(partial), "%s.%d.tmp", filename, (int) getpid() );
+    FILE* fp = fopen( partial, "wb" );
+    if ( fp == NULL )
+	return false;
+
+    WythoffFileHeader h;
+    memcpy( h.magic, "W4D1", 4 );
+    for ( int i = 0; i < 3; ++i )
+	h.branches[i] = mesh.symbol.branches[i];
+    h.rings = mesh.symbol.rings;
+    h.positions = (unsigned int) mesh.positions.size();
+    h.edges = (unsigned int) mesh.edges.size();
+    h.face_indices = (unsigned int) mesh.face_indices.size();
+    h.faces = (unsigned int) mesh.face_kind.size();
+
+    bool ok = fwrite( &h, sizeof(h), 1, fp ) == 1
+	&& write_array( fp, mesh.positions )
+	&& write_array( fp, mesh.edges )
+	&& write_array( fp, mesh.face_indices )
+	&& write_array( fp, mesh.face_start )
+	&& write_array( fp, mesh.face_kind );
+    ok = fclose( fp ) == 0 && ok;
+
+#ifdef _WIN32
+    // rename() won't replace a file here
+    if ( ok )
+	remove( filename );
+#endif
+    if ( !ok || rename( partial, filename ) != 0 ) {
+	remove( partial );
+	return false;
+    }
+    return true;
+}
+
+//  Whether the arrays read make a mesh: every index is of a vertex, and the
+//    faces, of 3 vertices or more, cover face_indices in order
+static bool
+valid_mesh( const WythoffMesh& mesh )
+{
+    int vertices = mesh.vertex_count();
+    if ( mesh.positions.size() % 4 != 0 || mesh.edges.size() % 2 != 0 )
+	return false;
+    for ( size_t i = 0; i < mesh.edges.size(); ++i )
+	if ( mesh.edges[i] >= vertices )
+	    return false;
+    for ( size_t i = 0; i < mesh.face_indices.size(); ++i )
+	if ( mesh.face_indices[i] >= vertices )
+	    return false;
+
+    if ( mesh.face_start[0] != 0
+	 || mesh.face_start[mesh.face_count()] != mesh.face_indices.size() )
+	return false;
+    for ( int f = 0; f < mesh.face_count(); ++f )
+	if ( mesh.face_start[f + 1] < mesh.face_start[f]
+	     || mesh.face_start[f + 1] - mesh.face_start[f] < 3
+	     || mesh.face_kind[f] >= 6 )
+	    return false;
+    return true;
+}
+
+bool
+LoadWythoff( WythoffMesh& mesh, const char* filename )
+{
+    FILE* fp = fopen( filename, "rb" );
+    if ( fp == NULL )
+	return false;
+
+    // The counts must add up to the file's size before anything is
+    // allocated for them
+    WythoffFileHeader h;
+    bool ok = fread( &h, sizeof(h), 1, fp ) == 1
+	&& memcmp( h.magic, "W4D1", 4 ) == 0
+	&& fseek( fp, 0, SEEK_END ) == 0;
+    long size = ok ? ftell( fp ) : -1;
+    unsigned long long expected = sizeof(h)
+	+ (unsigned long long) h.positions * sizeof(GLfloat)
+	+ ((unsigned long long) h.edges + h.face_indices) * sizeof(PolytopeIndex)
+	+ ((unsigned long long) h.faces + 1) * sizeof(GLuint)
+	+ (unsigned long long) h.faces * sizeof(unsigned char);
+    ok = ok && size >= 0 && (unsigned long long) size == expected
+	&& fseek( fp, sizeof(h), SEEK_SET ) == 0
+	&& read_array( fp, mesh.positions, h.positions )
+	&& read_array( fp, mesh.edges, h.edges )
+	&& read_array( fp, mesh.face_indices, h.face_indices )
+	&& read_array( fp, mesh.face_start, h.faces + 1 )
+	&& read_array( fp, mesh.face_kind, h.faces );
+    fclose( fp );
+
+    ok = ok && valid_mesh( mesh );
+    if ( ok ) {
+	for ( int i = 0; i < 3; ++i )
+	    mesh.symbol.branches[i] = h.branches[i];
+	mesh.symbol.rings = h.rings;
+    }
+    return ok;
+}
+
+bool
+LoadOrMakeWythoff( WythoffMesh& mesh, const WythoffSymbol& symbol,
+		   const char* cache_dir )
+{
+    char filename[256];
+    snprintf( filename, sizeof(filename), "%s/wythoff-%d-%d-%d-%d%d%d%d.mesh",
+	      cache_dir ? cache_dir : ".",
+	      symbol.branches[0], symbol.branches[1], symbol.branches[2],
+	      symbol.rings & 1, (symbol.rings >> 1) & 1,
+	      (symbol.rings >> 2) & 1, (symbol.rings >> 3) & 1 );
+
+    if ( LoadWythoff( mesh, filename ) ) {
+	bool same = mesh.symbol.rings == symbol.rings;
+	for ( int i = 0; i < 3; ++i )
+	    same = same && mesh.symbol.branches[i] == symbol.branches[i];
+	if ( same )
+	    return true;
+    }
+
+    if ( !MakeWythoff( mesh, symbol ) )
+	return false;
+    SaveWythoff( mesh, filename );	// a failed save only costs time later
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+static const struct {
+    const char*    name;
+    WythoffSymbol  symbol;
+} named_polytopes[] = {
+    { "5-cell",                 { { 3, 3, 3 },  1 } },
+    { "rectified-5-cell",       { { 3, 3, 3 },  2 } },
+    { "truncated-5-cell",       { { 3, 3, 3 },  3 } },
+    { "tesseract",              { { 4, 3, 3 },  1 } },
+    { "rectified-tesseract",    { { 4, 3, 3 },  2 } },
+    { "truncated-tesseract",    { { 4, 3, 3 },  3 } },
+    { "runcinated-tesseract",   { { 4, 3, 3 },  9 } },
+    { "16-cell",                { { 4, 3, 3 },  8 } },
+    { "truncated-16-cell",      { { 4, 3, 3 }, 12 } },
+    { "24-cell",                { { 3, 4, 3 },  1 } },
+    { "rectified-24-cell",      { { 3, 4, 3 },  2 } },
+    { "truncated-24-cell",      { { 3, 4, 3 },  3 } },
+    { "120-cell",               { { 5, 3, 3 },  1 } },
+    { "rectified-120-cell",     { { 5, 3, 3 },  2 } },
+    { "truncated-120-cell",     { { 5, 3, 3 },  3 } },
+    { "600-cell",               { { 5, 3, 3 },  8 } },
+    { "rectified-600-cell",     { { 5, 3, 3 },  4 } },
+    { "truncated-600-cell",     { { 5, 3, 3 }, 12 } },
+    { "omnitruncated-120-cell", { { 5, 3, 3 }, 15 } },
+};
+
+//  Also accepts "p,q,r:xxxx", e.g. "5,3,3:1100", with one 0/1 per mirror
+bool
+WythoffSymbolFromName( const char* name, WythoffSymbol& symbol )
+{
+    for ( size_t i = 0; i < sizeof(named_polytopes)/sizeof(named_polytopes[0]); ++i ) {
+	if ( strcmp( name, named_polytopes[i].name ) == 0 ) {
+	    symbol = named_polytopes[i].symbol;
+	    return true;
+	}
+    }
+
+    char ring_text[5];
+    if ( sscanf( name, "%d,%d,%d:%4[01]", &symbol.branches[0], &symbol.branches[1],
+		 &symbol.branches[2], ring_text ) != 4 || strlen( ring_text ) != 4 )
+	return false;
+
+    symbol.rings = 0;
+    for ( int i = 0; i < 4; ++i )
+	if ( ring_text[i] == '1' )
+	    symbol.rings |= 1 << i;
+    return true;
+}
@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//  --- Wythoff.h ---
+//
+//   Uniform 4-polytopes by Wythoff's construction.  A linear Coxeter
+//     diagram o-p-o-q-o-r-o names a group generated by four reflections,
+//     and the ring pattern picks which mirrors the starting point lies
+//     off of (unit distance from each ringed mirror, on the others).  The
+//     polytope is the orbit of that point under the group:
+//
+//       [3,3,3]  5-cell family      [4,3,3]  tesseract / 16-cell family
+//       [3,4,3]  24-cell family     [5,3,3]  120-cell / 600-cell family
+//
+//     e.g. [5,3,3] with rings 1000 is the 120-cell, 0001 the 600-cell and
+//     1100 the truncated 120-cell.
+//
+//   Edges and 2-faces are worked out once around the starting vertex,
+//     using the subgroup that leaves it fixed, and then carried to every
+//     other vertex by that vertex's group element.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __WYTHOFF_H__
+#define __WYTHOFF_H__
+
+#include "Polytope.h"
+
+//  Bit i of the ring mask is set if mirror i (left to right in the
+//    diagram) is ringed
+struct WythoffSymbol {
+    int  branches[3];	// p, q, r
+    int  rings;
+};
+
+struct WythoffMesh {
+    WythoffSymbol               symbol;
+
+    //  4 coordinates per vertex, on the unit sphere
+    std::vector<GLfloat>        positions;
+
+    //  2 vertex indices per edge
+    std::vector<PolytopeIndex>  edges;
+
+    //  Polygons of different sizes: face f is face_indices[face_start[f]]
+    //    up to face_start[f+1], in order around its boundary.  face_kind[f]
+    //    (0..5) tells which pair of mirrors generated it, which makes a
+    //    good color key.
+    std::vector<PolytopeIndex>  face_indices;
+    std::vector<GLuint>         face_start;
+    std::vector<unsigned char>  face_kind;
+
+    int vertex_count() const { return (int) positions.size() / 4; }
+    int edge_count() const { return (int) edges.size() / 2; }
+    int face_count() const { return (int) face_kind.size(); }
+    size_t bytes() const;
+};
+
+//  Build the polytope.  Returns false if the diagram is not one of the
+//    finite groups above (or their mirror images) or no mirror is ringed.
+bool MakeWythoff( WythoffMesh& mesh, const WythoffSymbol& symbol );
+
+//  Same, but first look in the cache directory ("." if NULL) for a copy
+//    saved by an earlier run, and save one after generating
+bool LoadOrMakeWythoff( WythoffMesh& mesh, const WythoffSymbol& symbol,
+			const char* cache_dir = NULL );
+
+bool SaveWythoff( const WythoffMesh& mesh, const char* filename );
+bool LoadWythoff( WythoffMesh& mesh, const char* filename );
+
+//  Named regular and uniform 4-polytopes ("24-cell", "600-cell",
+//    "truncated-120-cell", ...); false if the name is unknown
+bool WythoffSymbolFromName( const char* name, WythoffSymbol& symbol );
+
+#endif // __WYTHOFF_H__
@@ -0,0 +1,74 @@
+#version 430
+
+// View culling on the GPU, one invocation per object.  The objects are
+// the texture buffer of vshader_instanced.glsl seen as a storage buffer,
+// 6 vec4s each: center, tint, (scale), then the sines and cosines.
+//
+// Each object gets two DrawElementsIndirectCommands -- its wireframe at
+// commands[i] and its solid at commands[objects + i] -- with an instance
+// count of 1 if it may show and 0 if not.  Their base instance is the
+// object, which picks its entry of the per-instance vObject attribute in
+// vshader_instanced.glsl.
+//
+// The test is SceneCuller's (Cull.cpp): the object's 4D bounding sphere,
+// carried through the w + 1 projection, against the frustum planes.
+
+layout( local_size_x = 64 ) in;
+
+struct DrawCommand {
+	uint  count;
+	uint  instance_count;
+	uint  first_index;
+	int   base_vertex;
+	uint  base_instance;
+};
+
+layout( std430, binding = 0 ) readonly buffer Objects {
+	vec4 objects[];
+};
+
+layout( std430, binding = 1 ) writeonly buffer Commands {
+	DrawCommand commands[];
+};
+
+layout( std430, binding = 2 ) buffer Counters {
+	uint visible;
+};
+
+uniform int object_count;
+uniform int line_indices;
+uniform int triangle_indices;
+uniform float mesh_radius;
+uniform vec4 planes[6];
+
+bool
+may_show( vec4 c, float r )
+{
+	float w = c.w + 1.0;
+	if( w + r <= 0.0 )
+		return false;
+
+	vec3 p = c.xyz*w;
+	float r3 = r*(length( vec4( c.xyz, w ) ) + r);
+	for( int k=0; k<6; k++ )
+		if( dot( planes[k].xyz, p ) + planes[k].w < -r3 )
+			return false;
+	return true;
+}
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	uint n = uint( object_count );
+	if( i >= n )
+		return;
+
+	vec4 center = objects[6*i];
+	float scale = objects[6*i + 2].x;
+	uint shown = may_show( center, mesh_radius*scale ) ? 1u : 0u;
+	if( shown != 0u )
+		atomicAdd( visible, 1u );
+
+	commands[i] = DrawCommand( uint( line_indices ), shown, 0u, 0, i );
+	commands[n + i] = DrawCommand( uint( triangle_indices ), shown, 0u, 0, i );
+}
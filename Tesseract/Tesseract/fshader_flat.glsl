@@ -0,0 +1,10 @@
+#version 150
+
+flat in vec4 color;
+out vec4 fColor;
+
+void
+main()
+{
+	fColor=color;
+}
@@ -0,0 +1,19 @@
+#version 150
+
+// A tile of the impostor atlas: cleared to alpha 0, so whatever the object
+// covered has some alpha and the rest is cut away.  The faces' alpha is
+// 0.3, so a sample filtered mostly from outside the object is cut too.
+
+in  vec2 coord;
+out vec4 fColor;
+
+uniform sampler2D atlas;
+
+void
+main()
+{
+	vec4 c = texture( atlas, coord );
+	if( c.a < 0.1 )
+		discard;
+	fColor = vec4( c.rgb, 1.0 );
+}
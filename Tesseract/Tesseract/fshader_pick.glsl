@@ -0,0 +1,18 @@
+#version 410
+
+// The solid pass with picking on (-pick): the color as fshader.glsl has
+// it, and into the scene target's ID attachment the object, counted from
+// 1 so that 0 is nothing, and the triangle of its draw.
+
+in  vec4 color;
+layout(location = 0) out vec4 fColor;
+layout(location = 1) out uvec2 fId;
+
+uniform uint object;
+
+void
+main()
+{
+	fColor = color;
+	fId = uvec2( object, uint( gl_PrimitiveID ) );
+}
@@ -0,0 +1,30 @@
+#version 150
+
+// Stretch the scene, drawn at a fraction of the window's size, over the
+// window: a bilinear sample, sharpened by the difference from its four
+// neighbors a source texel away.  The more the scene is stretched, the
+// more "sharpness" there is; 0 is plain bilinear.
+
+in  vec2 coord;
+out vec4 fColor;
+
+uniform sampler2D scene;
+uniform vec2 texel;        // one source texel, in texture coordinates
+uniform vec2 region;
+uniform float sharpness;
+
+vec3
+fetch( vec2 at )
+{
+	// Stay inside the part drawn this frame
+	return texture( scene, clamp( at, 0.5*texel, region - 0.5*texel ) ).rgb;
+}
+
+void
+main()
+{
+	vec3 c = fetch( coord );
+	vec3 around = fetch( coord + vec2( texel.x, 0.0 ) ) + fetch( coord - vec2( texel.x, 0.0 ) )
+		+ fetch( coord + vec2( 0.0, texel.y ) ) + fetch( coord - vec2( 0.0, texel.y ) );
+	fColor = vec4( clamp( c + sharpness*(c - 0.25*around), 0.0, 1.0 ), 1.0 );
+}
@@ -0,0 +1,43 @@
+#version 150
+
+// Ray march through the box [-0.5, 0.5]^3 between two frames of a
+// streamed volume, blended by "between": the slice of the 4D dataset at
+// a w between the two.  Every face of the box is drawn, and the fragment
+// where the ray leaves the box does the marching, so each pixel is
+// marched once whether the eye is outside the box or in it.
+
+in  vec3 position;
+out vec4 fColor;
+
+uniform vec4 eye;          // in object space
+uniform sampler3D frame0;
+uniform sampler3D frame1;
+uniform float between;
+uniform int steps;
+
+void
+main()
+{
+	vec3 from = eye.xyz;
+	vec3 dir = normalize( position - from );
+	vec3 t0 = (vec3( -0.5 ) - from) / dir;
+	vec3 t1 = (vec3( 0.5 ) - from) / dir;
+	vec3 near = min( t0, t1 ), far = max( t0, t1 );
+	float enter = max( max( max( near.x, near.y ), near.z ), 0.0 );
+	float leave = min( min( far.x, far.y ), far.z );
+
+	if( distance( position, from ) < leave - 1.0e-3 )
+		discard;
+
+	// Front to back, premultiplied
+	float dt = (leave - enter) / float( steps );
+	vec4 sum = vec4( 0.0 );
+	for( int i=0; i<steps && sum.a < 0.99; i++ )
+	{
+		vec3 p = from + (enter + (float( i ) + 0.5)*dt)*dir + 0.5;
+		float d = mix( texture( frame0, p ).r, texture( frame1, p ).r, between );
+		vec4 c = vec4( d, d*d, 1.0 - d, d*0.2 );
+		sum += (1.0 - sum.a)*vec4( c.rgb*c.a, c.a );
+	}
+	fColor = sum;
+}
@@ -2,6 +2,14 @@
 //
 //  --- mat.h ---
 //
+//   mat<N,T> -- an N x N matrix stored as N row vectors, with the same
+//     constexpr, component-by-component operations as vec<N,T>.  mat2,
+//     mat3 and mat4 are the GLfloat instances; mat5 holds the homogeneous
+//     form of 4D affine transforms.
+//
+//   mat4 * vec4 and mat4 * mat4 have SSE versions, used whenever the
+//     product is not being worked out at compile time.
+//
 //////////////////////////////////////////////////////////////////////////////
 
 #ifndef __ANGEL_MAT_H__
@@ -10,562 +18,339 @@
 #include "vec.h"
 #include <stdio.h>
 
-namespace Angel {
-
-//----------------------------------------------------------------------------
-//
-//  mat2 - 2D square matrix
-//
-
-class mat2 {
-
-    vec2  _m[2];
-
-   public:
-    //
-    //  --- Constructors and Destructors ---
-    //
-
-    mat2( const GLfloat d = GLfloat(1.0) )  // Create a diagional matrix
-	{ _m[0].x = d;  _m[1].y = d;   }
-
-    mat2( const vec2& a, const vec2& b )
-	{ _m[0] = a;  _m[1] = b;  }
-
-    mat2( GLfloat m00, GLfloat m10, GLfloat m01, GLfloat m11 )
-	{ _m[0] = vec2( m00, m01 ); _m[1] = vec2( m10, m11 ); }
-
-    mat2( const mat2& m ) {
-	if ( *this != m ) {
-	    _m[0] = m._m[0];
-	    _m[1] = m._m[1];
-	} 
-    }
-
-    //
-    //  --- Indexing Operator ---
-    //
-
-    vec2& operator [] ( int i ) { return _m[i]; }
-    const vec2& operator [] ( int i ) const { return _m[i]; }
-
-    //
-    //  --- (non-modifying) Arithmatic Operators ---
-    //
-
-    mat2 operator + ( const mat2& m ) const
-	{ return mat2( _m[0]+m[0], _m[1]+m[1] ); }
-
-    mat2 operator - ( const mat2& m ) const
-	{ return mat2( _m[0]-m[0], _m[1]-m[1] ); }
-
-    mat2 operator * ( const GLfloat s ) const 
-	{ return mat2( s*_m[0], s*_m[1] ); }
-
-    mat2 operator / ( const GLfloat s ) const {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	    return mat2();
-	}
-#endif // DEBUG
-	
-	GLfloat r = GLfloat(1.0) / s;
-	return *this * r;
-    }
-
-    friend mat2 operator * ( const GLfloat s, const mat2& m )
-	{ return m * s; }
-	
-    mat2 operator * ( const mat2& m ) const {
-	mat2  a( 0.0 );
-
-	for ( int i = 0; i < 2; ++i ) {
-	    for ( int j = 0; j < 2; ++j ) {
-		for ( int k = 0; k < 2; ++k ) {
-		    a[i][j] += _m[i][k] * m[k][j];
-		}
-	    }
-	}
-
-	return a;
-    }
-
-    //
-    //  --- (modifying) Arithmetic Operators ---
-    //
-
-    mat2& operator += ( const mat2& m ) {
-	_m[0] += m[0];  _m[1] += m[1];  
-	return *this;
-    }
-
-    mat2& operator -= ( const mat2& m ) {
-	_m[0] -= m[0];  _m[1] -= m[1];  
-	return *this;
-    }
-
-    mat2& operator *= ( const GLfloat s ) {
-	_m[0] *= s;  _m[1] *= s;   
-	return *this;
-    }
-
-    mat2& operator *= ( const mat2& m ) {
-	mat2  a( 0.0 );
-
-	for ( int i = 0; i < 2; ++i ) {
-	    for ( int j = 0; j < 2; ++j ) {
-		for ( int k = 0; k < 2; ++k ) {
-		    a[i][j] += _m[i][k] * m[k][j];
-		}
-	    }
-	}
+#if ANGEL_SIMD
+#include <xmmintrin.h>
+#endif
 
-	return *this = a;
-    }
-    
-    mat2& operator /= ( const GLfloat s ) {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	    return mat2();
-	}
-#endif // DEBUG
+namespace Angel {
 
-	GLfloat r = GLfloat(1.0) / s;
-	return *this *= r;
-    }
+template <int N, class T = GLfloat> class mat;
 
-    //
-    //  --- Matrix / Vector operators ---
-    //
-
-    vec2 operator * ( const vec2& v ) const {  // m * v
-	return vec2( _m[0][0]*v.x + _m[0][1]*v.y,
-		     _m[1][0]*v.x + _m[1][1]*v.y );
-    }
-	
-    //
-    //  --- Insertion and Extraction Operators ---
-    //
-	
-    friend std::ostream& operator << ( std::ostream& os, const mat2& m )
-	{ return os << std::endl << m[0] << std::endl << m[1] << std::endl; }
+namespace detail {
 
-    friend std::istream& operator >> ( std::istream& is, mat2& m )
-	{ return is >> m._m[0] >> m._m[1] ; }
+struct diagonal_tag {};
+struct rows_tag {};
 
-    //
-    //  --- Conversion Operators ---
-    //
+template <class T, int K>
+struct array {
+    T  e[K];
+};
 
-    operator const GLfloat* () const
-	{ return static_cast<const GLfloat*>( &_m[0].x ); }
+//  Row i of the diagonal matrix d*I
+template <int N, class T, std::size_t... J>
+constexpr vec<N, T> diagonal_row( int i, T d, std::index_sequence<J...> )
+    { return vec<N, T>( components_tag(), (int(J) == i ? d : T(0))... ); }
 
-    operator GLfloat* ()
-	{ return static_cast<GLfloat*>( &_m[0].x ); }
-};
+//  Row i of a matrix whose elements are listed column by column
+template <int N, class T, std::size_t... J>
+constexpr vec<N, T> column_major_row( const array<T, N*N>& a, int i,
+				      std::index_sequence<J...> )
+    { return vec<N, T>( components_tag(), a.e[J*N + i]... ); }
 
-//
-//  --- Non-class mat2 Methods ---
-//
+//  Whether mat<N,T> has the SSE products below
+template <int N, class T>
+struct simd_mat : std::integral_constant<bool, ANGEL_SIMD && N == 4 &&
+					 std::is_same<T, float>::value> {};
 
-inline
-mat2 matrixCompMult( const mat2& A, const mat2& B ) {
-    return mat2( A[0][0]*B[0][0], A[0][1]*B[0][1],
-		 A[1][0]*B[1][0], A[1][1]*B[1][1] );
-}
+#if ANGEL_SIMD
+mat<4, float> sse_product( const mat<4, float>& a, const mat<4, float>& b );
+vec<4, float> sse_product( const mat<4, float>& a, const vec<4, float>& v );
+#endif
 
-inline
-mat2 transpose( const mat2& A ) {
-    return mat2( A[0][0], A[1][0],
-		 A[0][1], A[1][1] );
-}
+}  // namespace detail
 
-//----------------------------------------------------------------------------
+//////////////////////////////////////////////////////////////////////////////
 //
-//  mat3 - 3D square matrix 
+//  mat<N,T> - N x N square matrix
 //
 
-class mat3 {
+template <int N, class T>
+class mat {
 
-    vec3  _m[3];
+    vec<N, T>  _m[N];
 
    public:
+    typedef T  value_type;
+    enum { dimension = N };
+
     //
     //  --- Constructors and Destructors ---
     //
 
-    mat3( const GLfloat d = GLfloat(1.0) )  // Create a diagional matrix
-	{ _m[0].x = d;  _m[1].y = d;  _m[2].z = d;   }
+    constexpr mat( const T d = T(1.0) ) :  // Create a diagional matrix
+	mat( detail::diagonal_tag(), d, std::make_index_sequence<N>() ) {}
 
-    mat3( const vec3& a, const vec3& b, const vec3& c )
-	{ _m[0] = a;  _m[1] = b;  _m[2] = c;  }
+    //  One vec per row
+    template <class... R,
+	      typename std::enable_if<(N > 1 && sizeof...(R) + 1 == N),
+				      int>::type = 0>
+    constexpr mat( const vec<N, T>& first, const R&... rest ) :
+	_m{ first, rest... } {}
 
-    mat3( GLfloat m00, GLfloat m10, GLfloat m20,
-	  GLfloat m01, GLfloat m11, GLfloat m21,
-	  GLfloat m02, GLfloat m12, GLfloat m22 ) 
-	{
-	    _m[0] = vec3( m00, m01, m02 );
-	    _m[1] = vec3( m10, m11, m12 );
-	    _m[2] = vec3( m20, m21, m22 );
-	}
-
-    mat3( const mat3& m )
-	{
-	    if ( *this != m ) {
-		_m[0] = m._m[0];
-		_m[1] = m._m[1];
-		_m[2] = m._m[2];
-	    } 
-	}
+    //  All N*N elements, listed column by column: mat2( m00, m10, m01, m11 )
+    template <class... A,
+	      typename std::enable_if<(N > 1 && sizeof...(A) + 1 == N*N),
+				      int>::type = 0>
+    constexpr mat( T first, A... rest ) :
+	mat( detail::array<T, N*N>{ { first, T(rest)... } },
+	     std::make_index_sequence<N>() ) {}
 
     //
     //  --- Indexing Operator ---
     //
 
-    vec3& operator [] ( int i ) { return _m[i]; }
-    const vec3& operator [] ( int i ) const { return _m[i]; }
+    constexpr vec<N, T>& operator [] ( int i ) { return _m[i]; }
+    constexpr const vec<N, T>& operator [] ( int i ) const { return _m[i]; }
 
     //
-    //  --- (non-modifying) Arithmatic Operators ---
+    //  --- (non-modifying) Arithematic Operators ---
     //
 
-    mat3 operator + ( const mat3& m ) const
-	{ return mat3( _m[0]+m[0], _m[1]+m[1], _m[2]+m[2] ); }
+    constexpr mat operator + ( const mat& m ) const
+	{ return rows( m, detail::plus(), std::make_index_sequence<N>() ); }
 
-    mat3 operator - ( const mat3& m ) const
-	{ return mat3( _m[0]-m[0], _m[1]-m[1], _m[2]-m[2] ); }
+    constexpr mat operator - ( const mat& m ) const
+	{ return rows( m, detail::minus(), std::make_index_sequence<N>() ); }
 
-    mat3 operator * ( const GLfloat s ) const 
-	{ return mat3( s*_m[0], s*_m[1], s*_m[2] ); }
+    constexpr mat operator * ( const T s ) const
+	{ return scaled( s, std::make_index_sequence<N>() ); }
 
-    mat3 operator / ( const GLfloat s ) const {
+    constexpr mat operator / ( const T s ) const {
 #ifdef DEBUG
 	if ( std::fabs(s) < DivideByZeroTolerance ) {
 	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
 		      << "Division by zero" << std::endl;
-	    return mat3();
+	    return mat();
 	}
 #endif // DEBUG
-	
-	GLfloat r = GLfloat(1.0) / s;
+
+	T r = T(1.0) / s;
 	return *this * r;
     }
 
-    friend mat3 operator * ( const GLfloat s, const mat3& m )
+    friend constexpr mat operator * ( const T s, const mat& m )
 	{ return m * s; }
-	
-    mat3 operator * ( const mat3& m ) const {
-	mat3  a( 0.0 );
-
-	for ( int i = 0; i < 3; ++i ) {
-	    for ( int j = 0; j < 3; ++j ) {
-		for ( int k = 0; k < 3; ++k ) {
-		    a[i][j] += _m[i][k] * m[k][j];
-		}
-	    }
-	}
 
-	return a;
-    }
+    constexpr mat operator * ( const mat& m ) const
+	{ return product( m, detail::simd_mat<N, T>() ); }
 
     //
-    //  --- (modifying) Arithmetic Operators ---
+    //  --- (modifying) Arithematic Operators ---
     //
 
-    mat3& operator += ( const mat3& m ) {
-	_m[0] += m[0];  _m[1] += m[1];  _m[2] += m[2]; 
-	return *this;
-    }
+    constexpr mat& operator += ( const mat& m )
+	{ return *this = *this + m; }
 
-    mat3& operator -= ( const mat3& m ) {
-	_m[0] -= m[0];  _m[1] -= m[1];  _m[2] -= m[2]; 
-	return *this;
-    }
+    constexpr mat& operator -= ( const mat& m )
+	{ return *this = *this - m; }
 
-    mat3& operator *= ( const GLfloat s ) {
-	_m[0] *= s;  _m[1] *= s;  _m[2] *= s; 
-	return *this;
-    }
+    constexpr mat& operator *= ( const T s )
+	{ return *this = *this * s; }
 
-    mat3& operator *= ( const mat3& m ) {
-	mat3  a( 0.0 );
+    constexpr mat& operator *= ( const mat& m )
+	{ return *this = *this * m; }
 
-	for ( int i = 0; i < 3; ++i ) {
-	    for ( int j = 0; j < 3; ++j ) {
-		for ( int k = 0; k < 3; ++k ) {
-		    a[i][j] += _m[i][k] * m[k][j];
-		}
-	    }
-	}
-
-	return *this = a;
-    }
-
-    mat3& operator /= ( const GLfloat s ) {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	    return mat3();
-	}
-#endif // DEBUG
-
-	GLfloat r = GLfloat(1.0) / s;
-	return *this *= r;
-    }
+    constexpr mat& operator /= ( const T s )
+	{ return *this = *this / s; }
 
     //
     //  --- Matrix / Vector operators ---
     //
 
-    vec3 operator * ( const vec3& v ) const {  // m * v
-	return vec3( _m[0][0]*v.x + _m[0][1]*v.y + _m[0][2]*v.z,
-		     _m[1][0]*v.x + _m[1][1]*v.y + _m[1][2]*v.z,
-		     _m[2][0]*v.x + _m[2][1]*v.y + _m[2][2]*v.z );
-    }
-	
+    constexpr vec<N, T> operator * ( const vec<N, T>& v ) const  // m * v
+	{ return product( v, detail::simd_mat<N, T>() ); }
+
     //
     //  --- Insertion and Extraction Operators ---
     //
-	
-    friend std::ostream& operator << ( std::ostream& os, const mat3& m ) {
-	return os << std::endl 
-		  << m[0] << std::endl
-		  << m[1] << std::endl
-		  << m[2] << std::endl;
+
+    friend std::ostream& operator << ( std::ostream& os, const mat& m ) {
+	os << std::endl;
+	for ( int i = 0; i < N; ++i )
+	    os << m[i] << std::endl;
+	return os;
     }
 
-    friend std::istream& operator >> ( std::istream& is, mat3& m )
-	{ return is >> m._m[0] >> m._m[1] >> m._m[2] ; }
+    friend std::istream& operator >> ( std::istream& is, mat& m ) {
+	for ( int i = 0; i < N; ++i )
+	    is >> m._m[i];
+	return is;
+    }
 
     //
     //  --- Conversion Operators ---
     //
 
-    operator const GLfloat* () const
-	{ return static_cast<const GLfloat*>( &_m[0].x ); }
-
-    operator GLfloat* ()
-	{ return static_cast<GLfloat*>( &_m[0].x ); }
-};
-
-//
-//  --- Non-class mat3 Methods ---
-//
-
-inline
-mat3 matrixCompMult( const mat3& A, const mat3& B ) {
-    return mat3( A[0][0]*B[0][0], A[0][1]*B[0][1], A[0][2]*B[0][2],
-		 A[1][0]*B[1][0], A[1][1]*B[1][1], A[1][2]*B[1][2],
-		 A[2][0]*B[2][0], A[2][1]*B[2][1], A[2][2]*B[2][2] );
-}
-
-inline
-mat3 transpose( const mat3& A ) {
-    return mat3( A[0][0], A[1][0], A[2][0],
-		 A[0][1], A[1][1], A[2][1],
-		 A[0][2], A[1][2], A[2][2] );
-}
+    operator const T* () const
+	{ return static_cast<const T*>( _m[0] ); }
 
-//----------------------------------------------------------------------------
-//
-//  mat4.h - 4D square matrix
-//
+    operator T* ()
+	{ return static_cast<T*>( _m[0] ); }
 
-class mat4 {
+   private:
+    template <std::size_t... I>
+    constexpr mat( detail::diagonal_tag, T d, std::index_sequence<I...> ) :
+	_m{ detail::diagonal_row<N, T>( I, d,
+					std::make_index_sequence<N>() )... } {}
 
-    vec4  _m[4];
+    template <std::size_t... I>
+    constexpr mat( const detail::array<T, N*N>& a,
+		   std::index_sequence<I...> ) :
+	_m{ detail::column_major_row<N, T>( a, I,
+					    std::make_index_sequence<N>() )... } {}
 
-   public:
-    //
-    //  --- Constructors and Destructors ---
-    //
+    template <class... R>
+    constexpr mat( detail::rows_tag, const R&... rows ) :
+	_m{ rows... } {}
 
-    mat4( const GLfloat d = GLfloat(1.0) )  // Create a diagional matrix
-	{ _m[0].x = d;  _m[1].y = d;  _m[2].z = d;  _m[3].w = d; }
-
-    mat4( const vec4& a, const vec4& b, const vec4& c, const vec4& d )
-	{ _m[0] = a;  _m[1] = b;  _m[2] = c;  _m[3] = d; }
-
-    mat4( GLfloat m00, GLfloat m10, GLfloat m20, GLfloat m30,
-	  GLfloat m01, GLfloat m11, GLfloat m21, GLfloat m31,
-	  GLfloat m02, GLfloat m12, GLfloat m22, GLfloat m32,
-	  GLfloat m03, GLfloat m13, GLfloat m23, GLfloat m33 )
-	{
-	    _m[0] = vec4( m00, m01, m02, m03 );
-	    _m[1] = vec4( m10, m11, m12, m13 );
-	    _m[2] = vec4( m20, m21, m22, m23 );
-	    _m[3] = vec4( m30, m31, m32, m33 );
-	}
+    template <class F, std::size_t... I>
+    constexpr mat rows( const mat& m, F f, std::index_sequence<I...> ) const
+	{ return mat( detail::rows_tag(), _m[I].zip( m._m[I], f )... ); }
 
-    mat4( const mat4& m )
-	{
-	    if ( *this != m ) {
-		_m[0] = m._m[0];
-		_m[1] = m._m[1];
-		_m[2] = m._m[2];
-		_m[3] = m._m[3];
-	    } 
-	}
+    template <std::size_t... I>
+    constexpr mat scaled( T s, std::index_sequence<I...> ) const
+	{ return mat( detail::rows_tag(), (_m[I] * s)... ); }
 
-    //
-    //  --- Indexing Operator ---
-    //
+    //  Row i of this * m: row i's elements weighting the rows of m
+    template <std::size_t... K>
+    constexpr vec<N, T> product_row( const mat& m, int i,
+				     std::index_sequence<K...> ) const
+	{ return detail::sum( (m._m[K] * _m[i].at(K))... ); }
 
-    vec4& operator [] ( int i ) { return _m[i]; }
-    const vec4& operator [] ( int i ) const { return _m[i]; }
+    template <std::size_t... I>
+    constexpr mat product( const mat& m, std::index_sequence<I...> ) const {
+	return mat( detail::rows_tag(),
+		    product_row( m, I, std::make_index_sequence<N>() )... );
+    }
 
-    //
-    //  --- (non-modifying) Arithematic Operators ---
-    //
+    template <std::size_t... I>
+    constexpr vec<N, T> product( const vec<N, T>& v,
+				 std::index_sequence<I...> ) const
+	{ return vec<N, T>( detail::components_tag(), dot( _m[I], v )... ); }
 
-    mat4 operator + ( const mat4& m ) const
-	{ return mat4( _m[0]+m[0], _m[1]+m[1], _m[2]+m[2], _m[3]+m[3] ); }
+    constexpr mat product( const mat& m, std::false_type ) const
+	{ return product( m, std::make_index_sequence<N>() ); }
 
-    mat4 operator - ( const mat4& m ) const
-	{ return mat4( _m[0]-m[0], _m[1]-m[1], _m[2]-m[2], _m[3]-m[3] ); }
+    constexpr vec<N, T> product( const vec<N, T>& v, std::false_type ) const
+	{ return product( v, std::make_index_sequence<N>() ); }
 
-    mat4 operator * ( const GLfloat s ) const 
-	{ return mat4( s*_m[0], s*_m[1], s*_m[2], s*_m[3] ); }
+#if ANGEL_SIMD
+    constexpr mat product( const mat& m, std::true_type ) const {
+	if ( !ANGEL_CONSTANT_EVALUATED() )
+	    return detail::sse_product( *this, m );
+	return product( m, std::make_index_sequence<N>() );
+    }
 
-    mat4 operator / ( const GLfloat s ) const {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	    return mat4();
-	}
-#endif // DEBUG
-	
-	GLfloat r = GLfloat(1.0) / s;
-	return *this * r;
+    constexpr vec<N, T> product( const vec<N, T>& v, std::true_type ) const {
+	if ( !ANGEL_CONSTANT_EVALUATED() )
+	    return detail::sse_product( *this, v );
+	return product( v, std::make_index_sequence<N>() );
     }
+#endif
+};
 
-    friend mat4 operator * ( const GLfloat s, const mat4& m )
-	{ return m * s; }
-	
-    mat4 operator * ( const mat4& m ) const {
-	mat4  a( 0.0 );
-
-	for ( int i = 0; i < 4; ++i ) {
-	    for ( int j = 0; j < 4; ++j ) {
-		for ( int k = 0; k < 4; ++k ) {
-		    a[i][j] += _m[i][k] * m[k][j];
-		}
-	    }
-	}
+//
+//  --- Non-class mat Methods ---
+//
 
-	return a;
-    }
+namespace detail {
 
-    //
-    //  --- (modifying) Arithematic Operators ---
-    //
+template <int N, class T, std::size_t... I>
+constexpr mat<N, T> matrixCompMult( const mat<N, T>& A, const mat<N, T>& B,
+				    std::index_sequence<I...> )
+    { return mat<N, T>( (A[I] * B[I])... ); }
 
-    mat4& operator += ( const mat4& m ) {
-	_m[0] += m[0];  _m[1] += m[1];  _m[2] += m[2];  _m[3] += m[3];
-	return *this;
-    }
+template <int N, class T, std::size_t... J>
+constexpr vec<N, T> column( const mat<N, T>& A, int i,
+			    std::index_sequence<J...> )
+    { return vec<N, T>( components_tag(), A[J].at(i)... ); }
 
-    mat4& operator -= ( const mat4& m ) {
-	_m[0] -= m[0];  _m[1] -= m[1];  _m[2] -= m[2];  _m[3] -= m[3];
-	return *this;
-    }
+template <int N, class T, std::size_t... I>
+constexpr mat<N, T> transpose( const mat<N, T>& A, std::index_sequence<I...> )
+    { return mat<N, T>( column( A, I, std::make_index_sequence<N>() )... ); }
 
-    mat4& operator *= ( const GLfloat s ) {
-	_m[0] *= s;  _m[1] *= s;  _m[2] *= s;  _m[3] *= s;
-	return *this;
-    }
+}  // namespace detail
 
-    mat4& operator *= ( const mat4& m ) {
-	mat4  a( 0.0 );
+template <int N, class T>
+constexpr mat<N, T> matrixCompMult( const mat<N, T>& A, const mat<N, T>& B ) {
+    return detail::matrixCompMult( A, B, std::make_index_sequence<N>() );
+}
 
-	for ( int i = 0; i < 4; ++i ) {
-	    for ( int j = 0; j < 4; ++j ) {
-		for ( int k = 0; k < 4; ++k ) {
-		    a[i][j] += _m[i][k] * m[k][j];
-		}
-	    }
-	}
+template <int N, class T>
+constexpr mat<N, T> transpose( const mat<N, T>& A ) {
+    return detail::transpose( A, std::make_index_sequence<N>() );
+}
 
-	return *this = a;
-    }
+//----------------------------------------------------------------------------
+//
+//  SSE products for mat4.  Rows are gathered with _mm_set_ps rather than
+//    loaded: a mat4 is only guaranteed the alignment of a GLfloat, and the
+//    rows are often still in registers from building them.
+//
 
-    mat4& operator /= ( const GLfloat s ) {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	    return mat4();
-	}
-#endif // DEBUG
+#if ANGEL_SIMD
 
-	GLfloat r = GLfloat(1.0) / s;
-	return *this *= r;
-    }
+namespace detail {
 
-    //
-    //  --- Matrix / Vector operators ---
-    //
+inline __m128
+load( const vec<4, float>& v )
+{
+    return _mm_set_ps( v.w, v.z, v.y, v.x );
+}
 
-    vec4 operator * ( const vec4& v ) const {  // m * v
-	return vec4( _m[0][0]*v.x + _m[0][1]*v.y + _m[0][2]*v.z + _m[0][3]*v.w,
-		     _m[1][0]*v.x + _m[1][1]*v.y + _m[1][2]*v.z + _m[1][3]*v.w,
-		     _m[2][0]*v.x + _m[2][1]*v.y + _m[2][2]*v.z + _m[2][3]*v.w,
-		     _m[3][0]*v.x + _m[3][1]*v.y + _m[3][2]*v.z + _m[3][3]*v.w
-	    );
-    }
-	
-    //
-    //  --- Insertion and Extraction Operators ---
-    //
-	
-    friend std::ostream& operator << ( std::ostream& os, const mat4& m ) {
-	return os << std::endl 
-		  << m[0] << std::endl
-		  << m[1] << std::endl
-		  << m[2] << std::endl
-		  << m[3] << std::endl;
+inline mat<4, float>
+sse_product( const mat<4, float>& a, const mat<4, float>& b )
+{
+    __m128 b0 = load( b[0] );
+    __m128 b1 = load( b[1] );
+    __m128 b2 = load( b[2] );
+    __m128 b3 = load( b[3] );
+
+    mat<4, float> c;
+    float* pc = c;
+    for ( int i = 0; i < 4; ++i ) {
+	__m128 row = load( a[i] );
+	__m128 r = _mm_mul_ps( _mm_shuffle_ps( row, row, 0x00 ), b0 );
+	r = _mm_add_ps( r, _mm_mul_ps( _mm_shuffle_ps( row, row, 0x55 ), b1 ) );
+	r = _mm_add_ps( r, _mm_mul_ps( _mm_shuffle_ps( row, row, 0xaa ), b2 ) );
+	r = _mm_add_ps( r, _mm_mul_ps( _mm_shuffle_ps( row, row, 0xff ), b3 ) );
+	_mm_storeu_ps( pc + 4*i, r );
     }
+    return c;
+}
 
-    friend std::istream& operator >> ( std::istream& is, mat4& m )
-	{ return is >> m._m[0] >> m._m[1] >> m._m[2] >> m._m[3]; }
-
-    //
-    //  --- Conversion Operators ---
-    //
+inline vec<4, float>
+sse_product( const mat<4, float>& a, const vec<4, float>& v )
+{
+    __m128 c0 = load( a[0] );
+    __m128 c1 = load( a[1] );
+    __m128 c2 = load( a[2] );
+    __m128 c3 = load( a[3] );
+    _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );	// rows to columns
+
+    __m128 r = _mm_mul_ps( c0, _mm_set1_ps( v.x ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c1, _mm_set1_ps( v.y ) ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c2, _mm_set1_ps( v.z ) ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c3, _mm_set1_ps( v.w ) ) );
+
+    vec<4, float> out;
+    _mm_storeu_ps( out, r );
+    return out;
+}
 
-    operator const GLfloat* () const
-	{ return static_cast<const GLfloat*>( &_m[0].x ); }
+}  // namespace detail
 
-    operator GLfloat* ()
-	{ return static_cast<GLfloat*>( &_m[0].x ); }
-};
+#endif // ANGEL_SIMD
 
-//
-//  --- Non-class mat4 Methods ---
-//
+//----------------------------------------------------------------------------
 
-inline
-mat4 matrixCompMult( const mat4& A, const mat4& B ) {
-    return mat4(
-	A[0][0]*B[0][0], A[0][1]*B[0][1], A[0][2]*B[0][2], A[0][3]*B[0][3],
-	A[1][0]*B[1][0], A[1][1]*B[1][1], A[1][2]*B[1][2], A[1][3]*B[1][3],
-	A[2][0]*B[2][0], A[2][1]*B[2][1], A[2][2]*B[2][2], A[2][3]*B[2][3],
-	A[3][0]*B[3][0], A[3][1]*B[3][1], A[3][2]*B[3][2], A[3][3]*B[3][3] );
-}
+typedef mat<2, GLfloat>  mat2;
+typedef mat<3, GLfloat>  mat3;
+typedef mat<4, GLfloat>  mat4;
+typedef mat<5, GLfloat>  mat5;
 
-inline
-mat4 transpose( const mat4& A ) {
-    return mat4( A[0][0], A[1][0], A[2][0], A[3][0],
-		 A[0][1], A[1][1], A[2][1], A[3][1],
-		 A[0][2], A[1][2], A[2][2], A[3][2],
-		 A[0][3], A[1][3], A[2][3], A[3][3] );
-}
+//  Uploaded with glUniformMatrix4fv
+static_assert( sizeof(mat4) == 16 * sizeof(GLfloat), "mat4 must be packed" );
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -636,7 +421,7 @@ mat4 RotateZ( const GLfloat theta )
 //  Translation matrix generators
 //
 
-inline
+constexpr
 mat4 Translate( const GLfloat x, const GLfloat y, const GLfloat z )
 {
     mat4 c;
@@ -646,13 +431,13 @@ mat4 Translate( const GLfloat x, const GLfloat y, const GLfloat z )
     return c;
 }
 
-inline
+constexpr
 mat4 Translate( const vec3& v )
 {
     return Translate( v.x, v.y, v.z );
 }
 
-inline
+constexpr
 mat4 Translate( const vec4& v )
 {
     return Translate( v.x, v.y, v.z );
@@ -663,7 +448,7 @@ mat4 Translate( const vec4& v )
 //  Scale matrix generators
 //
 
-inline
+constexpr
 mat4 Scale( const GLfloat x, const GLfloat y, const GLfloat z )
 {
     mat4 c;
@@ -673,12 +458,35 @@ mat4 Scale( const GLfloat x, const GLfloat y, const GLfloat z )
     return c;
 }
 
-inline
+constexpr
 mat4 Scale( const vec3& v )
 {
     return Scale( v.x, v.y, v.z );
 }
 
+//----------------------------------------------------------------------------
+//
+//  4D affine transformations, as 5x5 matrices acting on vec5( p, 1.0 )
+//
+
+constexpr
+mat5 Affine4D( const mat4& linear, const vec4& offset = vec4( 0.0 ) )
+{
+    mat5 c;
+    for ( int i = 0; i < 4; ++i ) {
+	for ( int j = 0; j < 4; ++j )
+	    c[i][j] = linear[i][j];
+	c[i][4] = offset[i];
+    }
+    return c;
+}
+
+constexpr
+mat5 Translate4D( const vec4& v )
+{
+    return Affine4D( mat4(), v );
+}
+
 //----------------------------------------------------------------------------
 //
 //  Projection transformation matrix geneartors
@@ -690,7 +498,7 @@ mat4 Scale( const vec3& v )
 
 
 
-inline
+constexpr
 mat4 Ortho( const GLfloat left, const GLfloat right,
 	    const GLfloat bottom, const GLfloat top,
 	    const GLfloat zNear, const GLfloat zFar )
@@ -706,14 +514,14 @@ mat4 Ortho( const GLfloat left, const GLfloat right,
     return c;
 }
 
-inline
+constexpr
 mat4 Ortho2D( const GLfloat left, const GLfloat right,
 	      const GLfloat bottom, const GLfloat top )
 {
     return Ortho( left, right, bottom, top, -1.0, 1.0 );
 }
 
-inline
+constexpr
 mat4 Frustum( const GLfloat left, const GLfloat right,
 	      const GLfloat bottom, const GLfloat top,
 	      const GLfloat zNear, const GLfloat zFar )
@@ -754,16 +562,14 @@ inline
 mat4 LookAt( const vec4& eye, const vec4& at, const vec4& up )
 {
     vec4 n = normalize(at - eye);
-    vec4 u = normalize(cross(up,n));
-    vec4 v = normalize(cross(n,u));
-
-	//Make sure n, u, and w all represent vectors
-	n.w = 0;
-	u.w = 0;
-	v.w = 0;
+    vec3 u = normalize(cross(up,n));
+    vec3 v = normalize(cross(n,vec4(u, 0.0)));
 
+	//Make sure n, u, and w all represent vectors.  Built whole rather
+	//than by setting w afterwards, which would leave the SSE product
+	//reading back a vector that was just written a float at a time.
     vec4 t = vec4(0.0, 0.0, 0.0, 1.0);
-    mat4 c = mat4(u, v, n, t);
+    mat4 c = mat4(vec4(u, 0.0), vec4(v, 0.0), vec4(n.x, n.y, n.z, 0.0), t);
     return c * Translate( eye );
 }
 
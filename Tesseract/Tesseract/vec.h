@@ -2,217 +2,252 @@
 //
 //  --- vec.h ---
 //
+//   vec<N,T> -- an N component vector, with N fixed at compile time.  Every
+//     operation is spelled out component by component through an index
+//     sequence, so there are no loops left for the compiler to unroll, and
+//     all of them are constexpr.
+//
+//   vec2, vec3 and vec4 are the GLfloat instances.  They keep the x, y, z
+//     and w members and the constructors they have always had (including
+//     vec4( x, y, z ) setting w to 1).
+//
 //////////////////////////////////////////////////////////////////////////////
 
 #ifndef __ANGEL_VEC_H__
 #define __ANGEL_VEC_H__
 
 #include "Angel.h"
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+//  The SSE versions of the N = 4 float operations (see mat.h) can only be
+//    used outside of constant expressions, so they need a compiler that can
+//    tell the two apart.  Define ANGEL_NO_SIMD to turn them off.
+#if !defined(ANGEL_NO_SIMD) && (defined(__SSE__) || defined(_M_X64))
+#  if defined(__clang__)
+#    if __clang_major__ >= 9
+#      define ANGEL_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#    endif
+#  elif defined(__GNUC__) && __GNUC__ >= 9
+#    define ANGEL_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#  endif
+#endif
+
+#ifdef ANGEL_CONSTANT_EVALUATED
+#  define ANGEL_SIMD 1
+#else
+#  define ANGEL_SIMD 0
+#endif
 
 namespace Angel {
 
-//////////////////////////////////////////////////////////////////////////////
+template <int N, class T = GLfloat> struct vec;
+
+//----------------------------------------------------------------------------
 //
-//  vec2.h - 2D vector
+//  Storage: named members for 2, 3 and 4 components, an array otherwise
 //
 
-struct vec2 {
-
-    GLfloat  x;
-    GLfloat  y;
-
-    //
-    //  --- Constructors and Destructors ---
-    //
-
-    vec2( GLfloat s = GLfloat(0.0) ) :
-	x(s), y(s) {}
-
-    vec2( GLfloat x, GLfloat y ) :
-	x(x), y(y) {}
-
-    vec2( const vec2& v )
-	{ x = v.x;  y = v.y;  }
-
-    //
-    //  --- Indexing Operator ---
-    //
-
-    GLfloat& operator [] ( int i ) { return *(&x + i); }
-    const GLfloat operator [] ( int i ) const { return *(&x + i); }
-
-    //
-    //  --- (non-modifying) Arithematic Operators ---
-    //
+namespace detail {
 
-    vec2 operator - () const // unary minus operator
-	{ return vec2( -x, -y ); }
+struct components_tag {};
+struct fill_tag {};
+struct append_tag {};
 
-    vec2 operator + ( const vec2& v ) const
-	{ return vec2( x + v.x, y + v.y ); }
+template <int N, class T>
+struct vec_storage {
+    T  e[N];
 
-    vec2 operator - ( const vec2& v ) const
-	{ return vec2( x - v.x, y - v.y ); }
+    template <class... A>
+    constexpr vec_storage( components_tag, A... a ) : e{ a... } {}
 
-    vec2 operator * ( const GLfloat s ) const
-	{ return vec2( s*x, s*y ); }
+    constexpr T& at( int i ) { return e[i]; }
+    constexpr const T& at( int i ) const { return e[i]; }
 
-    vec2 operator * ( const vec2& v ) const
-	{ return vec2( x*v.x, y*v.y ); }
-
-    friend vec2 operator * ( const GLfloat s, const vec2& v )
-	{ return v * s; }
-
-    vec2 operator / ( const GLfloat s ) const {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	    return vec2();
-	}
-#endif // DEBUG
-
-	GLfloat r = GLfloat(1.0) / s;
-	return *this * r;
-    }
-
-    //
-    //  --- (modifying) Arithematic Operators ---
-    //
+    T* data() { return e; }
+    const T* data() const { return e; }
+};
 
-    vec2& operator += ( const vec2& v )
-	{ x += v.x;  y += v.y;   return *this; }
+template <class T>
+struct vec_storage<2, T> {
+    T  x;
+    T  y;
 
-    vec2& operator -= ( const vec2& v )
-	{ x -= v.x;  y -= v.y;  return *this; }
+    constexpr vec_storage( components_tag, T x, T y ) :
+	x(x), y(y) {}
 
-    vec2& operator *= ( const GLfloat s )
-	{ x *= s;  y *= s;   return *this; }
+    constexpr T& at( int i ) { return i == 0 ? x : y; }
+    constexpr const T& at( int i ) const { return i == 0 ? x : y; }
 
-    vec2& operator *= ( const vec2& v )
-	{ x *= v.x;  y *= v.y; return *this; }
+    T* data() { return &x; }
+    const T* data() const { return &x; }
+};
 
-    vec2& operator /= ( const GLfloat s ) {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	}
-#endif // DEBUG
+template <class T>
+struct vec_storage<3, T> {
+    T  x;
+    T  y;
+    T  z;
 
-	GLfloat r = GLfloat(1.0) / s;
-	*this *= r;
+    constexpr vec_storage( components_tag, T x, T y, T z ) :
+	x(x), y(y), z(z) {}
 
-	return *this;
-    }
-	
-    //
-    //  --- Insertion and Extraction Operators ---
-    //
+    constexpr T& at( int i ) { return i == 0 ? x : i == 1 ? y : z; }
+    constexpr const T& at( int i ) const
+	{ return i == 0 ? x : i == 1 ? y : z; }
 
-    friend std::ostream& operator << ( std::ostream& os, const vec2& v ) {
-	return os << "( " << v.x << ", " << v.y <<  " )";
-    }
+    T* data() { return &x; }
+    const T* data() const { return &x; }
+};
 
-    friend std::istream& operator >> ( std::istream& is, vec2& v )
-	{ return is >> v.x >> v.y ; }
+template <class T>
+struct vec_storage<4, T> {
+    T  x;
+    T  y;
+    T  z;
+    T  w;
 
-    //
-    //  --- Conversion Operators ---
-    //
+    constexpr vec_storage( components_tag, T x, T y, T z, T w ) :
+	x(x), y(y), z(z), w(w) {}
 
-    operator const GLfloat* () const
-	{ return static_cast<const GLfloat*>( &x ); }
+    constexpr T& at( int i )
+	{ return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
+    constexpr const T& at( int i ) const
+	{ return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
 
-    operator GLfloat* ()
-	{ return static_cast<GLfloat*>( &x ); }
+    T* data() { return &x; }
+    const T* data() const { return &x; }
 };
 
-//----------------------------------------------------------------------------
-//
-//  Non-class vec2 Methods
-//
+//  a + b + c + ..., added left to right like a hand-written sum
+template <class T>
+constexpr T sum( const T& a ) { return a; }
 
-inline
-GLfloat dot( const vec2& u, const vec2& v ) {
-    return u.x * v.x + u.y * v.y;
-}
+template <class T, class... R>
+constexpr T sum( const T& a, const T& b, const R&... rest )
+    { return sum( a + b, rest... ); }
 
-inline
-GLfloat length( const vec2& v ) {
-    return std::sqrt( dot(v,v) );
-}
+//  Element-wise operations for vec::map() and vec::zip()
+struct negate {
+    template <class T> constexpr T operator () ( T a ) const { return -a; }
+};
+struct plus {
+    template <class T> constexpr T operator () ( T a, T b ) const { return a + b; }
+};
+struct minus {
+    template <class T> constexpr T operator () ( T a, T b ) const { return a - b; }
+};
+struct times {
+    template <class T> constexpr T operator () ( T a, T b ) const { return a * b; }
+};
+template <class T>
+struct scale {
+    T  s;
+    constexpr T operator () ( T a ) const { return s * a; }
+};
 
-inline
-vec2 normalize( const vec2& v ) {
-    return v / length(v);
-}
+}  // namespace detail
 
 //////////////////////////////////////////////////////////////////////////////
 //
-//  vec3.h - 3D vector
+//  vec<N,T> - N component vector
 //
-//////////////////////////////////////////////////////////////////////////////
 
-struct vec3 {
+template <int N, class T>
+struct vec : detail::vec_storage<N, T> {
 
-    GLfloat  x;
-    GLfloat  y;
-    GLfloat  z;
+    typedef T  value_type;
+    enum { dimension = N };
 
     //
     //  --- Constructors and Destructors ---
     //
 
-    vec3( GLfloat s = GLfloat(0.0) ) :
-	x(s), y(s), z(s) {}
+    constexpr vec( T s = T(0) ) :
+	vec( detail::fill_tag(), s, std::make_index_sequence<N>() ) {}
 
-    vec3( GLfloat x, GLfloat y, GLfloat z ) :
-	x(x), y(y), z(z) {}
+    //  One value per component
+    template <class... A,
+	      typename std::enable_if<(N > 1 && sizeof...(A) + 1 == N),
+				      int>::type = 0>
+    constexpr vec( T first, A... rest ) :
+	detail::vec_storage<N, T>( detail::components_tag(), first,
+				   T(rest)... ) {}
 
-    vec3( const vec3& v ) { x = v.x;  y = v.y;  z = v.z; }
+    //  A point in homogeneous coordinates: vec4( x, y, z ) has w = 1
+    template <int M = N, typename std::enable_if<M == 4, int>::type = 0>
+    constexpr vec( T x, T y, T z ) :
+	detail::vec_storage<N, T>( detail::components_tag(), x, y, z, T(1) ) {}
 
-    vec3( const vec2& v, const float f ) { x = v.x;  y = v.y;  z = f; }
+    //  One dimension down plus a last component, which again defaults to 1
+    template <int M = N, typename std::enable_if<(M > 1), int>::type = 0>
+    constexpr vec( const vec<M - 1, T>& v, T last = T(1) ) :
+	vec( detail::append_tag(), v, last,
+	     std::make_index_sequence<N - 1>() ) {}
+
+    template <int M = N, typename std::enable_if<M == 4, int>::type = 0>
+    constexpr vec( const vec<2, T>& v, T z, T w ) :
+	detail::vec_storage<N, T>( detail::components_tag(), v.x, v.y, z, w ) {}
+
+    //  Exactly N components, for generic code (works for N = 1 too)
+    template <class... A>
+    constexpr vec( detail::components_tag, T first, A... rest ) :
+	detail::vec_storage<N, T>( detail::components_tag(), first,
+				   rest... ) {}
 
     //
     //  --- Indexing Operator ---
     //
 
-    GLfloat& operator [] ( int i ) { return *(&x + i); }
-    const GLfloat operator [] ( int i ) const { return *(&x + i); }
+    constexpr T& operator [] ( int i ) {
+#if ANGEL_SIMD
+	if ( !ANGEL_CONSTANT_EVALUATED() )
+	    return this->data()[i];
+#endif
+	return this->at( i );
+    }
+
+    constexpr const T operator [] ( int i ) const {
+#if ANGEL_SIMD
+	if ( !ANGEL_CONSTANT_EVALUATED() )
+	    return this->data()[i];
+#endif
+	return this->at( i );
+    }
 
     //
     //  --- (non-modifying) Arithematic Operators ---
     //
 
-    vec3 operator - () const  // unary minus operator
-	{ return vec3( -x, -y, -z ); }
+    constexpr vec operator - () const // unary minus operator
+	{ return map( detail::negate() ); }
 
-    vec3 operator + ( const vec3& v ) const
-	{ return vec3( x + v.x, y + v.y, z + v.z ); }
+    constexpr vec operator + ( const vec& v ) const
+	{ return zip( v, detail::plus() ); }
 
-    vec3 operator - ( const vec3& v ) const
-	{ return vec3( x - v.x, y - v.y, z - v.z ); }
+    constexpr vec operator - ( const vec& v ) const
+	{ return zip( v, detail::minus() ); }
 
-    vec3 operator * ( const GLfloat s ) const
-	{ return vec3( s*x, s*y, s*z ); }
+    constexpr vec operator * ( const T s ) const
+	{ return map( detail::scale<T>{ s } ); }
 
-    vec3 operator * ( const vec3& v ) const
-	{ return vec3( x*v.x, y*v.y, z*v.z ); }
+    constexpr vec operator * ( const vec& v ) const
+	{ return zip( v, detail::times() ); }
 
-    friend vec3 operator * ( const GLfloat s, const vec3& v )
+    friend constexpr vec operator * ( const T s, const vec& v )
 	{ return v * s; }
 
-    vec3 operator / ( const GLfloat s ) const {
+    constexpr vec operator / ( const T s ) const {
 #ifdef DEBUG
 	if ( std::fabs(s) < DivideByZeroTolerance ) {
 	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
 		      << "Division by zero" << std::endl;
-	    return vec3();
+	    return vec();
 	}
 #endif // DEBUG
 
-	GLfloat r = GLfloat(1.0) / s;
+	T r = T(1.0) / s;
 	return *this * r;
     }
 
@@ -220,242 +255,139 @@ struct vec3 {
     //  --- (modifying) Arithematic Operators ---
     //
 
-    vec3& operator += ( const vec3& v )
-	{ x += v.x;  y += v.y;  z += v.z;  return *this; }
+    constexpr vec& operator += ( const vec& v )
+	{ return *this = *this + v; }
 
-    vec3& operator -= ( const vec3& v )
-	{ x -= v.x;  y -= v.y;  z -= v.z;  return *this; }
+    constexpr vec& operator -= ( const vec& v )
+	{ return *this = *this - v; }
 
-    vec3& operator *= ( const GLfloat s )
-	{ x *= s;  y *= s;  z *= s;  return *this; }
+    constexpr vec& operator *= ( const T s )
+	{ return *this = *this * s; }
 
-    vec3& operator *= ( const vec3& v )
-	{ x *= v.x;  y *= v.y;  z *= v.z;  return *this; }
+    constexpr vec& operator *= ( const vec& v )
+	{ return *this = *this * v; }
 
-    vec3& operator /= ( const GLfloat s ) {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	}
-#endif // DEBUG
+    constexpr vec& operator /= ( const T s )
+	{ return *this = *this / s; }
 
-	GLfloat r = GLfloat(1.0) / s;
-	*this *= r;
-
-	return *this;
-    }
-	
     //
     //  --- Insertion and Extraction Operators ---
     //
 
-    friend std::ostream& operator << ( std::ostream& os, const vec3& v ) {
-	return os << "( " << v.x << ", " << v.y << ", " << v.z <<  " )";
+    friend std::ostream& operator << ( std::ostream& os, const vec& v ) {
+	os << "( " << v[0];
+	for ( int i = 1; i < N; ++i )
+	    os << ", " << v[i];
+	return os << " )";
     }
 
-    friend std::istream& operator >> ( std::istream& is, vec3& v )
-	{ return is >> v.x >> v.y >> v.z ; }
+    friend std::istream& operator >> ( std::istream& is, vec& v ) {
+	for ( int i = 0; i < N; ++i )
+	    is >> v[i];
+	return is;
+    }
 
     //
     //  --- Conversion Operators ---
     //
 
-    operator const GLfloat* () const
-	{ return static_cast<const GLfloat*>( &x ); }
+    operator const T* () const
+	{ return this->data(); }
 
-    operator GLfloat* ()
-	{ return static_cast<GLfloat*>( &x ); }
-};
-
-//----------------------------------------------------------------------------
-//
-//  Non-class vec3 Methods
-//
-
-inline
-GLfloat dot( const vec3& u, const vec3& v ) {
-    return u.x*v.x + u.y*v.y + u.z*v.z ;
-}
-
-inline
-GLfloat length( const vec3& v ) {
-    return std::sqrt( dot(v,v) );
-}
-
-inline
-vec3 normalize( const vec3& v ) {
-    return v / length(v);
-}
-
-inline
-vec3 cross(const vec3& a, const vec3& b )
-{
-    return vec3( a.y * b.z - a.z * b.y,
-		 a.z * b.x - a.x * b.z,
-		 a.x * b.y - a.y * b.x );
-}
-
-
-//////////////////////////////////////////////////////////////////////////////
-//
-//  vec4 - 4D vector
-//
-//////////////////////////////////////////////////////////////////////////////
-
-struct vec4 {
-
-    GLfloat  x;
-    GLfloat  y;
-    GLfloat  z;
-    GLfloat  w;
+    operator T* ()
+	{ return this->data(); }
 
     //
-    //  --- Constructors and Destructors ---
+    //  --- Component-wise helpers ---
     //
 
-    vec4( GLfloat s = GLfloat(0.0) ) :
-	x(s), y(s), z(s), w(s) {}
+    //  vec( f(v[0]), f(v[1]), ... )
+    template <class F>
+    constexpr vec map( F f ) const
+	{ return map( f, std::make_index_sequence<N>() ); }
 
-    vec4( GLfloat x, GLfloat y, GLfloat z ) :
-	x(x), y(y), z(z), w(1) {}
+    //  vec( f(v[0], u[0]), f(v[1], u[1]), ... )
+    template <class F>
+    constexpr vec zip( const vec& u, F f ) const
+	{ return zip( u, f, std::make_index_sequence<N>() ); }
 
-    vec4( GLfloat x, GLfloat y, GLfloat z, GLfloat w ) :
-	x(x), y(y), z(z), w(w) {}
-
-    vec4( const vec4& v ) { x = v.x;  y = v.y;  z = v.z;  w = v.w; }
-
-    vec4( const vec3& v, const float w = 1.0 ) : w(w)
-	{ x = v.x;  y = v.y;  z = v.z; }
-
-    vec4( const vec2& v, const float z, const float w ) : z(z), w(w)
-	{ x = v.x;  y = v.y; }
-
-    //
-    //  --- Indexing Operator ---
-    //
-
-    GLfloat& operator [] ( int i ) { return *(&x + i); }
-    const GLfloat operator [] ( int i ) const { return *(&x + i); }
-
-    //
-    //  --- (non-modifying) Arithematic Operators ---
-    //
-
-    vec4 operator - () const  // unary minus operator
-	{ return vec4( -x, -y, -z, -w ); }
+   private:
+    template <std::size_t... I>
+    constexpr vec( detail::fill_tag, T s, std::index_sequence<I...> ) :
+	detail::vec_storage<N, T>( detail::components_tag(),
+				   ((void) I, s)... ) {}
 
-    vec4 operator + ( const vec4& v ) const
-	{ return vec4( x + v.x, y + v.y, z + v.z, w + v.w ); }
+    template <std::size_t... I>
+    constexpr vec( detail::append_tag, const vec<N - 1, T>& v, T last,
+		   std::index_sequence<I...> ) :
+	detail::vec_storage<N, T>( detail::components_tag(), v.at(I)...,
+				   last ) {}
+    template <class F, std::size_t... I>
+    constexpr vec map( F f, std::index_sequence<I...> ) const
+	{ return vec( detail::components_tag(), f( this->at(I) )... ); }
 
-    vec4 operator - ( const vec4& v ) const
-	{ return vec4( x - v.x, y - v.y, z - v.z, w - v.w ); }
+    template <class F, std::size_t... I>
+    constexpr vec zip( const vec& u, F f, std::index_sequence<I...> ) const
+	{ return vec( detail::components_tag(), f( this->at(I), u.at(I) )... ); }
 
-    vec4 operator * ( const GLfloat s ) const
-	{ return vec4( s*x, s*y, s*z, s*w ); }
-
-    vec4 operator * ( const vec4& v ) const
-	{ return vec4( x*v.x, y*v.y, z*v.z, w*v.z ); }
-
-    friend vec4 operator * ( const GLfloat s, const vec4& v )
-	{ return v * s; }
-
-    vec4 operator / ( const GLfloat s ) const {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	    return vec4();
-	}
-#endif // DEBUG
-
-	GLfloat r = GLfloat(1.0) / s;
-	return *this * r;
-    }
-
-    //
-    //  --- (modifying) Arithematic Operators ---
-    //
-
-    vec4& operator += ( const vec4& v )
-	{ x += v.x;  y += v.y;  z += v.z;  w += v.w;  return *this; }
-
-    vec4& operator -= ( const vec4& v )
-	{ x -= v.x;  y -= v.y;  z -= v.z;  w -= v.w;  return *this; }
-
-    vec4& operator *= ( const GLfloat s )
-	{ x *= s;  y *= s;  z *= s;  w *= s;  return *this; }
-
-    vec4& operator *= ( const vec4& v )
-	{ x *= v.x, y *= v.y, z *= v.z, w *= v.w;  return *this; }
-
-    vec4& operator /= ( const GLfloat s ) {
-#ifdef DEBUG
-	if ( std::fabs(s) < DivideByZeroTolerance ) {
-	    std::cerr << "[" << __FILE__ << ":" << __LINE__ << "] "
-		      << "Division by zero" << std::endl;
-	}
-#endif // DEBUG
-
-	GLfloat r = GLfloat(1.0) / s;
-	*this *= r;
-
-	return *this;
-    }
-	
-    //
-    //  --- Insertion and Extraction Operators ---
-    //
-
-    friend std::ostream& operator << ( std::ostream& os, const vec4& v ) {
-	return os << "( " << v.x << ", " << v.y
-		  << ", " << v.z << ", " << v.w << " )";
-    }
-
-    friend std::istream& operator >> ( std::istream& is, vec4& v )
-	{ return is >> v.x >> v.y >> v.z >> v.w; }
-
-    //
-    //  --- Conversion Operators ---
-    //
-
-    operator const GLfloat* () const
-	{ return static_cast<const GLfloat*>( &x ); }
-
-    operator GLfloat* ()
-	{ return static_cast<GLfloat*>( &x ); }
 };
 
-//----------------------------------------------------------------------------
 //
-//  Non-class vec4 Methods
+//  --- Non-class vec Methods ---
 //
 
-inline
-GLfloat dot( const vec4& u, const vec4& v ) {
-    return u.x*v.x + u.y*v.y + u.z*v.z + u.w*v.w;
+namespace detail {
+
+template <int N, class T, std::size_t... I>
+constexpr T dot( const vec<N, T>& u, const vec<N, T>& v,
+		 std::index_sequence<I...> )
+    { return sum( (u.at(I) * v.at(I))... ); }
+
+}  // namespace detail
+
+template <int N, class T>
+constexpr T dot( const vec<N, T>& u, const vec<N, T>& v ) {
+    return detail::dot( u, v, std::make_index_sequence<N>() );
 }
 
-inline
-GLfloat length( const vec4& v ) {
+template <int N, class T>
+inline T length( const vec<N, T>& v ) {
     return std::sqrt( dot(v,v) );
 }
 
-inline
-vec4 normalize( const vec4& v ) {
+template <int N, class T>
+inline vec<N, T> normalize( const vec<N, T>& v ) {
     return v / length(v);
 }
 
-inline
-vec3 cross(const vec4& a, const vec4& b )
+template <class T>
+constexpr vec<3, T> cross( const vec<3, T>& a, const vec<3, T>& b )
 {
-    return vec3( a.y * b.z - a.z * b.y,
-		 a.z * b.x - a.x * b.z,
-		 a.x * b.y - a.y * b.x );
+    return vec<3, T>( a.y * b.z - a.z * b.y,
+		      a.z * b.x - a.x * b.z,
+		      a.x * b.y - a.y * b.x );
+}
+
+//  Cross product of the xyz parts
+template <class T>
+constexpr vec<3, T> cross( const vec<4, T>& a, const vec<4, T>& b )
+{
+    return vec<3, T>( a.y * b.z - a.z * b.y,
+		      a.z * b.x - a.x * b.z,
+		      a.x * b.y - a.y * b.x );
 }
 
 //----------------------------------------------------------------------------
 
+typedef vec<2, GLfloat>  vec2;
+typedef vec<3, GLfloat>  vec3;
+typedef vec<4, GLfloat>  vec4;
+typedef vec<5, GLfloat>  vec5;
+
+//  Arrays of these go straight into vertex buffers
+static_assert( sizeof(vec4) == 4 * sizeof(GLfloat), "vec4 must be packed" );
+static_assert( sizeof(vec5) == 5 * sizeof(GLfloat), "vec5 must be packed" );
+
 }  // namespace Angel
 
 #endif // __ANGEL_VEC_H__
@@ -0,0 +1,19 @@
+#version 150
+
+// Billboards standing in for distant objects, one instance each: a square
+// facing the camera at the eye-space center "box.xyz", "box.w" out to each
+// side, textured with the atlas tile at "tile.xy", "tile.z" on a side.  The
+// corners come from gl_VertexID, drawn as a strip of 4.
+
+in  vec4 vBox;
+in  vec4 vTile;
+out vec2 coord;
+
+uniform mat4 Projection;
+
+void main()
+{
+	vec2 corner = vec2( gl_VertexID & 1, gl_VertexID >> 1 );
+	coord = vTile.xy + corner*vTile.z;
+	gl_Position = Projection*vec4( vBox.xyz + vec3( vBox.w*(2.0*corner - 1.0), 0.0 ), 1.0 );
+}
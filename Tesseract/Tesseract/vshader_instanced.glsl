@@ -0,0 +1,120 @@
+#version 150
+
+// Instanced tesseracts, one draw for the whole scene.  Each instance's
+// placement, color and rotation are 6 texels of the texture buffer
+// "instances": center, tint, (scale), sines 0-3, (sines 4-5, cosines
+// 0-1), cosines 2-5.
+//
+// With "pulled" set there are no vertex attributes at all: the vertex is
+// looked up by gl_VertexID in the tables below, which init() fills from
+// the tesseract in FixedMesh.h -- 6 corners per square face for the
+// triangles, 2 per edge for the lines.  Without it the vertices come from
+// the solid and wireframe buffers as usual.
+//
+// Drawn from the commands cshader_cull.glsl writes ("indirect" set), each
+// draw is one instance, and which object it is comes from vObject: a
+// per-instance attribute of 0, 1, 2, ... read at the draw's base
+// instance.  Otherwise it is gl_InstanceID counted from "first", so that
+// one object of the buffer can be drawn on its own.
+
+in  vec4 vPosition;
+in  vec4 vNormal;
+in  int  vObject;
+out vec4 color;
+
+uniform samplerBuffer instances;
+uniform bool pulled;
+uniform bool lines;
+uniform bool indirect;
+uniform int first;
+
+uniform vec4 corners[16];
+uniform ivec4 quads[24];
+uniform ivec4 edges[16];        // two edges each
+uniform vec4 face_colors[24];   // divided by w
+
+uniform mat4 ModelView;
+uniform mat4 Projection;
+
+// The two triangles of a square face, (a, b, d) and (d, b, c)
+const int quad_corner[6] = int[6]( 0, 1, 3, 3, 1, 2 );
+
+void main()
+{
+	int base = 6*(indirect ? vObject : first + gl_InstanceID);
+	vec4 center = texelFetch( instances, base );
+	vec4 tint = texelFetch( instances, base + 1 );
+	float scale = texelFetch( instances, base + 2 ).x;
+	vec4 s = texelFetch( instances, base + 3 );
+	vec4 sc = texelFetch( instances, base + 4 );
+	vec4 c = texelFetch( instances, base + 5 );
+	float sines[6] = float[6]( s.x, s.y, s.z, s.w, sc.x, sc.y );
+	float cosines[6] = float[6]( sc.z, sc.w, c.x, c.y, c.z, c.w );
+
+	vec4 position, shade;
+	if( pulled )
+	{
+		if( lines )
+		{
+			position = corners[edges[gl_VertexID/4][gl_VertexID % 4]];
+			shade = vec4( 1.0 );
+		}
+		else
+		{
+			int face = gl_VertexID/6;
+			position = corners[quads[face][quad_corner[gl_VertexID % 6]]];
+			shade = face_colors[face];
+		}
+	}
+	else
+	{
+		position = vPosition;
+		shade = lines ? vec4( 1.0 ) : vNormal / vNormal.w;
+	}
+
+	// Perform rotation in 4D about the given planes
+	// XY
+	mat4 rotation = mat4( cosines[0],	sines[0],		0.0,	0.0,
+						  -sines[0],	cosines[0],		0.0,	0.0,
+						  0.0,			0.0,			1.0,	0.0,
+						  0.0,			0.0,			0.0,	1.0 );
+						  
+	// YZ
+	rotation = mat4( 1.0,			0.0,			0.0,		0.0,
+					 0.0,			cosines[1],		sines[1],	0.0,
+					 0.0,			-sines[1],		cosines[1],	0.0,
+					 0.0,			0.0,			0.0,		1.0 ) * rotation;
+	
+	// XZ
+	rotation = mat4( cosines[2],	0.0,	-sines[2],	0.0,
+					 0.0,			1.0,	0.0,		0.0,
+					 sines[2],		0.0,	cosines[2],	0.0,
+					 0.0,			0.0,	0.0,		1.0 ) * rotation;
+	
+	// XW
+	rotation = mat4( cosines[3],	0.0,	0.0,	sines[3],
+					 0.0,			1.0,	0.0,	0.0,
+					 0.0,			0.0,	1.0,	0.0,
+					 -sines[3],		0.0,	0.0,	cosines[3]) * rotation;
+	
+	// YW
+	rotation = mat4( 1.0,			0.0,			0.0,	0.0,
+					 0.0,			cosines[4],		0.0,	-sines[4],
+					 0.0,			0.0,			1.0,	0.0,
+					 0.0,			sines[4],		0.0,	cosines[4] ) * rotation;
+	
+	// ZW
+	rotation = mat4( 1.0,	0.0,	0.0,			0.0,
+					 0.0,	1.0,	0.0,			0.0,
+					 0.0,	0.0,	cosines[5],		-sines[5],
+					 0.0,	0.0,	sines[5],		cosines[5] ) * rotation;
+	
+	
+	vec4 temp = rotation*(scale*position) + center;
+    temp.w = temp.w + 1.0;
+    temp.xyz = temp.xyz * temp.w;
+    temp.w = 1.0;
+
+    color = shade*tint;
+    gl_Position = Projection*ModelView*temp;
+}
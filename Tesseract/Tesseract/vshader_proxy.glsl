@@ -0,0 +1,15 @@
+attribute  vec4 vPosition;
+varying    vec4 color;
+
+// An occlusion proxy: the cube of corners (+-1, +-1, +-1) moved to a box
+// around one object's projection -- center box.xyz, half size box.w
+
+uniform mat4 ModelView;
+uniform mat4 Projection;
+uniform vec4 box;
+
+void main()
+{
+    color = vec4( 1.0 );
+    gl_Position = Projection*ModelView*vec4( box.xyz + box.w*vPosition.xyz, 1.0 );
+}
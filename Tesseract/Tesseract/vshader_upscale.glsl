@@ -0,0 +1,16 @@
+#version 150
+
+// One triangle over the whole window, from gl_VertexID alone, for the
+// upscale pass.  "region" is the part of the scene texture drawn this
+// frame, in texture coordinates.
+
+out vec2 coord;
+
+uniform vec2 region;
+
+void main()
+{
+	vec2 corner = vec2( (gl_VertexID << 1) & 2, gl_VertexID & 2 );
+	coord = corner*region;
+	gl_Position = vec4( 2.0*corner - 1.0, 0.0, 1.0 );
+}
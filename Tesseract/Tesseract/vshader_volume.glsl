@@ -0,0 +1,12 @@
+attribute  vec4 vPosition;
+varying    vec3 position;   // on the box, in object space
+
+uniform mat4 ModelView;
+uniform mat4 Projection;
+
+void main()
+{
+    vec4 p = vec4( vPosition.xyz, 1.0 );
+    position = p.xyz;
+    gl_Position = Projection*ModelView*p;
+}
@@ -1,4 +1,5 @@
 attribute  vec4 vPosition;
+attribute  vec4 vMorph;
 //attribute  vec4 vNormal;
 varying    vec4 color;
 
@@ -10,6 +11,15 @@ uniform float cosines[6];
 uniform mat4 ModelView;
 uniform mat4 Projection;
 
+// Per-object placement in 4D and color
+uniform vec4 center;
+uniform float scale;
+uniform vec4 tint;
+
+// How far to move toward vMorph, for the curved surfaces' levels of
+// detail (Surface.h); 0 for other meshes
+uniform float morph;
+
 void main()
 {
 	// Perform rotation in 4D about the given planes
@@ -50,12 +60,13 @@ void main()
 					 0.0,	0.0,	sines[5],		cosines[5] ) * rotation;
 	
 	
-	vec4 temp = rotation*vPosition;
+	vec4 position = mix( vPosition, vMorph, morph );
+	vec4 temp = rotation*(scale*position) + center;
     temp.w = temp.w + 1.0;
     temp.xyz = temp.xyz * temp.w;
     temp.w = 1.0;
     
-    color = vec4(1.0,1.0,1.0,1.0);
+    color = tint;
     //color = vec4(abs(vNormal.x),abs(vNormal.y),abs(vNormal.z),1.0);
     gl_Position = Projection*ModelView*temp;
 }